@@ -7,6 +7,17 @@
 #include "ui.h"
 #include "bluetooth.h"
 #include "library_data.h"
+#include "abp_frame.h"
+#include "abp_codec.h"
+#include "abp_dispatch.h"
+#include "json_pull.h"
+#include "playback_mailbox.h"
+#include "app_log.h"
+#include "song_cache.h"
+#include "library_snapshot.h"
+#include "page_tracker.h"
+#include "song_window.h"
+#include "library_delta.h"
 
 using namespace esp_panel::drivers;
 using namespace esp_panel::board;
@@ -14,47 +25,417 @@ using namespace esp_panel::board;
 // Flag to send initial queries after connection
 static bool g_should_query_library = false;
 static unsigned long g_connection_time = 0;
-static const unsigned long QUERY_DELAY_MS = 2000;  // Wait 2 seconds for app to be ready
+static const unsigned long QUERY_DELAY_MS = 2000;  // Fallback for apps that never answer HELLO
+static volatile bool g_app_ready = false;          // Set when the app answers HELLO with CAPABILITIES
+static volatile bool g_wire_binary = false;        // App agreed to the binary (TLV) encoding
+static volatile bool g_song_windows = false;       // App answers offset / limit song queries (v1.3)
+static volatile bool g_library_deltas = false;     // App answers a revision with what changed since (v1.4)
+static volatile bool g_library_stream = false;     // App answers QUERY_LIBRARY with one interleaved stream (v1.5)
+static volatile bool g_request_ids = false;        // App echoes request ids and takes CANCEL (v1.6)
+static unsigned long g_last_dispatch_stats_ms = 0;
+static uint8_t g_synced_collections = 0;            // Bit per collection complete since the queries (g_transfer_lock)
+
+// Song list the UI last asked for - only that one is shown, other responses just go to the
+// cache. The UI task rewrites it under g_transfer_lock; other tasks read a copy (wanted_song_list()).
+static char g_wanted_context[16] = {0};
+static char g_wanted_context_id[MAX_ID_LENGTH] = {0};
+static char g_response_context[16] = {0};              // Songs response being received
+static char g_response_context_id[MAX_ID_LENGTH] = {0};
+static bool g_songs_staged = false;     // ... goes to the cache, not the library
+static bool g_response_wanted = false;  // ... is the wanted list, checked once per page
+
+// Long song lists are held as a window that follows the rows on screen (see song_window.h).
+// The window query in flight and the rows last shown are under g_transfer_lock.
+typedef struct {
+    uint32_t first;
+    uint32_t visible;
+    int direction;
+    bool pending;               // Shown since the window last covered them
+} SongView;
+static SongWindowFetch g_song_fetch = {};
+static bool g_song_fetch_open = false;  // Sent and not yet published
+static bool g_song_fetch_moves = false; // Follows paging: a failed one leaves the screen as it is
+static SongView g_song_view = {};
+static bool g_song_open_pending = false;    // The UI opened g_wanted_context, check_song_open() shows it
+// The song list is written by the protocol task (pages) and the loop task (cache restores),
+// one page or one restore at a time - never by the UI task. Other tasks read it under
+// this lock as well; only the UI is covered by the library's grace period.
+static SemaphoreHandle_t g_song_write_lock = nullptr;
+// Resident songs the response being received keeps (protocol task)
+typedef struct {
+    uint32_t start;
+    uint32_t count;
+    bool before;                // Ahead of the fetched ones
+} SongKeep;
+static SongKeep g_song_keep = {};
+
+// Delivery state of each collection's paginated response. Queries start transfers on the
+// loop and UI tasks, pages arrive on the protocol task - g_transfer_lock serializes them.
+static PageTracker g_transfers[LIBRARY_COLLECTION_COUNT];
+static uint32_t g_transfer_revisions[LIBRARY_COLLECTION_COUNT];    // Revision each query named, 0 = none
+static uint32_t g_last_request_id = 0;  // Of the last query that carried one
+static SemaphoreHandle_t g_transfer_lock = nullptr;
+// Binary message being dispatched (protocol task), so a page that arrives early can be held
+static const uint8_t* g_rx_message = nullptr;
+static size_t g_rx_length = 0;
+
+// JSON document for the single-record messages - library pages are streamed and never use it
+static const size_t JSON_DOC_SIZE = 1024;
+
+// Largest message we advertise: pages stream in constant memory, so only reassembly limits it
+static const size_t MAX_PARSE_MESSAGE = ABP_MAX_MESSAGE_SIZE;
+static const char* PROTOCOL_VERSION = "1.6";
+
+// Log anything the TX queue did not deliver; ctx is the message type name
+static void on_tx_done(TxStatus status, void* ctx) {
+    if (status == TX_STATUS_SENT) return;
+    static const char* status_names[] = {"sent", "merged", "dropped", "failed"};
+    LOGW(MAIN, "%s %s", (const char*)ctx, status_names[status]);
+}
+
+// Queries, PLAY_SONG and HELLO only matter as the latest of their type, so a newer one
+// replaces an older one still waiting to go out. Playback commands always go out (key 0).
+static uint32_t tx_merge_key(const char* type) {
+    AbpMessageType binary_type;
+    if (strncmp(type, "QUERY_", 6) != 0 && strcmp(type, "PLAY_SONG") != 0 && strcmp(type, "HELLO") != 0) {
+        return 0;
+    }
+    return abp_message_type_from_name(type, &binary_type) ? (uint32_t)binary_type : 0;
+}
+
+// Repeats for missing pages are not mergeable: each names different pages
+static void send_text(const char* type, const char* json, bool mergeable = true) {
+    bluetooth_send(json, mergeable ? tx_merge_key(type) : 0, on_tx_done, (void*)type);
+}
+
+// Send a message the app should see as binary (TLV) once it picked that encoding. False,
+// with nothing sent, when the fields did not fit the writer - the caller sends it as JSON.
+static bool send_binary(const char* type, AbpTlvWriter* w, bool mergeable = true) {
+    if (w->overflow) {
+        LOGE(MAIN, "%s does not fit %u bytes, sending it as JSON", type, (unsigned)w->capacity);
+        return false;
+    }
+    bluetooth_send(w->data, w->length, mergeable ? tx_merge_key(type) : 0, on_tx_done, (void*)type);
+    LOGD(MAIN, "Sent %s (binary, %u bytes)", type, (unsigned)w->length);
+    return true;
+}
+
+// Send a query message to the app. Beside the id, first_page / last_page (1-based) ask for
+// only those pages, offset / limit (song queries) for only that slice of the list, and
+// revision (playlists, artists, albums) for only what changed since that revision.
+// request_id, when not 0, is echoed in every page of the answer.
+void send_query(const char* query_type, const AbpQueryId& query) {
+    const char* id = query.id;
+    bool has_id = id != nullptr && strlen(id) > 0;
+    bool ranged = query.first_page != 0;
+    bool sliced = query.limit != 0;
+    AbpMessageType binary_type;
+    if (g_wire_binary && abp_message_type_from_name(query_type, &binary_type)) {
+        uint8_t buffer[128];
+        AbpTlvWriter w;
+        abp_binary_begin(&w, buffer, sizeof(buffer), binary_type);
+        AbpQueryId fields = query;
+        if (!has_id) fields.id = nullptr;
+        abp_encode_fields_query_id(&w, &fields);
+        if (send_binary(query_type, &w, !ranged)) return;
+    }
 
-// Send a query message to the app
-void send_query(const char* query_type, const char* id = nullptr) {
     StaticJsonDocument<256> doc;
     doc["type"] = query_type;
     doc["timestamp"] = millis() / 1000.0;
 
-    if (id != nullptr && strlen(id) > 0) {
+    if (has_id || ranged || sliced || query.revision != 0 || query.request_id != 0) {
         JsonObject payload = doc.createNestedObject("payload");
-        if (strcmp(query_type, "QUERY_PLAYLIST_SONGS") == 0) {
+        if (!has_id) {
+            // No id for the whole-collection queries
+        } else if (strcmp(query_type, "QUERY_PLAYLIST_SONGS") == 0) {
             payload["playlistId"] = id;
         } else if (strcmp(query_type, "QUERY_ALBUM_SONGS") == 0) {
             payload["albumId"] = id;
         } else if (strcmp(query_type, "QUERY_ARTIST_SONGS") == 0) {
             payload["artistId"] = id;
         }
+        if (ranged) {
+            payload["firstPage"] = query.first_page;
+            payload["lastPage"] = query.last_page;
+        }
+        if (sliced) {
+            payload["offset"] = query.offset;
+            payload["limit"] = query.limit;
+        }
+        if (query.revision != 0) {
+            payload["revision"] = query.revision;
+        }
+        if (query.request_id != 0) {
+            payload["requestId"] = query.request_id;
+        }
     }
 
     char buffer[256];
     serializeJson(doc, buffer, sizeof(buffer));
-    bluetooth_send(buffer);
-    Serial.print("[Main] Sent query: ");
-    Serial.println(buffer);
+    send_text(query_type, buffer, !ranged);
+    LOGD(MAIN, "Sent query: %s", buffer);
+}
+
+void send_query(const char* query_type, const char* id = nullptr) {
+    AbpQueryId query = {};
+    query.id = id;
+    send_query(query_type, query);
+}
+
+// Tell the app to stop sending the pages of a query (v1.6); 0 - no id was sent - is a no-op
+static void send_cancel(uint32_t request_id) {
+    if (request_id == 0 || !g_request_ids) return;
+    if (g_wire_binary) {
+        uint8_t buffer[16];
+        AbpTlvWriter w;
+        abp_binary_begin(&w, buffer, sizeof(buffer), ABP_MSG_CANCEL);
+        AbpCancel cancel = {request_id};
+        abp_encode_fields_cancel(&w, &cancel);
+        if (send_binary("CANCEL", &w)) return;
+    }
+
+    StaticJsonDocument<128> doc;
+    doc["type"] = "CANCEL";
+    doc["timestamp"] = millis() / 1000.0;
+    doc.createNestedObject("payload")["requestId"] = request_id;
+
+    char buffer[128];
+    serializeJson(doc, buffer, sizeof(buffer));
+    send_text("CANCEL", buffer);
+    LOGD(MAIN, "Sent cancel: %s", buffer);
+}
+
+// Id for a query about to go out, 0 for apps that would not echo it (g_transfer_lock held)
+static uint32_t next_request_id(void) {
+    if (!g_request_ids) return 0;
+    if (++g_last_request_id == 0) g_last_request_id = 1;
+    return g_last_request_id;
+}
+
+// Start tracking a collection's answer to a new query carrying request_id (g_transfer_lock
+// held). Returns the id of the query it supersedes while that one is still being
+// answered, for send_cancel(), else 0.
+static uint32_t start_transfer(LibraryCollection collection, const char* context, const char* context_id,
+                               uint32_t first_item, uint32_t item_limit, uint32_t request_id) {
+    PageTracker* transfer = &g_transfers[collection];
+    uint32_t superseded = transfer->active ? transfer->request_id : 0;
+    page_tracker_start(transfer, context, context_id, first_item, item_limit, request_id, millis());
+    return superseded;
+}
+
+// Song list context a query asks for, or nullptr for other queries
+static const char* song_query_context(const char* query_type) {
+    if (strcmp(query_type, "QUERY_PLAYLIST_SONGS") == 0) return "playlist";
+    if (strcmp(query_type, "QUERY_ALBUM_SONGS") == 0) return "album";
+    if (strcmp(query_type, "QUERY_ARTIST_SONGS") == 0) return "artist";
+    return nullptr;
+}
+
+// Query that asks for a collection again; for songs, by the context the list was asked with
+static const char* collection_query(LibraryCollection collection, const char* context) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS: return "QUERY_PLAYLISTS";
+    case LIBRARY_ARTISTS: return "QUERY_ARTISTS";
+    case LIBRARY_ALBUMS: return "QUERY_ALBUMS";
+    default: break;
+    }
+    if (strcmp(context, "playlist") == 0) return "QUERY_PLAYLIST_SONGS";
+    if (strcmp(context, "album") == 0) return "QUERY_ALBUM_SONGS";
+    if (strcmp(context, "artist") == 0) return "QUERY_ARTIST_SONGS";
+    return "QUERY_SONGS";
+}
+
+// Ask for a list and track its pages from here on (any task). A song list is asked for
+// as the window fetch describes when the app takes offset / limit, else whole.
+static void query_collection(LibraryCollection collection, const char* query_type, const char* context = nullptr,
+                             const char* id = nullptr, const SongWindowFetch* fetch = nullptr, bool moves = false) {
+    SongWindowFetch slice = {};
+    if (fetch && g_song_windows) slice = *fetch;
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    uint32_t request_id = next_request_id();
+    uint32_t superseded = start_transfer(collection, context, id, slice.offset, slice.limit, request_id);
+    if (collection == LIBRARY_SONGS) {
+        g_song_fetch = slice;
+        g_song_fetch_open = true;
+        g_song_fetch_moves = moves;
+    }
+    xSemaphoreGive(g_transfer_lock);
+    // The list asked for before (one the user left) need not finish streaming
+    send_cancel(superseded);
+    AbpQueryId query = {};
+    query.id = id;
+    query.offset = slice.offset;
+    query.limit = slice.limit;
+    query.request_id = request_id;
+    send_query(query_type, query);
+}
+
+// Ask for playlists, artists or albums (any task); revision names the version held, so
+// the app answers with only what changed since (v1.4). 0 asks for the whole list.
+static void query_library(LibraryCollection collection, uint32_t revision) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    uint32_t request_id = next_request_id();
+    uint32_t superseded = start_transfer(collection, nullptr, nullptr, 0, 0, request_id);
+    g_transfer_revisions[collection] = revision;
+    xSemaphoreGive(g_transfer_lock);
+    send_cancel(superseded);
+    AbpQueryId query = {};
+    query.revision = revision;
+    query.request_id = request_id;
+    send_query(collection_query(collection, nullptr), query);
+}
+
+// Playlists, artists and albums - the lists a library sync asks for, and their QUERY_LIBRARY names
+static const LibraryCollection LIBRARY_LISTS[] = {LIBRARY_PLAYLISTS, LIBRARY_ARTISTS, LIBRARY_ALBUMS};
+static const size_t LIBRARY_LIST_COUNT = sizeof(LIBRARY_LISTS) / sizeof(LIBRARY_LISTS[0]);
+static const char* library_list_name(LibraryCollection collection) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS: return "playlists";
+    case LIBRARY_ARTISTS: return "artists";
+    default: return "albums";
+    }
+}
+
+// Ask for all library lists in one QUERY_LIBRARY (v1.5), each against its revision and
+// up to what the store holds. The app sends their pages as one interleaved stream; the
+// response types route each page to its collection's transfer as for separate queries.
+// The lists share one request id, so their transfers are tracked under the same one.
+static void query_library_stream(const uint32_t* revisions) {
+    uint32_t superseded[LIBRARY_LIST_COUNT];
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    uint32_t request_id = next_request_id();
+    for (size_t i = 0; i < LIBRARY_LIST_COUNT; i++) {
+        superseded[i] = start_transfer(LIBRARY_LISTS[i], nullptr, nullptr, 0, 0, request_id);
+        g_transfer_revisions[LIBRARY_LISTS[i]] = revisions[i];
+    }
+    xSemaphoreGive(g_transfer_lock);
+    // A stream still running has the same id in every list - cancel it once
+    for (size_t i = 0; i < LIBRARY_LIST_COUNT; i++) {
+        bool seen = false;
+        for (size_t j = 0; j < i; j++) seen |= superseded[j] == superseded[i];
+        if (!seen) send_cancel(superseded[i]);
+    }
+
+    if (g_wire_binary) {
+        uint8_t lists[96];
+        AbpTlvWriter list_writer;
+        abp_tlv_writer_init(&list_writer, lists, sizeof(lists));
+        for (size_t i = 0; i < LIBRARY_LIST_COUNT; i++) {
+            uint8_t item[32];
+            AbpTlvWriter item_writer;
+            abp_tlv_writer_init(&item_writer, item, sizeof(item));
+            AbpLibraryListRequest request = {library_list_name(LIBRARY_LISTS[i]), revisions[i],
+                                             library_get_capacity(LIBRARY_LISTS[i])};
+            abp_encode_fields_library_list_request(&item_writer, &request);
+            // An item cut short still reads as a list entry - count it against the list
+            list_writer.overflow |= item_writer.overflow;
+            abp_tlv_write_bytes(&list_writer, 1, item, item_writer.length);
+        }
+        uint8_t buffer[128];
+        AbpTlvWriter w;
+        abp_binary_begin(&w, buffer, sizeof(buffer), ABP_MSG_QUERY_LIBRARY);
+        AbpQueryLibrary query = {{lists, list_writer.length, 1, (uint16_t)LIBRARY_LIST_COUNT}, request_id};
+        abp_encode_fields_query_library(&w, &query);
+        if (list_writer.overflow) {
+            LOGE(MAIN, "QUERY_LIBRARY lists do not fit %u bytes, sending it as JSON", (unsigned)sizeof(lists));
+        } else if (send_binary("QUERY_LIBRARY", &w)) {
+            return;
+        }
+    }
+
+    StaticJsonDocument<384> doc;
+    doc["type"] = "QUERY_LIBRARY";
+    doc["timestamp"] = millis() / 1000.0;
+    JsonObject payload = doc.createNestedObject("payload");
+    JsonArray collections = payload.createNestedArray("collections");
+    for (size_t i = 0; i < LIBRARY_LIST_COUNT; i++) {
+        JsonObject request = collections.createNestedObject();
+        request["collection"] = library_list_name(LIBRARY_LISTS[i]);
+        if (revisions[i] != 0) request["revision"] = revisions[i];
+        request["limit"] = library_get_capacity(LIBRARY_LISTS[i]);
+    }
+    if (request_id != 0) payload["requestId"] = request_id;
+
+    char buffer[384];
+    serializeJson(doc, buffer, sizeof(buffer));
+    send_text("QUERY_LIBRARY", buffer);
+    LOGD(MAIN, "Sent query: %s", buffer);
 }
 
-// UI query callback - called when UI needs data from app
+// Repeat a transfer's query, or the given pages of it, for the same slice of the list and
+// against the same revision - the app pages that delta the same way again. The repeat
+// carries the transfer's request id, so its pages are still the ones waited for.
+static void repeat_query(LibraryCollection collection, const char* context, const char* context_id,
+                         uint32_t first_item, uint32_t item_limit, uint32_t revision, uint32_t request_id,
+                         uint32_t first_page = 0, uint32_t last_page = 0) {
+    AbpQueryId query = {context_id, first_page, last_page, first_item, item_limit, revision, request_id};
+    send_query(collection_query(collection, context), query);
+}
+
+// UI query callback - called when UI needs data from app (on the UI task, LVGL lock held).
+// A song list is opened by the loop task (check_song_open()): restoring it replaces the
+// library's list, which would wait here for UI frames this task cannot draw.
 void on_ui_query(const char* query_type, const char* id) {
-    // Songs are now cleared when we receive the first page of response
+    const char* context = song_query_context(query_type);
+    if (context) {
+        xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+        snprintf(g_wanted_context, sizeof(g_wanted_context), "%s", context);
+        snprintf(g_wanted_context_id, sizeof(g_wanted_context_id), "%s", id ? id : "");
+        g_song_view = {};
+        g_song_open_pending = true;
+        xSemaphoreGive(g_transfer_lock);
+        return;
+    }
     send_query(query_type, id);
 }
 
+// UI song window callback - paging a song list showed other rows (on the UI task, LVGL lock
+// held). The loop task moves the window toward them (check_song_window()).
+void on_ui_song_window(uint32_t first, uint32_t visible, int direction) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    g_song_view = {first, visible, direction, true};
+    xSemaphoreGive(g_transfer_lock);
+}
+
+// UI songs closed callback - the user left the song list (on the UI task, LVGL lock held).
+// Nobody waits for the rest of it any more: the app is told to stop sending it, and pages
+// already on their way are dropped as stale.
+void on_ui_songs_closed(void) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    g_wanted_context[0] = '\0';
+    g_wanted_context_id[0] = '\0';
+    g_song_open_pending = false;
+    PageTracker* transfer = &g_transfers[LIBRARY_SONGS];
+    uint32_t request_id = transfer->active ? transfer->request_id : 0;
+    page_tracker_cancel(transfer);
+    g_song_fetch_open = false;
+    g_song_view = {};
+    xSemaphoreGive(g_transfer_lock);
+    send_cancel(request_id);
+}
+
 // UI play callback - called when user taps a song to play
 void on_ui_play(const char* song_id, const char* context, const char* context_id, int song_index) {
+    bool has_context = context != nullptr && strlen(context) > 0;
+
+    if (g_wire_binary) {
+        uint8_t buffer[192];
+        AbpTlvWriter w;
+        abp_binary_begin(&w, buffer, sizeof(buffer), ABP_MSG_PLAY_SONG);
+        AbpPlaySong play = {song_id, has_context ? context : nullptr, has_context ? context_id : nullptr,
+                            (uint32_t)song_index};
+        abp_encode_fields_play_song(&w, &play);
+        if (send_binary("PLAY_SONG", &w)) return;
+    }
+
     StaticJsonDocument<256> doc;
     doc["type"] = "PLAY_SONG";
     doc["timestamp"] = millis() / 1000.0;
 
     JsonObject payload = doc.createNestedObject("payload");
     payload["songId"] = song_id;
-    if (context != nullptr && strlen(context) > 0) {
+    if (has_context) {
         payload["context"] = context;
         payload["contextId"] = context_id;
     }
@@ -62,281 +443,1086 @@ void on_ui_play(const char* song_id, const char* context, const char* context_id
 
     char buffer[256];
     serializeJson(doc, buffer, sizeof(buffer));
-    bluetooth_send(buffer);
+    send_text("PLAY_SONG", buffer);
 
-    Serial.print("[Main] Sent play command: ");
-    Serial.println(buffer);
+    LOGI(MAIN, "Sent play command: %s", buffer);
 }
 
 // UI command callback - called for playback control (play/pause, next, prev)
 void on_ui_command(const char* command) {
+    AbpMessageType binary_type;
+    if (g_wire_binary && abp_message_type_from_name(command, &binary_type)) {
+        uint8_t buffer[ABP_BINARY_HEADER_SIZE];
+        AbpTlvWriter w;
+        abp_binary_begin(&w, buffer, sizeof(buffer), binary_type);
+        if (send_binary(command, &w)) return;
+    }
+
     StaticJsonDocument<128> doc;
     doc["type"] = command;
     doc["timestamp"] = millis() / 1000.0;
 
     char buffer[128];
     serializeJson(doc, buffer, sizeof(buffer));
-    bluetooth_send(buffer);
+    send_text(command, buffer);
+
+    LOGI(MAIN, "Sent command: %s", buffer);
+}
+
+// Send HELLO so the app can size its pages to this link and these buffers
+void send_hello(uint16_t mtu) {
+    StaticJsonDocument<384> doc;
+    doc["type"] = "HELLO";
+    doc["timestamp"] = millis() / 1000.0;
 
-    Serial.print("[Main] Sent command: ");
-    Serial.println(buffer);
+    JsonObject payload = doc.createNestedObject("payload");
+    payload["protocolVersion"] = PROTOCOL_VERSION;
+    payload["mtu"] = mtu;
+    payload["maxMessageSize"] = MAX_PARSE_MESSAGE;
+    payload["maxWriteLength"] = BLE_RX_MAX_MESSAGE;
+    payload["maxDeltaItems"] = LIBRARY_DELTA_MAX_ENTRIES;
+
+    JsonObject capacities = payload.createNestedObject("capacities");
+    capacities["playlists"] = library_get_capacity(LIBRARY_PLAYLISTS);
+    capacities["artists"] = library_get_capacity(LIBRARY_ARTISTS);
+    capacities["albums"] = library_get_capacity(LIBRARY_ALBUMS);
+    capacities["songs"] = library_get_capacity(LIBRARY_SONGS);
+
+    JsonArray encodings = payload.createNestedArray("encodings");
+    encodings.add("json");
+    encodings.add("tlv");
+
+    char buffer[384];
+    serializeJson(doc, buffer, sizeof(buffer));
+    send_text("HELLO", buffer);
+    LOGD(MAIN, "Sent hello: %s", buffer);
 }
 
-// Send initial library queries
+// Bluetooth subscribe callback - the app enabled notifications (runs on the protocol task)
+void on_ble_subscribe(uint16_t mtu) {
+    g_app_ready = false;
+    g_wire_binary = false;
+    send_hello(mtu);
+}
+
+// Send initial library queries - against the revisions held, so an unchanged library
+// costs one empty page per collection. One QUERY_LIBRARY when the app takes it, else a
+// query per collection.
 void send_library_queries() {
-    Serial.println("[Main] Requesting library data...");
-    send_query("QUERY_PLAYLISTS");
-    delay(50);
-    send_query("QUERY_ARTISTS");
-    delay(50);
-    send_query("QUERY_ALBUMS");
+    LOGI(MAIN, "Requesting library data...");
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    g_synced_collections = 0;
+    xSemaphoreGive(g_transfer_lock);
+    uint32_t revisions[LIBRARY_LIST_COUNT];
+    for (size_t i = 0; i < LIBRARY_LIST_COUNT; i++) {
+        revisions[i] = g_library_deltas ? library_get_revision(LIBRARY_LISTS[i]) : 0;
+    }
+    if (g_library_stream) {
+        query_library_stream(revisions);
+        return;
+    }
+    for (size_t i = 0; i < LIBRARY_LIST_COUNT; i++) {
+        query_library(LIBRARY_LISTS[i], revisions[i]);
+    }
 }
 
 // Bluetooth connection callback
 void on_ble_connection(bool connected) {
-    Serial.print("[Main] BLE connection: ");
-    Serial.println(connected ? "connected" : "disconnected");
+    LOGI(MAIN, "BLE connection: %s", connected ? "connected" : "disconnected");
 
     if (connected) {
         // Record connection time - we'll send queries after a delay
         g_connection_time = millis();
         g_should_query_library = true;
-        Serial.println("[Main] Will query library in 2 seconds...");
+        LOGI(MAIN, "Will query library in 2 seconds...");
     } else {
-        // Clear library data on disconnect
+        // The library stays browsable while disconnected; the next sync refreshes it
         g_should_query_library = false;
-        library_data_clear();
+        g_app_ready = false;
+        g_wire_binary = false;
+        g_song_windows = false;
+        g_library_deltas = false;
+        g_library_stream = false;
+        g_request_ids = false;
+
+        // Whatever was on its way is lost; the next sync asks again
+        xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+        for (PageTracker& transfer : g_transfers) {
+            page_tracker_cancel(&transfer);
+        }
+        g_song_fetch_open = false;
+        xSemaphoreGive(g_transfer_lock);
     }
 }
 
-// Handle SONG_STARTED message
-void handle_song_started(JsonObject& payload) {
-    const char* title = payload["title"] | "Unknown";
-    const char* artist = payload["artist"] | "Unknown Artist";
-    const char* album = payload["album"] | "Unknown Album";
-    float duration = payload["duration"] | 0.0f;
+// Whether a "major.minor" protocol version is at least major.minor
+static bool version_at_least(const char* version, int major, int minor) {
+    int have_major = 0;
+    int have_minor = 0;
+    sscanf(version, "%d.%d", &have_major, &have_minor);
+    return have_major > major || (have_major == major && have_minor >= minor);
+}
 
-    Serial.print("[Main] Song started: ");
-    Serial.print(title);
-    Serial.print(" - ");
-    Serial.println(artist);
+// Handle CAPABILITIES message - the app's answer to HELLO
+void handle_capabilities(JsonObject& payload) {
+    const char* version = payload["protocolVersion"] | "1.0";
+    const char* encoding = payload["encoding"] | "json";
+    int pageBudget = payload["pageBudget"] | 0;
+
+    LOGI(MAIN, "App capabilities: v%s encoding=%s pageBudget=%d", version, encoding, pageBudget);
+
+    // Both directions switch to the agreed encoding; incoming JSON is still accepted
+    g_wire_binary = strcmp(encoding, "tlv") == 0;
+    // Older apps send every song list whole, whatever a query asks for
+    g_song_windows = version_at_least(version, 1, 3);
+    // ... and every library list whole, without a revision
+    g_library_deltas = version_at_least(version, 1, 4);
+    // ... and know only the per-collection library queries
+    g_library_stream = version_at_least(version, 1, 5);
+    // ... and answer queries without echoing an id, nor stop for CANCEL
+    g_request_ids = version_at_least(version, 1, 6);
+
+    // No need to wait out QUERY_DELAY_MS any more
+    g_app_ready = true;
+}
 
-    lvgl_port_lock(-1);
-    ui_set_song_info(title, artist, album, (uint16_t)duration);
-    ui_set_playing(true);
-    ui_set_progress(0);
-    lvgl_port_unlock();
+// ============================================================================
+// Message handlers - shared by the JSON and binary paths
+// ============================================================================
+
+// Last published position, so SONG_STOPPED keeps it (protocol task only)
+static uint32_t g_last_elapsed_ms = 0;
+
+static const char* str_or(const char* value, const char* fallback) {
+    return value ? value : fallback;
 }
 
-// Handle SONG_STOPPED message
-void handle_song_stopped(JsonObject& payload) {
-    Serial.println("[Main] Song stopped");
+// Log a received response page
+static void log_response_page(const char* kind, uint32_t page, uint32_t totalPages, size_t items) {
+    LOGD(MAIN, "Received %s page %u/%u (%u items)",
+         kind, (unsigned)page, (unsigned)totalPages, (unsigned)items);
+}
 
-    lvgl_port_lock(-1);
-    ui_set_playing(false);
-    lvgl_port_unlock();
+// A song transfer was given up (the version being built is never published): paging on
+// asks for the window again, and a list being opened stops waiting for it
+static void song_transfer_given_up(void) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    bool moves = g_song_fetch_moves;
+    g_song_fetch_open = false;
+    g_song_view.pending = false;
+    xSemaphoreGive(g_transfer_lock);
+    if (!moves) {
+        lvgl_port_lock(-1);
+        ui_refresh_ble_songs();
+        lvgl_port_unlock();
+    }
 }
 
-// Handle PLAYBACK_PROGRESS message
-void handle_playback_progress(JsonObject& payload) {
-    float elapsedTime = payload["elapsedTime"] | 0.0f;
-    bool isPlaying = payload["isPlaying"] | false;
+// Check a response page against its collection's transfer. True if it is next in order
+// and should be applied now; early pages are held (binary ones) and replayed by
+// on_ble_data() once the gap before them fills.
+static bool accept_page(LibraryCollection collection, const PageInfo& info, bool binary) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    PageTracker* transfer = &g_transfers[collection];
+    PageAction action = page_tracker_accept(transfer, &info, binary ? g_rx_message : nullptr,
+                                            binary ? g_rx_length : 0, millis());
+    uint32_t first_item = transfer->first_item;
+    uint32_t item_limit = transfer->item_limit;
+    uint32_t revision = g_transfer_revisions[collection];
+    uint32_t request_id = transfer->request_id;
+    xSemaphoreGive(g_transfer_lock);
+
+    switch (action) {
+    case PAGE_APPLY:
+        return true;
+    case PAGE_HOLD:
+        LOGD(MAIN, "Page %u/%u of collection %d early, held", (unsigned)info.page, (unsigned)info.total_pages,
+             (int)collection);
+        break;
+    case PAGE_DROP:
+        LOGD(MAIN, "Page %u/%u of collection %d early, dropped", (unsigned)info.page, (unsigned)info.total_pages,
+             (int)collection);
+        break;
+    case PAGE_RESTART:
+        // The app's list changed mid-transfer - pages of the old one no longer fit
+        LOGW(MAIN, "Collection %d changed during transfer, asking again", (int)collection);
+        repeat_query(collection, str_or(info.context, ""), info.context_id, first_item, item_limit, revision,
+                     request_id);
+        break;
+    case PAGE_STALE:
+        // Answers a query superseded or cancelled since - dropped before any item is read
+        LOGD(MAIN, "Page %u/%u of collection %d answers request %u, stale", (unsigned)info.page,
+             (unsigned)info.total_pages, (int)collection, (unsigned)info.request_id);
+        break;
+    case PAGE_GIVE_UP:
+        // Pages hold at least one item, so the app ignored the limit asked for
+        LOGE(MAIN, "Collection %d sent in %u pages, more than its %u records fill, giving up", (int)collection,
+             (unsigned)info.total_pages, (unsigned)library_get_capacity(collection));
+        if (collection == LIBRARY_SONGS) song_transfer_given_up();
+        break;
+    case PAGE_DUPLICATE:
+    case PAGE_FOREIGN:
+        break;
+    }
+    return false;
+}
+
+// Record an applied page; true when it completed the transfer
+static bool page_applied(LibraryCollection collection, uint32_t page, size_t items) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    bool complete = page_tracker_applied(&g_transfers[collection], page, (uint32_t)items);
+    xSemaphoreGive(g_transfer_lock);
+    return complete;
+}
+
+void apply_song_started(const AbpSongStarted& msg) {
+    // Fields the message leaves out come from the song list when it holds this song. The
+    // loop task may restore another list meanwhile, so the record is read under its lock.
+    xSemaphoreTake(g_song_write_lock, portMAX_DELAY);
+    const BLESong* known = msg.song_id ? library_get_song_by_id(msg.song_id) : nullptr;
+    const char* title = str_or(msg.title, known ? known->title : "Unknown");
+    const char* artist = str_or(msg.artist, known ? library_song_artist(known) : "Unknown Artist");
+    const char* album = str_or(msg.album, known ? library_song_album(known) : "Unknown Album");
+
+    LOGI(MAIN, "Song started: %s - %s", title, artist);
+
+    // Replaces any progress of the previous song the UI has not taken yet
+    g_last_elapsed_ms = 0;
+    playback_mailbox_publish(0, true, msg.song_id);
 
     lvgl_port_lock(-1);
-    ui_set_progress((uint16_t)elapsedTime);
-    ui_set_playing(isPlaying);
+    ui_set_song_info(title, artist, album, (uint16_t)(msg.duration_ms / 1000));
     lvgl_port_unlock();
+    xSemaphoreGive(g_song_write_lock);
 }
 
-// Handle PLAYLISTS_RESPONSE message
-void handle_playlists_response(JsonObject& payload) {
-    int page = payload["page"] | 1;
-    int totalPages = payload["totalPages"] | 1;
-    JsonArray playlists = payload["playlists"];
+void apply_song_stopped(const AbpSongStopped& msg) {
+    LOGI(MAIN, "Song stopped");
+    playback_mailbox_publish(g_last_elapsed_ms, false, msg.song_id);
+}
+
+// Arrives every 250 ms - no LVGL lock here, the UI picks up the latest value once per frame
+void apply_playback_progress(const AbpPlaybackProgress& msg) {
+    g_last_elapsed_ms = msg.elapsed_ms;
+    playback_mailbox_publish(msg.elapsed_ms, msg.is_playing, msg.song_id);
+}
 
-    Serial.print("[Main] Received playlists page ");
-    Serial.print(page);
-    Serial.print("/");
-    Serial.print(totalPages);
-    Serial.print(" (");
-    Serial.print(playlists.size());
-    Serial.println(" items)");
+// Merge the page into the sorted views and search index of the version being built.
+// The UI cannot see it until library_publish() on the last page, so no LVGL lock.
+static void update_page_indexes(LibraryCollection collection) {
+    library_update_sort_indexes(collection);
+    library_update_search_index(collection);
+}
 
-    // Only clear on first page
-    if (page == 1) {
-        library_clear_playlists();
+// Once playlists, artists and albums have all arrived complete, the store is snapshotted
+// to flash for the next boot
+static void note_collection_synced(LibraryCollection collection) {
+    const uint8_t all = (1 << LIBRARY_PLAYLISTS) | (1 << LIBRARY_ARTISTS) | (1 << LIBRARY_ALBUMS);
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    g_synced_collections |= 1 << collection;
+    bool complete = g_synced_collections == all;
+    if (complete) g_synced_collections = 0;
+    xSemaphoreGive(g_transfer_lock);
+    if (complete) {
+        // Collections a delta left unchanged may still read the old image
+        library_delta_detach_image();
+        library_snapshot_save();
     }
+}
 
-    for (JsonObject pl : playlists) {
-        const char* id = pl["id"] | "";
-        const char* name = pl["name"] | "Unknown";
-        uint16_t songCount = pl["songCount"] | 0;
-        library_add_playlist(id, name, songCount);
+// Revision fields of a playlists, artists or albums page (v1.4)
+typedef struct {
+    uint32_t revision;          // 0 from older apps
+    bool delta;                 // Items are changes since the revision the query named
+} PageRevision;
+
+// Page 1 starts the next version - or, for a delta, the changes to apply to the live one
+static void begin_library_page(LibraryCollection collection, uint32_t page, const PageRevision& rev) {
+    if (page != 1) return;
+    if (rev.delta) {
+        xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+        uint32_t base = g_transfer_revisions[collection];
+        xSemaphoreGive(g_transfer_lock);
+        library_delta_begin(collection, base);
+        return;
     }
+    library_begin_update(collection);
+    library_set_revision(collection, rev.revision);
+}
 
-    if (page == totalPages) {
-        Serial.print("[Main] All playlists received, total: ");
-        Serial.println(library_get_playlist_count());
+static void apply_playlist(const PageRevision& rev, const char* id, const char* name, uint16_t song_count,
+                           bool removed) {
+    if (!rev.delta) library_add_playlist(id, name, song_count);
+    else if (removed) library_delta_remove(LIBRARY_PLAYLISTS, id);
+    else library_delta_put_playlist(id, name, song_count);
+}
+
+static void apply_artist(const PageRevision& rev, const char* id, const char* name, uint16_t album_count,
+                         uint16_t song_count, bool removed) {
+    if (!rev.delta) library_add_artist(id, name, album_count, song_count);
+    else if (removed) library_delta_remove(LIBRARY_ARTISTS, id);
+    else library_delta_put_artist(id, name, album_count, song_count);
+}
+
+static void apply_album(const PageRevision& rev, const char* id, const char* name, const char* artist,
+                        uint16_t song_count, uint16_t year, bool removed) {
+    if (!rev.delta) library_add_album(id, name, artist, song_count, year);
+    else if (removed) library_delta_remove(LIBRARY_ALBUMS, id);
+    else library_delta_put_album(id, name, artist, song_count, year);
+}
+
+static lib_index_t library_count(LibraryCollection collection) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS: return library_get_playlist_count();
+    case LIBRARY_ARTISTS: return library_get_artist_count();
+    case LIBRARY_ALBUMS: return library_get_album_count();
+    default: return library_get_song_count();
     }
 }
 
-// Handle ARTISTS_RESPONSE message
-void handle_artists_response(JsonObject& payload) {
-    int page = payload["page"] | 1;
-    int totalPages = payload["totalPages"] | 1;
-    JsonArray artists = payload["artists"];
+// kind names the collection in the log. The last page publishes the version built, or
+// applies the delta; one that does not fit the live version is asked for again whole.
+static void finish_library_page(LibraryCollection collection, const char* kind, uint32_t page, size_t items,
+                                const PageRevision& rev) {
+    if (!rev.delta) update_page_indexes(collection);
+    if (!page_applied(collection, page, items)) return;
 
-    Serial.print("[Main] Received artists page ");
-    Serial.print(page);
-    Serial.print("/");
-    Serial.print(totalPages);
-    Serial.print(" (");
-    Serial.print(artists.size());
-    Serial.println(" items)");
+    if (!rev.delta) {
+        library_publish(collection);
+        LOGI(MAIN, "All %s received, total: %u", kind, (unsigned)library_count(collection));
+    } else {
+        LibraryDeltaResult result = library_delta_apply(collection, rev.revision);
+        if (result == LIBRARY_DELTA_FAILED) {
+            LOGW(MAIN, "Asking for all %s instead", kind);
+            query_library(collection, 0);
+            return;
+        }
+        LOGI(MAIN, "%s %s at revision %08x, total: %u", kind,
+             result == LIBRARY_DELTA_APPLIED ? "updated" : "unchanged", (unsigned)rev.revision,
+             (unsigned)library_count(collection));
+    }
+    note_collection_synced(collection);
+}
+
+typedef struct {
+    char context[sizeof(g_wanted_context)];
+    char context_id[sizeof(g_wanted_context_id)];
+} SongListId;
+
+// Copy of the song list the UI wants, taken whole (g_transfer_lock not held)
+static SongListId wanted_song_list(void) {
+    SongListId wanted;
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    memcpy(wanted.context, g_wanted_context, sizeof(wanted.context));
+    memcpy(wanted.context_id, g_wanted_context_id, sizeof(wanted.context_id));
+    xSemaphoreGive(g_transfer_lock);
+    return wanted;
+}
+
+static bool is_wanted_context(const char* context, const char* context_id) {
+    SongListId wanted = wanted_song_list();
+    return strcmp(context, wanted.context) == 0 && strcmp(context_id, wanted.context_id) == 0;
+}
+
+// Check once per songs page whether its list is still the one wanted
+static void note_song_page(void) {
+    g_response_wanted = is_wanted_context(g_response_context, g_response_context_id);
+}
 
-    // Only clear on first page
-    if (page == 1) {
-        library_clear_artists();
+// Copy resident songs at list positions [first, first + count) into the version being built
+static void keep_window_songs(uint32_t first, uint32_t count) {
+    uint32_t start = library_get_song_window_start();
+    for (uint32_t i = first; i < first + count; i++) {
+        const BLESong* song = library_get_song((lib_index_t)(i - start));
+        if (song) {
+            library_add_song(song->id, song->title, library_song_artist(song), library_song_album(song),
+                             song->duration_sec, song->track_number);
+        }
+    }
+}
+
+// Songs of the shown window a window response keeps - none if the window moved or the
+// list changed since the fetch was planned
+static SongKeep window_keep(const SongWindowFetch& fetch, const char* context, const char* context_id) {
+    uint32_t start, total;
+    lib_index_t count;
+    library_get_song_window(&start, &count, &total);
+    bool same_list = strcmp(context, library_get_song_context_type()) == 0 &&
+                     strcmp(context_id, library_get_song_context_id()) == 0;
+    if (fetch.keep_count == 0 || !same_list || fetch.keep_start < start ||
+        fetch.keep_start + fetch.keep_count > (uint32_t)start + count) {
+        return {};
     }
+    return {fetch.keep_start, fetch.keep_count, fetch.keep_start < fetch.offset};
+}
 
-    for (JsonObject artist : artists) {
-        const char* id = artist["id"] | "";
-        const char* name = artist["name"] | "Unknown";
-        uint8_t albumCount = artist["albumCount"] | 0;
-        uint16_t songCount = artist["songCount"] | 0;
-        library_add_artist(id, name, albumCount, songCount);
+// First page of a songs response. It loads the library only when it is the list the UI
+// is waiting for; a refresh of the list already shown, or a late answer for a list the
+// user has left, is staged in the cache instead. A window of a long list is never
+// staged - the cache holds whole lists only.
+static void begin_song_list(const PageInfo& info) {
+    const char* context = str_or(info.context, "");
+    const char* context_id = str_or(info.context_id, "");
+    snprintf(g_response_context, sizeof(g_response_context), "%s", context);
+    snprintf(g_response_context_id, sizeof(g_response_context_id), "%s", context_id);
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    SongWindowFetch fetch = g_song_fetch;
+    xSemaphoreGive(g_transfer_lock);
+
+    bool whole = fetch.limit == 0 || info.total_items <= fetch.limit;
+    bool wanted = is_wanted_context(context, context_id);
+    bool shown = strcmp(context, library_get_song_context_type()) == 0 &&
+                 strcmp(context_id, library_get_song_context_id()) == 0;
+    g_songs_staged = whole && (!wanted || shown) && song_cache_stage_begin(context, context_id);
+    g_song_keep = {};
+    if (g_songs_staged || !wanted) return;
+
+    if (!whole) g_song_keep = window_keep(fetch, context, context_id);
+    library_begin_update(LIBRARY_SONGS);
+    library_set_song_context(context, context_id);
+    if (!whole) {
+        library_set_song_window(g_song_keep.before ? g_song_keep.start : info.offset, info.total_items);
     }
+    if (g_song_keep.before) keep_window_songs(g_song_keep.start, g_song_keep.count);
+}
 
-    if (page == totalPages) {
-        Serial.print("[Main] All artists received, total: ");
-        Serial.println(library_get_artist_count());
+static void add_song(const char* id, const char* title, const char* artist, const char* album, uint16_t duration,
+                     uint8_t track) {
+    if (g_songs_staged) {
+        song_cache_stage_add(id, title, artist, album, duration, track);
+    } else if (g_response_wanted) {
+        library_add_song(id, title, artist, album, duration, track);
+    }
+    // Otherwise the user opened another list mid-response - the rest of this one is dropped
+}
+
+// The window query answered is published (or dropped) - the next one may go out
+static void close_song_fetch(void) {
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    g_song_fetch_open = false;
+    xSemaphoreGive(g_transfer_lock);
+}
+
+void finish_songs_page(uint32_t page, size_t items) {
+    if (!g_songs_staged) update_page_indexes(LIBRARY_SONGS);
+    if (!page_applied(LIBRARY_SONGS, page, items)) return;
+
+    // Only refresh UI after last page
+    if (!g_songs_staged) {
+        if (!is_wanted_context(g_response_context, g_response_context_id)) {
+            close_song_fetch();
+            return;
+        }
+        if (g_song_keep.count > 0 && !g_song_keep.before) {
+            keep_window_songs(g_song_keep.start, g_song_keep.count);
+            update_page_indexes(LIBRARY_SONGS);
+        }
+        library_publish(LIBRARY_SONGS);
+        uint32_t start, total;
+        lib_index_t count;
+        library_get_song_window(&start, &count, &total);
+        if (count == total) {
+            LOGI(MAIN, "All songs received, total: %u", (unsigned)count);
+        } else {
+            LOGI(MAIN, "Songs %u-%u of %u received", (unsigned)start, (unsigned)(start + count), (unsigned)total);
+        }
+        song_cache_store_current();
+        close_song_fetch();
+
+        // Redrawn only while the user is still on it - a list left mid-transfer must not
+        // pull them back once it finishes
+        lvgl_port_lock(-1);
+        ui_refresh_ble_songs();
+        lvgl_port_unlock();
+        return;
+    }
+
+    // Revalidation: the list on screen is only replaced if the app's copy changed
+    bool show = is_wanted_context(library_get_song_context_type(), library_get_song_context_id());
+    if (song_cache_stage_commit(show) && show) {
+        LOGI(MAIN, "Song list changed, total: %u", (unsigned)library_get_song_count());
+        lvgl_port_lock(-1);
+        ui_refresh_ble_songs();
+        lvgl_port_unlock();
     }
+    g_songs_staged = false;
+    close_song_fetch();
+}
+
+// ============================================================================
+// JSON messages
+// ============================================================================
+
+// Handle SONG_STARTED message
+void handle_song_started(JsonObject& payload) {
+    AbpSongStarted msg = {};
+    msg.song_id = payload["songId"];
+    msg.title = payload["title"];
+    msg.artist = payload["artist"];
+    msg.album = payload["album"];
+    msg.duration_ms = (uint32_t)((payload["duration"] | 0.0f) * 1000);
+    apply_song_started(msg);
 }
 
-// Handle ALBUMS_RESPONSE message
-void handle_albums_response(JsonObject& payload) {
-    int page = payload["page"] | 1;
-    int totalPages = payload["totalPages"] | 1;
-    JsonArray albums = payload["albums"];
+// Handle SONG_STOPPED message
+void handle_song_stopped(JsonObject& payload) {
+    AbpSongStopped msg = {};
+    msg.song_id = payload["songId"];
+    apply_song_stopped(msg);
+}
 
-    Serial.print("[Main] Received albums page ");
-    Serial.print(page);
-    Serial.print("/");
-    Serial.print(totalPages);
-    Serial.print(" (");
-    Serial.print(albums.size());
-    Serial.println(" items)");
+// Handle PLAYBACK_PROGRESS message
+void handle_playback_progress(JsonObject& payload) {
+    AbpPlaybackProgress msg = {};
+    msg.song_id = payload["songId"];
+    msg.elapsed_ms = (uint32_t)((payload["elapsedTime"] | 0.0f) * 1000);
+    msg.is_playing = payload["isPlaying"] | false;
+    apply_playback_progress(msg);
+}
 
-    // Only clear on first page
-    if (page == 1) {
-        library_clear_albums();
+// ============================================================================
+// JSON library pages - streamed one record at a time, no document is built
+// ============================================================================
+
+// Page fields of a *_RESPONSE payload and where its item array starts
+typedef struct {
+    uint32_t page;
+    uint32_t total_pages;
+    uint32_t total_items;       // 0 = not sent (before v1.2)
+    uint32_t offset;
+    PageRevision revision;      // Playlists, artists and albums (v1.4)
+    const char* context;
+    const char* context_id;
+    uint32_t request_id;        // 0 = not sent (before v1.6)
+    size_t items_pos;           // 0 = no item array
+    bool in_items;              // Second pass started
+} PageHeader;
+
+// First pass: read the page fields, which may come after the items, and note where the
+// items start. The items themselves are skipped without touching the buffer. Dispatch
+// stopped at "type", which the app sends first, so this is the first walk over the page.
+static bool read_page_header(JsonPull* p, const char* items_key, PageHeader* header) {
+    *header = {1, 1, 0, 0, {0, false}, "", "", 0, 0, false};
+    if (!json_pull_find(p, "payload") || !json_pull_object_begin(p)) return false;
+
+    const char* key;
+    while (json_pull_object_next(p, &key)) {
+        if (strcmp(key, "page") == 0) {
+            header->page = (uint32_t)json_pull_number_or(p, 1);
+        } else if (strcmp(key, "totalPages") == 0) {
+            header->total_pages = (uint32_t)json_pull_number_or(p, 1);
+        } else if (strcmp(key, "totalItems") == 0) {
+            header->total_items = (uint32_t)json_pull_number_or(p, 0);
+        } else if (strcmp(key, "offset") == 0) {
+            header->offset = (uint32_t)json_pull_number_or(p, 0);
+        } else if (strcmp(key, "revision") == 0) {
+            header->revision.revision = (uint32_t)json_pull_number_or(p, 0);
+        } else if (strcmp(key, "delta") == 0) {
+            header->revision.delta = json_pull_bool_or(p, false);
+        } else if (strcmp(key, "context") == 0) {
+            header->context = json_pull_string_or(p, "");
+        } else if (strcmp(key, "contextId") == 0) {
+            header->context_id = json_pull_string_or(p, "");
+        } else if (strcmp(key, "requestId") == 0) {
+            header->request_id = (uint32_t)json_pull_number_or(p, 0);
+        } else {
+            if (strcmp(key, items_key) == 0 && json_pull_peek(p) == JSON_PULL_ARRAY) {
+                header->items_pos = p->pos;
+            }
+            json_pull_skip(p);
+        }
     }
+    return !p->error;
+}
+
+// Tracker view of the header; JSON pages are not held - the header pass has rewritten the
+// buffer - so an early one is dropped and asked for again
+static bool accept_json_page(LibraryCollection collection, const PageHeader* header) {
+    PageInfo info = {header->page, header->total_pages, header->total_items, header->offset,
+                     collection == LIBRARY_SONGS ? header->context : nullptr,
+                     collection == LIBRARY_SONGS ? header->context_id : nullptr, header->request_id};
+    return accept_page(collection, info, false);
+}
 
-    for (JsonObject album : albums) {
-        const char* id = album["id"] | "";
-        const char* name = album["name"] | "Unknown";
-        const char* artist = album["artist"] | "Unknown";
-        uint8_t songCount = album["songCount"] | 0;
-        uint16_t year = album["year"] | 0;
-        library_add_album(id, name, artist, songCount, year);
+// Second pass: position on the next item object, false after the last one. The header
+// pass left the reader past the payload, so the first call goes back to the items.
+static bool next_page_item(JsonPull* p, PageHeader* header) {
+    if (header->items_pos == 0) return false;
+    if (!header->in_items) {
+        header->in_items = true;
+        p->pos = header->items_pos;
+        if (!json_pull_array_begin(p)) return false;
     }
+    while (json_pull_array_next(p)) {
+        if (json_pull_peek(p) == JSON_PULL_OBJECT) {
+            return json_pull_object_begin(p);
+        }
+        json_pull_skip(p);
+    }
+    return false;
+}
 
-    if (page == totalPages) {
-        Serial.print("[Main] All albums received, total: ");
-        Serial.println(library_get_album_count());
+// Stream PLAYLISTS_RESPONSE
+bool stream_playlists_response(char* data, size_t length) {
+    JsonPull p;
+    json_pull_init(&p, data, length);
+    PageHeader header;
+    if (!read_page_header(&p, "playlists", &header)) return false;
+    if (!accept_json_page(LIBRARY_PLAYLISTS, &header)) return true;
+
+    // A sync builds the next version, live once its last page is in
+    begin_library_page(LIBRARY_PLAYLISTS, header.page, header.revision);
+
+    size_t items = 0;
+    while (next_page_item(&p, &header)) {
+        const char* id = "";
+        const char* name = "Unknown";
+        uint16_t songCount = 0;
+        bool removed = false;
+        const char* key;
+        while (json_pull_object_next(&p, &key)) {
+            if (strcmp(key, "id") == 0) id = json_pull_string_or(&p, "");
+            else if (strcmp(key, "name") == 0) name = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "songCount") == 0) songCount = (uint16_t)json_pull_number_or(&p, 0);
+            else if (strcmp(key, "removed") == 0) removed = json_pull_bool_or(&p, false);
+            else json_pull_skip(&p);
+        }
+        if (p.error) return false;
+        apply_playlist(header.revision, id, name, songCount, removed);
+        items++;
     }
+
+    log_response_page("playlists", header.page, header.total_pages, items);
+    finish_library_page(LIBRARY_PLAYLISTS, "playlists", header.page, items, header.revision);
+    return !p.error;
 }
 
-// Handle SONGS_RESPONSE message
-void handle_songs_response(JsonObject& payload) {
-    int page = payload["page"] | 1;
-    int totalPages = payload["totalPages"] | 1;
-    JsonArray songs = payload["songs"];
+// Stream ARTISTS_RESPONSE
+bool stream_artists_response(char* data, size_t length) {
+    JsonPull p;
+    json_pull_init(&p, data, length);
+    PageHeader header;
+    if (!read_page_header(&p, "artists", &header)) return false;
+    if (!accept_json_page(LIBRARY_ARTISTS, &header)) return true;
+
+    // A sync builds the next version, live once its last page is in
+    begin_library_page(LIBRARY_ARTISTS, header.page, header.revision);
+
+    size_t items = 0;
+    while (next_page_item(&p, &header)) {
+        const char* id = "";
+        const char* name = "Unknown";
+        uint16_t albumCount = 0;
+        uint16_t songCount = 0;
+        bool removed = false;
+        const char* key;
+        while (json_pull_object_next(&p, &key)) {
+            if (strcmp(key, "id") == 0) id = json_pull_string_or(&p, "");
+            else if (strcmp(key, "name") == 0) name = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "albumCount") == 0) albumCount = (uint16_t)json_pull_number_or(&p, 0);
+            else if (strcmp(key, "songCount") == 0) songCount = (uint16_t)json_pull_number_or(&p, 0);
+            else if (strcmp(key, "removed") == 0) removed = json_pull_bool_or(&p, false);
+            else json_pull_skip(&p);
+        }
+        if (p.error) return false;
+        apply_artist(header.revision, id, name, albumCount, songCount, removed);
+        items++;
+    }
 
-    Serial.print("[Main] Received songs page ");
-    Serial.print(page);
-    Serial.print("/");
-    Serial.print(totalPages);
-    Serial.print(" (");
-    Serial.print(songs.size());
-    Serial.println(" items)");
+    log_response_page("artists", header.page, header.total_pages, items);
+    finish_library_page(LIBRARY_ARTISTS, "artists", header.page, items, header.revision);
+    return !p.error;
+}
+
+// Stream ALBUMS_RESPONSE
+bool stream_albums_response(char* data, size_t length) {
+    JsonPull p;
+    json_pull_init(&p, data, length);
+    PageHeader header;
+    if (!read_page_header(&p, "albums", &header)) return false;
+    if (!accept_json_page(LIBRARY_ALBUMS, &header)) return true;
+
+    // A sync builds the next version, live once its last page is in
+    begin_library_page(LIBRARY_ALBUMS, header.page, header.revision);
+
+    size_t items = 0;
+    while (next_page_item(&p, &header)) {
+        const char* id = "";
+        const char* name = "Unknown";
+        const char* artist = "Unknown";
+        uint16_t songCount = 0;
+        uint16_t year = 0;
+        bool removed = false;
+        const char* key;
+        while (json_pull_object_next(&p, &key)) {
+            if (strcmp(key, "id") == 0) id = json_pull_string_or(&p, "");
+            else if (strcmp(key, "name") == 0) name = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "artist") == 0) artist = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "songCount") == 0) songCount = (uint16_t)json_pull_number_or(&p, 0);
+            else if (strcmp(key, "year") == 0) year = (uint16_t)json_pull_number_or(&p, 0);
+            else if (strcmp(key, "removed") == 0) removed = json_pull_bool_or(&p, false);
+            else json_pull_skip(&p);
+        }
+        if (p.error) return false;
+        apply_album(header.revision, id, name, artist, songCount, year, removed);
+        items++;
+    }
+
+    log_response_page("albums", header.page, header.total_pages, items);
+    finish_library_page(LIBRARY_ALBUMS, "albums", header.page, items, header.revision);
+    return !p.error;
+}
+
+// Stream SONGS_RESPONSE (g_song_write_lock held)
+static bool stream_song_page(char* data, size_t length) {
+    JsonPull p;
+    json_pull_init(&p, data, length);
+    PageHeader header;
+    if (!read_page_header(&p, "songs", &header)) return false;
+    if (!accept_json_page(LIBRARY_SONGS, &header)) return true;
 
     // Only clear and set context on first page
-    if (page == 1) {
-        library_clear_songs();
-        const char* context = payload["context"] | "";
-        const char* contextId = payload["contextId"] | "";
-        library_set_song_context(context, contextId);
+    if (header.page == 1) {
+        begin_song_list({header.page, header.total_pages, header.total_items, header.offset, header.context,
+                         header.context_id, header.request_id});
     }
+    note_song_page();
+
+    size_t items = 0;
+    while (next_page_item(&p, &header)) {
+        const char* id = "";
+        const char* title = "Unknown";
+        const char* artist = "Unknown";
+        const char* album = "Unknown";
+        double duration = 0;
+        uint8_t trackNumber = 0;
+        const char* key;
+        while (json_pull_object_next(&p, &key)) {
+            if (strcmp(key, "id") == 0) id = json_pull_string_or(&p, "");
+            else if (strcmp(key, "title") == 0) title = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "artist") == 0) artist = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "album") == 0) album = json_pull_string_or(&p, "Unknown");
+            else if (strcmp(key, "duration") == 0) duration = json_pull_number_or(&p, 0);
+            else if (strcmp(key, "trackNumber") == 0) trackNumber = (uint8_t)json_pull_number_or(&p, 0);
+            else json_pull_skip(&p);
+        }
+        if (p.error) return false;
+        add_song(id, title, artist, album, (uint16_t)duration, trackNumber);
+        items++;
+    }
+
+    log_response_page("songs", header.page, header.total_pages, items);
+    finish_songs_page(header.page, items);
+    return !p.error;
+}
+
+bool stream_songs_response(char* data, size_t length) {
+    xSemaphoreTake(g_song_write_lock, portMAX_DELAY);
+    bool ok = stream_song_page(data, length);
+    xSemaphoreGive(g_song_write_lock);
+    return ok;
+}
 
-    for (JsonObject song : songs) {
-        const char* id = song["id"] | "";
-        const char* title = song["title"] | "Unknown";
-        const char* artist = song["artist"] | "Unknown";
-        const char* album = song["album"] | "Unknown";
-        float duration = song["duration"] | 0.0f;
-        uint8_t trackNumber = song["trackNumber"] | 0;
-        library_add_song(id, title, artist, album, (uint16_t)duration, trackNumber);
+// ============================================================================
+// Binary (TLV) messages - decoded in place, no JSON document involved
+// ============================================================================
+
+void handle_playlists_binary(const AbpPlaylistsResponse& msg) {
+    log_response_page("playlists", msg.page, msg.total_pages, msg.playlists.count);
+    PageInfo info = {msg.page, msg.total_pages, msg.total_items, msg.offset, nullptr, nullptr, msg.request_id};
+    if (!accept_page(LIBRARY_PLAYLISTS, info, true)) return;
+    PageRevision rev = {msg.revision, msg.delta};
+    begin_library_page(LIBRARY_PLAYLISTS, msg.page, rev);
+
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&msg.playlists, &pos, &item, &item_length)) {
+        AbpPlaylistInfo pl;
+        if (abp_decode_playlist_info(item, item_length, &pl)) {
+            apply_playlist(rev, str_or(pl.id, ""), str_or(pl.name, "Unknown"), pl.song_count, pl.removed);
+        }
     }
 
-    // Only refresh UI after last page
-    if (page == totalPages) {
-        Serial.print("[Main] All songs received, total: ");
-        Serial.println(library_get_song_count());
+    finish_library_page(LIBRARY_PLAYLISTS, "playlists", msg.page, msg.playlists.count, rev);
+}
 
-        lvgl_port_lock(-1);
-        ui_show_ble_songs();
-        lvgl_port_unlock();
+void handle_artists_binary(const AbpArtistsResponse& msg) {
+    log_response_page("artists", msg.page, msg.total_pages, msg.artists.count);
+    PageInfo info = {msg.page, msg.total_pages, msg.total_items, msg.offset, nullptr, nullptr, msg.request_id};
+    if (!accept_page(LIBRARY_ARTISTS, info, true)) return;
+    PageRevision rev = {msg.revision, msg.delta};
+    begin_library_page(LIBRARY_ARTISTS, msg.page, rev);
+
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&msg.artists, &pos, &item, &item_length)) {
+        AbpArtistInfo artist;
+        if (abp_decode_artist_info(item, item_length, &artist)) {
+            apply_artist(rev, str_or(artist.id, ""), str_or(artist.name, "Unknown"), artist.album_count,
+                         artist.song_count, artist.removed);
+        }
     }
+
+    finish_library_page(LIBRARY_ARTISTS, "artists", msg.page, msg.artists.count, rev);
 }
 
-// Bluetooth data callback - receives JSON from Amperfy app
-void on_ble_data(const char* data, size_t length) {
-    // Print raw data received
-    Serial.println("\n========== BLE DATA RECEIVED ==========");
-    Serial.print("Length: ");
-    Serial.print(length);
-    Serial.println(" bytes");
-    Serial.println("Raw JSON:");
-    Serial.println(data);
-    Serial.println("========================================\n");
+void handle_albums_binary(const AbpAlbumsResponse& msg) {
+    log_response_page("albums", msg.page, msg.total_pages, msg.albums.count);
+    PageInfo info = {msg.page, msg.total_pages, msg.total_items, msg.offset, nullptr, nullptr, msg.request_id};
+    if (!accept_page(LIBRARY_ALBUMS, info, true)) return;
+    PageRevision rev = {msg.revision, msg.delta};
+    begin_library_page(LIBRARY_ALBUMS, msg.page, rev);
+
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&msg.albums, &pos, &item, &item_length)) {
+        AbpAlbumInfo album;
+        if (abp_decode_album_info(item, item_length, &album)) {
+            apply_album(rev, str_or(album.id, ""), str_or(album.name, "Unknown"), str_or(album.artist, "Unknown"),
+                        album.song_count, album.year, album.removed);
+        }
+    }
 
-    // Parse JSON - use larger buffer for library responses
-    StaticJsonDocument<4096> doc;
-    DeserializationError error = deserializeJson(doc, data, length);
+    finish_library_page(LIBRARY_ALBUMS, "albums", msg.page, msg.albums.count, rev);
+}
 
-    if (error) {
-        Serial.print("[Main] JSON parse error: ");
-        Serial.println(error.c_str());
+// g_song_write_lock held
+static void apply_song_page(const AbpSongsResponse& msg) {
+    log_response_page("songs", msg.page, msg.total_pages, msg.songs.count);
+    PageInfo info = {msg.page, msg.total_pages, msg.total_items, msg.offset, str_or(msg.context, ""),
+                     str_or(msg.context_id, ""), msg.request_id};
+    if (!accept_page(LIBRARY_SONGS, info, true)) return;
+    if (msg.page == 1) {
+        begin_song_list(info);
+    }
+    note_song_page();
+
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&msg.songs, &pos, &item, &item_length)) {
+        AbpSongInfo song;
+        if (abp_decode_song_info(item, item_length, &song)) {
+            add_song(str_or(song.id, ""), str_or(song.title, "Unknown"), str_or(song.artist, "Unknown"),
+                     str_or(song.album, "Unknown"), (uint16_t)(song.duration_ms / 1000), song.track_number);
+        }
+    }
+
+    finish_songs_page(msg.page, msg.songs.count);
+}
+
+void handle_songs_binary(const AbpSongsResponse& msg) {
+    xSemaphoreTake(g_song_write_lock, portMAX_DELAY);
+    apply_song_page(msg);
+    xSemaphoreGive(g_song_write_lock);
+}
+
+// Adapter from the dispatch registry to a shared handler: decode the body into its struct, then apply it
+#define BINARY_HANDLER(snake, Struct, handler) \
+    static bool binary_##snake(const uint8_t* body, size_t length) { \
+        Struct msg; \
+        if (!abp_decode_##snake(body, length, &msg)) return false; \
+        abp_dispatch_mark_parsed(); \
+        handler(msg); \
+        return true; \
+    }
+
+BINARY_HANDLER(song_started, AbpSongStarted, apply_song_started)
+BINARY_HANDLER(song_stopped, AbpSongStopped, apply_song_stopped)
+BINARY_HANDLER(playback_progress, AbpPlaybackProgress, apply_playback_progress)
+BINARY_HANDLER(playlists_response, AbpPlaylistsResponse, handle_playlists_binary)
+BINARY_HANDLER(artists_response, AbpArtistsResponse, handle_artists_binary)
+BINARY_HANDLER(albums_response, AbpAlbumsResponse, handle_albums_binary)
+BINARY_HANDLER(songs_response, AbpSongsResponse, handle_songs_binary)
+
+#undef BINARY_HANDLER
+
+// Fields each JSON handler reads - everything else is skipped while parsing
+static const char* CAPABILITIES_FILTER =
+    R"({"payload":{"protocolVersion":true,"encoding":true,"pageBudget":true}})";
+static const char* SONG_STARTED_FILTER =
+    R"({"payload":{"songId":true,"title":true,"artist":true,"album":true,"duration":true}})";
+static const char* SONG_STOPPED_FILTER =
+    R"({"payload":{"songId":true}})";
+static const char* PLAYBACK_PROGRESS_FILTER =
+    R"({"payload":{"songId":true,"elapsedTime":true,"isPlaying":true}})";
+// Message types the display handles - new types only need a line here
+void register_message_handlers() {
+    ABP_DISPATCH_REGISTER(CAPABILITIES, handle_capabilities, nullptr, CAPABILITIES_FILTER);
+    ABP_DISPATCH_REGISTER(SONG_STARTED, handle_song_started, binary_song_started, SONG_STARTED_FILTER);
+    ABP_DISPATCH_REGISTER(SONG_STOPPED, handle_song_stopped, binary_song_stopped, SONG_STOPPED_FILTER);
+    ABP_DISPATCH_REGISTER(PLAYBACK_PROGRESS, handle_playback_progress, binary_playback_progress,
+                          PLAYBACK_PROGRESS_FILTER);
+    ABP_DISPATCH_REGISTER_STREAM(PLAYLISTS_RESPONSE, stream_playlists_response, binary_playlists_response);
+    ABP_DISPATCH_REGISTER_STREAM(ARTISTS_RESPONSE, stream_artists_response, binary_artists_response);
+    ABP_DISPATCH_REGISTER_STREAM(ALBUMS_RESPONSE, stream_albums_response, binary_albums_response);
+    ABP_DISPATCH_REGISTER_STREAM(SONGS_RESPONSE, stream_songs_response, binary_songs_response);
+}
+
+// Route a binary message, noting it so a response page that arrived early can be held
+static void dispatch_binary(const uint8_t* data, size_t length) {
+    g_rx_message = data;
+    g_rx_length = length;
+    abp_dispatch_binary(data, length);
+    g_rx_message = nullptr;
+    g_rx_length = 0;
+}
+
+// Replay held pages that are next in order now that the page before them was applied
+static void replay_held_pages(void) {
+    for (PageTracker& transfer : g_transfers) {
+        while (true) {
+            HeldPage held;
+            xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+            bool ready = page_tracker_take_ready(&transfer, &held);
+            xSemaphoreGive(g_transfer_lock);
+            if (!ready) break;
+            dispatch_binary(held.data, held.length);
+            page_tracker_release(&held);
+        }
+    }
+}
+
+// Bluetooth data callback - receives messages from Amperfy app (runs on the protocol task)
+// The buffer is parsed in place, so the library records are the only copy of each string
+void on_ble_data(char* data, size_t length) {
+    if (abp_is_binary((const uint8_t*)data, length)) {
+        dispatch_binary((const uint8_t*)data, length);
+        replay_held_pages();
         return;
     }
 
-    const char* type = doc["type"] | "";
-    JsonObject payload = doc["payload"];
-
-    if (strcmp(type, "SONG_STARTED") == 0) {
-        handle_song_started(payload);
-    } else if (strcmp(type, "SONG_STOPPED") == 0) {
-        handle_song_stopped(payload);
-    } else if (strcmp(type, "PLAYBACK_PROGRESS") == 0) {
-        handle_playback_progress(payload);
-    } else if (strcmp(type, "PLAYLISTS_RESPONSE") == 0) {
-        handle_playlists_response(payload);
-    } else if (strcmp(type, "ARTISTS_RESPONSE") == 0) {
-        handle_artists_response(payload);
-    } else if (strcmp(type, "ALBUMS_RESPONSE") == 0) {
-        handle_albums_response(payload);
-    } else if (strcmp(type, "SONGS_RESPONSE") == 0) {
-        handle_songs_response(payload);
-    } else {
-        Serial.print("[Main] Unknown message type: ");
-        Serial.println(type);
+    // Head of the raw message (before parsing, which rewrites the buffer) - debug builds only
+    LOGD(MAIN, "RX %u bytes: %.*s", (unsigned)length, APP_LOG_LINE_SIZE, data);
+
+    // Zero-copy filtered parsing only stores slots for the kept fields, so this stays small
+    static StaticJsonDocument<JSON_DOC_SIZE> doc;
+    abp_dispatch_json(data, length, doc);
+}
+
+// Ask again for pages that stopped arriving; a transfer that never completes is given up
+// so its screen does not wait forever (loop task)
+static void check_transfers(void) {
+    for (int c = 0; c < LIBRARY_COLLECTION_COUNT; c++) {
+        PageTracker* transfer = &g_transfers[c];
+        PageRange ranges[PAGE_TRACKER_MAX_RANGES];
+        int range_count = 0;
+        char context[PAGE_TRACKER_CONTEXT_SIZE];
+        char context_id[PAGE_TRACKER_CONTEXT_ID_SIZE];
+
+        xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+        PagePollResult result = page_tracker_poll(transfer, millis(), ranges, &range_count);
+        memcpy(context, transfer->context, sizeof(context));
+        memcpy(context_id, transfer->context_id, sizeof(context_id));
+        uint32_t first_item = transfer->first_item;
+        uint32_t item_limit = transfer->item_limit;
+        uint32_t revision = g_transfer_revisions[c];
+        uint32_t request_id = transfer->request_id;
+        xSemaphoreGive(g_transfer_lock);
+
+        LibraryCollection collection = (LibraryCollection)c;
+        const char* query_type = collection_query(collection, context);
+        if (result == PAGE_POLL_RETRY) {
+            if (range_count == 0) {
+                LOGW(MAIN, "No answer to %s, asking again", query_type);
+                repeat_query(collection, context, context_id, first_item, item_limit, revision, request_id);
+            }
+            for (int i = 0; i < range_count; i++) {
+                LOGW(MAIN, "%s pages %u-%u missing, asking again", query_type, (unsigned)ranges[i].first,
+                     (unsigned)ranges[i].last);
+                repeat_query(collection, context, context_id, first_item, item_limit, revision, request_id,
+                             ranges[i].first, ranges[i].last);
+            }
+        } else if (result == PAGE_POLL_FAILED) {
+            // The version being built is never published; the next sync starts it over
+            LOGE(MAIN, "%s did not complete, giving up", query_type);
+            if (collection == LIBRARY_SONGS) song_transfer_given_up();
+        }
+    }
+}
+
+// Open the song list the UI asked for (loop task). A cached copy shows at once; the app is
+// asked for the list either way, to revalidate it. Nothing to restore if the library
+// already holds (or is loading) this list.
+static void check_song_open(void) {
+    char context[sizeof(g_wanted_context)];
+    char context_id[sizeof(g_wanted_context_id)];
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    bool pending = g_song_open_pending;
+    g_song_open_pending = false;
+    memcpy(context, g_wanted_context, sizeof(context));
+    memcpy(context_id, g_wanted_context_id, sizeof(context_id));
+    xSemaphoreGive(g_transfer_lock);
+    if (!pending) return;
+
+    xSemaphoreTake(g_song_write_lock, portMAX_DELAY);
+    bool loaded = strcmp(context, library_get_song_context_type()) == 0 &&
+                  strcmp(context_id, library_get_song_context_id()) == 0;
+    if (!loaded) {
+        if (song_cache_restore(context, context_id)) {
+            LOGD(MAIN, "Songs of %s %s from cache, revalidating", context, context_id);
+        } else {
+            library_clear_songs();      // Loading... until the first page arrives
+        }
+    }
+    xSemaphoreGive(g_song_write_lock);
+    if (!loaded) {
+        lvgl_port_lock(-1);
+        ui_refresh_ble_songs();
+        lvgl_port_unlock();
+    }
+
+    // A long list opens with its first chunk only
+    SongWindowFetch fetch;
+    song_window_first(&fetch);
+    query_collection(LIBRARY_SONGS, collection_query(LIBRARY_SONGS, context), context, context_id, &fetch);
+}
+
+// Move the song window toward the rows last shown, one window query at a time; rows
+// paged to while one is out are caught up with once it is published (loop task)
+static void check_song_window(void) {
+    if (!g_song_windows) return;
+    // The rows shown and the list they belong to, as the UI last set them
+    SongListId wanted;
+    xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+    SongView view = g_song_view;
+    bool busy = g_song_fetch_open || g_transfers[LIBRARY_SONGS].active;
+    memcpy(wanted.context, g_wanted_context, sizeof(wanted.context));
+    memcpy(wanted.context_id, g_wanted_context_id, sizeof(wanted.context_id));
+    xSemaphoreGive(g_transfer_lock);
+    if (!view.pending || busy) return;
+
+    // Still opening the list (or another one is shown) - its first chunk comes first.
+    // Pages replace the list on the protocol task, so it is read under their lock.
+    xSemaphoreTake(g_song_write_lock, portMAX_DELAY);
+    bool shown = strcmp(wanted.context, library_get_song_context_type()) == 0 &&
+                 strcmp(wanted.context_id, library_get_song_context_id()) == 0;
+    uint32_t start, total;
+    lib_index_t count;
+    library_get_song_window(&start, &count, &total);
+    xSemaphoreGive(g_song_write_lock);
+    if (!shown) return;
+    SongWindow window = {start, count, total};
+    SongWindowFetch fetch;
+    if (!song_window_plan(&window, view.first, view.visible, view.direction, &fetch)) {
+        xSemaphoreTake(g_transfer_lock, portMAX_DELAY);
+        if (g_song_view.first == view.first) g_song_view.pending = false;
+        xSemaphoreGive(g_transfer_lock);
+        return;
     }
+    LOGD(MAIN, "Song window %u-%u of %u, asking for %u-%u", (unsigned)start, (unsigned)(start + count),
+         (unsigned)total, (unsigned)fetch.offset, (unsigned)(fetch.offset + fetch.limit));
+    query_collection(LIBRARY_SONGS, collection_query(LIBRARY_SONGS, wanted.context), wanted.context,
+                     wanted.context_id, &fetch, true);
 }
 
 void setup()
 {
     Serial.begin(115200);
+    app_log_init();
 
     Serial.println("Initializing board");
     Board *board = new Board();
@@ -360,6 +1546,10 @@ void setup()
 #endif
     assert(board->begin());
 
+    /* Before the LVGL task starts - UI callbacks take these from the first frame */
+    g_transfer_lock = xSemaphoreCreateMutex();
+    g_song_write_lock = xSemaphoreCreateMutex();
+
     Serial.println("Initializing LVGL");
     lvgl_port_init(board->getLCD(), board->getTouch());
 
@@ -374,19 +1564,36 @@ void setup()
     ui_set_query_callback(on_ui_query);
     ui_set_play_callback(on_ui_play);
     ui_set_command_callback(on_ui_command);
+    ui_set_song_window_callback(on_ui_song_window);
+    ui_set_songs_closed_callback(on_ui_songs_closed);
 
     /* Release the mutex */
     lvgl_port_unlock();
 
-    /* Initialize library data storage */
+    /* Initialize library data storage (PSRAM arenas, default capacities) */
     library_data_init();
+    library_delta_init();
+    song_cache_init();
     library_load_selections();  // Load last selected indices from NVS
 
+    /* Last synced library from flash, attached in place - the lists work before the app connects */
+    if (library_snapshot_init() && library_snapshot_load()) {
+        LOGI(MAIN, "Library ready from flash %lu ms after boot", millis());
+    }
+
     /* Initialize Bluetooth */
     Serial.println("Initializing Bluetooth");
+    for (int c = 0; c < LIBRARY_COLLECTION_COUNT; c++) {
+        // A page holds at least one item, so a transfer has at most capacity pages
+        if (!page_tracker_init(&g_transfers[c], library_get_capacity((LibraryCollection)c))) {
+            LOGE(MAIN, "No memory to track pages of collection %d", c);
+        }
+    }
+    register_message_handlers();
     bluetooth_init("Amperfy-ESP32");
     bluetooth_set_connection_callback(on_ble_connection);
     bluetooth_set_data_callback(on_ble_data);
+    bluetooth_set_subscribe_callback(on_ble_subscribe);
 
     Serial.println("Setup complete!");
 }
@@ -396,17 +1603,56 @@ void loop()
     /* Handle Bluetooth events */
     bluetooth_update();
 
-    /* Send library queries after connection (with delay for app to be ready) */
+    /* Send library queries once the app answered HELLO (or after a delay for older apps) */
     if (g_should_query_library && bluetooth_is_connected()) {
         unsigned long elapsed = millis() - g_connection_time;
-        if (elapsed >= QUERY_DELAY_MS) {
+        if (g_app_ready || elapsed >= QUERY_DELAY_MS) {
             g_should_query_library = false;
-            Serial.print("[Main] Sending library queries after ");
-            Serial.print(elapsed);
-            Serial.println("ms delay");
+            LOGI(MAIN, "Sending library queries after %lums%s", elapsed,
+                 g_app_ready ? " (handshake done)" : " delay");
             send_library_queries();
         }
     }
 
+    /* A song list the UI opened - from the cache even while disconnected */
+    check_song_open();
+
+    /* Missing pages of library responses, and the song window following the screen */
+    if (bluetooth_is_connected()) {
+        check_transfers();
+        check_song_window();
+    }
+
+    /* Per-message-type cost, alongside the link stats bluetooth_update() logs */
+    if (bluetooth_is_connected() && millis() - g_last_dispatch_stats_ms >= BLE_STATS_INTERVAL_MS) {
+        g_last_dispatch_stats_ms = millis();
+        abp_dispatch_log_stats();
+        library_log_store_stats();
+        song_cache_log_stats();
+        library_delta_log_stats();
+        library_snapshot_log_stats();
+
+        PageTrackerStats transfers = {};
+        for (const PageTracker& transfer : g_transfers) {
+            page_tracker_add_stats(&transfer, &transfers);
+        }
+        LOGI(MAIN, "Transfers: %u started, %u completed, %u failed, timeouts=%u retransmits=%u (%u pages) "
+             "held=%u dropped=%u duplicates=%u stale=%u restarts=%u",
+             (unsigned)transfers.transfers, (unsigned)transfers.completed, (unsigned)transfers.failed,
+             (unsigned)transfers.timeouts, (unsigned)transfers.retransmits, (unsigned)transfers.pages_requested,
+             (unsigned)transfers.held, (unsigned)transfers.dropped, (unsigned)transfers.duplicates,
+             (unsigned)transfers.stale, (unsigned)transfers.restarts);
+
+        PlaybackMailboxStats progress;
+        playback_mailbox_get_stats(&progress);
+        LOGI(MAIN, "Progress updates: published=%u shown=%u coalesced=%u",
+             (unsigned)progress.published, (unsigned)progress.taken, (unsigned)progress.coalesced);
+
+        AppLogStats log_stats;
+        app_log_get_stats(&log_stats);
+        LOGI(MAIN, "Log: written=%u dropped=%u (hw %u/%u)",
+             (unsigned)log_stats.written, (unsigned)log_stats.dropped, (unsigned)log_stats.high_water, APP_LOG_SLOTS);
+    }
+
     delay(10);
 }
@@ -0,0 +1,256 @@
+/*
+ * ABP Codec - Compact binary (TLV) encoding for Amperfy Bluetooth Protocol messages
+ * Structs, decoders and encoders are generated from the lists in abp_schema.h
+ */
+
+#include "abp_codec.h"
+#include <string.h>
+
+// ============================================================================
+// TLV primitives
+// ============================================================================
+
+static bool read_varint(AbpTlvReader* r, uint32_t* value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (r->pos >= r->length) return false;
+        uint8_t byte = r->data[r->pos++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void abp_tlv_reader_init(AbpTlvReader* r, const uint8_t* data, size_t length) {
+    r->data = data;
+    r->length = length;
+    r->pos = 0;
+    r->error = false;
+}
+
+bool abp_tlv_next(AbpTlvReader* r, AbpTlvField* field) {
+    if (r->error || r->pos >= r->length) return false;
+
+    uint8_t key = r->data[r->pos++];
+    field->number = key >> 3;
+    field->wire_type = key & 0x07;
+    field->bytes = nullptr;
+
+    if (!read_varint(r, &field->value)) {
+        r->error = true;
+        return false;
+    }
+    if (field->wire_type == ABP_WIRE_BYTES) {
+        if (field->value > r->length - r->pos) {
+            r->error = true;
+            return false;
+        }
+        field->bytes = r->data + r->pos;
+        r->pos += field->value;
+    } else if (field->wire_type != ABP_WIRE_VARINT) {
+        r->error = true;
+        return false;
+    }
+    return true;
+}
+
+static void write_raw(AbpTlvWriter* w, const uint8_t* bytes, size_t length) {
+    if (w->overflow || length > w->capacity - w->length) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->data + w->length, bytes, length);
+    w->length += length;
+}
+
+static void write_varint_raw(AbpTlvWriter* w, uint32_t value) {
+    uint8_t buf[5];
+    size_t n = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buf[n++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    write_raw(w, buf, n);
+}
+
+void abp_tlv_writer_init(AbpTlvWriter* w, uint8_t* out, size_t capacity) {
+    w->data = out;
+    w->capacity = capacity;
+    w->length = 0;
+    w->overflow = false;
+}
+
+void abp_tlv_write_varint(AbpTlvWriter* w, uint8_t number, uint32_t value) {
+    uint8_t key = (uint8_t)(number << 3) | ABP_WIRE_VARINT;
+    write_raw(w, &key, 1);
+    write_varint_raw(w, value);
+}
+
+void abp_tlv_write_bytes(AbpTlvWriter* w, uint8_t number, const uint8_t* bytes, size_t length) {
+    uint8_t key = (uint8_t)(number << 3) | ABP_WIRE_BYTES;
+    write_raw(w, &key, 1);
+    write_varint_raw(w, (uint32_t)length);
+    write_raw(w, bytes, length);
+}
+
+void abp_tlv_write_string(AbpTlvWriter* w, uint8_t number, const char* str) {
+    abp_tlv_write_bytes(w, number, (const uint8_t*)str, strlen(str) + 1);  // Keep the NUL
+}
+
+bool abp_list_next(const AbpList* list, size_t* pos, const uint8_t** item, size_t* item_length) {
+    AbpTlvReader r;
+    abp_tlv_reader_init(&r, list->data, list->length);
+    r.pos = *pos;
+
+    AbpTlvField field;
+    while (abp_tlv_next(&r, &field)) {
+        if (field.number == list->number && field.wire_type == ABP_WIRE_BYTES) {
+            *item = field.bytes;
+            *item_length = field.value;
+            *pos = r.pos;
+            return true;
+        }
+    }
+    *pos = list->length;
+    return false;
+}
+
+// ============================================================================
+// Field readers / writers by kind
+// ============================================================================
+
+static bool read_STR(const AbpTlvField* f, const char** out) {
+    // Must be length-delimited and end with the NUL the sender appended
+    if (f->wire_type != ABP_WIRE_BYTES || f->value == 0 || f->bytes[f->value - 1] != '\0') return false;
+    *out = (const char*)f->bytes;
+    return true;
+}
+
+static bool read_U32(const AbpTlvField* f, uint32_t* out) {
+    if (f->wire_type != ABP_WIRE_VARINT) return false;
+    *out = f->value;
+    return true;
+}
+
+static bool read_MS(const AbpTlvField* f, uint32_t* out) {
+    return read_U32(f, out);
+}
+
+static bool read_BOOL(const AbpTlvField* f, bool* out) {
+    if (f->wire_type != ABP_WIRE_VARINT) return false;
+    *out = f->value != 0;
+    return true;
+}
+
+static bool read_LIST(const AbpTlvField* f, AbpList* out) {
+    if (f->wire_type != ABP_WIRE_BYTES) return false;
+    out->count++;
+    return true;
+}
+
+static void write_STR(AbpTlvWriter* w, uint8_t number, const char* value) {
+    if (value) abp_tlv_write_string(w, number, value);
+}
+
+static void write_U32(AbpTlvWriter* w, uint8_t number, uint32_t value) {
+    if (value) abp_tlv_write_varint(w, number, value);
+}
+
+static void write_MS(AbpTlvWriter* w, uint8_t number, uint32_t value) {
+    write_U32(w, number, value);
+}
+
+static void write_BOOL(AbpTlvWriter* w, uint8_t number, bool value) {
+    if (value) abp_tlv_write_varint(w, number, 1);
+}
+
+// Copy the list's items (already encoded as field `number`) into the message
+static void write_LIST(AbpTlvWriter* w, uint8_t number, const AbpList& list) {
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&list, &pos, &item, &item_length)) {
+        abp_tlv_write_bytes(w, number, item, item_length);
+    }
+}
+
+// ============================================================================
+// Generated decoders / encoders
+// ============================================================================
+
+// Lists point at the whole body; abp_list_next() picks out the item fields
+#define ABP_LIST_INIT(num, kind, mem) ABP_LIST_INIT_##kind(num, mem)
+#define ABP_LIST_INIT_STR(num, mem)
+#define ABP_LIST_INIT_U32(num, mem)
+#define ABP_LIST_INIT_MS(num, mem)
+#define ABP_LIST_INIT_BOOL(num, mem)
+#define ABP_LIST_INIT_LIST(num, mem) \
+    out->mem.data = data; out->mem.length = length; out->mem.number = num;
+
+#define ABP_DECODE_CASE(num, kind, mem) \
+    case num: ok = read_##kind(&field, &out->mem); break;
+
+#define ABP_ENCODE_FIELD(num, kind, mem) \
+    write_##kind(w, num, in->mem);
+
+#define ABP_DEFINE_CODEC(Struct, snake, FIELDS) \
+    bool abp_decode_##snake(const uint8_t* data, size_t length, Struct* out) { \
+        memset(out, 0, sizeof(*out)); \
+        FIELDS(ABP_LIST_INIT) \
+        AbpTlvReader r; \
+        abp_tlv_reader_init(&r, data, length); \
+        AbpTlvField field; \
+        while (abp_tlv_next(&r, &field)) { \
+            bool ok = true; \
+            switch (field.number) { \
+                FIELDS(ABP_DECODE_CASE) \
+                default: break; \
+            } \
+            if (!ok) return false; \
+        } \
+        return !r.error; \
+    } \
+    void abp_encode_fields_##snake(AbpTlvWriter* w, const Struct* in) { \
+        FIELDS(ABP_ENCODE_FIELD) \
+    }
+
+ABP_STRUCTS(ABP_DEFINE_CODEC)
+
+// ============================================================================
+// Messages
+// ============================================================================
+
+bool abp_is_binary(const uint8_t* data, size_t length) {
+    return length >= ABP_BINARY_HEADER_SIZE && data[0] == ABP_BINARY_MAGIC;
+}
+
+AbpMessageType abp_binary_type(const uint8_t* data) {
+    return (AbpMessageType)data[1];
+}
+
+const char* abp_message_type_name(AbpMessageType type) {
+    switch (type) {
+#define ABP_TYPE_NAME(id, name) case ABP_MSG_##name: return #name;
+        ABP_MESSAGE_TYPES(ABP_TYPE_NAME)
+#undef ABP_TYPE_NAME
+    }
+    return "UNKNOWN";
+}
+
+bool abp_message_type_from_name(const char* name, AbpMessageType* type) {
+#define ABP_TYPE_MATCH(id, type_name) \
+    if (strcmp(name, #type_name) == 0) { *type = ABP_MSG_##type_name; return true; }
+    ABP_MESSAGE_TYPES(ABP_TYPE_MATCH)
+#undef ABP_TYPE_MATCH
+    return false;
+}
+
+void abp_binary_begin(AbpTlvWriter* w, uint8_t* out, size_t capacity, AbpMessageType type) {
+    abp_tlv_writer_init(w, out, capacity);
+    uint8_t header[ABP_BINARY_HEADER_SIZE] = {ABP_BINARY_MAGIC, (uint8_t)type};
+    write_raw(w, header, sizeof(header));
+}
@@ -0,0 +1,104 @@
+/*
+ * ABP Codec - Compact binary (TLV) encoding for Amperfy Bluetooth Protocol messages
+ * Structs, decoders and encoders are generated from the lists in abp_schema.h
+ *
+ * Decoding never copies: string members point into the message buffer, which
+ * must stay alive while the struct is in use.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "abp_schema.h"
+
+#define ABP_BINARY_MAGIC        0xB1
+#define ABP_BINARY_HEADER_SIZE  2       // magic + type id
+
+#define ABP_WIRE_VARINT         0
+#define ABP_WIRE_BYTES          2
+
+typedef enum {
+#define ABP_TYPE_ENUM(id, name) ABP_MSG_##name = id,
+    ABP_MESSAGE_TYPES(ABP_TYPE_ENUM)
+#undef ABP_TYPE_ENUM
+} AbpMessageType;
+
+// Repeated nested messages: the region holding them and the field number to pick out
+typedef struct {
+    const uint8_t* data;
+    size_t length;
+    uint8_t number;
+    uint16_t count;
+} AbpList;
+
+// ============================================================================
+// TLV primitives
+// ============================================================================
+
+typedef struct {
+    const uint8_t* data;
+    size_t length;
+    size_t pos;
+    bool error;
+} AbpTlvReader;
+
+typedef struct {
+    uint8_t number;
+    uint8_t wire_type;
+    uint32_t value;             // Varint value, or byte length for wire type 2
+    const uint8_t* bytes;       // Start of the bytes for wire type 2
+} AbpTlvField;
+
+typedef struct {
+    uint8_t* data;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+} AbpTlvWriter;
+
+void abp_tlv_reader_init(AbpTlvReader* r, const uint8_t* data, size_t length);
+// Returns false at the end of the data or on malformed input (r->error set)
+bool abp_tlv_next(AbpTlvReader* r, AbpTlvField* field);
+
+void abp_tlv_writer_init(AbpTlvWriter* w, uint8_t* out, size_t capacity);
+void abp_tlv_write_varint(AbpTlvWriter* w, uint8_t number, uint32_t value);
+void abp_tlv_write_bytes(AbpTlvWriter* w, uint8_t number, const uint8_t* bytes, size_t length);
+void abp_tlv_write_string(AbpTlvWriter* w, uint8_t number, const char* str);
+
+// Walk the items of a list; *pos starts at 0. Returns false after the last item.
+bool abp_list_next(const AbpList* list, size_t* pos, const uint8_t** item, size_t* item_length);
+
+// ============================================================================
+// Messages
+// ============================================================================
+
+// True if the buffer holds a binary message rather than JSON
+bool abp_is_binary(const uint8_t* data, size_t length);
+AbpMessageType abp_binary_type(const uint8_t* data);
+const char* abp_message_type_name(AbpMessageType type);
+// Map a JSON "type" string to its binary id, false if it has none
+bool abp_message_type_from_name(const char* name, AbpMessageType* type);
+
+// Write the magic/type header, then fill in fields with an abp_encode_fields_* call
+void abp_binary_begin(AbpTlvWriter* w, uint8_t* out, size_t capacity, AbpMessageType type);
+
+#define ABP_CTYPE_STR   const char*
+#define ABP_CTYPE_U32   uint32_t
+#define ABP_CTYPE_MS    uint32_t
+#define ABP_CTYPE_BOOL  bool
+#define ABP_CTYPE_LIST  AbpList
+
+#define ABP_STRUCT_MEMBER(num, kind, mem) ABP_CTYPE_##kind mem;
+#define ABP_DECLARE_STRUCT(Struct, snake, FIELDS) \
+    typedef struct { FIELDS(ABP_STRUCT_MEMBER) } Struct; \
+    bool abp_decode_##snake(const uint8_t* data, size_t length, Struct* out); \
+    void abp_encode_fields_##snake(AbpTlvWriter* w, const Struct* in);
+
+ABP_STRUCTS(ABP_DECLARE_STRUCT)
+
+#undef ABP_DECLARE_STRUCT
+#undef ABP_STRUCT_MEMBER
+
+// Decode the body of a binary message (after the header) into one of the structs above
+#define abp_decode_message(snake, data, length, out) \
+    abp_decode_##snake((data) + ABP_BINARY_HEADER_SIZE, (length) - ABP_BINARY_HEADER_SIZE, (out))
@@ -0,0 +1,238 @@
+/*
+ * ABP Dispatch - Handler registry for incoming Amperfy Bluetooth Protocol messages
+ * JSON "type" strings and binary type ids both resolve to one table entry in O(1)
+ */
+
+#include <Arduino.h>
+#include "abp_dispatch.h"
+#include "app_log.h"
+#include "json_pull.h"
+#include <esp_timer.h>
+#include <string.h>
+
+// ============================================================================
+// Compile-time slot check
+// ============================================================================
+
+static constexpr uint32_t kTypeHashes[] = {
+#define ABP_TYPE_HASH(id, name) abp_type_hash(#name),
+    ABP_MESSAGE_TYPES(ABP_TYPE_HASH)
+#undef ABP_TYPE_HASH
+};
+
+static constexpr bool slots_are_unique() {
+    for (size_t i = 0; i < sizeof(kTypeHashes) / sizeof(kTypeHashes[0]); i++) {
+        for (size_t j = i + 1; j < sizeof(kTypeHashes) / sizeof(kTypeHashes[0]); j++) {
+            if (abp_dispatch_slot(kTypeHashes[i]) == abp_dispatch_slot(kTypeHashes[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert((ABP_DISPATCH_SLOTS & (ABP_DISPATCH_SLOTS - 1)) == 0, "ABP_DISPATCH_SLOTS must be a power of two");
+static_assert(slots_are_unique(), "Two ABP message types share a dispatch slot - raise ABP_DISPATCH_SLOTS");
+static_assert(sizeof(kTypeHashes) / sizeof(kTypeHashes[0]) <= ABP_DISPATCH_MAX_TYPES,
+              "More ABP message types than ABP_DISPATCH_MAX_TYPES");
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+typedef struct {
+    const char* name;
+    uint32_t hash;
+    AbpMessageType type;
+    AbpJsonHandler json;
+    AbpBinaryHandler binary;
+    AbpStreamHandler stream;
+    DynamicJsonDocument* filter;    // nullptr = keep everything
+    AbpTypeStats stats;
+} DispatchEntry;
+
+// Slot / id tables hold entry index + 1 so zero means empty
+static DispatchEntry g_entries[ABP_DISPATCH_MAX_TYPES];
+static uint8_t g_entry_count = 0;
+static uint8_t g_by_slot[ABP_DISPATCH_SLOTS];
+static uint8_t g_by_id[256];
+static uint32_t g_unhandled = 0;
+static int64_t g_parsed_us = 0;
+
+static DynamicJsonDocument* build_filter(const char* name, const char* filter_json) {
+    DynamicJsonDocument* filter = new DynamicJsonDocument(ABP_DISPATCH_FILTER_SIZE);
+    DeserializationError error = deserializeJson(*filter, filter_json);
+    if (error) {
+        LOGE(DISPATCH, "Bad filter for %s: %s", name, error.c_str());
+        delete filter;
+        return nullptr;
+    }
+    filter->shrinkToFit();
+    return filter;
+}
+
+void abp_dispatch_register(AbpMessageType type, const char* name, uint32_t hash,
+                           AbpJsonHandler json, AbpBinaryHandler binary, const char* filter) {
+    uint8_t index = g_by_id[type];
+    if (index == 0) {
+        if (g_entry_count >= ABP_DISPATCH_MAX_TYPES) {
+            LOGE(DISPATCH, "Registry full, cannot add %s", name);
+            return;
+        }
+        index = ++g_entry_count;
+        g_by_id[type] = index;
+        g_by_slot[abp_dispatch_slot(hash)] = index;
+    }
+
+    DispatchEntry* entry = &g_entries[index - 1];
+    entry->name = name;
+    entry->hash = hash;
+    entry->type = type;
+    entry->json = json;
+    entry->binary = binary;
+    entry->stream = nullptr;
+    delete entry->filter;
+    entry->filter = filter ? build_filter(name, filter) : nullptr;
+}
+
+void abp_dispatch_register_stream(AbpMessageType type, AbpStreamHandler stream) {
+    uint8_t index = g_by_id[type];
+    if (index != 0) {
+        g_entries[index - 1].stream = stream;
+    }
+}
+
+static DispatchEntry* find_by_name(const char* type) {
+    uint32_t hash = abp_type_hash(type);
+    uint8_t index = g_by_slot[abp_dispatch_slot(hash)];
+    if (index == 0) return nullptr;
+
+    // Names outside the schema can still land on a used slot
+    DispatchEntry* entry = &g_entries[index - 1];
+    return (entry->hash == hash && strcmp(entry->name, type) == 0) ? entry : nullptr;
+}
+
+static void record(DispatchEntry* entry, size_t length, uint32_t parse_us, int64_t handler_start_us) {
+    uint32_t handler_us = (uint32_t)(esp_timer_get_time() - handler_start_us);
+    entry->stats.count++;
+    entry->stats.bytes += length;
+    entry->stats.parse_us += parse_us;
+    entry->stats.handler_us += handler_us;
+    if (handler_us > entry->stats.max_handler_us) {
+        entry->stats.max_handler_us = handler_us;
+    }
+}
+
+// Pass 1 reads only "type" and stops there, leaving the buffer intact for the in-place pass.
+// The app sends it first, so the payload - a whole page for stream types - is not walked here.
+static bool read_type(char* data, size_t length, char* type, size_t size) {
+    JsonPull p;
+    json_pull_init(&p, data, length);
+    type[0] = '\0';
+    if (!json_pull_object_begin(&p)) return false;
+
+    char key[16];
+    while (json_pull_object_next_copy(&p, key, sizeof(key))) {
+        if (strcmp(key, "type") == 0) return json_pull_string_copy(&p, type, size);
+        if (!json_pull_skip(&p)) return false;
+    }
+    return !p.error;
+}
+
+bool abp_dispatch_json(char* data, size_t length, JsonDocument& doc) {
+    int64_t start_us = esp_timer_get_time();
+
+    char type[32];
+    if (!read_type(data, length, type, sizeof(type))) {
+        LOGE(DISPATCH, "JSON parse error reading type");
+        return false;
+    }
+
+    DispatchEntry* entry = find_by_name(type);
+    if (!entry || (!entry->json && !entry->stream)) {
+        g_unhandled++;
+        LOGW(DISPATCH, "Unknown message type: %s", type);
+        return false;
+    }
+
+    // Stream handlers read the buffer themselves, constant memory whatever the page size
+    if (entry->stream) {
+        int64_t handler_start_us = esp_timer_get_time();
+        if (!entry->stream(data, length)) {
+            entry->stats.errors++;
+            LOGE(DISPATCH, "JSON stream error in %s", entry->name);
+        }
+        record(entry, length, (uint32_t)(handler_start_us - start_us), handler_start_us);
+        return true;
+    }
+
+    // Pass 2: mutable input selects zero-copy mode - strings stay in the receive buffer
+    DeserializationError error;
+    if (entry->filter) {
+        error = deserializeJson(doc, data, length, DeserializationOption::Filter(*entry->filter));
+    } else {
+        error = deserializeJson(doc, data, length);
+    }
+    if (error) {
+        entry->stats.errors++;
+        LOGE(DISPATCH, "JSON parse error in %s: %s", entry->name, error.c_str());
+        return false;
+    }
+
+    JsonObject payload = doc["payload"];
+    int64_t handler_start_us = esp_timer_get_time();
+    entry->json(payload);
+    record(entry, length, (uint32_t)(handler_start_us - start_us), handler_start_us);
+    return true;
+}
+
+void abp_dispatch_mark_parsed(void) {
+    g_parsed_us = esp_timer_get_time();
+}
+
+bool abp_dispatch_binary(const uint8_t* data, size_t length) {
+    uint8_t index = g_by_id[abp_binary_type(data)];
+    DispatchEntry* entry = index ? &g_entries[index - 1] : nullptr;
+    if (!entry || !entry->binary) {
+        g_unhandled++;
+        LOGW(DISPATCH, "Unhandled binary message: %s", abp_message_type_name(abp_binary_type(data)));
+        return false;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    g_parsed_us = start_us;
+    if (!entry->binary(data + ABP_BINARY_HEADER_SIZE, length - ABP_BINARY_HEADER_SIZE)) {
+        entry->stats.errors++;
+        LOGE(DISPATCH, "Binary decode error: %s", entry->name);
+        return true;
+    }
+    record(entry, length, (uint32_t)(g_parsed_us - start_us), g_parsed_us);
+    return true;
+}
+
+bool abp_dispatch_get_stats(AbpMessageType type, AbpTypeStats* stats) {
+    uint8_t index = g_by_id[type];
+    if (index == 0) return false;
+    *stats = g_entries[index - 1].stats;
+    return true;
+}
+
+uint32_t abp_dispatch_unhandled_count(void) {
+    return g_unhandled;
+}
+
+void abp_dispatch_log_stats(void) {
+    for (uint8_t i = 0; i < g_entry_count; i++) {
+        const DispatchEntry* entry = &g_entries[i];
+        const AbpTypeStats* s = &entry->stats;
+        if (s->count == 0 && s->errors == 0) continue;
+
+        LOGI(DISPATCH, "%-18s n=%u err=%u bytes=%u parse_avg=%uus handler_avg=%uus handler_max=%uus",
+             entry->name, (unsigned)s->count, (unsigned)s->errors, (unsigned)s->bytes,
+             s->count ? (unsigned)(s->parse_us / s->count) : 0,
+             s->count ? (unsigned)(s->handler_us / s->count) : 0, (unsigned)s->max_handler_us);
+    }
+    if (g_unhandled) {
+        LOGI(DISPATCH, "unhandled=%u", (unsigned)g_unhandled);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * ABP Dispatch - Handler registry for incoming Amperfy Bluetooth Protocol messages
+ * JSON "type" strings and binary type ids both resolve to one table entry in O(1)
+ *
+ * Types are keyed by a constexpr FNV-1a hash of their name. Every name in
+ * ABP_MESSAGE_TYPES is checked at compile time to land in its own table slot,
+ * so adding a type that collides fails the build instead of misrouting.
+ *
+ * JSON is parsed in place (ArduinoJson zero-copy mode) through a per-type
+ * filter, so the document only holds the fields a handler reads and its strings
+ * point into the receive buffer. Handlers copy what they keep exactly once.
+ * Types whose payload grows with page size register a stream handler instead
+ * and read the buffer with json_pull, so no document is built at all.
+ *
+ * Each type keeps count / bytes / parse / handler timing so per-type cost shows
+ * up in the periodic stats log. Dispatch runs only on the BLE protocol task.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ArduinoJson.h>
+#include "abp_codec.h"
+
+#define ABP_DISPATCH_SLOTS      1024        // Power of two; raise if the slot check below fails
+#define ABP_DISPATCH_MAX_TYPES  32          // Handlers that can be registered
+#define ABP_DISPATCH_FILTER_SIZE 512        // Scratch document a filter is parsed into
+
+// FNV-1a over a NUL-terminated type name
+constexpr uint32_t abp_type_hash(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+constexpr uint32_t abp_dispatch_slot(uint32_t hash) {
+    return hash & (ABP_DISPATCH_SLOTS - 1);
+}
+
+// Handlers run on the protocol task. Binary handlers get the body after the
+// 2-byte header and return false if it did not decode.
+typedef void (*AbpJsonHandler)(JsonObject& payload);
+typedef bool (*AbpBinaryHandler)(const uint8_t* body, size_t length);
+// Gets the whole JSON message (mutable, null-terminated), returns false if it was malformed
+typedef bool (*AbpStreamHandler)(char* data, size_t length);
+
+typedef struct {
+    uint32_t count;             // Messages dispatched
+    uint32_t errors;            // Messages of this type that failed to parse / decode
+    uint64_t bytes;
+    uint64_t parse_us;          // JSON deserialize (both passes) / TLV decode; stream handlers parse as they go
+    uint64_t handler_us;
+    uint32_t max_handler_us;
+} AbpTypeStats;
+
+// Register handlers for a type in ABP_MESSAGE_TYPES; either handler may be nullptr.
+// filter is an ArduinoJson filter in JSON form, e.g. {"payload":{"title":true}}, naming
+// the fields the JSON handler reads; nullptr keeps the whole message.
+// Use ABP_DISPATCH_REGISTER so the name is checked against the schema at compile time.
+void abp_dispatch_register(AbpMessageType type, const char* name, uint32_t hash,
+                           AbpJsonHandler json, AbpBinaryHandler binary, const char* filter);
+
+#define ABP_DISPATCH_REGISTER(NAME, json, binary, filter) \
+    abp_dispatch_register(ABP_MSG_##NAME, #NAME, abp_type_hash(#NAME), (json), (binary), (filter))
+
+// Register a JSON stream handler for a type (after ABP_DISPATCH_REGISTER, which it keeps)
+void abp_dispatch_register_stream(AbpMessageType type, AbpStreamHandler stream);
+
+#define ABP_DISPATCH_REGISTER_STREAM(NAME, stream, binary) \
+    do { \
+        ABP_DISPATCH_REGISTER(NAME, nullptr, (binary), nullptr); \
+        abp_dispatch_register_stream(ABP_MSG_##NAME, (stream)); \
+    } while (0)
+
+// Parse a JSON message in place into doc and route it. data must be mutable and
+// null-terminated, and is left modified. Returns false if it did not parse or has no handler.
+bool abp_dispatch_json(char* data, size_t length, JsonDocument& doc);
+
+// Route a binary message (header included). Returns false if it has no binary handler.
+bool abp_dispatch_binary(const uint8_t* data, size_t length);
+
+// Binary handlers call this once the body is decoded so decode and handling are timed apart
+void abp_dispatch_mark_parsed(void);
+
+// Stats for a registered type, false if the type has no handlers
+bool abp_dispatch_get_stats(AbpMessageType type, AbpTypeStats* stats);
+// Messages whose type had no handler
+uint32_t abp_dispatch_unhandled_count(void);
+// Log one line per type that has seen traffic
+void abp_dispatch_log_stats(void);
@@ -0,0 +1,270 @@
+/*
+ * ABP Framing - Fragmentation and reassembly for Amperfy Bluetooth Protocol messages
+ * Lets messages larger than a single BLE write travel as a sequence of fragments
+ */
+
+#include "abp_frame.h"
+#include <string.h>
+
+// ============================================================================
+// CRC-32
+// ============================================================================
+
+// Nibble table keeps the footprint at 64 bytes while staying fast enough for BLE rates
+static const uint32_t CRC32_NIBBLE_TABLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+uint32_t abp_crc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLE_TABLE[crc & 0x0F];
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+
+// ============================================================================
+// Header
+// ============================================================================
+
+static uint16_t read_u16(const uint8_t* p) {
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void write_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+bool abp_frame_parse_header(const uint8_t* data, size_t length, AbpFrameHeader* header) {
+    if (length < ABP_FRAME_HEADER_SIZE || data[0] != ABP_FRAME_MAGIC) {
+        return false;
+    }
+    header->magic = data[0];
+    header->flags = data[1];
+    header->msg_id = read_u16(data + 2);
+    header->frag_index = read_u16(data + 4);
+    header->frag_count = read_u16(data + 6);
+    header->frag_size = read_u16(data + 8);
+    header->total_len = read_u16(data + 10);
+    header->crc = read_u32(data + 12);
+    return true;
+}
+
+void abp_frame_write_header(uint8_t* out, const AbpFrameHeader* header) {
+    out[0] = ABP_FRAME_MAGIC;
+    out[1] = header->flags;
+    write_u16(out + 2, header->msg_id);
+    write_u16(out + 4, header->frag_index);
+    write_u16(out + 6, header->frag_count);
+    write_u16(out + 8, header->frag_size);
+    write_u16(out + 10, header->total_len);
+    write_u32(out + 12, header->crc);
+}
+
+uint16_t abp_frame_count(size_t message_length, size_t frag_payload) {
+    if (frag_payload == 0) return 0;
+    if (message_length == 0) return 1;
+    return (uint16_t)((message_length + frag_payload - 1) / frag_payload);
+}
+
+size_t abp_frame_build(uint8_t* out, const uint8_t* message, size_t message_length, uint16_t msg_id,
+                       uint16_t index, size_t frag_payload, uint32_t crc, uint8_t flags) {
+    AbpFrameHeader header;
+    header.magic = ABP_FRAME_MAGIC;
+    header.flags = flags;
+    header.msg_id = msg_id;
+    header.frag_index = index;
+    header.frag_count = abp_frame_count(message_length, frag_payload);
+    header.frag_size = (uint16_t)frag_payload;
+    header.total_len = (uint16_t)message_length;
+    header.crc = crc;
+    abp_frame_write_header(out, &header);
+
+    size_t offset = (size_t)index * frag_payload;
+    size_t chunk = 0;
+    if (offset < message_length) {
+        chunk = message_length - offset;
+        if (chunk > frag_payload) chunk = frag_payload;
+        memcpy(out + ABP_FRAME_HEADER_SIZE, message + offset, chunk);
+    }
+    return ABP_FRAME_HEADER_SIZE + chunk;
+}
+
+// ============================================================================
+// Reassembly
+// ============================================================================
+
+static void slot_release(AbpReassemblySlot* slot) {
+    slot->in_use = false;
+    slot->received = 0;
+    memset(slot->bitmap, 0, sizeof(slot->bitmap));
+}
+
+static AbpReassemblySlot* slot_find(AbpReassembler* r, uint16_t msg_id) {
+    for (int i = 0; i < ABP_REASSEMBLY_SLOTS; i++) {
+        if (r->slots[i].in_use && r->slots[i].msg_id == msg_id) {
+            return &r->slots[i];
+        }
+    }
+    return nullptr;
+}
+
+// Take a free slot, or evict the one that has been idle the longest
+static AbpReassemblySlot* slot_claim(AbpReassembler* r) {
+    AbpReassemblySlot* oldest = &r->slots[0];
+    for (int i = 0; i < ABP_REASSEMBLY_SLOTS; i++) {
+        if (!r->slots[i].in_use) {
+            return &r->slots[i];
+        }
+        if (r->slots[i].last_activity_ms < oldest->last_activity_ms) {
+            oldest = &r->slots[i];
+        }
+    }
+    r->stats.evicted++;
+    slot_release(oldest);
+    return oldest;
+}
+
+static bool header_is_valid(const AbpFrameHeader* h, size_t payload_length) {
+    if (h->frag_count == 0 || h->frag_count > ABP_MAX_FRAGMENTS) return false;
+    if (h->frag_index >= h->frag_count) return false;
+    if (h->total_len > ABP_MAX_MESSAGE_SIZE || h->frag_size == 0) return false;
+    if (abp_frame_count(h->total_len, h->frag_size) != h->frag_count) return false;
+
+    // Every fragment but the last is exactly frag_size, the last carries the remainder
+    size_t offset = (size_t)h->frag_index * h->frag_size;
+    size_t expected = h->total_len - offset;
+    if (expected > h->frag_size) expected = h->frag_size;
+    return payload_length == expected;
+}
+
+void abp_reassembler_init(AbpReassembler* r, uint8_t* pool) {
+    memset(r, 0, sizeof(*r));
+    for (int i = 0; i < ABP_REASSEMBLY_SLOTS; i++) {
+        r->slots[i].buffer = pool + (size_t)i * (ABP_MAX_MESSAGE_SIZE + 1);
+    }
+}
+
+void abp_reassembler_reset(AbpReassembler* r) {
+    for (int i = 0; i < ABP_REASSEMBLY_SLOTS; i++) {
+        slot_release(&r->slots[i]);
+    }
+}
+
+AbpFrameResult abp_reassembler_feed(AbpReassembler* r, uint8_t* data, size_t length, uint32_t now_ms,
+                                    uint8_t** message, size_t* message_length) {
+    AbpFrameHeader h;
+    if (!abp_frame_parse_header(data, length, &h)) {
+        // Legacy unframed message - the whole write is the message
+        if (length == 0) return ABP_FRAME_ERROR;
+        data[length] = '\0';
+        *message = data;
+        *message_length = length;
+        r->stats.unframed++;
+        return ABP_FRAME_COMPLETE;
+    }
+
+    uint8_t* payload = data + ABP_FRAME_HEADER_SIZE;
+    size_t payload_length = length - ABP_FRAME_HEADER_SIZE;
+    if (!header_is_valid(&h, payload_length)) {
+        r->stats.malformed++;
+        return ABP_FRAME_ERROR;
+    }
+
+    // Single-fragment messages are verified and handed out in place, no copy
+    if (h.frag_count == 1) {
+        if (abp_crc32(payload, payload_length) != h.crc) {
+            r->stats.crc_errors++;
+            return ABP_FRAME_ERROR;
+        }
+        payload[payload_length] = '\0';
+        *message = payload;
+        *message_length = payload_length;
+        r->stats.fragments++;
+        r->stats.completed++;
+        return ABP_FRAME_COMPLETE;
+    }
+
+    AbpReassemblySlot* slot = slot_find(r, h.msg_id);
+    if (slot && (slot->frag_count != h.frag_count || slot->total_len != h.total_len ||
+                 slot->frag_size != h.frag_size || slot->crc != h.crc)) {
+        // Same id but a different message - the old one is never going to finish
+        r->stats.malformed++;
+        slot_release(slot);
+        slot = nullptr;
+    }
+    if (!slot) {
+        slot = slot_claim(r);
+        slot->in_use = true;
+        slot->msg_id = h.msg_id;
+        slot->frag_count = h.frag_count;
+        slot->frag_size = h.frag_size;
+        slot->total_len = h.total_len;
+        slot->crc = h.crc;
+        slot->received = 0;
+        memset(slot->bitmap, 0, sizeof(slot->bitmap));
+    }
+    slot->last_activity_ms = now_ms;
+
+    uint32_t word = h.frag_index / 32;
+    uint32_t bit = 1u << (h.frag_index % 32);
+    if (slot->bitmap[word] & bit) {
+        r->stats.duplicates++;
+        return ABP_FRAME_INCOMPLETE;
+    }
+
+    memcpy(slot->buffer + (size_t)h.frag_index * h.frag_size, payload, payload_length);
+    slot->bitmap[word] |= bit;
+    slot->received++;
+    r->stats.fragments++;
+
+    if (slot->received < slot->frag_count) {
+        return ABP_FRAME_INCOMPLETE;
+    }
+
+    // All fragments placed - verify and release the slot (buffer stays valid until next feed)
+    bool crc_ok = abp_crc32(slot->buffer, slot->total_len) == slot->crc;
+    slot_release(slot);
+    if (!crc_ok) {
+        r->stats.crc_errors++;
+        return ABP_FRAME_ERROR;
+    }
+
+    slot->buffer[slot->total_len] = '\0';
+    *message = slot->buffer;
+    *message_length = slot->total_len;
+    r->stats.completed++;
+    return ABP_FRAME_COMPLETE;
+}
+
+void abp_reassembler_expire(AbpReassembler* r, uint32_t now_ms) {
+    for (int i = 0; i < ABP_REASSEMBLY_SLOTS; i++) {
+        AbpReassemblySlot* slot = &r->slots[i];
+        if (slot->in_use && now_ms - slot->last_activity_ms > ABP_REASSEMBLY_TIMEOUT_MS) {
+            r->stats.timeouts++;
+            slot_release(slot);
+        }
+    }
+}
+
+bool abp_reassembler_pending(const AbpReassembler* r) {
+    for (int i = 0; i < ABP_REASSEMBLY_SLOTS; i++) {
+        if (r->slots[i].in_use) return true;
+    }
+    return false;
+}
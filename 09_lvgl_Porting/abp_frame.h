@@ -0,0 +1,108 @@
+/*
+ * ABP Framing - Fragmentation and reassembly for Amperfy Bluetooth Protocol messages
+ * Lets messages larger than a single BLE write travel as a sequence of fragments
+ *
+ * Fragment layout (little-endian, 16-byte header followed by payload):
+ *   [0]      magic (0xAB)
+ *   [1]      flags
+ *   [2..3]   message id
+ *   [4..5]   fragment index
+ *   [6..7]   fragment count
+ *   [8..9]   fragment size (payload bytes in every fragment but the last)
+ *   [10..11] total message length
+ *   [12..15] CRC-32 of the complete message
+ *
+ * Writes that do not start with the magic byte are treated as complete, unframed
+ * (ABP v1.0) messages so older senders keep working.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ABP_FRAME_MAGIC             0xAB
+#define ABP_FRAME_HEADER_SIZE       16
+#define ABP_MAX_MESSAGE_SIZE        (16 * 1024)  // Largest reassembled message
+#define ABP_MAX_FRAGMENTS           128          // Fragments per message
+#define ABP_REASSEMBLY_SLOTS        2            // Messages that can be in flight at once
+#define ABP_REASSEMBLY_TIMEOUT_MS   2000         // Drop a partial message after this much silence
+
+// Bytes needed for the reassembly pool passed to abp_reassembler_init()
+#define ABP_REASSEMBLY_POOL_SIZE    (ABP_REASSEMBLY_SLOTS * (ABP_MAX_MESSAGE_SIZE + 1))
+
+typedef enum {
+    ABP_FRAME_INCOMPLETE,   // Fragment accepted, message not finished yet
+    ABP_FRAME_COMPLETE,     // A whole message is available
+    ABP_FRAME_ERROR         // Fragment rejected (see stats)
+} AbpFrameResult;
+
+typedef struct {
+    uint8_t magic;
+    uint8_t flags;
+    uint16_t msg_id;
+    uint16_t frag_index;
+    uint16_t frag_count;
+    uint16_t frag_size;
+    uint16_t total_len;
+    uint32_t crc;
+} AbpFrameHeader;
+
+typedef struct {
+    uint8_t* buffer;                            // ABP_MAX_MESSAGE_SIZE + 1 bytes from the pool
+    bool in_use;
+    uint16_t msg_id;
+    uint16_t frag_count;
+    uint16_t frag_size;
+    uint16_t total_len;
+    uint16_t received;
+    uint32_t crc;
+    uint32_t bitmap[ABP_MAX_FRAGMENTS / 32];    // Fragments already placed
+    uint32_t last_activity_ms;
+} AbpReassemblySlot;
+
+typedef struct {
+    uint32_t unframed;          // Legacy single-write messages passed through
+    uint32_t completed;         // Framed messages reassembled successfully
+    uint32_t fragments;         // Fragments accepted
+    uint32_t duplicates;        // Fragments received twice
+    uint32_t malformed;         // Truncated or inconsistent fragments
+    uint32_t crc_errors;        // Messages whose CRC did not match
+    uint32_t timeouts;          // Partial messages expired
+    uint32_t evicted;           // Partial messages pushed out by newer ones
+} AbpFrameStats;
+
+typedef struct {
+    AbpReassemblySlot slots[ABP_REASSEMBLY_SLOTS];
+    AbpFrameStats stats;
+} AbpReassembler;
+
+// CRC-32 (IEEE 802.3, reflected, as used by zlib)
+uint32_t abp_crc32(const uint8_t* data, size_t length);
+
+// Header encode/decode
+bool abp_frame_parse_header(const uint8_t* data, size_t length, AbpFrameHeader* header);
+void abp_frame_write_header(uint8_t* out, const AbpFrameHeader* header);
+
+// Number of fragments needed to carry a message with the given payload bytes per fragment
+uint16_t abp_frame_count(size_t message_length, size_t frag_payload);
+
+// Build fragment `index` of a message into out (ABP_FRAME_HEADER_SIZE + frag_payload bytes),
+// returns the number of bytes written
+size_t abp_frame_build(uint8_t* out, const uint8_t* message, size_t message_length, uint16_t msg_id,
+                       uint16_t index, size_t frag_payload, uint32_t crc, uint8_t flags);
+
+// Reassembler - pool must hold ABP_REASSEMBLY_POOL_SIZE bytes
+void abp_reassembler_init(AbpReassembler* r, uint8_t* pool);
+void abp_reassembler_reset(AbpReassembler* r);
+
+// Feed one BLE write. On ABP_FRAME_COMPLETE, *message/*message_length describe the
+// null-terminated message; it stays valid until the next call into the reassembler.
+// Unframed writes are returned as-is (data must have room for a terminator at data[length]).
+AbpFrameResult abp_reassembler_feed(AbpReassembler* r, uint8_t* data, size_t length, uint32_t now_ms,
+                                    uint8_t** message, size_t* message_length);
+
+// Drop partial messages that have been idle longer than ABP_REASSEMBLY_TIMEOUT_MS
+void abp_reassembler_expire(AbpReassembler* r, uint32_t now_ms);
+
+// True while any partial message is waiting for fragments
+bool abp_reassembler_pending(const AbpReassembler* r);
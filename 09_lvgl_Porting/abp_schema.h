@@ -0,0 +1,196 @@
+/*
+ * ABP Schema - Binary (TLV) layout of every Amperfy Bluetooth Protocol message
+ * Single source of truth for abp_codec: structs, decoders and encoders are generated from these lists
+ *
+ * Binary message: [0xB1][type id][fields...]
+ * Each field starts with a key byte (number << 3 | wire type) followed by
+ *   wire type 0 - unsigned LEB128 varint (U32, MS, BOOL)
+ *   wire type 2 - varint length + bytes (STR, LIST item)
+ * Strings carry a trailing NUL so the decoder can hand them out in place.
+ * Fields that are absent decode as 0 / false / nullptr; unknown fields are skipped.
+ *
+ * Keep in sync with BluetoothBinaryCodec in the app (BluetoothProtocol.swift).
+ */
+#pragma once
+
+// Message type ids - X(id, NAME) where NAME matches the JSON "type" string
+#define ABP_MESSAGE_TYPES(X) \
+    X(1,  SONG_STARTED) \
+    X(2,  SONG_STOPPED) \
+    X(3,  PLAYBACK_PROGRESS) \
+    X(8,  HELLO) \
+    X(9,  CAPABILITIES) \
+    X(10, QUERY_PLAYLISTS) \
+    X(11, QUERY_ARTISTS) \
+    X(12, QUERY_ALBUMS) \
+    X(13, QUERY_SONGS) \
+    X(14, QUERY_PLAYLIST_SONGS) \
+    X(15, QUERY_ARTIST_SONGS) \
+    X(16, QUERY_ALBUM_SONGS) \
+    X(17, QUERY_LIBRARY) \
+    X(18, CANCEL) \
+    X(20, PLAY_SONG) \
+    X(21, PLAY_PAUSE) \
+    X(22, NEXT_SONG) \
+    X(23, PREV_SONG) \
+    X(30, PLAYLISTS_RESPONSE) \
+    X(31, ARTISTS_RESPONSE) \
+    X(32, ALBUMS_RESPONSE) \
+    X(33, SONGS_RESPONSE) \
+    X(40, ERROR)
+
+// Structs - X(StructName, snake_name, FIELDS)
+// HELLO and CAPABILITIES are always JSON (the encoding is not agreed yet) and the
+// playback commands have no fields. Every other QUERY_* type uses AbpQueryId.
+#define ABP_STRUCTS(X) \
+    X(AbpSongStarted,       song_started,       ABP_FIELDS_SONG_STARTED) \
+    X(AbpSongStopped,       song_stopped,       ABP_FIELDS_SONG_STOPPED) \
+    X(AbpPlaybackProgress,  playback_progress,  ABP_FIELDS_PLAYBACK_PROGRESS) \
+    X(AbpQueryId,           query_id,           ABP_FIELDS_QUERY_ID) \
+    X(AbpLibraryListRequest, library_list_request, ABP_FIELDS_LIBRARY_LIST_REQUEST) \
+    X(AbpQueryLibrary,      query_library,      ABP_FIELDS_QUERY_LIBRARY) \
+    X(AbpCancel,            cancel,             ABP_FIELDS_CANCEL) \
+    X(AbpPlaySong,          play_song,          ABP_FIELDS_PLAY_SONG) \
+    X(AbpPlaylistInfo,      playlist_info,      ABP_FIELDS_PLAYLIST_INFO) \
+    X(AbpArtistInfo,        artist_info,        ABP_FIELDS_ARTIST_INFO) \
+    X(AbpAlbumInfo,         album_info,         ABP_FIELDS_ALBUM_INFO) \
+    X(AbpSongInfo,          song_info,          ABP_FIELDS_SONG_INFO) \
+    X(AbpPlaylistsResponse, playlists_response, ABP_FIELDS_PLAYLISTS_RESPONSE) \
+    X(AbpArtistsResponse,   artists_response,   ABP_FIELDS_ARTISTS_RESPONSE) \
+    X(AbpAlbumsResponse,    albums_response,    ABP_FIELDS_ALBUMS_RESPONSE) \
+    X(AbpSongsResponse,     songs_response,     ABP_FIELDS_SONGS_RESPONSE) \
+    X(AbpError,             error,              ABP_FIELDS_ERROR)
+
+// Fields - F(number, KIND, member)
+#define ABP_FIELDS_SONG_STARTED(F) \
+    F(1, STR, song_id) \
+    F(2, STR, title) \
+    F(3, STR, artist) \
+    F(4, STR, album) \
+    F(5, MS,  duration_ms) \
+    F(6, STR, playlist_name) \
+    F(7, STR, playlist_id)
+
+#define ABP_FIELDS_SONG_STOPPED(F) \
+    F(1, STR, song_id)
+
+#define ABP_FIELDS_PLAYBACK_PROGRESS(F) \
+    F(1, STR,  song_id) \
+    F(2, MS,   elapsed_ms) \
+    F(3, MS,   duration_ms) \
+    F(4, BOOL, is_playing)
+
+// id: QUERY_PLAYLIST_SONGS / QUERY_ARTIST_SONGS / QUERY_ALBUM_SONGS only
+// first_page / last_page: only those pages of the response (v1.2), 0 = all of them
+// offset / limit: song queries, only that slice of the list (v1.3), limit 0 = to the end
+// revision: playlists / artists / albums, the revision held (v1.4) - answer with what changed since
+// request_id: echoed in every response page (v1.6), 0 = none; repeats of lost pages reuse it
+#define ABP_FIELDS_QUERY_ID(F) \
+    F(1, STR, id) \
+    F(2, U32, first_page) \
+    F(3, U32, last_page) \
+    F(4, U32, offset) \
+    F(5, U32, limit) \
+    F(6, U32, revision) \
+    F(7, U32, request_id)
+
+// QUERY_LIBRARY (v1.5): several of the lists above in one request; the app answers with
+// one stream of their response pages, interleaved. collection: "playlists", "artists" or
+// "albums"; revision as in AbpQueryId; limit: items wanted at most, 0 = all it can hold
+#define ABP_FIELDS_LIBRARY_LIST_REQUEST(F) \
+    F(1, STR, collection) \
+    F(2, U32, revision) \
+    F(3, U32, limit)
+
+#define ABP_FIELDS_QUERY_LIBRARY(F) \
+    F(1, LIST, collections) \
+    F(2, U32,  request_id)
+
+// CANCEL (v1.6): stop sending the pages of that query - nobody is waiting for them
+#define ABP_FIELDS_CANCEL(F) \
+    F(1, U32, request_id)
+
+#define ABP_FIELDS_PLAY_SONG(F) \
+    F(1, STR, song_id) \
+    F(2, STR, context) \
+    F(3, STR, context_id) \
+    F(4, U32, song_index)
+
+// removed: delta pages only (v1.4), the record with this id is gone - no other fields
+#define ABP_FIELDS_PLAYLIST_INFO(F) \
+    F(1, STR,  id) \
+    F(2, STR,  name) \
+    F(3, U32,  song_count) \
+    F(9, BOOL, removed)
+
+#define ABP_FIELDS_ARTIST_INFO(F) \
+    F(1, STR,  id) \
+    F(2, STR,  name) \
+    F(3, U32,  album_count) \
+    F(4, U32,  song_count) \
+    F(9, BOOL, removed)
+
+#define ABP_FIELDS_ALBUM_INFO(F) \
+    F(1, STR,  id) \
+    F(2, STR,  name) \
+    F(3, STR,  artist) \
+    F(4, U32,  song_count) \
+    F(5, U32,  year) \
+    F(9, BOOL, removed)
+
+#define ABP_FIELDS_SONG_INFO(F) \
+    F(1, STR, id) \
+    F(2, STR, title) \
+    F(3, STR, artist) \
+    F(4, STR, album) \
+    F(5, MS,  duration_ms) \
+    F(6, U32, track_number)
+
+// Responses: offset = items on the pages before this one, total_items = items on all
+// pages (v1.2; absent from older apps), so a receiver can check pages fit together.
+// revision = the app's revision of the list (v1.4); delta = the pages hold only what
+// changed since the revision the query named (no items: nothing did). request_id =
+// the query's (v1.6), so pages of one superseded or cancelled are dropped unread.
+#define ABP_FIELDS_PLAYLISTS_RESPONSE(F) \
+    F(1, U32,  page) \
+    F(2, U32,  total_pages) \
+    F(3, LIST, playlists) \
+    F(6, U32,  offset) \
+    F(7, U32,  total_items) \
+    F(8, U32,  revision) \
+    F(9, BOOL, delta) \
+    F(10, U32, request_id)
+
+#define ABP_FIELDS_ARTISTS_RESPONSE(F) \
+    F(1, U32,  page) \
+    F(2, U32,  total_pages) \
+    F(3, LIST, artists) \
+    F(6, U32,  offset) \
+    F(7, U32,  total_items) \
+    F(8, U32,  revision) \
+    F(9, BOOL, delta) \
+    F(10, U32, request_id)
+
+#define ABP_FIELDS_ALBUMS_RESPONSE(F) \
+    F(1, U32,  page) \
+    F(2, U32,  total_pages) \
+    F(3, LIST, albums) \
+    F(6, U32,  offset) \
+    F(7, U32,  total_items) \
+    F(8, U32,  revision) \
+    F(9, BOOL, delta) \
+    F(10, U32, request_id)
+
+#define ABP_FIELDS_SONGS_RESPONSE(F) \
+    F(1, U32,  page) \
+    F(2, U32,  total_pages) \
+    F(3, LIST, songs) \
+    F(4, STR,  context) \
+    F(5, STR,  context_id) \
+    F(6, U32,  offset) \
+    F(7, U32,  total_items) \
+    F(10, U32, request_id)
+
+#define ABP_FIELDS_ERROR(F) \
+    F(1, STR, code) \
+    F(2, STR, message)
@@ -0,0 +1,131 @@
+/*
+ * App Log - Leveled, asynchronous logging for the sketch
+ * Lines are formatted into a lock-free ring and written to Serial by a low-priority task
+ */
+
+#include <Arduino.h>
+#include "app_log.h"
+#include <esp_heap_caps.h>
+#include <atomic>
+#include <new>
+#include <stdarg.h>
+#include <stdio.h>
+
+// Bounded multi-producer queue (Vyukov): a slot is free for position p when its
+// sequence equals p, and holds a finished line when it equals p + 1
+typedef struct {
+    std::atomic<uint32_t> seq;
+    uint16_t length;
+    char text[APP_LOG_LINE_SIZE];
+} LogSlot;
+
+static LogSlot* g_slots = nullptr;
+static std::atomic<uint32_t> g_head(0);         // Next position to claim (producers)
+static std::atomic<uint32_t> g_tail(0);         // Next position to print (written by the drain task only)
+static std::atomic<uint32_t> g_written(0);
+static std::atomic<uint32_t> g_dropped(0);
+static std::atomic<uint32_t> g_high_water(0);
+
+static_assert((APP_LOG_SLOTS & (APP_LOG_SLOTS - 1)) == 0, "APP_LOG_SLOTS must be a power of two");
+
+static void drop_line(void) {
+    g_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void app_log_write(const char* tag, const char* format, ...) {
+    if (!g_slots) {
+        drop_line();
+        return;
+    }
+
+    // Claim a slot, or give up at once if the drain task is behind
+    uint32_t pos = g_head.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    while (true) {
+        slot = &g_slots[pos & (APP_LOG_SLOTS - 1)];
+        int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (g_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            drop_line();
+            return;
+        } else {
+            pos = g_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    int length = snprintf(slot->text, APP_LOG_LINE_SIZE, "[%s] ", tag);
+    va_list args;
+    va_start(args, format);
+    length += vsnprintf(slot->text + length, APP_LOG_LINE_SIZE - length, format, args);
+    va_end(args);
+    if (length > APP_LOG_LINE_SIZE - 2) {
+        length = APP_LOG_LINE_SIZE - 2;     // Truncated - keep room for the newline
+    }
+    slot->text[length++] = '\n';
+    slot->length = (uint16_t)length;
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    g_written.fetch_add(1, std::memory_order_relaxed);
+    uint32_t depth = pos + 1 - g_tail.load(std::memory_order_relaxed);
+    uint32_t high = g_high_water.load(std::memory_order_relaxed);
+    while (depth > high && !g_high_water.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {
+    }
+}
+
+// Print every finished line in order, stopping at one still being formatted
+static void drain(void) {
+    uint32_t tail = g_tail.load(std::memory_order_relaxed);
+    while (true) {
+        LogSlot* slot = &g_slots[tail & (APP_LOG_SLOTS - 1)];
+        if (slot->seq.load(std::memory_order_acquire) != tail + 1) return;
+
+        Serial.write((const uint8_t*)slot->text, slot->length);
+        slot->seq.store(tail + APP_LOG_SLOTS, std::memory_order_release);
+        tail++;
+        g_tail.store(tail, std::memory_order_relaxed);
+    }
+}
+
+static void log_task(void* arg) {
+    uint32_t reported_drops = 0;
+    while (true) {
+        drain();
+
+        uint32_t dropped = g_dropped.load(std::memory_order_relaxed);
+        if (dropped != reported_drops) {
+            Serial.printf("[Log] %u lines dropped\n", (unsigned)(dropped - reported_drops));
+            reported_drops = dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(APP_LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+void app_log_init(void) {
+    if (g_slots) return;
+
+    // Lines go to PSRAM when available, like the BLE buffers
+    LogSlot* slots = (LogSlot*)heap_caps_malloc(sizeof(LogSlot) * APP_LOG_SLOTS, MALLOC_CAP_SPIRAM);
+    if (!slots) {
+        slots = (LogSlot*)heap_caps_malloc(sizeof(LogSlot) * APP_LOG_SLOTS, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!slots) {
+        Serial.println("[Log] Failed to allocate log ring, logging disabled");
+        return;
+    }
+    for (uint32_t i = 0; i < APP_LOG_SLOTS; i++) {
+        new (&slots[i].seq) std::atomic<uint32_t>(i);
+    }
+    g_slots = slots;
+
+    if (xTaskCreate(log_task, "app_log", APP_LOG_TASK_STACK_SIZE, nullptr, APP_LOG_TASK_PRIORITY, nullptr) != pdPASS) {
+        Serial.println("[Log] Failed to create log task");
+    }
+}
+
+void app_log_get_stats(AppLogStats* stats) {
+    stats->written = g_written.load(std::memory_order_relaxed);
+    stats->dropped = g_dropped.load(std::memory_order_relaxed);
+    stats->high_water = g_high_water.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,77 @@
+/*
+ * App Log - Leveled, asynchronous logging for the sketch
+ * Lines are formatted into a lock-free ring and written to Serial by a low-priority task
+ *
+ * Each module has a compile-time level; a call above it compiles to nothing
+ * (arguments are not evaluated). Any task may log: a full ring drops the line
+ * and counts it instead of waiting, so logging never back-pressures the caller.
+ * Safe from BLE callbacks and any task; not from ISRs (formatting is vsnprintf).
+ *
+ *   LOGI(BLE, "App subscribed, MTU %u", mtu);   ->  "[BLE] App subscribed, MTU 185"
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define APP_LOG_NONE        0
+#define APP_LOG_ERROR       1
+#define APP_LOG_WARN        2
+#define APP_LOG_INFO        3
+#define APP_LOG_DEBUG       4
+
+// Per-module levels - override with -D, e.g. in the sketch's build_opt.h
+#ifndef APP_LOG_LEVEL_BLE
+#define APP_LOG_LEVEL_BLE       APP_LOG_INFO
+#endif
+#ifndef APP_LOG_LEVEL_MAIN
+#define APP_LOG_LEVEL_MAIN      APP_LOG_INFO
+#endif
+#ifndef APP_LOG_LEVEL_LIBRARY
+#define APP_LOG_LEVEL_LIBRARY   APP_LOG_INFO
+#endif
+#ifndef APP_LOG_LEVEL_UI
+#define APP_LOG_LEVEL_UI        APP_LOG_INFO
+#endif
+#ifndef APP_LOG_LEVEL_DISPATCH
+#define APP_LOG_LEVEL_DISPATCH  APP_LOG_INFO
+#endif
+
+// Tags printed in front of each line
+#define APP_LOG_TAG_BLE         "BLE"
+#define APP_LOG_TAG_MAIN        "Main"
+#define APP_LOG_TAG_LIBRARY     "Library"
+#define APP_LOG_TAG_UI          "UI"
+#define APP_LOG_TAG_DISPATCH    "Dispatch"
+
+#define APP_LOG_SLOTS               64          // Lines buffered (power of two)
+#define APP_LOG_LINE_SIZE           160         // Longer lines are truncated
+#define APP_LOG_TASK_STACK_SIZE     (3 * 1024)
+#define APP_LOG_TASK_PRIORITY       (1)         // Below the protocol, TX and LVGL tasks
+#define APP_LOG_DRAIN_INTERVAL_MS   20
+
+typedef struct {
+    uint32_t written;           // Lines queued
+    uint32_t dropped;           // Lines lost because the ring was full (or not started)
+    uint32_t high_water;        // Most lines waiting at once
+} AppLogStats;
+
+// Allocate the ring and start the drain task; lines logged before this are dropped
+void app_log_init(void);
+
+// Format one line into the ring. Use the LOG* macros rather than calling this directly.
+void app_log_write(const char* tag, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+void app_log_get_stats(AppLogStats* stats);
+
+#define APP_LOG_AT(module, level, format, ...) \
+    do { \
+        if (APP_LOG_LEVEL_##module >= (level)) { \
+            app_log_write(APP_LOG_TAG_##module, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOGE(module, format, ...) APP_LOG_AT(module, APP_LOG_ERROR, format, ##__VA_ARGS__)
+#define LOGW(module, format, ...) APP_LOG_AT(module, APP_LOG_WARN, format, ##__VA_ARGS__)
+#define LOGI(module, format, ...) APP_LOG_AT(module, APP_LOG_INFO, format, ##__VA_ARGS__)
+#define LOGD(module, format, ...) APP_LOG_AT(module, APP_LOG_DEBUG, format, ##__VA_ARGS__)
@@ -0,0 +1,50 @@
+/*
+ * Arena - Bump-pointer region allocator
+ * One contiguous block (PSRAM when available) handed out front to back and freed all at once
+ */
+
+#include "arena.h"
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#else
+#include <stdlib.h>
+#endif
+
+static void* arena_malloc(size_t size, bool psram) {
+#ifdef ARDUINO
+    return heap_caps_malloc(size, psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    // Host builds (tools/) have no PSRAM
+    return psram ? nullptr : malloc(size);
+#endif
+}
+
+bool arena_init(Arena* arena, size_t capacity) {
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->in_psram = true;
+    arena->base = (uint8_t*)arena_malloc(capacity, true);
+    if (!arena->base) {
+        arena->in_psram = false;
+        arena->base = (uint8_t*)arena_malloc(capacity, false);
+    }
+    arena->capacity = arena->base ? capacity : 0;
+    return arena->base != nullptr;
+}
+
+void* arena_alloc(Arena* arena, size_t size, size_t align) {
+    size_t start = (arena->used + align - 1) & ~(align - 1);
+    if (start > arena->capacity || size > arena->capacity - start) return nullptr;
+
+    arena->used = start + size;
+    if (arena->used > arena->high_water) arena->high_water = arena->used;
+    return arena->base + start;
+}
+
+void arena_reset(Arena* arena) {
+    arena->used = 0;
+}
+
+size_t arena_remaining(const Arena* arena) {
+    return arena->capacity - arena->used;
+}
@@ -0,0 +1,28 @@
+/*
+ * Arena - Bump-pointer region allocator
+ * One contiguous block (PSRAM when available) handed out front to back and freed all at once
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t* base;
+    size_t capacity;
+    size_t used;                // Bytes handed out since the last reset
+    size_t high_water;          // Most bytes ever in use at once
+    bool in_psram;
+} Arena;
+
+// Reserve capacity bytes for the arena, PSRAM first with an internal-RAM fallback
+bool arena_init(Arena* arena, size_t capacity);
+
+// Take size bytes aligned to align (a power of two), or nullptr if the arena is full
+void* arena_alloc(Arena* arena, size_t size, size_t align);
+
+// Forget every allocation - O(1), the memory is not cleared
+void arena_reset(Arena* arena);
+
+// Bytes still available (ignoring alignment padding)
+size_t arena_remaining(const Arena* arena);
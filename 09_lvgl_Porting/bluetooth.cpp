@@ -4,10 +4,15 @@
  */
 
 #include "bluetooth.h"
+#include "msg_ring.h"
+#include "abp_frame.h"
+#include "app_log.h"
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 // Nordic UART Service UUIDs (matching Amperfy protocol)
 #define SERVICE_UUID           "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
@@ -26,12 +31,42 @@ static bool oldDeviceConnected = false;
 // Callbacks
 static BLEConnectionCallback connectionCallback = nullptr;
 static BLEDataCallback dataCallback = nullptr;
+static BLESubscribeCallback subscribeCallback = nullptr;
+
+// Link state (written by the BLE host task)
+static volatile uint16_t g_mtu = BLE_DEFAULT_MTU;
+static volatile bool g_subscribe_pending = false;
+
+// Transmit path: any task enqueues, the TX task fragments and paces the notifications
+static TxQueue g_tx_queue;
+static SemaphoreHandle_t g_tx_lock = nullptr;      // Guards g_tx_queue
+static TaskHandle_t g_tx_task = nullptr;
+static uint8_t g_tx_frame[BLE_TX_MAX_FRAME];       // TX task only
+static uint16_t g_tx_msg_id = 0;                   // TX task only
+static volatile bool g_tx_congested = false;
+static volatile bool g_tx_notify_failed = false;
+static volatile uint32_t g_tx_notifications = 0;
+static volatile uint32_t g_tx_notify_errors = 0;
+static volatile uint32_t g_tx_congestion_events = 0;
+
+// Receive path: onWrite only copies into the ring, the protocol task reassembles and parses
+static MsgRing g_rx_ring;
+static uint8_t g_rx_message[BLE_RX_MAX_MESSAGE + 1];  // +1 for null terminator
+static AbpReassembler g_reassembler;
+static TaskHandle_t g_protocol_task = nullptr;
+
+// onWrite timing (written only by the BLE host task)
+static volatile uint32_t g_rx_callback_count = 0;
+static volatile uint32_t g_rx_callback_max_us = 0;
+static volatile uint64_t g_rx_callback_total_us = 0;
+static uint32_t g_rx_dispatched = 0;
+static unsigned long g_last_stats_ms = 0;
 
 // Server callbacks
 class ServerCallbacks: public BLEServerCallbacks {
     void onConnect(BLEServer* pServer) {
         deviceConnected = true;
-        Serial.println("[BLE] Device connected");
+        LOGI(BLE, "Device connected");
         if (connectionCallback) {
             connectionCallback(true);
         }
@@ -39,35 +74,253 @@ class ServerCallbacks: public BLEServerCallbacks {
 
     void onDisconnect(BLEServer* pServer) {
         deviceConnected = false;
-        Serial.println("[BLE] Device disconnected");
+        g_mtu = BLE_DEFAULT_MTU;
+        g_subscribe_pending = false;
+        g_tx_congested = false;
+        if (g_tx_task) {
+            xTaskNotifyGive(g_tx_task);  // Fail whatever is still queued
+        }
+        LOGI(BLE, "Device disconnected");
         if (connectionCallback) {
             connectionCallback(false);
         }
     }
+
+    void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+        g_mtu = param->mtu.mtu;
+    }
+};
+
+// TX CCCD callbacks - the app is ready to receive once it enables notifications
+// Runs on the BLE host task, so only flag it and let the protocol task do the talking
+class CccdCallbacks: public BLEDescriptorCallbacks {
+    void onWrite(BLEDescriptor* pDescriptor) {
+        if (((BLE2902*)pDescriptor)->getNotifications() && g_protocol_task) {
+            g_subscribe_pending = true;
+            xTaskNotifyGive(g_protocol_task);
+        }
+    }
 };
 
+// TX characteristic callbacks - notification results (runs inside notify() on the TX task)
+class TxCallbacks: public BLECharacteristicCallbacks {
+    void onStatus(BLECharacteristic* pCharacteristic, Status s, uint32_t code) {
+        if (s != SUCCESS_NOTIFY && s != SUCCESS_INDICATE) {
+            g_tx_notify_failed = true;
+            g_tx_notify_errors = g_tx_notify_errors + 1;
+        }
+    }
+};
+
+// Raw GATTS events - only congestion is of interest, the library handles the rest
+// Runs on the BLE host task
+static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
+    if (event != ESP_GATTS_CONGEST_EVT) {
+        return;
+    }
+    g_tx_congested = param->congest.congested;
+    if (g_tx_congested) {
+        g_tx_congestion_events = g_tx_congestion_events + 1;
+    } else if (g_tx_task) {
+        xTaskNotifyGive(g_tx_task);
+    }
+}
+
 // RX characteristic callbacks (data from app)
+// Runs on the BLE host task: copy the bytes and return, never parse or print here
 class RxCallbacks: public BLECharacteristicCallbacks {
     void onWrite(BLECharacteristic *pCharacteristic) {
-        String rxValue = pCharacteristic->getValue();
+        int64_t start_us = esp_timer_get_time();
+
+        size_t length = pCharacteristic->getLength();
+        if (length > 0 && length <= BLE_RX_MAX_MESSAGE) {
+            if (msg_ring_push(&g_rx_ring, pCharacteristic->getData(), (uint16_t)length) && g_protocol_task) {
+                xTaskNotifyGive(g_protocol_task);
+            }
+        }
+
+        uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+        g_rx_callback_count = g_rx_callback_count + 1;
+        g_rx_callback_total_us = g_rx_callback_total_us + elapsed_us;
+        if (elapsed_us > g_rx_callback_max_us) {
+            g_rx_callback_max_us = elapsed_us;
+        }
+    }
+};
+
+// Large buffers go to PSRAM when available so internal SRAM stays free for LVGL and the BLE stack
+static uint8_t* alloc_large_buffer(size_t size) {
+    uint8_t* buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (!buffer) {
+        buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return buffer;
+}
 
-        if (rxValue.length() > 0) {
-            Serial.print("[BLE] Received ");
-            Serial.print(rxValue.length());
-            Serial.println(" bytes");
+// Protocol task - drains the RX ring, reassembles fragments and hands complete messages to the data callback
+static void protocol_task(void* arg) {
+    while (true) {
+        // Wake up periodically while a partial message is pending so it can time out
+        TickType_t wait = abp_reassembler_pending(&g_reassembler) ? pdMS_TO_TICKS(ABP_REASSEMBLY_TIMEOUT_MS / 4)
+                                                                   : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, wait);
 
+        if (g_subscribe_pending) {
+            g_subscribe_pending = false;
+            LOGI(BLE, "App subscribed, MTU %u", (unsigned)g_mtu);
+            if (subscribeCallback) {
+                subscribeCallback(g_mtu);
+            }
+        }
+
+        size_t length;
+        while ((length = msg_ring_pop(&g_rx_ring, g_rx_message, BLE_RX_MAX_MESSAGE)) > 0) {
+            uint8_t* message = nullptr;
+            size_t message_length = 0;
+            if (abp_reassembler_feed(&g_reassembler, g_rx_message, length, millis(),
+                                     &message, &message_length) != ABP_FRAME_COMPLETE) {
+                continue;
+            }
+
+            g_rx_dispatched++;
             if (dataCallback) {
-                dataCallback(rxValue.c_str(), rxValue.length());
+                dataCallback((char*)message, message_length);
             }
         }
+
+        abp_reassembler_expire(&g_reassembler, millis());
     }
-};
+}
+
+// ============================================================================
+// Transmit task
+// ============================================================================
+
+// Block while the link is congested, false if it does not clear in time or we disconnect
+static bool tx_wait_uncongested(void) {
+    uint32_t start = millis();
+    while (g_tx_congested && deviceConnected) {
+        if (millis() - start >= BLE_TX_CONGEST_TIMEOUT_MS) {
+            return false;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+    return deviceConnected;
+}
+
+// One notification; notify() returns once the stack has taken it, which paces us to the link
+static bool tx_notify(uint8_t* data, size_t length) {
+    if (!tx_wait_uncongested()) {
+        return false;
+    }
+    g_tx_notify_failed = false;
+    pTxCharacteristic->setValue(data, length);
+    pTxCharacteristic->notify();
+    g_tx_notifications = g_tx_notifications + 1;
+    return !g_tx_notify_failed;
+}
+
+static bool tx_send_message(const uint8_t* data, size_t length) {
+    size_t max_notify = g_mtu - BLE_ATT_HEADER_SIZE;
+    if (max_notify > BLE_TX_MAX_FRAME) max_notify = BLE_TX_MAX_FRAME;
+
+    if (length <= max_notify) {
+        // Fits one notification - send unframed so v1.0 apps keep working
+        return tx_notify((uint8_t*)data, length);
+    }
+
+    size_t frag_payload = max_notify - ABP_FRAME_HEADER_SIZE;
+    uint16_t count = abp_frame_count(length, frag_payload);
+    if (length > ABP_MAX_MESSAGE_SIZE || count > ABP_MAX_FRAGMENTS) {
+        LOGE(BLE, "Message too large to send: %u bytes at MTU %u", (unsigned)length, (unsigned)g_mtu);
+        return false;
+    }
+
+    uint32_t crc = abp_crc32(data, length);
+    uint16_t msg_id = g_tx_msg_id++;
+    for (uint16_t i = 0; i < count; i++) {
+        size_t frame_length = abp_frame_build(g_tx_frame, data, length, msg_id, i, frag_payload, crc, 0);
+        if (!tx_notify(g_tx_frame, frame_length)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run completion callbacks outside the queue lock so they may send again
+static void tx_run_completions(void) {
+    while (true) {
+        TxCompletion completion;
+        xSemaphoreTake(g_tx_lock, portMAX_DELAY);
+        bool have = tx_queue_pop_completion(&g_tx_queue, &completion);
+        xSemaphoreGive(g_tx_lock);
+        if (!have) break;
+        completion.done(completion.status, completion.ctx);
+    }
+}
+
+// TX task - sends queued messages one at a time, in order
+static void tx_task(void* arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (true) {
+            xSemaphoreTake(g_tx_lock, portMAX_DELAY);
+            TxEntry* entry = nullptr;
+            if (deviceConnected && pTxCharacteristic) {
+                entry = tx_queue_front(&g_tx_queue, millis());
+            } else {
+                tx_queue_fail_all(&g_tx_queue);
+            }
+            xSemaphoreGive(g_tx_lock);
+
+            if (!entry) {
+                tx_run_completions();
+                break;
+            }
+
+            // The entry is in flight, so producers leave its bytes alone while we send
+            bool sent = tx_send_message(entry->data, entry->length);
+
+            xSemaphoreTake(g_tx_lock, portMAX_DELAY);
+            tx_queue_complete(&g_tx_queue, entry, sent ? TX_STATUS_SENT : TX_STATUS_FAILED, millis());
+            xSemaphoreGive(g_tx_lock);
+            tx_run_completions();
+        }
+    }
+}
 
 void bluetooth_init(const char* device_name) {
-    Serial.println("[BLE] Initializing Bluetooth...");
+    LOGI(BLE, "Initializing Bluetooth...");
+
+    // Start the protocol task before any write can arrive
+    uint8_t* ring_storage = alloc_large_buffer(BLE_RX_RING_SIZE);
+    uint8_t* reassembly_pool = alloc_large_buffer(ABP_REASSEMBLY_POOL_SIZE);
+    uint8_t* tx_pool = alloc_large_buffer(TX_QUEUE_POOL_SIZE);
+    if (!ring_storage || !reassembly_pool || !tx_pool) {
+        LOGE(BLE, "Failed to allocate receive/transmit buffers");
+        return;
+    }
+    msg_ring_init(&g_rx_ring, ring_storage, BLE_RX_RING_SIZE);
+    abp_reassembler_init(&g_reassembler, reassembly_pool);
+    BaseType_t ret = xTaskCreatePinnedToCore(protocol_task, "abp_proto", BLE_PROTOCOL_TASK_STACK_SIZE, nullptr,
+                                             BLE_PROTOCOL_TASK_PRIORITY, &g_protocol_task, BLE_PROTOCOL_TASK_CORE);
+    if (ret != pdPASS) {
+        LOGE(BLE, "Failed to create protocol task");
+    }
+
+    tx_queue_init(&g_tx_queue, tx_pool);
+    g_tx_lock = xSemaphoreCreateMutex();
+    ret = xTaskCreatePinnedToCore(tx_task, "abp_tx", BLE_TX_TASK_STACK_SIZE, nullptr,
+                                  BLE_TX_TASK_PRIORITY, &g_tx_task, BLE_PROTOCOL_TASK_CORE);
+    if (ret != pdPASS) {
+        LOGE(BLE, "Failed to create TX task");
+    }
 
     // Create the BLE Device
     BLEDevice::init(device_name);
+    BLEDevice::setMTU(BLE_REQUESTED_MTU);
+    BLEDevice::setCustomGattsHandler(gatts_event_handler);
 
     // Create the BLE Server
     pServer = BLEDevice::createServer();
@@ -81,7 +334,10 @@ void bluetooth_init(const char* device_name) {
         CHARACTERISTIC_UUID_TX,
         BLECharacteristic::PROPERTY_NOTIFY
     );
-    pTxCharacteristic->addDescriptor(new BLE2902());
+    BLE2902* pTxCccd = new BLE2902();
+    pTxCccd->setCallbacks(new CccdCallbacks());
+    pTxCharacteristic->addDescriptor(pTxCccd);
+    pTxCharacteristic->setCallbacks(new TxCallbacks());
 
     // Create RX Characteristic (App -> ESP32)
     pRxCharacteristic = pService->createCharacteristic(
@@ -101,27 +357,40 @@ void bluetooth_init(const char* device_name) {
     pAdvertising->setMinPreferred(0x12);
     BLEDevice::startAdvertising();
 
-    Serial.print("[BLE] Device name: ");
-    Serial.println(device_name);
-    Serial.println("[BLE] Waiting for connection...");
+    LOGI(BLE, "Device name: %s", device_name);
+    LOGI(BLE, "Waiting for connection...");
 }
 
 bool bluetooth_is_connected(void) {
     return deviceConnected;
 }
 
-void bluetooth_send(const char* data) {
-    if (deviceConnected && pTxCharacteristic) {
-        pTxCharacteristic->setValue((uint8_t*)data, strlen(data));
-        pTxCharacteristic->notify();
-    }
+uint16_t bluetooth_get_mtu(void) {
+    return g_mtu;
+}
+
+bool bluetooth_send(const char* data, uint32_t merge_key, TxDoneCallback done, void* ctx) {
+    return bluetooth_send((const uint8_t*)data, strlen(data), merge_key, done, ctx);
 }
 
-void bluetooth_send(const uint8_t* data, size_t length) {
-    if (deviceConnected && pTxCharacteristic) {
-        pTxCharacteristic->setValue((uint8_t*)data, length);
-        pTxCharacteristic->notify();
+bool bluetooth_send(const uint8_t* data, size_t length, uint32_t merge_key, TxDoneCallback done, void* ctx) {
+    if (!g_tx_lock) return false;
+
+    // Disconnected, the failure is still reported on the TX task, never from in here
+    xSemaphoreTake(g_tx_lock, portMAX_DELAY);
+    bool queued = false;
+    if (deviceConnected) {
+        queued = tx_queue_push(&g_tx_queue, data, length, merge_key, done, ctx, millis());
+    } else {
+        tx_queue_fail(&g_tx_queue, done, ctx);
+    }
+    xSemaphoreGive(g_tx_lock);
+
+    // Wake the TX task even on failure so the drop is reported through the callback
+    if (g_tx_task) {
+        xTaskNotifyGive(g_tx_task);
     }
+    return queued;
 }
 
 void bluetooth_set_connection_callback(BLEConnectionCallback callback) {
@@ -132,12 +401,73 @@ void bluetooth_set_data_callback(BLEDataCallback callback) {
     dataCallback = callback;
 }
 
+void bluetooth_set_subscribe_callback(BLESubscribeCallback callback) {
+    subscribeCallback = callback;
+}
+
+void bluetooth_get_rx_stats(BLERxStats* stats) {
+    if (!stats) return;
+    uint32_t count = g_rx_callback_count;
+    stats->callback_count = count;
+    stats->callback_max_us = g_rx_callback_max_us;
+    stats->callback_avg_us = count > 0 ? (uint32_t)(g_rx_callback_total_us / count) : 0;
+    stats->messages_dispatched = g_rx_dispatched;
+    stats->ring_dropped = g_rx_ring.dropped.load(std::memory_order_relaxed);
+    stats->ring_used = msg_ring_used(&g_rx_ring);
+    stats->ring_high_water = g_rx_ring.high_water.load(std::memory_order_relaxed);
+    stats->ring_capacity = g_rx_ring.capacity;
+}
+
+void bluetooth_get_tx_stats(BLETxStats* stats) {
+    if (!stats) return;
+    if (g_tx_lock) {
+        xSemaphoreTake(g_tx_lock, portMAX_DELAY);
+        stats->queue = g_tx_queue.stats;
+        xSemaphoreGive(g_tx_lock);
+    } else {
+        memset(&stats->queue, 0, sizeof(stats->queue));
+    }
+    stats->notifications = g_tx_notifications;
+    stats->notify_errors = g_tx_notify_errors;
+    stats->congestion_events = g_tx_congestion_events;
+}
+
+void bluetooth_log_stats(void) {
+    BLERxStats stats;
+    bluetooth_get_rx_stats(&stats);
+    LOGI(BLE, "RX stats: writes=%u dispatched=%u dropped=%u cb_avg=%uus cb_max=%uus ring=%u/%u (hw %u)",
+         (unsigned)stats.callback_count, (unsigned)stats.messages_dispatched, (unsigned)stats.ring_dropped,
+         (unsigned)stats.callback_avg_us, (unsigned)stats.callback_max_us,
+         (unsigned)stats.ring_used, (unsigned)stats.ring_capacity, (unsigned)stats.ring_high_water);
+
+    const AbpFrameStats* frames = &g_reassembler.stats;
+    LOGI(BLE, "Frames: completed=%u unframed=%u fragments=%u dup=%u malformed=%u crc=%u timeout=%u evicted=%u",
+         (unsigned)frames->completed, (unsigned)frames->unframed, (unsigned)frames->fragments,
+         (unsigned)frames->duplicates, (unsigned)frames->malformed, (unsigned)frames->crc_errors,
+         (unsigned)frames->timeouts, (unsigned)frames->evicted);
+
+    BLETxStats tx;
+    bluetooth_get_tx_stats(&tx);
+    LOGI(BLE, "TX stats: queued=%u sent=%u merged=%u dropped=%u failed=%u depth=%u (hw %u) "
+         "max_wait=%ums notifies=%u errors=%u congested=%u",
+         (unsigned)tx.queue.enqueued, (unsigned)tx.queue.sent, (unsigned)tx.queue.merged,
+         (unsigned)tx.queue.dropped, (unsigned)tx.queue.failed, (unsigned)tx.queue.depth,
+         (unsigned)tx.queue.high_water, (unsigned)tx.queue.max_wait_ms, (unsigned)tx.notifications,
+         (unsigned)tx.notify_errors, (unsigned)tx.congestion_events);
+}
+
 void bluetooth_update(void) {
+    // Periodic receive path report while connected
+    if (deviceConnected && millis() - g_last_stats_ms >= BLE_STATS_INTERVAL_MS) {
+        g_last_stats_ms = millis();
+        bluetooth_log_stats();
+    }
+
     // Handle disconnecting - restart advertising
     if (!deviceConnected && oldDeviceConnected) {
         delay(500); // give the bluetooth stack time to get ready
         pServer->startAdvertising();
-        Serial.println("[BLE] Restarting advertising...");
+        LOGI(BLE, "Restarting advertising...");
         oldDeviceConnected = deviceConnected;
     }
 
@@ -5,10 +5,58 @@
 #pragma once
 
 #include <Arduino.h>
+#include "tx_queue.h"
+
+// Receive path configuration
+#define BLE_RX_MAX_MESSAGE              512         // Largest single write (one fragment) accepted from the app
+#define BLE_RX_RING_SIZE                (16 * 1024) // Bytes buffered between onWrite and the protocol task (power of two)
+#define BLE_PROTOCOL_TASK_STACK_SIZE    (10 * 1024) // Protocol task parses JSON on its own stack
+#define BLE_PROTOCOL_TASK_PRIORITY      (2)         // Same as the LVGL task
+#ifdef ARDUINO_RUNNING_CORE
+#define BLE_PROTOCOL_TASK_CORE          (ARDUINO_RUNNING_CORE)
+#else
+#define BLE_PROTOCOL_TASK_CORE          (1)
+#endif
+#define BLE_STATS_INTERVAL_MS           30000       // How often bluetooth_update() logs link stats
+
+// Link configuration
+#define BLE_DEFAULT_MTU                 23          // ATT MTU before the client exchanges a larger one
+#define BLE_REQUESTED_MTU               517         // Largest ATT MTU, accepted when the app asks for it
+#define BLE_ATT_HEADER_SIZE             3           // Opcode + handle in every notification
+#define BLE_TX_MAX_FRAME                (BLE_REQUESTED_MTU - BLE_ATT_HEADER_SIZE)  // Largest single notification
+
+// Transmit path configuration
+#define BLE_TX_TASK_STACK_SIZE          (4 * 1024)
+#define BLE_TX_TASK_PRIORITY            (2)
+#define BLE_TX_CONGEST_TIMEOUT_MS       1000        // Give up on a message if the link stays congested this long
+
+// Receive path statistics
+typedef struct {
+    uint32_t callback_count;        // onWrite invocations
+    uint32_t callback_avg_us;       // Average time spent inside onWrite
+    uint32_t callback_max_us;       // Worst-case time spent inside onWrite
+    uint32_t messages_dispatched;   // Messages handed to the data callback
+    uint32_t ring_dropped;          // Writes lost because the ring was full
+    uint32_t ring_used;             // Bytes currently queued
+    uint32_t ring_high_water;       // Most bytes ever queued
+    uint32_t ring_capacity;
+} BLERxStats;
+
+// Transmit path statistics
+typedef struct {
+    TxQueueStats queue;
+    uint32_t notifications;         // Notifications handed to the stack
+    uint32_t notify_errors;         // Notifications the stack rejected
+    uint32_t congestion_events;     // Times the link reported congestion
+} BLETxStats;
 
 // Callback function types for received data
 typedef void (*BLEConnectionCallback)(bool connected);
-typedef void (*BLEDataCallback)(const char* data, size_t length);
+// Receives complete (reassembled) messages, null-terminated. The buffer belongs to the
+// protocol task and is only valid during the call, but may be modified in place.
+typedef void (*BLEDataCallback)(char* data, size_t length);
+// Called once the app enables notifications, with the negotiated MTU
+typedef void (*BLESubscribeCallback)(uint16_t mtu);
 
 // Initialize the BLE server
 void bluetooth_init(const char* device_name = "Amperfy-ESP32");
@@ -16,13 +64,30 @@ void bluetooth_init(const char* device_name = "Amperfy-ESP32");
 // Check if a device is connected
 bool bluetooth_is_connected(void);
 
-// Send data to the connected device
-void bluetooth_send(const char* data);
-void bluetooth_send(const uint8_t* data, size_t length);
+// Negotiated ATT MTU (BLE_DEFAULT_MTU while disconnected)
+uint16_t bluetooth_get_mtu(void);
+
+// Queue data for the connected device - returns immediately, false if it was not queued
+// Messages longer than one notification are split into ABP fragments by the TX task.
+// A non-zero merge_key makes the message "latest wins": a newer one with the same key
+// replaces it while it is still waiting. done runs on the TX task once the message is
+// sent, merged, dropped or failed - never inside this call, disconnected or not. Before
+// bluetooth_init() nothing is queued and done is not called.
+bool bluetooth_send(const char* data, uint32_t merge_key = 0, TxDoneCallback done = nullptr, void* ctx = nullptr);
+bool bluetooth_send(const uint8_t* data, size_t length, uint32_t merge_key = 0,
+                    TxDoneCallback done = nullptr, void* ctx = nullptr);
 
 // Set callbacks
+// The data callback runs on the protocol task, not on the BLE host task
 void bluetooth_set_connection_callback(BLEConnectionCallback callback);
 void bluetooth_set_data_callback(BLEDataCallback callback);
+// The subscribe callback also runs on the protocol task
+void bluetooth_set_subscribe_callback(BLESubscribeCallback callback);
+
+// Receive / transmit path statistics
+void bluetooth_get_rx_stats(BLERxStats* stats);
+void bluetooth_get_tx_stats(BLETxStats* stats);
+void bluetooth_log_stats(void);
 
 // Call periodically to handle BLE events (reconnection, etc.)
 void bluetooth_update(void);
@@ -0,0 +1,80 @@
+/*
+ * Collate - Ordering of library names the way a listener expects
+ */
+
+#include "collate.h"
+
+// Base letter of U+00C0..U+017F, '.' where the code point is not a letter (x, division sign)
+static const char LATIN_FOLD[] =
+    "aaaaaaaceeeeiiiidnooooo.ouuuuyts"      // U+00C0
+    "aaaaaaaceeeeiiiidnooooo.ouuuuyty"      // U+00E0
+    "aaaaaaccccccccddddeeeeeeeeeegggg"      // U+0100
+    "gggghhhhiiiiiiiiiiiijjkkklllllll"      // U+0120
+    "lllnnnnnnnnnoooooooorrrrrrssssss"      // U+0140
+    "ssttttttuuuuuuuuuuuuwwyyyzzzzzzs";     // U+0160
+
+static const uint32_t LATIN_FOLD_FIRST = 0xC0;
+static const uint32_t LATIN_FOLD_LAST = 0x17F;
+
+// Decode one UTF-8 sequence; a malformed byte stands for itself
+static uint32_t decode_utf8(const uint8_t** s) {
+    const uint8_t* p = *s;
+    uint32_t c = p[0];
+    int extra = 0;
+    if (c >= 0xF8) {
+        extra = 0;
+    } else if (c >= 0xF0) {
+        c &= 0x07;
+        extra = 3;
+    } else if (c >= 0xE0) {
+        c &= 0x0F;
+        extra = 2;
+    } else if (c >= 0xC0) {
+        c &= 0x1F;
+        extra = 1;
+    }
+
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *s = p + 1;
+            return p[0];
+        }
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    *s = p + 1 + extra;
+    return c;
+}
+
+uint32_t collate_next(const char** s) {
+    const uint8_t* p = (const uint8_t*)*s;
+    if (*p == 0) return 0;
+
+    uint32_t c = decode_utf8(&p);
+    *s = (const char*)p;
+
+    if (c >= 'A' && c <= 'Z') return c + ('a' - 'A');
+    if (c >= LATIN_FOLD_FIRST && c <= LATIN_FOLD_LAST) {
+        char base = LATIN_FOLD[c - LATIN_FOLD_FIRST];
+        if (base != '.') return (uint32_t)base;
+    }
+    return c;
+}
+
+int collate_compare(const char* a, const char* b) {
+    while (true) {
+        uint32_t ca = collate_next(&a);
+        uint32_t cb = collate_next(&b);
+        if (ca != cb) return ca < cb ? -1 : 1;
+        if (ca == 0) return 0;
+    }
+}
+
+const char* collate_skip_article(const char* name) {
+    const char* p = name;
+    static const char ARTICLE[] = "the ";
+    for (int i = 0; ARTICLE[i]; i++) {
+        if (collate_next(&p) != (uint32_t)ARTICLE[i]) return name;
+    }
+    // "The" alone, or "The " with nothing after it, is the name
+    return *p ? p : name;
+}
@@ -0,0 +1,19 @@
+/*
+ * Collate - Ordering of library names the way a listener expects
+ * Case-insensitive, accents folded to their base letter ("Émilie" sorts with "emilie")
+ *
+ * Names are UTF-8. ASCII and Latin-1 / Latin Extended-A letters are folded; every
+ * other code point compares by value, which keeps each script grouped together.
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Next folded code point of *s, advancing *s past it; 0 at the end of the string
+uint32_t collate_next(const char** s);
+
+// <0, 0 or >0 as a sorts before, with or after b
+int collate_compare(const char* a, const char* b);
+
+// Name without a leading "The " ("The Beatles" sorts under B); the name itself otherwise
+const char* collate_skip_article(const char* name);
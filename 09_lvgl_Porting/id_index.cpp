@@ -0,0 +1,77 @@
+/*
+ * ID Index - Open-addressing hash index from record ID to record index
+ * Built incrementally as records are added; reset in O(1) with the collection
+ */
+
+#include "id_index.h"
+#include <string.h>
+
+// FNV-1a; IDs are UUID-like, so every byte carries entropy
+static uint32_t hash_id(const char* id) {
+    uint32_t hash = 2166136261u;
+    while (*id) {
+        hash = (hash ^ (uint8_t)*id++) * 16777619u;
+    }
+    return hash;
+}
+
+static const char* record_id(const void* records, size_t stride, lib_index_t record) {
+    return (const char*)records + (size_t)record * stride;
+}
+
+bool id_index_init(IdIndex* index, lib_index_t capacity) {
+    uint32_t slot_count = 1;
+    while (slot_count < (uint32_t)capacity * 2) slot_count <<= 1;
+
+    index->slots = nullptr;
+    index->slot_mask = 0;
+    index->probes = 0;
+    index->lookups = 0;
+    if (!arena_init(&index->storage, slot_count * sizeof(IdIndexSlot))) return false;
+
+    index->slots = (IdIndexSlot*)arena_alloc(&index->storage, slot_count * sizeof(IdIndexSlot), alignof(IdIndexSlot));
+    index->slot_mask = slot_count - 1;
+    memset(index->slots, 0, slot_count * sizeof(IdIndexSlot));
+    index->generation = 1;
+    return true;
+}
+
+void id_index_reset(IdIndex* index) {
+    if (!index->slots) return;
+    index->generation++;
+    if (index->generation == 0) {
+        // Wrapped - stale slots could look current again, so clear them once
+        memset(index->slots, 0, (index->slot_mask + 1) * sizeof(IdIndexSlot));
+        index->generation = 1;
+    }
+}
+
+void id_index_insert(IdIndex* index, const char* id, lib_index_t record, const void* records, size_t stride) {
+    if (!index->slots) return;
+
+    uint32_t hash = hash_id(id);
+    uint32_t slot = hash & index->slot_mask;
+    while (index->slots[slot].generation == index->generation) {
+        const IdIndexSlot* s = &index->slots[slot];
+        if (s->hash == hash && strcmp(record_id(records, stride, s->record), id) == 0) return;
+        slot = (slot + 1) & index->slot_mask;
+    }
+    index->slots[slot].hash = hash;
+    index->slots[slot].generation = index->generation;
+    index->slots[slot].record = record;
+}
+
+lib_index_t id_index_find(IdIndex* index, const char* id, const void* records, size_t stride) {
+    if (!index->slots || !id) return ID_INDEX_NONE;
+
+    uint32_t hash = hash_id(id);
+    uint32_t slot = hash & index->slot_mask;
+    index->lookups++;
+    while (index->slots[slot].generation == index->generation) {
+        const IdIndexSlot* s = &index->slots[slot];
+        index->probes++;
+        if (s->hash == hash && strcmp(record_id(records, stride, s->record), id) == 0) return s->record;
+        slot = (slot + 1) & index->slot_mask;
+    }
+    return ID_INDEX_NONE;
+}
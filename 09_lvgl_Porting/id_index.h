@@ -0,0 +1,43 @@
+/*
+ * ID Index - Open-addressing hash index from record ID to record index
+ * Built incrementally as records are added; reset in O(1) with the collection
+ *
+ * The index stores only hashes and record indices. Lookups confirm a hit against the
+ * records themselves, which must start with their NUL-terminated ID (as every BLE*
+ * record does) and be laid out as an array of stride bytes.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "library_data.h"
+
+#define ID_INDEX_NONE   0xFFFF      // Not found
+
+typedef struct {
+    uint32_t hash;
+    uint16_t generation;        // Slot is empty unless this matches the index's generation
+    lib_index_t record;
+} IdIndexSlot;
+
+typedef struct {
+    Arena storage;
+    IdIndexSlot* slots;
+    uint32_t slot_mask;
+    uint16_t generation;
+    uint32_t probes;            // Slots looked at by lookups, for the stats line
+    uint32_t lookups;
+} IdIndex;
+
+// Size the table for capacity records (at most half full), PSRAM first
+bool id_index_init(IdIndex* index, lib_index_t capacity);
+
+// Forget every entry - O(1), slots from older generations read as empty
+void id_index_reset(IdIndex* index);
+
+// Add record under id; an ID already present keeps pointing at its first record
+void id_index_insert(IdIndex* index, const char* id, lib_index_t record, const void* records, size_t stride);
+
+// Record index for id, or ID_INDEX_NONE
+lib_index_t id_index_find(IdIndex* index, const char* id, const void* records, size_t stride);
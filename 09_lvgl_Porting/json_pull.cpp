@@ -0,0 +1,338 @@
+/*
+ * JSON Pull - Streaming JSON reader that never builds a document
+ * Walks a mutable, null-terminated buffer one token at a time in constant memory
+ */
+
+#include "json_pull.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_PULL_MAX_NUMBER    32          // Longest number literal accepted
+
+// ============================================================================
+// Low-level scanning
+// ============================================================================
+
+static bool fail(JsonPull* p) {
+    p->error = true;
+    return false;
+}
+
+// Current character after whitespace, '\0' at the end or after an error
+static char current(JsonPull* p) {
+    if (p->error) return '\0';
+    while (p->pos < p->length) {
+        char c = p->data[p->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') return c;
+        p->pos++;
+    }
+    return '\0';
+}
+
+static bool expect(JsonPull* p, char c) {
+    if (current(p) != c) return fail(p);
+    p->pos++;
+    return true;
+}
+
+static bool match_literal(JsonPull* p, const char* literal) {
+    size_t n = strlen(literal);
+    if (p->length - p->pos < n || strncmp(p->data + p->pos, literal, n) != 0) return fail(p);
+    p->pos += n;
+    return true;
+}
+
+static bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool read_hex4(JsonPull* p, size_t at, uint32_t* out) {
+    if (p->length - at < 4) return false;
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_value(p->data[at + i]);
+        if (digit < 0) return false;
+        value = (value << 4) | (uint32_t)digit;
+    }
+    *out = value;
+    return true;
+}
+
+static size_t write_utf8(char* out, uint32_t cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Unescape the string that starts just past pos's opening quote into out. In place (out
+// inside the buffer) the decoded form never overtakes the source; a copy that does not fit
+// in size is read to its end and handed out empty, so it matches nothing.
+static bool decode_into(JsonPull* p, char* out, size_t size) {
+    size_t read = p->pos;
+    size_t write = 0;
+    bool fits = true;
+
+    while (read < p->length) {
+        char c = p->data[read++];
+        if (c == '"') {
+            out[fits ? write : 0] = '\0';
+            p->pos = read;
+            return true;
+        }
+        if (write + 4 >= size) {
+            fits = false;
+            write = 0;
+        }
+        if (c != '\\') {
+            out[write++] = c;
+            continue;
+        }
+        if (read >= p->length) break;
+
+        char e = p->data[read++];
+        switch (e) {
+            case '"':  out[write++] = '"'; break;
+            case '\\': out[write++] = '\\'; break;
+            case '/':  out[write++] = '/'; break;
+            case 'b':  out[write++] = '\b'; break;
+            case 'f':  out[write++] = '\f'; break;
+            case 'n':  out[write++] = '\n'; break;
+            case 'r':  out[write++] = '\r'; break;
+            case 't':  out[write++] = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!read_hex4(p, read, &cp)) return fail(p);
+                read += 4;
+                // Surrogate pair - the low half follows as another \\u escape
+                uint32_t low;
+                if (cp >= 0xD800 && cp <= 0xDBFF && p->length - read >= 6 && p->data[read] == '\\' &&
+                    p->data[read + 1] == 'u' && read_hex4(p, read + 2, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    read += 6;
+                }
+                write += write_utf8(out + write, cp);
+                break;
+            }
+            default:
+                return fail(p);
+        }
+    }
+    return fail(p);
+}
+
+static bool decode_string(JsonPull* p, const char** out) {
+    if (!expect(p, '"')) return false;
+    char* start = p->data + p->pos;
+    if (!decode_into(p, start, SIZE_MAX)) return false;
+    *out = start;
+    return true;
+}
+
+static bool skip_string(JsonPull* p) {
+    if (!expect(p, '"')) return false;
+    while (p->pos < p->length) {
+        char c = p->data[p->pos++];
+        if (c == '"') return true;
+        if (c == '\\') p->pos++;
+    }
+    return fail(p);
+}
+
+static bool skip_scalar(JsonPull* p) {
+    char c = current(p);
+    if (c == 't') return match_literal(p, "true");
+    if (c == 'f') return match_literal(p, "false");
+    if (c == 'n') return match_literal(p, "null");
+    if (c == '"') return skip_string(p);
+
+    size_t start = p->pos;
+    while (p->pos < p->length && is_number_char(p->data[p->pos])) p->pos++;
+    return p->pos > start ? true : fail(p);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void json_pull_init(JsonPull* p, char* data, size_t length) {
+    p->data = data;
+    p->length = length;
+    p->pos = 0;
+    p->error = false;
+}
+
+JsonPullType json_pull_peek(JsonPull* p) {
+    char c = current(p);
+    switch (c) {
+        case '{': return JSON_PULL_OBJECT;
+        case '[': return JSON_PULL_ARRAY;
+        case '"': return JSON_PULL_STRING;
+        case 't':
+        case 'f': return JSON_PULL_BOOL;
+        case 'n': return JSON_PULL_NULL;
+        case '}':
+        case ']':
+        case '\0': return p->error ? JSON_PULL_INVALID : JSON_PULL_END;
+        default:  return (c == '-' || (c >= '0' && c <= '9')) ? JSON_PULL_NUMBER : JSON_PULL_INVALID;
+    }
+}
+
+bool json_pull_object_begin(JsonPull* p) {
+    return expect(p, '{');
+}
+
+bool json_pull_object_next(JsonPull* p, const char** key) {
+    char c = current(p);
+    if (c == '}') {
+        p->pos++;
+        return false;
+    }
+    if (c == ',') p->pos++;
+    if (!decode_string(p, key)) return false;
+    return expect(p, ':');
+}
+
+bool json_pull_object_next_copy(JsonPull* p, char* key, size_t size) {
+    char c = current(p);
+    if (c == '}') {
+        p->pos++;
+        return false;
+    }
+    if (c == ',') p->pos++;
+    if (!expect(p, '"') || !decode_into(p, key, size)) return false;
+    return expect(p, ':');
+}
+
+bool json_pull_array_begin(JsonPull* p) {
+    return expect(p, '[');
+}
+
+bool json_pull_array_next(JsonPull* p) {
+    char c = current(p);
+    if (c == ']') {
+        p->pos++;
+        return false;
+    }
+    if (c == ',') p->pos++;
+    return !p->error && current(p) != '\0';
+}
+
+bool json_pull_string(JsonPull* p, const char** out) {
+    return decode_string(p, out);
+}
+
+bool json_pull_string_copy(JsonPull* p, char* out, size_t size) {
+    return expect(p, '"') && decode_into(p, out, size);
+}
+
+bool json_pull_number(JsonPull* p, double* out) {
+    current(p);
+    size_t start = p->pos;
+    while (p->pos < p->length && is_number_char(p->data[p->pos])) p->pos++;
+
+    size_t n = p->pos - start;
+    if (n == 0 || n >= JSON_PULL_MAX_NUMBER) return fail(p);
+
+    // Copy out so strtod never runs past the number
+    char number[JSON_PULL_MAX_NUMBER];
+    memcpy(number, p->data + start, n);
+    number[n] = '\0';
+    char* end;
+    *out = strtod(number, &end);
+    return end == number + n ? true : fail(p);
+}
+
+bool json_pull_bool(JsonPull* p, bool* out) {
+    char c = current(p);
+    if (c == 't' && match_literal(p, "true")) {
+        *out = true;
+        return true;
+    }
+    if (c == 'f' && match_literal(p, "false")) {
+        *out = false;
+        return true;
+    }
+    return fail(p);
+}
+
+const char* json_pull_string_or(JsonPull* p, const char* fallback) {
+    const char* value;
+    if (json_pull_peek(p) != JSON_PULL_STRING) {
+        json_pull_skip(p);
+        return fallback;
+    }
+    return json_pull_string(p, &value) ? value : fallback;
+}
+
+double json_pull_number_or(JsonPull* p, double fallback) {
+    double value;
+    if (json_pull_peek(p) != JSON_PULL_NUMBER) {
+        json_pull_skip(p);
+        return fallback;
+    }
+    return json_pull_number(p, &value) ? value : fallback;
+}
+
+bool json_pull_bool_or(JsonPull* p, bool fallback) {
+    bool value;
+    if (json_pull_peek(p) != JSON_PULL_BOOL) {
+        json_pull_skip(p);
+        return fallback;
+    }
+    return json_pull_bool(p, &value) ? value : fallback;
+}
+
+bool json_pull_skip(JsonPull* p) {
+    // Iterative so nesting depth costs no stack
+    uint32_t depth = 0;
+    do {
+        char c = current(p);
+        if (c == '{' || c == '[') {
+            depth++;
+            p->pos++;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) return fail(p);
+            depth--;
+            p->pos++;
+        } else if ((c == ',' || c == ':') && depth > 0) {
+            p->pos++;
+        } else if (c == '\0' || !skip_scalar(p)) {
+            return fail(p);
+        }
+    } while (depth > 0);
+    return true;
+}
+
+bool json_pull_find(JsonPull* p, const char* key) {
+    if (!json_pull_object_begin(p)) return false;
+    const char* name;
+    while (json_pull_object_next(p, &name)) {
+        if (strcmp(name, key) == 0) return true;
+        if (!json_pull_skip(p)) return false;
+    }
+    return false;
+}
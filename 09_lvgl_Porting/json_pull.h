@@ -0,0 +1,64 @@
+/*
+ * JSON Pull - Streaming JSON reader that never builds a document
+ * Walks a mutable, null-terminated buffer one token at a time in constant memory
+ *
+ * Strings (keys and values) are unescaped in place and handed out as pointers into
+ * the buffer, so each one may be read once; skipped values are left untouched. The *_copy
+ * reads decode into a caller buffer instead, for a look-ahead that a later pass repeats.
+ * Any malformed input sets p->error and makes every later call return false.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    JSON_PULL_END,              // End of input, or the current container is closed
+    JSON_PULL_OBJECT,
+    JSON_PULL_ARRAY,
+    JSON_PULL_STRING,
+    JSON_PULL_NUMBER,
+    JSON_PULL_BOOL,
+    JSON_PULL_NULL,
+    JSON_PULL_INVALID
+} JsonPullType;
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t pos;
+    bool error;
+} JsonPull;
+
+void json_pull_init(JsonPull* p, char* data, size_t length);
+
+// Type of the next value without consuming it
+JsonPullType json_pull_peek(JsonPull* p);
+
+// Containers: call *_begin on the value, then *_next until it returns false (the
+// closing bracket is consumed then). object_next yields the key, positioned on its value.
+bool json_pull_object_begin(JsonPull* p);
+bool json_pull_object_next(JsonPull* p, const char** key);
+bool json_pull_array_begin(JsonPull* p);
+// object_next without touching the buffer: the key is copied into key ("" if longer than size - 1)
+bool json_pull_object_next_copy(JsonPull* p, char* key, size_t size);
+bool json_pull_array_next(JsonPull* p);
+
+// Scalars. Each consumes the value; a value of another type is an error.
+bool json_pull_string(JsonPull* p, const char** out);
+bool json_pull_number(JsonPull* p, double* out);
+bool json_pull_bool(JsonPull* p, bool* out);
+// string without touching the buffer, copied into out ("" if longer than size - 1)
+bool json_pull_string_copy(JsonPull* p, char* out, size_t size);
+
+// Typed reads that take null or a wrong-typed value as "absent": the value is skipped and
+// the fallback returned, the way ArduinoJson's `value | fallback` behaves
+const char* json_pull_string_or(JsonPull* p, const char* fallback);
+double json_pull_number_or(JsonPull* p, double fallback);
+bool json_pull_bool_or(JsonPull* p, bool fallback);
+
+// Skip one value of any type, nested containers included, without modifying the buffer
+bool json_pull_skip(JsonPull* p);
+
+// Find key in the object the reader is positioned on and stop on its value
+bool json_pull_find(JsonPull* p, const char* key);
@@ -4,35 +4,88 @@
  */
 
 #include "library_data.h"
+#include "arena.h"
+#include "id_index.h"
+#include "sort_index.h"
+#include "search_index.h"
+#include "collate.h"
+#include "library_image.h"
+#include "abp_frame.h"
+#include "app_log.h"
+#include <stddef.h>
 #include <string.h>
+#include <atomic>
+#ifdef ARDUINO
 #include <Arduino.h>
 #include <Preferences.h>
 
 // NVS storage
 static Preferences g_prefs;
 static const char* PREFS_NAMESPACE = "amperfy";
+#endif
 
 // Last selected indices (persisted)
-static uint8_t g_last_playlist_index = 0;
-static uint8_t g_last_artist_index = 0;
-static uint8_t g_last_album_index = 0;
-
-// Storage arrays
-static BLEPlaylist g_playlists[MAX_BLE_PLAYLISTS];
-static uint8_t g_playlist_count = 0;
-
-static BLEArtist g_artists[MAX_BLE_ARTISTS];
-static uint8_t g_artist_count = 0;
-
-static BLEAlbum g_albums[MAX_BLE_ALBUMS];
-static uint8_t g_album_count = 0;
-
-static BLESong g_songs[MAX_BLE_SONGS];
-static uint8_t g_song_count = 0;
-
-// Song context tracking
-static char g_song_context_type[32] = {0};
-static char g_song_context_id[MAX_ID_LENGTH] = {0};
+static lib_index_t g_last_playlist_index = 0;
+static lib_index_t g_last_artist_index = 0;
+static lib_index_t g_last_album_index = 0;
+
+// Storage - one arena per collection version so each can be rebuilt on its own. Records
+// of one type are all the same size, so the arena lays them out as a plain array.
+typedef struct {
+    Arena arena;
+    const uint8_t* records;     // arena.base, or the table of the attached image
+    const LibraryImageHeader* image;    // Attached image, read-only
+    SearchIndex image_search;   // View of the image's words while attached
+    IdIndex ids;                // Record ID -> index
+    SortIndex sorts[LIBRARY_ORDER_COUNT];
+    SearchIndex search;         // Words of each record's name
+    StringPool names;           // Artist/album names shared between records (albums, songs)
+    lib_index_t count;
+    bool retired;               // Was live, readers may still be on it
+    uint32_t retired_frame;     // g_frames when it was replaced
+    char context_type[32];      // Songs: the list this version holds
+    char context_id[MAX_ID_LENGTH];
+    uint32_t window_start;      // Songs: list position of the first record ...
+    uint32_t list_total;        // ... and the list's length, 0 when it is all here
+    uint32_t revision;          // App's revision of these records, 0 = none
+} CollectionVersion;
+
+// Two versions per collection: readers only ever see the live one, complete; the next
+// is built beside it and published with one pointer swap (see library_publish())
+typedef struct {
+    CollectionVersion versions[2];
+    std::atomic<CollectionVersion*> live;
+    CollectionVersion* next;    // Being built by the collection's writer, nullptr when none is open
+    const SortCompare* compares;        // Per LibraryOrder, nullptr where unsupported
+    SearchName name_of;
+    size_t record_size;
+    size_t record_align;
+    lib_index_t capacity;
+    lib_index_t high_water;
+    uint32_t publishes;
+    uint32_t grace_waits;       // Builds that had to wait for the UI to leave a version
+} Collection;
+
+// The ID index reads IDs straight from the records
+static_assert(offsetof(BLEPlaylist, id) == 0 && offsetof(BLEArtist, id) == 0 &&
+              offsetof(BLEAlbum, id) == 0 && offsetof(BLESong, id) == 0, "records must start with their ID");
+
+static Collection g_collections[LIBRARY_COLLECTION_COUNT];
+static const char* COLLECTION_NAMES[LIBRARY_COLLECTION_COUNT] = {"playlists", "artists", "albums", "songs"};
+
+// Live until a collection's first publish, and what clearing publishes - never written
+static CollectionVersion g_empty_version;
+
+// Frames the UI has drawn (library_note_frame()), 0 until it runs
+static std::atomic<uint32_t> g_frames(0);
+
+// Run of new records being merged into a sort index, sized for the largest collection
+static Arena g_sort_scratch;
+static lib_index_t* g_sort_run = nullptr;
+
+// Words being merged into a search index, a page's worth at a time
+#define LIBRARY_SEARCH_RUN  256
+static SearchWord g_search_run[LIBRARY_SEARCH_RUN];
 
 // Flag to track if we have BLE data
 static bool g_has_ble_data = false;
@@ -40,15 +93,476 @@ static bool g_has_ble_data = false;
 // Helper to safely copy strings
 static void safe_strcpy(char* dest, const char* src, size_t dest_size) {
     if (src) {
-        strncpy(dest, src, dest_size - 1);
-        dest[dest_size - 1] = '\0';
+        // Copy only the string, strncpy would also zero-fill the rest of the field
+        size_t length = strnlen(src, dest_size - 1);
+        memcpy(dest, src, length);
+        dest[length] = '\0';
     } else {
         dest[0] = '\0';
     }
 }
 
-void library_data_init(void) {
+static const CollectionVersion* version_of(const void* context) {
+    return (const CollectionVersion*)context;
+}
+
+// Album or song artist/album name by handle, from the pool or the attached image
+static const char* version_name(const CollectionVersion* v, StrHandle handle) {
+    return v->image ? library_image_name(v->image, handle) : string_pool_get(&v->names, handle);
+}
+
+// ============================================================================
+// Sort Orders
+// ============================================================================
+
+// Each comparator and name function gets the version being sorted or searched
+
+static const BLEPlaylist* playlists_in(const void* context) {
+    return (const BLEPlaylist*)version_of(context)->records;
+}
+
+static const BLEArtist* artists_in(const void* context) {
+    return (const BLEArtist*)version_of(context)->records;
+}
+
+static const BLEAlbum* albums_in(const void* context) {
+    return (const BLEAlbum*)version_of(context)->records;
+}
+
+static const BLESong* songs_in(const void* context) {
+    return (const BLESong*)version_of(context)->records;
+}
+
+// Unknown years and track numbers (0) sort last
+static int compare_numbers(uint16_t a, uint16_t b) {
+    if (a == b) return 0;
+    if (a == 0) return 1;
+    if (b == 0) return -1;
+    return a < b ? -1 : 1;
+}
+
+static int compare_playlist_names(const void* context, lib_index_t a, lib_index_t b) {
+    const BLEPlaylist* playlists = playlists_in(context);
+    return collate_compare(playlists[a].name, playlists[b].name);
+}
+
+static int compare_artist_names(const void* context, lib_index_t a, lib_index_t b) {
+    const BLEArtist* artists = artists_in(context);
+    return collate_compare(collate_skip_article(artists[a].name), collate_skip_article(artists[b].name));
+}
+
+static int compare_album_names(const void* context, lib_index_t a, lib_index_t b) {
+    const BLEAlbum* albums = albums_in(context);
+    int result = collate_compare(albums[a].name, albums[b].name);
+    if (result != 0) return result;
+    return collate_compare(version_name(version_of(context), albums[a].artist),
+                           version_name(version_of(context), albums[b].artist));
+}
+
+static int compare_album_artists(const void* context, lib_index_t a, lib_index_t b) {
+    const BLEAlbum* albums = albums_in(context);
+    int result = collate_compare(collate_skip_article(version_name(version_of(context), albums[a].artist)),
+                                 collate_skip_article(version_name(version_of(context), albums[b].artist)));
+    if (result != 0) return result;
+    result = compare_numbers(albums[a].year, albums[b].year);
+    if (result != 0) return result;
+    return collate_compare(albums[a].name, albums[b].name);
+}
+
+static int compare_album_years(const void* context, lib_index_t a, lib_index_t b) {
+    const BLEAlbum* albums = albums_in(context);
+    int result = compare_numbers(albums[a].year, albums[b].year);
+    if (result != 0) return result;
+    return collate_compare(albums[a].name, albums[b].name);
+}
+
+static int compare_song_titles(const void* context, lib_index_t a, lib_index_t b) {
+    const BLESong* songs = songs_in(context);
+    int result = collate_compare(songs[a].title, songs[b].title);
+    if (result != 0) return result;
+    return collate_compare(version_name(version_of(context), songs[a].artist),
+                           version_name(version_of(context), songs[b].artist));
+}
+
+// Album, then track - an artist's songs come out album by album
+static int compare_song_tracks(const void* context, lib_index_t a, lib_index_t b) {
+    const BLESong* songs = songs_in(context);
+    int result = collate_compare(version_name(version_of(context), songs[a].album),
+                                 version_name(version_of(context), songs[b].album));
+    if (result != 0) return result;
+    result = compare_numbers(songs[a].track_number, songs[b].track_number);
+    if (result != 0) return result;
+    return collate_compare(songs[a].title, songs[b].title);
+}
+
+static int compare_song_artists(const void* context, lib_index_t a, lib_index_t b) {
+    const BLESong* songs = songs_in(context);
+    int result = collate_compare(collate_skip_article(version_name(version_of(context), songs[a].artist)),
+                                 collate_skip_article(version_name(version_of(context), songs[b].artist)));
+    if (result != 0) return result;
+    return compare_song_tracks(context, a, b);
+}
+
+static const char* playlist_name(const void* context, lib_index_t record) {
+    return playlists_in(context)[record].name;
+}
+
+static const char* artist_name(const void* context, lib_index_t record) {
+    return artists_in(context)[record].name;
+}
+
+static const char* album_name(const void* context, lib_index_t record) {
+    return albums_in(context)[record].name;
+}
+
+static const char* song_title(const void* context, lib_index_t record) {
+    return songs_in(context)[record].title;
+}
+
+// Indexed by LibraryOrder
+static const SortCompare PLAYLIST_ORDERS[LIBRARY_ORDER_COUNT] = {nullptr, compare_playlist_names, nullptr, nullptr,
+                                                                 nullptr};
+static const SortCompare ARTIST_ORDERS[LIBRARY_ORDER_COUNT] = {nullptr, compare_artist_names, nullptr, nullptr,
+                                                               nullptr};
+static const SortCompare ALBUM_ORDERS[LIBRARY_ORDER_COUNT] = {nullptr, compare_album_names, compare_album_artists,
+                                                              compare_album_years, nullptr};
+static const SortCompare SONG_ORDERS[LIBRARY_ORDER_COUNT] = {nullptr, compare_song_titles, compare_song_artists,
+                                                             nullptr, compare_song_tracks};
+
+// ============================================================================
+// Collections
+// ============================================================================
+
+static bool version_init(Collection* c, CollectionVersion* v, lib_index_t capacity, uint32_t names) {
+    bool ok = arena_init(&v->arena, (size_t)capacity * c->record_size) && id_index_init(&v->ids, capacity) &&
+              search_index_init(&v->search, (uint32_t)capacity * LIBRARY_SEARCH_AVG_WORDS);
+    for (int order = 0; ok && order < LIBRARY_ORDER_COUNT; order++) {
+        if (c->compares[order]) ok = sort_index_init(&v->sorts[order], capacity);
+    }
+    if (ok && names > 0) ok = string_pool_init(&v->names, (uint16_t)names, names * LIBRARY_POOL_AVG_NAME);
+    v->records = v->arena.base;
+    return ok;
+}
+
+// names: pooled names per version, 0 for collections without any
+static bool collection_init(Collection* c, lib_index_t capacity, size_t record_size, size_t record_align,
+                            const SortCompare* compares, SearchName name_of, uint32_t names) {
+    c->high_water = 0;
+    c->record_size = record_size;
+    c->record_align = record_align;
+    c->compares = compares;
+    c->name_of = name_of;
+    c->next = nullptr;
+    c->live.store(&g_empty_version, std::memory_order_release);
+    bool ok = version_init(c, &c->versions[0], capacity, names) && version_init(c, &c->versions[1], capacity, names);
+    c->capacity = ok ? capacity : 0;
+    return ok;
+}
+
+static LibraryCollection collection_of(const Collection* c) {
+    return (LibraryCollection)(c - g_collections);
+}
+
+// The version readers see. Records of a published version never change; a reader that
+// loaded it keeps a consistent view until the UI's next frames (see library_note_frame()).
+static CollectionVersion* live_version(LibraryCollection collection) {
+    return g_collections[collection].live.load(std::memory_order_acquire);
+}
+
+// Version a record pointer came from - a reader may still hold one from the version a
+// swap just replaced
+static const CollectionVersion* version_holding(Collection* c, const void* record) {
+    const uint8_t* p = (const uint8_t*)record;
+    for (const CollectionVersion& v : c->versions) {
+        if (v.records && p >= v.records && p < v.records + (size_t)v.count * c->record_size) return &v;
+    }
+    return c->live.load(std::memory_order_acquire);
+}
+
+static void version_reset(CollectionVersion* v) {
+    v->image = nullptr;
+    v->records = v->arena.base;
+    arena_reset(&v->arena);
+    id_index_reset(&v->ids);
+    search_index_reset(&v->search);
+    for (int order = 0; order < LIBRARY_ORDER_COUNT; order++) {
+        sort_index_reset(&v->sorts[order]);
+    }
+    string_pool_reset(&v->names);
+    v->count = 0;
+    v->context_type[0] = '\0';
+    v->context_id[0] = '\0';
+    v->window_start = 0;
+    v->list_total = 0;
+    v->revision = 0;
+}
+
+// Grace period: a UI reader that loaded v before it was replaced is done with it once the
+// frame counter has moved twice - the frame it was in ticks at most once. Writers are never
+// the UI task, which could not draw them. A UI that stopped drawing is logged, not
+// overtaken: reusing v early could reset it under a reader.
+static void wait_for_readers(Collection* c, CollectionVersion* v) {
+    if (!v->retired) return;
+    v->retired = false;
+    if (g_frames.load(std::memory_order_acquire) == 0) return;     // No UI yet, nobody else reads
+
+    uint32_t waited = 0;
+    while (g_frames.load(std::memory_order_acquire) - v->retired_frame < LIBRARY_GRACE_FRAMES) {
+        if (waited == 0) c->grace_waits++;
+        if (waited > 0 && waited % LIBRARY_GRACE_TIMEOUT_MS == 0) {
+            LOGW(LIBRARY, "No UI frame in %u ms, still waiting to reuse the old %s", (unsigned)waited,
+                 COLLECTION_NAMES[collection_of(c)]);
+        }
+#ifdef ARDUINO
+        delay(1);
+#endif
+        waited++;
+    }
+}
+
+// Start a new version in the buffer readers are not on; restarts one already open
+static CollectionVersion* collection_begin(Collection* c) {
+    CollectionVersion* v = c->next;
+    if (!v) {
+        v = c->live.load(std::memory_order_relaxed) == &c->versions[0] ? &c->versions[1] : &c->versions[0];
+        wait_for_readers(c, v);
+    }
+    version_reset(v);
+    c->next = v;
+    return v;
+}
+
+// Version pages go into, starting one when none is open
+static CollectionVersion* collection_building(Collection* c) {
+    return c->next ? c->next : collection_begin(c);
+}
+
+// One pointer swap; the version it replaces is stamped for the grace period
+static void collection_publish(Collection* c, CollectionVersion* v) {
+    CollectionVersion* old = c->live.load(std::memory_order_relaxed);
+    c->live.store(v, std::memory_order_release);
+    if (old != &g_empty_version && old != v) {
+        old->retired = true;
+        old->retired_frame = g_frames.load(std::memory_order_acquire);
+    }
+    if (v == c->next) c->next = nullptr;
+    c->publishes++;
+    if (v->count > 0) g_has_ble_data = true;
+}
+
+// Next free record of v with its ID filled in and indexed, or nullptr when v is full
+static void* collection_add(Collection* c, CollectionVersion* v, const char* id) {
+    if (v->count >= c->capacity) return nullptr;
+    char* record = (char*)arena_alloc(&v->arena, c->record_size, c->record_align);
+    if (!record) return nullptr;
+
+    safe_strcpy(record, id, MAX_ID_LENGTH);
+    id_index_insert(&v->ids, record, v->count, v->arena.base, c->record_size);
+    v->count++;
+    if (v->count > c->high_water) c->high_water = v->count;
+    return record;
+}
+
+static const void* version_find(Collection* c, CollectionVersion* v, const char* id) {
+    if (v->count == 0) return nullptr;
+    if (v->image) {
+        lib_index_t index = library_image_find(v->image, collection_of(c), id);
+        return index == LIBRARY_IMAGE_NO_RECORD ? nullptr : v->records + (size_t)index * c->record_size;
+    }
+    lib_index_t index = id_index_find(&v->ids, id, v->records, c->record_size);
+    return index == ID_INDEX_NONE ? nullptr : v->records + (size_t)index * c->record_size;
+}
+
+static const void* collection_get(LibraryCollection collection, lib_index_t index) {
+    const CollectionVersion* v = live_version(collection);
+    if (index >= v->count) return nullptr;
+    return v->records + (size_t)index * g_collections[collection].record_size;
+}
+
+static const void* collection_find(LibraryCollection collection, const char* id) {
+    Collection* c = &g_collections[collection];
+    return version_find(c, c->live.load(std::memory_order_acquire), id);
+}
+
+static const SearchIndex* version_search(const CollectionVersion* v) {
+    return v->image ? &v->image_search : &v->search;
+}
+
+static lib_index_t version_sorted_index(const Collection* c, const CollectionVersion* v, LibraryOrder order,
+                                        lib_index_t position) {
+    if (!c->compares || !c->compares[order]) return position;
+    if (v->image) {
+        const lib_index_t* positions = library_image_order(v->image, collection_of(c), order);
+        return positions && position < v->count ? positions[position] : position;
+    }
+    return sort_index_get(&v->sorts[order], position);
+}
+
+// Index the name of the record collection_add() just returned, once it is filled in
+static void collection_index_name(Collection* c, CollectionVersion* v) {
+    lib_index_t record = v->count - 1;
+    search_index_add(&v->search, record, c->name_of(v, record));
+}
+
+bool library_data_init(const LibraryCapacity* capacity) {
+    static const LibraryCapacity defaults = {MAX_BLE_PLAYLISTS, MAX_BLE_ARTISTS, MAX_BLE_ALBUMS, MAX_BLE_SONGS};
+    if (!capacity) capacity = &defaults;
+
+    // Albums pool one name (artist) per record, songs two (artist, album); handles are
+    // 16-bit, so a pool tops out at 65535 distinct names
+    uint32_t album_names = (uint32_t)capacity->albums + 1;
+    uint32_t song_names = (uint32_t)capacity->songs * 2 + 1;
+    if (album_names > 65535) album_names = 65535;
+    if (song_names > 65535) song_names = 65535;
+
+    bool ok = collection_init(&g_collections[LIBRARY_PLAYLISTS], capacity->playlists, sizeof(BLEPlaylist),
+                              alignof(BLEPlaylist), PLAYLIST_ORDERS, playlist_name, 0);
+    ok &= collection_init(&g_collections[LIBRARY_ARTISTS], capacity->artists, sizeof(BLEArtist), alignof(BLEArtist),
+                          ARTIST_ORDERS, artist_name, 0);
+    ok &= collection_init(&g_collections[LIBRARY_ALBUMS], capacity->albums, sizeof(BLEAlbum), alignof(BLEAlbum),
+                          ALBUM_ORDERS, album_name, album_names);
+    ok &= collection_init(&g_collections[LIBRARY_SONGS], capacity->songs, sizeof(BLESong), alignof(BLESong),
+                          SONG_ORDERS, song_title, song_names);
+
+    lib_index_t largest = 0;
+    for (int i = 0; i < LIBRARY_COLLECTION_COUNT; i++) {
+        if (g_collections[i].capacity > largest) largest = g_collections[i].capacity;
+    }
+    ok &= arena_init(&g_sort_scratch, (size_t)largest * sizeof(lib_index_t));
+    g_sort_run = (lib_index_t*)arena_alloc(&g_sort_scratch, (size_t)largest * sizeof(lib_index_t),
+                                           alignof(lib_index_t));
+    if (!ok) {
+        LOGE(LIBRARY, "Failed to allocate library store");
+    }
+
     library_data_clear();
+    library_log_store_stats();
+    return ok;
+}
+
+lib_index_t library_get_capacity(LibraryCollection collection) {
+    return g_collections[collection].capacity;
+}
+
+void library_get_store_stats(LibraryCollection collection, LibraryStoreStats* stats) {
+    const Collection* c = &g_collections[collection];
+    const CollectionVersion* v = live_version(collection);
+    stats->count = v->count;
+    stats->capacity = c->capacity;
+    stats->high_water = c->high_water;
+    stats->bytes_used = v->arena.used;
+    stats->bytes_capacity = c->versions[0].arena.capacity;
+    stats->bytes_high_water = c->versions[0].arena.high_water > c->versions[1].arena.high_water
+                                  ? c->versions[0].arena.high_water
+                                  : c->versions[1].arena.high_water;
+    stats->in_psram = c->versions[0].arena.in_psram;
+    stats->publishes = c->publishes;
+}
+
+void library_log_store_stats(void) {
+    for (int i = 0; i < LIBRARY_COLLECTION_COUNT; i++) {
+        LibraryStoreStats stats;
+        library_get_store_stats((LibraryCollection)i, &stats);
+        const Collection* c = &g_collections[i];
+        const CollectionVersion* v = live_version((LibraryCollection)i);
+        uint32_t compares = 0;
+        for (const CollectionVersion& version : c->versions) {
+            for (int order = 0; order < LIBRARY_ORDER_COUNT; order++) {
+                compares += version.sorts[order].compares;
+            }
+        }
+        LOGI(LIBRARY, "Store %-9s %u/%u (hw %u) bytes=%u/%u (hw %u) %s id_lookups=%u probes=%u sort_compares=%u",
+             COLLECTION_NAMES[i], (unsigned)stats.count, (unsigned)stats.capacity, (unsigned)stats.high_water,
+             (unsigned)stats.bytes_used, (unsigned)stats.bytes_capacity, (unsigned)stats.bytes_high_water,
+             v->image ? "image" : stats.in_psram ? "psram" : "internal", (unsigned)v->ids.lookups,
+             (unsigned)v->ids.probes, (unsigned)compares);
+        const SearchIndex* search = version_search(v);
+        LOGI(LIBRARY, "Search %-8s words=%u/%u dropped=%u publishes=%u grace_waits=%u%s", COLLECTION_NAMES[i],
+             (unsigned)search->count, (unsigned)search->capacity, (unsigned)search->dropped,
+             (unsigned)c->publishes, (unsigned)c->grace_waits, c->next ? " (building)" : "");
+    }
+
+    const LibraryCollection pooled[] = {LIBRARY_ALBUMS, LIBRARY_SONGS};
+    for (LibraryCollection collection : pooled) {
+        const StringPool* pool = &live_version(collection)->names;
+        LOGI(LIBRARY, "Names %-9s %u/%u bytes=%u/%u (hw %u) hits=%u/%u failed=%u", COLLECTION_NAMES[collection],
+             (unsigned)pool->count, (unsigned)pool->max_strings, (unsigned)pool->chars.used,
+             (unsigned)pool->chars.capacity, (unsigned)pool->chars.high_water, (unsigned)pool->stats.hits,
+             (unsigned)pool->stats.interned, (unsigned)pool->stats.failed);
+    }
+}
+
+bool library_supports_order(LibraryCollection collection, LibraryOrder order) {
+    const Collection* c = &g_collections[collection];
+    return order == LIBRARY_ORDER_ARRIVAL || (c->compares && c->compares[order]);
+}
+
+void library_update_sort_indexes(LibraryCollection collection) {
+    Collection* c = &g_collections[collection];
+    CollectionVersion* v = c->next;
+    if (!g_sort_run || !c->compares || !v) return;
+    for (int order = 0; order < LIBRARY_ORDER_COUNT; order++) {
+        if (c->compares[order]) sort_index_update(&v->sorts[order], v->count, c->compares[order], v, g_sort_run);
+    }
+}
+
+lib_index_t library_get_sorted_index(LibraryCollection collection, LibraryOrder order, lib_index_t position) {
+    return version_sorted_index(&g_collections[collection], live_version(collection), order, position);
+}
+
+void library_update_search_index(LibraryCollection collection) {
+    CollectionVersion* v = g_collections[collection].next;
+    if (!v) return;
+    search_index_update(&v->search, g_search_run, LIBRARY_SEARCH_RUN);
+}
+
+uint16_t library_search(const char* query, LibrarySearchHit* hits, uint16_t max_hits) {
+    static const LibraryCollection ORDER[] = {LIBRARY_ARTISTS, LIBRARY_ALBUMS, LIBRARY_PLAYLISTS, LIBRARY_SONGS};
+    static lib_index_t records[LIBRARY_SEARCH_RUN];
+    if (max_hits > LIBRARY_SEARCH_RUN) max_hits = LIBRARY_SEARCH_RUN;
+
+    uint16_t found = 0;
+    for (int i = 0; i < LIBRARY_COLLECTION_COUNT; i++) {
+        // An even share of what is left, so a collection with few hits leaves room for the next
+        uint16_t share = (max_hits - found) / (LIBRARY_COLLECTION_COUNT - i);
+        if (i == LIBRARY_COLLECTION_COUNT - 1) share = max_hits - found;
+        const Collection* c = &g_collections[ORDER[i]];
+        const CollectionVersion* v = c->live.load(std::memory_order_acquire);
+        if (share == 0 || !c->name_of) continue;
+
+        uint16_t count = search_index_query(version_search(v), query, c->name_of, v, records, share);
+        for (uint16_t r = 0; r < count; r++) {
+            hits[found].collection = ORDER[i];
+            hits[found].record = records[r];
+            found++;
+        }
+    }
+    return found;
+}
+
+void library_begin_update(LibraryCollection collection) {
+    collection_begin(&g_collections[collection]);
+}
+
+void library_publish(LibraryCollection collection) {
+    Collection* c = &g_collections[collection];
+    if (c->next) collection_publish(c, c->next);
+}
+
+void library_note_frame(void) {
+    g_frames.fetch_add(1, std::memory_order_release);
+}
+
+// Songs are left to their own writer - they never read the image
+void library_reclaim(void) {
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        Collection* c = &g_collections[i];
+        for (CollectionVersion& v : c->versions) {
+            if (!v.retired) continue;
+            wait_for_readers(c, &v);
+            version_reset(&v);
+        }
+    }
 }
 
 void library_data_clear(void) {
@@ -63,47 +577,232 @@ bool library_has_ble_data(void) {
     return g_has_ble_data;
 }
 
+// ============================================================================
+// Library Image
+// ============================================================================
+
+static uint32_t image_align(uint32_t offset) {
+    return (offset + LIBRARY_IMAGE_ALIGN - 1) & ~(uint32_t)(LIBRARY_IMAGE_ALIGN - 1);
+}
+
+// Album artist names by handle, from the pool or the attached image
+static uint32_t album_artist_count(const CollectionVersion* albums) {
+    return albums->image ? albums->image->name_count : albums->names.count;
+}
+
+// Where each section goes; the header's offsets, counts and size
+static void image_layout(const CollectionVersion* const* versions, LibraryImageHeader* header) {
+    memset(header, 0, sizeof(*header));
+    header->magic = LIBRARY_IMAGE_MAGIC;
+    header->version = LIBRARY_IMAGE_VERSION;
+    header->header_size = sizeof(LibraryImageHeader);
+
+    const CollectionVersion* albums = versions[LIBRARY_ALBUMS];
+    uint32_t offset = sizeof(LibraryImageHeader);
+    header->names = offset;
+    header->name_count = album_artist_count(albums);
+    offset = image_align(offset + header->name_count * sizeof(uint32_t));
+    header->strings = offset;
+    for (uint32_t handle = 0; handle < header->name_count; handle++) {
+        header->strings_size += strlen(version_name(albums, (StrHandle)handle)) + 1;
+    }
+    offset = image_align(offset + header->strings_size);
+
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        const CollectionVersion* v = versions[i];
+        LibraryImageCollection* section = &header->collections[i];
+        section->count = v->count;
+        section->records = offset;
+        offset = image_align(offset + v->count * g_collections[i].record_size);
+
+        if (v->count > 0) {
+            section->id_slot_count = 2;
+            while (section->id_slot_count < 2u * v->count) section->id_slot_count <<= 1;
+            section->id_slots = offset;
+            offset = image_align(offset + section->id_slot_count * sizeof(lib_index_t));
+        }
+        for (int order = LIBRARY_ORDER_ARRIVAL + 1; order < LIBRARY_ORDER_COUNT; order++) {
+            if (!library_supports_order((LibraryCollection)i, (LibraryOrder)order)) continue;
+            section->orders[order] = offset;
+            offset = image_align(offset + v->count * sizeof(lib_index_t));
+        }
+
+        // Words not merged yet are left out - the page indexes are current after a sync
+        section->words = offset;
+        section->word_count = version_search(v)->sorted;
+        offset = image_align(offset + section->word_count * sizeof(SearchWord));
+        section->revision = v->revision;
+    }
+    header->image_size = offset;
+}
+
+// Field by field into zeroed memory, so bytes past each name stay zero and equal
+// libraries give identical images
+static void image_write_records(const CollectionVersion* const* versions, const LibraryImageHeader* header,
+                                uint8_t* image) {
+    const BLEPlaylist* from_playlists = playlists_in(versions[LIBRARY_PLAYLISTS]);
+    BLEPlaylist* playlists = (BLEPlaylist*)(image + header->collections[LIBRARY_PLAYLISTS].records);
+    for (lib_index_t i = 0; i < versions[LIBRARY_PLAYLISTS]->count; i++) {
+        safe_strcpy(playlists[i].id, from_playlists[i].id, MAX_ID_LENGTH);
+        safe_strcpy(playlists[i].name, from_playlists[i].name, MAX_NAME_LENGTH);
+        playlists[i].song_count = from_playlists[i].song_count;
+    }
+    const BLEArtist* from_artists = artists_in(versions[LIBRARY_ARTISTS]);
+    BLEArtist* artists = (BLEArtist*)(image + header->collections[LIBRARY_ARTISTS].records);
+    for (lib_index_t i = 0; i < versions[LIBRARY_ARTISTS]->count; i++) {
+        safe_strcpy(artists[i].id, from_artists[i].id, MAX_ID_LENGTH);
+        safe_strcpy(artists[i].name, from_artists[i].name, MAX_NAME_LENGTH);
+        artists[i].album_count = from_artists[i].album_count;
+        artists[i].song_count = from_artists[i].song_count;
+    }
+    const BLEAlbum* from_albums = albums_in(versions[LIBRARY_ALBUMS]);
+    BLEAlbum* albums = (BLEAlbum*)(image + header->collections[LIBRARY_ALBUMS].records);
+    for (lib_index_t i = 0; i < versions[LIBRARY_ALBUMS]->count; i++) {
+        safe_strcpy(albums[i].id, from_albums[i].id, MAX_ID_LENGTH);
+        safe_strcpy(albums[i].name, from_albums[i].name, MAX_NAME_LENGTH);
+        albums[i].artist = from_albums[i].artist;   // Same handles, the name table is the pool's
+        albums[i].song_count = from_albums[i].song_count;
+        albums[i].year = from_albums[i].year;
+    }
+}
+
+// An ID already present keeps its first record, as in the store
+static void image_write_ids(LibraryCollection collection, const LibraryImageCollection* section, uint8_t* image) {
+    if (section->count == 0) return;
+    lib_index_t* slots = (lib_index_t*)(image + section->id_slots);
+    memset(slots, 0xFF, section->id_slot_count * sizeof(lib_index_t));
+    const uint8_t* records = image + section->records;
+    size_t record_size = library_image_record_size(collection);
+    uint32_t mask = section->id_slot_count - 1;
+    for (uint32_t i = 0; i < section->count; i++) {
+        const char* id = (const char*)records + i * record_size;
+        uint32_t slot = library_image_hash(id) & mask;
+        while (slots[slot] != LIBRARY_IMAGE_NO_RECORD &&
+               strcmp((const char*)records + slots[slot] * record_size, id) != 0) {
+            slot = (slot + 1) & mask;
+        }
+        if (slots[slot] == LIBRARY_IMAGE_NO_RECORD) slots[slot] = (lib_index_t)i;
+    }
+}
+
+uint32_t library_build_image(uint8_t* image, uint32_t capacity) {
+    // The live versions, loaded once - a publish in between cannot mix two syncs
+    const CollectionVersion* versions[LIBRARY_IMAGE_COLLECTIONS];
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        versions[i] = live_version((LibraryCollection)i);
+    }
+
+    LibraryImageHeader header;
+    image_layout(versions, &header);
+    if (!image) return header.image_size;
+    if (capacity < header.image_size) return 0;
+    memset(image, 0, header.image_size);
+
+    uint32_t* names = (uint32_t*)(image + header.names);
+    uint32_t at = 0;
+    for (uint32_t handle = 0; handle < header.name_count; handle++) {
+        const char* name = version_name(versions[LIBRARY_ALBUMS], (StrHandle)handle);
+        size_t length = strlen(name) + 1;
+        names[handle] = at;
+        memcpy(image + header.strings + at, name, length);
+        at += length;
+    }
+
+    image_write_records(versions, &header, image);
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        LibraryCollection collection = (LibraryCollection)i;
+        const LibraryImageCollection* section = &header.collections[i];
+        image_write_ids(collection, section, image);
+        for (int order = LIBRARY_ORDER_ARRIVAL + 1; order < LIBRARY_ORDER_COUNT; order++) {
+            if (!section->orders[order]) continue;
+            lib_index_t* positions = (lib_index_t*)(image + section->orders[order]);
+            for (uint32_t p = 0; p < section->count; p++) {
+                positions[p] = version_sorted_index(&g_collections[i], versions[i], (LibraryOrder)order,
+                                                    (lib_index_t)p);
+            }
+        }
+        if (section->word_count > 0) {
+            memcpy(image + section->words, version_search(versions[i])->words,
+                   section->word_count * sizeof(SearchWord));
+        }
+    }
+
+    header.crc = abp_crc32(image + sizeof(header), header.image_size - sizeof(header));
+    memcpy(image, &header, sizeof(header));
+    return header.image_size;
+}
+
+// Each collection gets a version reading from the image, published like a finished sync
+bool library_attach_image(const uint8_t* data, uint32_t size) {
+    const LibraryImageHeader* image = library_image_check(data, size);
+    if (!image) return false;
+
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        Collection* c = &g_collections[i];
+        CollectionVersion* v = collection_begin(c);
+        v->image = image;
+        v->records = (const uint8_t*)library_image_records(image, (LibraryCollection)i);
+        v->count = image->collections[i].count;
+        v->revision = image->collections[i].revision;
+        search_index_view(&v->image_search, library_image_words(image, (LibraryCollection)i),
+                          image->collections[i].word_count);
+        collection_publish(c, v);
+    }
+    return true;
+}
+
+bool library_image_attached(void) {
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        if (live_version((LibraryCollection)i)->image) return true;
+    }
+    return false;
+}
+
+bool library_collection_in_image(LibraryCollection collection) {
+    return live_version(collection)->image != nullptr;
+}
+
+// Like the song context, the revision goes live with the version's records
+void library_set_revision(LibraryCollection collection, uint32_t revision) {
+    collection_building(&g_collections[collection])->revision = revision;
+}
+
+uint32_t library_get_revision(LibraryCollection collection) {
+    return live_version(collection)->revision;
+}
+
 // ============================================================================
 // Playlists
 // ============================================================================
 
 void library_clear_playlists(void) {
-    memset(g_playlists, 0, sizeof(g_playlists));
-    g_playlist_count = 0;
+    collection_publish(&g_collections[LIBRARY_PLAYLISTS], &g_empty_version);
 }
 
 bool library_add_playlist(const char* id, const char* name, uint16_t song_count) {
-    if (g_playlist_count >= MAX_BLE_PLAYLISTS) {
-        Serial.println("[Library] Max playlists reached");
+    Collection* c = &g_collections[LIBRARY_PLAYLISTS];
+    CollectionVersion* v = collection_building(c);
+    BLEPlaylist* pl = (BLEPlaylist*)collection_add(c, v, id);
+    if (!pl) {
+        LOGW(LIBRARY, "Max playlists reached");
         return false;
     }
-
-    BLEPlaylist* pl = &g_playlists[g_playlist_count];
-    safe_strcpy(pl->id, id, MAX_ID_LENGTH);
     safe_strcpy(pl->name, name, MAX_NAME_LENGTH);
     pl->song_count = song_count;
-
-    g_playlist_count++;
-    g_has_ble_data = true;
+    collection_index_name(c, v);
     return true;
 }
 
-uint8_t library_get_playlist_count(void) {
-    return g_playlist_count;
+lib_index_t library_get_playlist_count(void) {
+    return live_version(LIBRARY_PLAYLISTS)->count;
 }
 
-const BLEPlaylist* library_get_playlist(uint8_t index) {
-    if (index >= g_playlist_count) return nullptr;
-    return &g_playlists[index];
+const BLEPlaylist* library_get_playlist(lib_index_t index) {
+    return (const BLEPlaylist*)collection_get(LIBRARY_PLAYLISTS, index);
 }
 
 const BLEPlaylist* library_get_playlist_by_id(const char* id) {
-    for (uint8_t i = 0; i < g_playlist_count; i++) {
-        if (strcmp(g_playlists[i].id, id) == 0) {
-            return &g_playlists[i];
-        }
-    }
-    return nullptr;
+    return (const BLEPlaylist*)collection_find(LIBRARY_PLAYLISTS, id);
 }
 
 // ============================================================================
@@ -111,43 +810,34 @@ const BLEPlaylist* library_get_playlist_by_id(const char* id) {
 // ============================================================================
 
 void library_clear_artists(void) {
-    memset(g_artists, 0, sizeof(g_artists));
-    g_artist_count = 0;
+    collection_publish(&g_collections[LIBRARY_ARTISTS], &g_empty_version);
 }
 
-bool library_add_artist(const char* id, const char* name, uint8_t album_count, uint16_t song_count) {
-    if (g_artist_count >= MAX_BLE_ARTISTS) {
-        Serial.println("[Library] Max artists reached");
+bool library_add_artist(const char* id, const char* name, uint16_t album_count, uint16_t song_count) {
+    Collection* c = &g_collections[LIBRARY_ARTISTS];
+    CollectionVersion* v = collection_building(c);
+    BLEArtist* artist = (BLEArtist*)collection_add(c, v, id);
+    if (!artist) {
+        LOGW(LIBRARY, "Max artists reached");
         return false;
     }
-
-    BLEArtist* artist = &g_artists[g_artist_count];
-    safe_strcpy(artist->id, id, MAX_ID_LENGTH);
     safe_strcpy(artist->name, name, MAX_NAME_LENGTH);
     artist->album_count = album_count;
     artist->song_count = song_count;
-
-    g_artist_count++;
-    g_has_ble_data = true;
+    collection_index_name(c, v);
     return true;
 }
 
-uint8_t library_get_artist_count(void) {
-    return g_artist_count;
+lib_index_t library_get_artist_count(void) {
+    return live_version(LIBRARY_ARTISTS)->count;
 }
 
-const BLEArtist* library_get_artist(uint8_t index) {
-    if (index >= g_artist_count) return nullptr;
-    return &g_artists[index];
+const BLEArtist* library_get_artist(lib_index_t index) {
+    return (const BLEArtist*)collection_get(LIBRARY_ARTISTS, index);
 }
 
 const BLEArtist* library_get_artist_by_id(const char* id) {
-    for (uint8_t i = 0; i < g_artist_count; i++) {
-        if (strcmp(g_artists[i].id, id) == 0) {
-            return &g_artists[i];
-        }
-    }
-    return nullptr;
+    return (const BLEArtist*)collection_find(LIBRARY_ARTISTS, id);
 }
 
 // ============================================================================
@@ -155,44 +845,39 @@ const BLEArtist* library_get_artist_by_id(const char* id) {
 // ============================================================================
 
 void library_clear_albums(void) {
-    memset(g_albums, 0, sizeof(g_albums));
-    g_album_count = 0;
+    collection_publish(&g_collections[LIBRARY_ALBUMS], &g_empty_version);
 }
 
-bool library_add_album(const char* id, const char* name, const char* artist, uint8_t song_count, uint16_t year) {
-    if (g_album_count >= MAX_BLE_ALBUMS) {
-        Serial.println("[Library] Max albums reached");
+bool library_add_album(const char* id, const char* name, const char* artist, uint16_t song_count, uint16_t year) {
+    Collection* c = &g_collections[LIBRARY_ALBUMS];
+    CollectionVersion* v = collection_building(c);
+    BLEAlbum* album = (BLEAlbum*)collection_add(c, v, id);
+    if (!album) {
+        LOGW(LIBRARY, "Max albums reached");
         return false;
     }
-
-    BLEAlbum* album = &g_albums[g_album_count];
-    safe_strcpy(album->id, id, MAX_ID_LENGTH);
     safe_strcpy(album->name, name, MAX_NAME_LENGTH);
-    safe_strcpy(album->artist, artist, MAX_NAME_LENGTH);
+    album->artist = string_pool_intern(&v->names, artist, MAX_NAME_LENGTH);
     album->song_count = song_count;
     album->year = year;
-
-    g_album_count++;
-    g_has_ble_data = true;
+    collection_index_name(c, v);
     return true;
 }
 
-uint8_t library_get_album_count(void) {
-    return g_album_count;
+lib_index_t library_get_album_count(void) {
+    return live_version(LIBRARY_ALBUMS)->count;
 }
 
-const BLEAlbum* library_get_album(uint8_t index) {
-    if (index >= g_album_count) return nullptr;
-    return &g_albums[index];
+const BLEAlbum* library_get_album(lib_index_t index) {
+    return (const BLEAlbum*)collection_get(LIBRARY_ALBUMS, index);
 }
 
 const BLEAlbum* library_get_album_by_id(const char* id) {
-    for (uint8_t i = 0; i < g_album_count; i++) {
-        if (strcmp(g_albums[i].id, id) == 0) {
-            return &g_albums[i];
-        }
-    }
-    return nullptr;
+    return (const BLEAlbum*)collection_find(LIBRARY_ALBUMS, id);
+}
+
+const char* library_album_artist(const BLEAlbum* album) {
+    return version_name(version_holding(&g_collections[LIBRARY_ALBUMS], album), album->artist);
 }
 
 // ============================================================================
@@ -200,99 +885,132 @@ const BLEAlbum* library_get_album_by_id(const char* id) {
 // ============================================================================
 
 void library_clear_songs(void) {
-    memset(g_songs, 0, sizeof(g_songs));
-    g_song_count = 0;
-    g_song_context_type[0] = '\0';
-    g_song_context_id[0] = '\0';
+    collection_publish(&g_collections[LIBRARY_SONGS], &g_empty_version);
 }
 
 bool library_add_song(const char* id, const char* title, const char* artist, const char* album, uint16_t duration, uint8_t track) {
-    if (g_song_count >= MAX_BLE_SONGS) {
-        Serial.println("[Library] Max songs reached");
+    Collection* c = &g_collections[LIBRARY_SONGS];
+    CollectionVersion* v = collection_building(c);
+    BLESong* song = (BLESong*)collection_add(c, v, id);
+    if (!song) {
+        LOGW(LIBRARY, "Max songs reached");
         return false;
     }
-
-    BLESong* song = &g_songs[g_song_count];
-    safe_strcpy(song->id, id, MAX_ID_LENGTH);
     safe_strcpy(song->title, title, MAX_NAME_LENGTH);
-    safe_strcpy(song->artist, artist, MAX_NAME_LENGTH);
-    safe_strcpy(song->album, album, MAX_NAME_LENGTH);
+    song->artist = string_pool_intern(&v->names, artist, MAX_NAME_LENGTH);
+    song->album = string_pool_intern(&v->names, album, MAX_NAME_LENGTH);
     song->duration_sec = duration;
     song->track_number = track;
-
-    g_song_count++;
+    collection_index_name(c, v);
     return true;
 }
 
-uint8_t library_get_song_count(void) {
-    return g_song_count;
+lib_index_t library_get_song_count(void) {
+    return live_version(LIBRARY_SONGS)->count;
 }
 
-const BLESong* library_get_song(uint8_t index) {
-    if (index >= g_song_count) return nullptr;
-    return &g_songs[index];
+const BLESong* library_get_song(lib_index_t index) {
+    return (const BLESong*)collection_get(LIBRARY_SONGS, index);
 }
 
+const BLESong* library_get_song_by_id(const char* id) {
+    return (const BLESong*)collection_find(LIBRARY_SONGS, id);
+}
+
+const char* library_song_artist(const BLESong* song) {
+    return version_name(version_holding(&g_collections[LIBRARY_SONGS], song), song->artist);
+}
+
+const char* library_song_album(const BLESong* song) {
+    return version_name(version_holding(&g_collections[LIBRARY_SONGS], song), song->album);
+}
+
+// The context belongs to the version being built and goes live with its songs
 void library_set_song_context(const char* context_type, const char* context_id) {
-    safe_strcpy(g_song_context_type, context_type, sizeof(g_song_context_type));
-    safe_strcpy(g_song_context_id, context_id, sizeof(g_song_context_id));
+    CollectionVersion* v = collection_building(&g_collections[LIBRARY_SONGS]);
+    safe_strcpy(v->context_type, context_type, sizeof(v->context_type));
+    safe_strcpy(v->context_id, context_id, sizeof(v->context_id));
 }
 
 const char* library_get_song_context_type(void) {
-    return g_song_context_type;
+    return live_version(LIBRARY_SONGS)->context_type;
 }
 
 const char* library_get_song_context_id(void) {
-    return g_song_context_id;
+    return live_version(LIBRARY_SONGS)->context_id;
+}
+
+// Like the context, the window goes live with the version's songs
+void library_set_song_window(uint32_t start, uint32_t total) {
+    CollectionVersion* v = collection_building(&g_collections[LIBRARY_SONGS]);
+    v->window_start = start;
+    v->list_total = total;
+}
+
+void library_get_song_window(uint32_t* start, lib_index_t* count, uint32_t* total) {
+    const CollectionVersion* v = live_version(LIBRARY_SONGS);
+    *start = v->window_start;
+    *count = v->count;
+    *total = v->list_total > v->count ? v->list_total : v->count;
+}
+
+uint32_t library_get_song_window_start(void) {
+    return live_version(LIBRARY_SONGS)->window_start;
+}
+
+uint32_t library_get_song_list_total(void) {
+    const CollectionVersion* v = live_version(LIBRARY_SONGS);
+    return v->list_total > v->count ? v->list_total : v->count;
 }
 
 // ============================================================================
 // Persistent Selection Tracking
 // ============================================================================
 
-void library_set_last_playlist_index(uint8_t index) {
+void library_set_last_playlist_index(lib_index_t index) {
     g_last_playlist_index = index;
 }
 
-uint8_t library_get_last_playlist_index(void) {
+lib_index_t library_get_last_playlist_index(void) {
     return g_last_playlist_index;
 }
 
-void library_set_last_artist_index(uint8_t index) {
+void library_set_last_artist_index(lib_index_t index) {
     g_last_artist_index = index;
 }
 
-uint8_t library_get_last_artist_index(void) {
+lib_index_t library_get_last_artist_index(void) {
     return g_last_artist_index;
 }
 
-void library_set_last_album_index(uint8_t index) {
+void library_set_last_album_index(lib_index_t index) {
     g_last_album_index = index;
 }
 
-uint8_t library_get_last_album_index(void) {
+lib_index_t library_get_last_album_index(void) {
     return g_last_album_index;
 }
 
 void library_save_selections(void) {
+#ifdef ARDUINO
     g_prefs.begin(PREFS_NAMESPACE, false);
-    g_prefs.putUChar("lastPlaylist", g_last_playlist_index);
-    g_prefs.putUChar("lastArtist", g_last_artist_index);
-    g_prefs.putUChar("lastAlbum", g_last_album_index);
+    g_prefs.putUShort("lastPlaylist", g_last_playlist_index);
+    g_prefs.putUShort("lastArtist", g_last_artist_index);
+    g_prefs.putUShort("lastAlbum", g_last_album_index);
     g_prefs.end();
-    Serial.println("[Library] Saved selections to NVS");
+    LOGI(LIBRARY, "Saved selections to NVS");
+#endif
 }
 
 void library_load_selections(void) {
+#ifdef ARDUINO
     g_prefs.begin(PREFS_NAMESPACE, true);  // read-only
-    g_last_playlist_index = g_prefs.getUChar("lastPlaylist", 0);
-    g_last_artist_index = g_prefs.getUChar("lastArtist", 0);
-    g_last_album_index = g_prefs.getUChar("lastAlbum", 0);
+    // Older firmware stored 8-bit indices; NVS reads of the wrong width return the default
+    g_last_playlist_index = g_prefs.getUShort("lastPlaylist", g_prefs.getUChar("lastPlaylist", 0));
+    g_last_artist_index = g_prefs.getUShort("lastArtist", g_prefs.getUChar("lastArtist", 0));
+    g_last_album_index = g_prefs.getUShort("lastAlbum", g_prefs.getUChar("lastAlbum", 0));
     g_prefs.end();
-    Serial.print("[Library] Loaded selections: playlist=");
-    Serial.print(g_last_playlist_index);
-    Serial.print(", artist=");
-    Serial.print(g_last_artist_index);
-    Serial.print(", album=");
-    Serial.println(g_last_album_index);
+    LOGI(LIBRARY, "Loaded selections: playlist=%u, artist=%u, album=%u",
+         (unsigned)g_last_playlist_index, (unsigned)g_last_artist_index, (unsigned)g_last_album_index);
+#endif
 }
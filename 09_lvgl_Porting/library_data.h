@@ -5,14 +5,31 @@
 #pragma once
 
 #include <stdint.h>
-
-// Maximum counts for dynamic data
-#define MAX_BLE_PLAYLISTS   50
-#define MAX_BLE_ARTISTS     100
-#define MAX_BLE_ALBUMS      100
-#define MAX_BLE_SONGS       200
+#include "string_pool.h"
+
+// Record index and count type for every collection
+typedef uint16_t lib_index_t;
+#define LIBRARY_MAX_RECORDS 65535       // Per collection, the most a lib_index_t can count
+
+// Default capacities, used when library_data_init() is not given any - override with -D
+#ifndef MAX_BLE_PLAYLISTS
+#define MAX_BLE_PLAYLISTS   200
+#endif
+#ifndef MAX_BLE_ARTISTS
+#define MAX_BLE_ARTISTS     1000
+#endif
+#ifndef MAX_BLE_ALBUMS
+#define MAX_BLE_ALBUMS      2000
+#endif
+#ifndef MAX_BLE_SONGS
+#define MAX_BLE_SONGS       2000
+#endif
 #define MAX_NAME_LENGTH     64
 #define MAX_ID_LENGTH       48
+#define LIBRARY_POOL_AVG_NAME   24      // Pooled bytes budgeted per artist/album name
+#define LIBRARY_SEARCH_AVG_WORDS 4      // Search index words budgeted per name
+#define LIBRARY_GRACE_FRAMES    2       // UI frames before a replaced version is reused
+#define LIBRARY_GRACE_TIMEOUT_MS 200    // Waiting longer for them is logged (and goes on)
 
 // Dynamic playlist structure
 typedef struct {
@@ -25,7 +42,7 @@ typedef struct {
 typedef struct {
     char id[MAX_ID_LENGTH];
     char name[MAX_NAME_LENGTH];
-    uint8_t album_count;
+    uint16_t album_count;
     uint16_t song_count;
 } BLEArtist;
 
@@ -33,8 +50,8 @@ typedef struct {
 typedef struct {
     char id[MAX_ID_LENGTH];
     char name[MAX_NAME_LENGTH];
-    char artist[MAX_NAME_LENGTH];
-    uint8_t song_count;
+    StrHandle artist;           // library_album_artist()
+    uint16_t song_count;
     uint16_t year;
 } BLEAlbum;
 
@@ -42,14 +59,117 @@ typedef struct {
 typedef struct {
     char id[MAX_ID_LENGTH];
     char title[MAX_NAME_LENGTH];
-    char artist[MAX_NAME_LENGTH];
-    char album[MAX_NAME_LENGTH];
+    StrHandle artist;           // library_song_artist()
+    StrHandle album;            // library_song_album()
     uint16_t duration_sec;
     uint8_t track_number;
 } BLESong;
 
-// Initialize library data storage
-void library_data_init(void);
+// Records each collection can hold; the store is reserved once, in PSRAM when available
+typedef struct {
+    lib_index_t playlists;
+    lib_index_t artists;
+    lib_index_t albums;
+    lib_index_t songs;
+} LibraryCapacity;
+
+typedef enum {
+    LIBRARY_PLAYLISTS,
+    LIBRARY_ARTISTS,
+    LIBRARY_ALBUMS,
+    LIBRARY_SONGS,
+    LIBRARY_COLLECTION_COUNT
+} LibraryCollection;
+
+// Orders a collection can be listed in besides arrival (see library_supports_order())
+typedef enum {
+    LIBRARY_ORDER_ARRIVAL,      // As the app sent it - for songs, the order of the playlist or album
+    LIBRARY_ORDER_NAME,         // Name or title, A-Z
+    LIBRARY_ORDER_ARTIST,       // Artist, then year (albums) or album and track (songs)
+    LIBRARY_ORDER_YEAR,         // Albums, oldest first
+    LIBRARY_ORDER_TRACK,        // Songs, by track number
+    LIBRARY_ORDER_COUNT
+} LibraryOrder;
+
+typedef struct {
+    lib_index_t count;          // Records held now
+    lib_index_t capacity;       // Records the collection can hold
+    lib_index_t high_water;     // Most records held at once
+    uint32_t bytes_used;
+    uint32_t bytes_capacity;
+    uint32_t bytes_high_water;
+    bool in_psram;
+    uint32_t publishes;         // Versions made live (library_publish(), clears, attaches)
+} LibraryStoreStats;
+
+// Initialize library data storage (nullptr for the MAX_BLE_* defaults).
+// Every collection holds two versions of that size - the live one and the next.
+// Returns false if the store could not be allocated.
+bool library_data_init(const LibraryCapacity* capacity = nullptr);
+
+// Records the collection can hold, as sized by library_data_init()
+lib_index_t library_get_capacity(LibraryCollection collection);
+
+// Usage of one collection's arena (the live version)
+void library_get_store_stats(LibraryCollection collection, LibraryStoreStats* stats);
+void library_log_store_stats(void);
+
+// Versions - each collection is double-buffered. Readers (the getters below) always see
+// the live version, which never changes once published. Adds, sort and search updates go
+// to the next version, made live in one atomic pointer swap by library_publish(); the
+// version it replaces is only reused once the UI has moved on (library_note_frame()).
+// Clearing makes an empty collection live at once and leaves a version being built alone.
+// One writer per collection at a time, and never the UI task: starting a version waits
+// for the UI to draw frames. The grace period only covers the UI task, which reads
+// without a lock; any other task reads a collection it writes itself, or holds the lock
+// its writer holds (the sketch's g_song_write_lock for songs).
+
+// Start the next version of the collection empty, e.g. on page 1 of a sync; restarts
+// one being built. Adding to a collection with none open starts one as well.
+void library_begin_update(LibraryCollection collection);
+
+// Make the version being built live (on the last page). Does nothing when none is open.
+void library_publish(LibraryCollection collection);
+
+// Call from the UI task once per frame, outside any library read
+void library_note_frame(void);
+
+// Wait for readers to leave every replaced playlists, artists and albums version, then
+// reset those versions, letting go of any image they read (song lists never do). Call before unmapping or freeing an attached image.
+void library_reclaim(void);
+
+// Sorted views - each is kept up to date as pages arrive, so switching order costs nothing
+bool library_supports_order(LibraryCollection collection, LibraryOrder order);
+
+// Merge records added since the last call into every sort index of the version being
+// built (call once per ingested page)
+void library_update_sort_indexes(LibraryCollection collection);
+
+// Record index at position in the given order; unsupported orders read as arrival order
+lib_index_t library_get_sorted_index(LibraryCollection collection, LibraryOrder order, lib_index_t position);
+
+// Flat image of the playlists, artists and albums with their indexes (see library_image.h).
+// With image nullptr only measures it; returns the size, or 0 when capacity is too small.
+// Words not yet merged into a search index are left out, so build after the page updates.
+uint32_t library_build_image(uint8_t* image, uint32_t capacity);
+
+// Read playlists, artists and albums in place from an image - a flash mapping or a
+// buffer that outlives the attachment - instead of the arenas; nothing is copied.
+// Returns false (library untouched) when it fails library_image_check(). Published like
+// a finished sync; the image is read until the next one replaces it.
+bool library_attach_image(const uint8_t* image, uint32_t size);
+
+// Whether any live collection reads from an attached image
+bool library_image_attached(void);
+
+// Whether the live version of collection reads from an attached image
+bool library_collection_in_image(LibraryCollection collection);
+
+// Revision the app gave a collection's records (protocol v1.4), sent back with the next
+// query so the app can answer with what changed since (see library_delta.h). Set on the
+// version being built, read from the live one; 0 when there is none.
+void library_set_revision(LibraryCollection collection, uint32_t revision);
+uint32_t library_get_revision(LibraryCollection collection);
 
 // Clear all library data
 void library_data_clear(void);
@@ -57,47 +177,73 @@ void library_data_clear(void);
 // Check if we have BLE library data
 bool library_has_ble_data(void);
 
+// Name search over every collection (see search_index.h)
+typedef struct {
+    LibraryCollection collection;
+    lib_index_t record;
+} LibrarySearchHit;
+
+// Merge words of records added since the last call into the search index of the
+// version being built (call once per ingested page)
+void library_update_search_index(LibraryCollection collection);
+
+// Records with a name word starting with each word of query - "beat" finds "The Beatles",
+// "pink fl" finds "Pink Floyd". Each collection gets a share of max_hits, artists first.
+uint16_t library_search(const char* query, LibrarySearchHit* hits, uint16_t max_hits);
+
 // Playlist functions
 void library_clear_playlists(void);
 bool library_add_playlist(const char* id, const char* name, uint16_t song_count);
-uint8_t library_get_playlist_count(void);
-const BLEPlaylist* library_get_playlist(uint8_t index);
+lib_index_t library_get_playlist_count(void);
+const BLEPlaylist* library_get_playlist(lib_index_t index);
 const BLEPlaylist* library_get_playlist_by_id(const char* id);
 
 // Artist functions
 void library_clear_artists(void);
-bool library_add_artist(const char* id, const char* name, uint8_t album_count, uint16_t song_count);
-uint8_t library_get_artist_count(void);
-const BLEArtist* library_get_artist(uint8_t index);
+bool library_add_artist(const char* id, const char* name, uint16_t album_count, uint16_t song_count);
+lib_index_t library_get_artist_count(void);
+const BLEArtist* library_get_artist(lib_index_t index);
 const BLEArtist* library_get_artist_by_id(const char* id);
 
 // Album functions
 void library_clear_albums(void);
-bool library_add_album(const char* id, const char* name, const char* artist, uint8_t song_count, uint16_t year);
-uint8_t library_get_album_count(void);
-const BLEAlbum* library_get_album(uint8_t index);
+bool library_add_album(const char* id, const char* name, const char* artist, uint16_t song_count, uint16_t year);
+lib_index_t library_get_album_count(void);
+const BLEAlbum* library_get_album(lib_index_t index);
 const BLEAlbum* library_get_album_by_id(const char* id);
+const char* library_album_artist(const BLEAlbum* album);
 
 // Song functions (for playlist/album detail views)
 void library_clear_songs(void);
 bool library_add_song(const char* id, const char* title, const char* artist, const char* album, uint16_t duration, uint8_t track);
-uint8_t library_get_song_count(void);
-const BLESong* library_get_song(uint8_t index);
+lib_index_t library_get_song_count(void);
+const BLESong* library_get_song(lib_index_t index);
+const BLESong* library_get_song_by_id(const char* id);
+const char* library_song_artist(const BLESong* song);
+const char* library_song_album(const BLESong* song);
 
-// Context tracking for song lists
+// Context tracking for song lists - set on the version being built, read from the live one
 void library_set_song_context(const char* context_type, const char* context_id);
 const char* library_get_song_context_type(void);
 const char* library_get_song_context_id(void);
 
+// Window of a long song list (protocol v1.3): the records held are list positions
+// [start, start + count) of total. A version starts out holding its whole list. Positions
+// and totals are not bounded by the records a collection can hold.
+void library_set_song_window(uint32_t start, uint32_t total);
+void library_get_song_window(uint32_t* start, lib_index_t* count, uint32_t* total);
+uint32_t library_get_song_window_start(void);
+uint32_t library_get_song_list_total(void);
+
 // Persistent selection tracking (survives reboot)
-void library_set_last_playlist_index(uint8_t index);
-uint8_t library_get_last_playlist_index(void);
+void library_set_last_playlist_index(lib_index_t index);
+lib_index_t library_get_last_playlist_index(void);
 
-void library_set_last_artist_index(uint8_t index);
-uint8_t library_get_last_artist_index(void);
+void library_set_last_artist_index(lib_index_t index);
+lib_index_t library_get_last_artist_index(void);
 
-void library_set_last_album_index(uint8_t index);
-uint8_t library_get_last_album_index(void);
+void library_set_last_album_index(lib_index_t index);
+lib_index_t library_get_last_album_index(void);
 
 // Save selections to NVS (call periodically or on selection change)
 void library_save_selections(void);
@@ -0,0 +1,276 @@
+/*
+ * Library Delta - Incremental sync of playlists, artists and albums (protocol v1.4)
+ */
+
+#include "library_delta.h"
+#include "arena.h"
+#include "id_index.h"
+#include "app_log.h"
+#include <stddef.h>
+#include <string.h>
+
+static_assert(LIBRARY_PLAYLISTS < LIBRARY_DELTA_COLLECTIONS && LIBRARY_ARTISTS < LIBRARY_DELTA_COLLECTIONS &&
+              LIBRARY_ALBUMS < LIBRARY_DELTA_COLLECTIONS && LIBRARY_SONGS >= LIBRARY_DELTA_COLLECTIONS,
+              "deltas cover playlists, artists and albums");
+
+// One added, changed or removed record; fields a collection does not have stay 0
+typedef struct {
+    char id[MAX_ID_LENGTH];     // First, for the ID index
+    char name[MAX_NAME_LENGTH];
+    char artist[MAX_NAME_LENGTH];   // Albums
+    uint16_t song_count;
+    uint16_t album_count;       // Artists
+    uint16_t year;              // Albums
+    bool removed;
+    bool matched;               // Met a live record while applying
+} DeltaEntry;
+
+typedef struct {
+    Arena storage;
+    DeltaEntry* entries;
+    IdIndex ids;
+    lib_index_t count;
+    uint32_t base_revision;
+    bool open;                  // Between library_delta_begin() and library_delta_apply()
+    bool overflow;
+} DeltaStaging;
+
+static DeltaStaging g_staging[LIBRARY_DELTA_COLLECTIONS];
+static LibraryDeltaStats g_stats = {};
+static const char* COLLECTION_NAMES[LIBRARY_DELTA_COLLECTIONS] = {"playlists", "artists", "albums"};
+
+static void copy_string(char* dest, const char* src, size_t size) {
+    size_t length = strnlen(src ? src : "", size - 1);
+    memcpy(dest, src ? src : "", length);
+    dest[length] = '\0';
+}
+
+static DeltaEntry* find_entry(DeltaStaging* s, const char* id) {
+    if (s->count == 0) return nullptr;
+    lib_index_t index = id_index_find(&s->ids, id, s->entries, sizeof(DeltaEntry));
+    return index == ID_INDEX_NONE ? nullptr : &s->entries[index];
+}
+
+// Entry for id, cleared - a record named twice keeps only its last state - or nullptr
+// when the staging is full
+static DeltaEntry* stage(LibraryCollection collection, const char* id) {
+    DeltaStaging* s = &g_staging[collection];
+    if (!s->open || !s->entries) return nullptr;
+    DeltaEntry* entry = find_entry(s, id);
+    if (!entry) {
+        if (s->count >= LIBRARY_DELTA_MAX_ENTRIES) {
+            s->overflow = true;
+            return nullptr;
+        }
+        entry = &s->entries[s->count];
+        copy_string(entry->id, id, MAX_ID_LENGTH);
+        id_index_insert(&s->ids, entry->id, s->count, s->entries, sizeof(DeltaEntry));
+        s->count++;
+        g_stats.entries++;
+    }
+    memset(entry->name, 0, sizeof(*entry) - offsetof(DeltaEntry, name));
+    return entry;
+}
+
+// ============================================================================
+// Building the next version
+// ============================================================================
+
+static lib_index_t live_count(LibraryCollection collection) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS: return library_get_playlist_count();
+    case LIBRARY_ARTISTS: return library_get_artist_count();
+    default: return library_get_album_count();
+    }
+}
+
+// Records start with their ID
+static const char* live_id(LibraryCollection collection, lib_index_t index) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS: return library_get_playlist(index)->id;
+    case LIBRARY_ARTISTS: return library_get_artist(index)->id;
+    default: return library_get_album(index)->id;
+    }
+}
+
+// Carry a live record over unchanged, through the public getters - it may sit in the
+// arena or the attached image
+static void add_live(LibraryCollection collection, lib_index_t index) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS: {
+        const BLEPlaylist* pl = library_get_playlist(index);
+        library_add_playlist(pl->id, pl->name, pl->song_count);
+        break;
+    }
+    case LIBRARY_ARTISTS: {
+        const BLEArtist* artist = library_get_artist(index);
+        library_add_artist(artist->id, artist->name, artist->album_count, artist->song_count);
+        break;
+    }
+    default: {
+        const BLEAlbum* album = library_get_album(index);
+        library_add_album(album->id, album->name, library_album_artist(album), album->song_count, album->year);
+        break;
+    }
+    }
+    g_stats.copied++;
+}
+
+static void add_entry(LibraryCollection collection, const DeltaEntry* entry) {
+    switch (collection) {
+    case LIBRARY_PLAYLISTS:
+        library_add_playlist(entry->id, entry->name, entry->song_count);
+        break;
+    case LIBRARY_ARTISTS:
+        library_add_artist(entry->id, entry->name, entry->album_count, entry->song_count);
+        break;
+    default:
+        library_add_album(entry->id, entry->name, entry->artist, entry->song_count, entry->year);
+        break;
+    }
+}
+
+// Next version: the live records in their order, each replaced or dropped by its entry,
+// then the entries no live record matched (added). s nullptr copies the live version.
+static void rebuild(LibraryCollection collection, DeltaStaging* s, uint32_t revision) {
+    lib_index_t count = live_count(collection);
+    library_begin_update(collection);
+    for (lib_index_t i = 0; i < count; i++) {
+        DeltaEntry* entry = s ? find_entry(s, live_id(collection, i)) : nullptr;
+        if (!entry) {
+            add_live(collection, i);
+            continue;
+        }
+        entry->matched = true;
+        if (!entry->removed) add_entry(collection, entry);
+    }
+    for (lib_index_t i = 0; s && i < s->count; i++) {
+        if (!s->entries[i].matched && !s->entries[i].removed) add_entry(collection, &s->entries[i]);
+    }
+    library_set_revision(collection, revision);
+
+    // Indexes in one pass, as for a page, then live in one swap like a finished sync
+    library_update_sort_indexes(collection);
+    library_update_search_index(collection);
+    library_publish(collection);
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool library_delta_init(void) {
+    bool ok = true;
+    for (DeltaStaging& s : g_staging) {
+        if (s.entries) continue;
+        size_t bytes = LIBRARY_DELTA_MAX_ENTRIES * sizeof(DeltaEntry);
+        if (arena_init(&s.storage, bytes) && id_index_init(&s.ids, LIBRARY_DELTA_MAX_ENTRIES)) {
+            s.entries = (DeltaEntry*)arena_alloc(&s.storage, bytes, alignof(DeltaEntry));
+        }
+        ok &= s.entries != nullptr;
+    }
+    if (!ok) {
+        LOGE(LIBRARY, "Failed to allocate delta staging, every sync will be a full one");
+    }
+    return ok;
+}
+
+void library_delta_begin(LibraryCollection collection, uint32_t base_revision) {
+    if (collection >= LIBRARY_DELTA_COLLECTIONS) return;
+    DeltaStaging* s = &g_staging[collection];
+    id_index_reset(&s->ids);
+    s->count = 0;
+    s->base_revision = base_revision;
+    s->open = true;
+    s->overflow = false;
+}
+
+bool library_delta_put_playlist(const char* id, const char* name, uint16_t song_count) {
+    DeltaEntry* entry = stage(LIBRARY_PLAYLISTS, id);
+    if (!entry) return false;
+    copy_string(entry->name, name, MAX_NAME_LENGTH);
+    entry->song_count = song_count;
+    return true;
+}
+
+bool library_delta_put_artist(const char* id, const char* name, uint16_t album_count, uint16_t song_count) {
+    DeltaEntry* entry = stage(LIBRARY_ARTISTS, id);
+    if (!entry) return false;
+    copy_string(entry->name, name, MAX_NAME_LENGTH);
+    entry->album_count = album_count;
+    entry->song_count = song_count;
+    return true;
+}
+
+bool library_delta_put_album(const char* id, const char* name, const char* artist, uint16_t song_count,
+                             uint16_t year) {
+    DeltaEntry* entry = stage(LIBRARY_ALBUMS, id);
+    if (!entry) return false;
+    copy_string(entry->name, name, MAX_NAME_LENGTH);
+    copy_string(entry->artist, artist, MAX_NAME_LENGTH);
+    entry->song_count = song_count;
+    entry->year = year;
+    return true;
+}
+
+bool library_delta_remove(LibraryCollection collection, const char* id) {
+    if (collection >= LIBRARY_DELTA_COLLECTIONS) return false;
+    DeltaEntry* entry = stage(collection, id);
+    if (!entry) return false;
+    entry->removed = true;
+    return true;
+}
+
+LibraryDeltaResult library_delta_apply(LibraryCollection collection, uint32_t revision) {
+    if (collection >= LIBRARY_DELTA_COLLECTIONS) return LIBRARY_DELTA_FAILED;
+    DeltaStaging* s = &g_staging[collection];
+    bool open = s->open;
+    s->open = false;
+
+    // The delta is against the version the query named; anything else would be patched wrong
+    uint32_t live_revision = library_get_revision(collection);
+    if (!open || !s->entries || s->overflow || live_revision != s->base_revision) {
+        g_stats.failed++;
+        LOGW(LIBRARY, "Delta for %s does not apply (%u entries%s, revision %08x, asked against %08x)",
+             COLLECTION_NAMES[collection], (unsigned)s->count, s->overflow ? ", overflowed" : "",
+             (unsigned)live_revision, (unsigned)s->base_revision);
+        return LIBRARY_DELTA_FAILED;
+    }
+    if (s->count == 0 && revision == live_revision) {
+        g_stats.unchanged++;
+        return LIBRARY_DELTA_UNCHANGED;
+    }
+
+    rebuild(collection, s, revision);
+    g_stats.applied++;
+    LOGI(LIBRARY, "Delta for %s: %u entries applied, revision %08x -> %08x, %u records",
+         COLLECTION_NAMES[collection], (unsigned)s->count, (unsigned)live_revision, (unsigned)revision,
+         (unsigned)live_count(collection));
+    return LIBRARY_DELTA_APPLIED;
+}
+
+bool library_delta_detach_image(void) {
+    int in_image = 0;
+    for (int i = 0; i < LIBRARY_DELTA_COLLECTIONS; i++) {
+        in_image += library_collection_in_image((LibraryCollection)i);
+    }
+    if (in_image == 0 || in_image == LIBRARY_DELTA_COLLECTIONS) return false;
+
+    for (int i = 0; i < LIBRARY_DELTA_COLLECTIONS; i++) {
+        LibraryCollection collection = (LibraryCollection)i;
+        if (!library_collection_in_image(collection)) continue;
+        rebuild(collection, nullptr, library_get_revision(collection));
+        g_stats.detached++;
+    }
+    return true;
+}
+
+void library_delta_get_stats(LibraryDeltaStats* stats) {
+    *stats = g_stats;
+}
+
+void library_delta_log_stats(void) {
+    LOGI(LIBRARY, "Deltas applied=%u unchanged=%u failed=%u entries=%u copied=%u detached=%u",
+         (unsigned)g_stats.applied, (unsigned)g_stats.unchanged, (unsigned)g_stats.failed,
+         (unsigned)g_stats.entries, (unsigned)g_stats.copied, (unsigned)g_stats.detached);
+}
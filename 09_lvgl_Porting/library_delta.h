@@ -0,0 +1,65 @@
+/*
+ * Library Delta - Incremental sync of playlists, artists and albums (protocol v1.4)
+ * Applies "what changed since revision N" answers instead of downloading a list again
+ *
+ * Each collection carries the revision the app gave its records (library_get_revision()),
+ * kept in the flash image across reboots. Queries send it back; an app that still knows
+ * that revision answers with delta pages: records added or changed, and the IDs of
+ * records removed - no items at all when nothing changed, which is the usual reconnect.
+ *
+ * Delta entries are staged per collection as the pages arrive. On the last page the next
+ * version is built from the live one - removed records dropped, changed ones replaced in
+ * place, added ones appended - and published like a finished sync, so readers never see
+ * a half-applied delta. More entries than LIBRARY_DELTA_MAX_ENTRIES, or a live version
+ * that is no longer the one the query named, fail the delta: ask for the whole list.
+ *
+ * Loop and protocol tasks only (where pages are applied); not thread-safe on its own.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "library_data.h"
+
+#define LIBRARY_DELTA_MAX_ENTRIES   256     // Entries staged per collection and sync (advertised in HELLO)
+#define LIBRARY_DELTA_COLLECTIONS   3       // Playlists, artists, albums - song lists are per screen
+
+typedef enum {
+    LIBRARY_DELTA_UNCHANGED,    // Nothing changed, the live version stays
+    LIBRARY_DELTA_APPLIED,      // A version with the changes is live
+    LIBRARY_DELTA_FAILED        // Entries overflowed, or the live version moved - ask for the whole list
+} LibraryDeltaResult;
+
+typedef struct {
+    uint32_t applied;           // Deltas that published a new version
+    uint32_t unchanged;         // ... that had nothing in them
+    uint32_t failed;
+    uint32_t entries;           // Records staged (added, changed or removed)
+    uint32_t copied;            // Records carried over from the live versions
+    uint32_t detached;          // Collections moved off the flash image to save a new one
+} LibraryDeltaStats;
+
+// Reserve the staging entries (PSRAM first). Returns false when they could not be
+// allocated; deltas then fail and every sync is a full one.
+bool library_delta_init(void);
+
+// Page 1 of a delta for collection arrived; base_revision is what the query sent
+void library_delta_begin(LibraryCollection collection, uint32_t base_revision);
+
+// Stage an added or changed record, or a removed ID. False once the staging is full.
+bool library_delta_put_playlist(const char* id, const char* name, uint16_t song_count);
+bool library_delta_put_artist(const char* id, const char* name, uint16_t album_count, uint16_t song_count);
+bool library_delta_put_album(const char* id, const char* name, const char* artist, uint16_t song_count,
+                             uint16_t year);
+bool library_delta_remove(LibraryCollection collection, const char* id);
+
+// Last page: build and publish the next version at revision, or leave the live one
+LibraryDeltaResult library_delta_apply(LibraryCollection collection, uint32_t revision);
+
+// Once a sync is complete: when deltas replaced some collections while others still read
+// the attached flash image, copy those into the arenas too, so the image can be released
+// and a new one saved (library_snapshot_save() skips while one is attached). Returns true
+// when anything was copied.
+bool library_delta_detach_image(void);
+
+void library_delta_get_stats(LibraryDeltaStats* stats);
+void library_delta_log_stats(void);
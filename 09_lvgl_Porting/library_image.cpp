@@ -0,0 +1,192 @@
+/*
+ * Library Image - Flat, pointer-free image of the playlists, artists and albums
+ */
+
+#include "library_image.h"
+#include "abp_frame.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The image stores records and words exactly as they sit in RAM; pin the layouts so a
+// change shows up here instead of as a misread image
+static_assert(sizeof(BLEPlaylist) == 114 && sizeof(BLEArtist) == 116 && sizeof(BLEAlbum) == 118,
+              "record layout changed - bump LIBRARY_IMAGE_VERSION");
+static_assert(sizeof(SearchWord) == 8 && offsetof(SearchWord, record) == 4,
+              "search word layout changed - bump LIBRARY_IMAGE_VERSION");
+static_assert(sizeof(LibraryImageHeader) % LIBRARY_IMAGE_ALIGN == 0, "header must keep sections aligned");
+
+static const size_t RECORD_SIZES[LIBRARY_IMAGE_COLLECTIONS] = {sizeof(BLEPlaylist), sizeof(BLEArtist),
+                                                                sizeof(BLEAlbum)};
+
+static const uint8_t* base_of(const LibraryImageHeader* image) {
+    return (const uint8_t*)image;
+}
+
+// Whether bytes at offset lie inside the image, after the header and aligned
+static bool section_ok(const LibraryImageHeader* image, uint32_t offset, uint64_t bytes) {
+    if (offset % LIBRARY_IMAGE_ALIGN != 0 || offset < image->header_size) return false;
+    return (uint64_t)offset + bytes <= image->image_size;
+}
+
+static bool collection_ok(const LibraryImageHeader* image, int collection) {
+    const LibraryImageCollection* c = &image->collections[collection];
+    if (c->count > LIBRARY_MAX_RECORDS) return false;
+    if (!section_ok(image, c->records, (uint64_t)c->count * RECORD_SIZES[collection])) return false;
+
+    // Probing needs a free slot to stop at, and every record it lands on must exist: at
+    // most one slot per record (a duplicate ID has none), the rest empty
+    if (c->count > 0) {
+        if (c->id_slot_count <= c->count || (c->id_slot_count & (c->id_slot_count - 1)) != 0) return false;
+        if (!section_ok(image, c->id_slots, (uint64_t)c->id_slot_count * sizeof(lib_index_t))) return false;
+        const lib_index_t* slots = (const lib_index_t*)(base_of(image) + c->id_slots);
+        uint32_t used = 0;
+        for (uint32_t i = 0; i < c->id_slot_count; i++) {
+            if (slots[i] == LIBRARY_IMAGE_NO_RECORD) continue;
+            if (slots[i] >= c->count) return false;
+            used++;
+        }
+        if (used > c->count) return false;
+    }
+    if (c->orders[LIBRARY_ORDER_ARRIVAL] != 0) return false;
+    for (int order = 0; order < LIBRARY_ORDER_COUNT; order++) {
+        if (c->orders[order] && !section_ok(image, c->orders[order], (uint64_t)c->count * sizeof(lib_index_t))) {
+            return false;
+        }
+    }
+    return c->word_count == 0 || section_ok(image, c->words, (uint64_t)c->word_count * sizeof(SearchWord));
+}
+
+const LibraryImageHeader* library_image_check(const void* data, size_t size) {
+    const LibraryImageHeader* image = (const LibraryImageHeader*)data;
+    if (!data || size < sizeof(LibraryImageHeader)) return nullptr;
+    if (image->magic != LIBRARY_IMAGE_MAGIC || image->version != LIBRARY_IMAGE_VERSION ||
+        image->header_size != sizeof(LibraryImageHeader) || image->image_size < image->header_size ||
+        image->image_size > size) {
+        return nullptr;
+    }
+
+    if (image->name_count > 0 && !section_ok(image, image->names, (uint64_t)image->name_count * sizeof(uint32_t))) {
+        return nullptr;
+    }
+    // A terminated heap, and offsets inside it, keep every name lookup inside the image
+    if (image->strings_size > 0 && (!section_ok(image, image->strings, image->strings_size) ||
+                                    base_of(image)[image->strings + image->strings_size - 1] != '\0')) {
+        return nullptr;
+    }
+    const uint32_t* names = (const uint32_t*)(base_of(image) + image->names);
+    for (uint32_t i = 0; i < image->name_count; i++) {
+        if (names[i] >= image->strings_size) return nullptr;
+    }
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        if (!collection_ok(image, i)) return nullptr;
+    }
+
+    const uint8_t* body = base_of(image) + image->header_size;
+    if (abp_crc32(body, image->image_size - image->header_size) != image->crc) return nullptr;
+    return image;
+}
+
+static bool field_terminated(const char* field, size_t size) {
+    return memchr(field, '\0', size) != nullptr;
+}
+
+static const char* validate_collection(const LibraryImageHeader* image, LibraryCollection collection) {
+    const LibraryImageCollection* c = &image->collections[collection];
+    const uint8_t* records = (const uint8_t*)library_image_records(image, collection);
+    size_t record_size = RECORD_SIZES[collection];
+
+    for (uint32_t i = 0; i < c->count; i++) {
+        const uint8_t* record = records + i * record_size;
+        // Every record starts with its ID, then its name
+        if (!field_terminated((const char*)record, MAX_ID_LENGTH)) return "unterminated ID";
+        if (!field_terminated((const char*)record + MAX_ID_LENGTH, MAX_NAME_LENGTH)) return "unterminated name";
+        if (collection == LIBRARY_ALBUMS) {
+            BLEAlbum album;
+            memcpy(&album, record, sizeof(album));
+            if (album.artist >= image->name_count) return "album artist handle out of range";
+        }
+        // Duplicate IDs resolve to their first record, as in the store
+        lib_index_t found = library_image_find(image, collection, (const char*)record);
+        if (found == LIBRARY_IMAGE_NO_RECORD || found > i ||
+            strcmp((const char*)records + found * record_size, (const char*)record) != 0) {
+            return "ID does not find its record";
+        }
+    }
+
+    uint8_t* seen = (uint8_t*)malloc(c->count ? c->count : 1);
+    if (!seen) return "out of memory";
+    const char* error = nullptr;
+    for (int order = 0; order < LIBRARY_ORDER_COUNT && !error; order++) {
+        const lib_index_t* positions = library_image_order(image, collection, (LibraryOrder)order);
+        if (!positions) continue;
+        memset(seen, 0, c->count);
+        for (uint32_t i = 0; i < c->count && !error; i++) {
+            if (positions[i] >= c->count || seen[positions[i]]) error = "sort order is not a permutation";
+            else seen[positions[i]] = 1;
+        }
+    }
+    free(seen);
+    if (error) return error;
+
+    const SearchWord* words = library_image_words(image, collection);
+    for (uint32_t i = 0; i < c->word_count; i++) {
+        if (words[i].record >= c->count) return "search word record out of range";
+        if (i > 0 && words[i].key < words[i - 1].key) return "search words out of order";
+    }
+    return nullptr;
+}
+
+const char* library_image_validate(const LibraryImageHeader* image) {
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        const char* error = validate_collection(image, (LibraryCollection)i);
+        if (error) return error;
+    }
+    return nullptr;
+}
+
+// FNV-1a
+uint32_t library_image_hash(const char* id) {
+    uint32_t hash = 2166136261u;
+    for (const uint8_t* p = (const uint8_t*)id; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+size_t library_image_record_size(LibraryCollection collection) {
+    return collection < LIBRARY_IMAGE_COLLECTIONS ? RECORD_SIZES[collection] : 0;
+}
+
+const void* library_image_records(const LibraryImageHeader* image, LibraryCollection collection) {
+    return base_of(image) + image->collections[collection].records;
+}
+
+const lib_index_t* library_image_order(const LibraryImageHeader* image, LibraryCollection collection,
+                                       LibraryOrder order) {
+    uint32_t offset = image->collections[collection].orders[order];
+    return offset ? (const lib_index_t*)(base_of(image) + offset) : nullptr;
+}
+
+const SearchWord* library_image_words(const LibraryImageHeader* image, LibraryCollection collection) {
+    return (const SearchWord*)(base_of(image) + image->collections[collection].words);
+}
+
+lib_index_t library_image_find(const LibraryImageHeader* image, LibraryCollection collection, const char* id) {
+    const LibraryImageCollection* c = &image->collections[collection];
+    if (c->id_slot_count == 0 || !id) return LIBRARY_IMAGE_NO_RECORD;
+
+    const lib_index_t* slots = (const lib_index_t*)(base_of(image) + c->id_slots);
+    const uint8_t* records = base_of(image) + c->records;
+    uint32_t mask = c->id_slot_count - 1;
+    for (uint32_t slot = library_image_hash(id) & mask;; slot = (slot + 1) & mask) {
+        lib_index_t record = slots[slot];
+        if (record == LIBRARY_IMAGE_NO_RECORD) return LIBRARY_IMAGE_NO_RECORD;
+        if (strcmp((const char*)records + (size_t)record * RECORD_SIZES[collection], id) == 0) return record;
+    }
+}
+
+const char* library_image_name(const LibraryImageHeader* image, StrHandle handle) {
+    if (handle >= image->name_count) return "";
+    const uint32_t* names = (const uint32_t*)(base_of(image) + image->names);
+    return (const char*)base_of(image) + image->strings + names[handle];
+}
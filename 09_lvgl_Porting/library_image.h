@@ -0,0 +1,82 @@
+/*
+ * Library Image - Flat, pointer-free image of the playlists, artists and albums
+ * Built from the store after a sync (or on the host by tools/library_image_tool.cpp)
+ * and read in place - from a flash mapping or one bulk read - with no per-record work
+ *
+ * Every reference is an offset from the start of the image, so it can sit at any
+ * address. Records use the in-RAM BLE* layouts (names inline, album artists as handles
+ * into the image's own name table), and the indexes are the ones library_data keeps:
+ * an ID hash table, each supported sort order, and the search words in key order.
+ *
+ *   header | names | strings | per collection: records, ID slots, orders, search words
+ *
+ * Sections start on LIBRARY_IMAGE_ALIGN boundaries; numbers are little-endian, as on
+ * the ESP32 and the hosts the tool runs on. Any layout change bumps the version.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "library_data.h"
+#include "search_index.h"
+
+#define LIBRARY_IMAGE_MAGIC         0x4D494C41      // "ALIM"
+#define LIBRARY_IMAGE_VERSION       2
+#define LIBRARY_IMAGE_COLLECTIONS   3               // Playlists, artists, albums - song lists are per screen
+#define LIBRARY_IMAGE_ALIGN         8
+#define LIBRARY_IMAGE_NO_RECORD     0xFFFF          // Empty ID slot, and "not found"
+
+typedef struct {
+    uint32_t count;
+    uint32_t records;                       // count records in the collection's BLE* layout
+    uint32_t id_slots;                      // id_slot_count record indices, linear probing
+    uint32_t id_slot_count;                 // Power of two, at most half full; 0 when count is 0
+    uint32_t orders[LIBRARY_ORDER_COUNT];   // count record indices per order, 0 = not stored
+    uint32_t words;                         // word_count SearchWord in key order
+    uint32_t word_count;
+    uint32_t revision;                      // App's revision of the records (protocol v1.4), 0 = none
+} LibraryImageCollection;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;                   // sizeof(LibraryImageHeader)
+    uint32_t image_size;                    // Header included
+    uint32_t crc;                           // abp_crc32() of everything after the header
+    uint32_t sequence;                      // Set by the writer; of two valid copies the higher wins
+    uint32_t names;                         // name_count uint32 offsets into strings, by StrHandle
+    uint32_t name_count;
+    uint32_t strings;                       // NUL-terminated album artist names back to back
+    uint32_t strings_size;
+    LibraryImageCollection collections[LIBRARY_IMAGE_COLLECTIONS];
+    uint32_t reserved;                      // 0 - keeps the header a multiple of LIBRARY_IMAGE_ALIGN
+} LibraryImageHeader;
+
+// Header of a well-formed image of size bytes, or nullptr. Checks the version, that every
+// section lies inside the image, that ID slots hold record indices and name offsets point
+// into the string heap, and the CRC - enough to read it safely when it was written by
+// library_build_image().
+const LibraryImageHeader* library_image_check(const void* image, size_t size);
+
+// Deeper checks for the host tool (on a checked image): names and IDs are terminated,
+// handles are in range, every ID finds its record, orders are permutations and words are sorted.
+// Returns nullptr when the image passes, or what is wrong with it.
+const char* library_image_validate(const LibraryImageHeader* image);
+
+// Hash the ID slots are probed with
+uint32_t library_image_hash(const char* id);
+
+// Size of one record of collection (playlists, artists or albums)
+size_t library_image_record_size(LibraryCollection collection);
+
+// Sections of a checked image
+const void* library_image_records(const LibraryImageHeader* image, LibraryCollection collection);
+const lib_index_t* library_image_order(const LibraryImageHeader* image, LibraryCollection collection,
+                                       LibraryOrder order);     // nullptr when not stored
+const SearchWord* library_image_words(const LibraryImageHeader* image, LibraryCollection collection);
+
+// Record index for id, or LIBRARY_IMAGE_NO_RECORD
+lib_index_t library_image_find(const LibraryImageHeader* image, LibraryCollection collection, const char* id);
+
+// Album artist name for a handle; "" when out of range
+const char* library_image_name(const LibraryImageHeader* image, StrHandle handle);
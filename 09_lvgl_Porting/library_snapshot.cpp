@@ -0,0 +1,293 @@
+/*
+ * Library Snapshot - Playlists, artists and albums kept in flash across reboots
+ */
+
+#include "library_snapshot.h"
+#include "library_image.h"
+#include "app_log.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <string.h>
+
+#define FLASH_SECTOR_SIZE   4096
+#define LEGACY_PATH         "/library.bin"      // Record stream of earlier builds
+
+static bool g_ready = false;
+static const esp_partition_t* g_partition = nullptr;   // nullptr: LittleFS
+static uint32_t g_slot_size = 0;
+static int g_slot = -1;                         // Partition slot with the newest image, -1 when none
+static uint32_t g_sequence = 0;                 // Of the newest image in flash
+static uint32_t g_flash_crc = 0;                // ... and its contents, to skip rewriting it
+static uint32_t g_flash_size = 0;
+static std::atomic<bool> g_writing(false);      // A write task owns the image
+
+// What the library was attached to at boot, released once it has moved to the arenas
+static esp_partition_mmap_handle_t g_map_handle;
+static bool g_map_active = false;
+static uint8_t* g_loaded = nullptr;
+
+static LibrarySnapshotStats g_stats = {};
+
+static uint32_t elapsed_ms(int64_t start_us) {
+    return (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+}
+
+static void note_flash_image(const LibraryImageHeader* header) {
+    g_sequence = header->sequence;
+    g_flash_crc = header->crc;
+    g_flash_size = header->image_size;
+    g_stats.bytes = header->image_size;
+}
+
+// ============================================================================
+// Library partition
+// ============================================================================
+
+static bool map_slot(int slot, const void** data) {
+    return esp_partition_mmap(g_partition, (size_t)slot * g_slot_size, g_slot_size, ESP_PARTITION_MMAP_DATA, data,
+                              &g_map_handle) == ESP_OK;
+}
+
+static bool load_partition(void) {
+    // Newest sequence first; a slot that fails the checks falls back to the other one
+    LibraryImageHeader headers[2];
+    int order[2] = {0, 1};
+    for (int slot = 0; slot < 2; slot++) {
+        if (esp_partition_read(g_partition, (size_t)slot * g_slot_size, &headers[slot], sizeof(headers[slot])) !=
+            ESP_OK) {
+            headers[slot].magic = 0;
+        }
+    }
+    if (headers[1].magic == LIBRARY_IMAGE_MAGIC &&
+        (headers[0].magic != LIBRARY_IMAGE_MAGIC || headers[1].sequence > headers[0].sequence)) {
+        order[0] = 1;
+        order[1] = 0;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        int slot = order[i];
+        const void* data = nullptr;
+        if (headers[slot].magic != LIBRARY_IMAGE_MAGIC || !map_slot(slot, &data)) continue;
+        if (library_attach_image((const uint8_t*)data, g_slot_size)) {
+            g_map_active = true;
+            g_slot = slot;
+            note_flash_image((const LibraryImageHeader*)data);
+            return true;
+        }
+        esp_partition_munmap(g_map_handle);
+        g_stats.failures++;
+        LOGW(LIBRARY, "Library image in slot %d is corrupt, ignoring it", slot);
+    }
+    return false;
+}
+
+// Erase the slot not holding the newest image, then write the body and the header
+// last - until the header lands the slot does not look like an image at all
+static bool write_partition(const uint8_t* image, uint32_t size) {
+    int slot = g_slot == 0 ? 1 : 0;
+    size_t offset = (size_t)slot * g_slot_size;
+    uint32_t erase_size = (size + FLASH_SECTOR_SIZE - 1) & ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
+    uint32_t header_size = sizeof(LibraryImageHeader);
+    if (size > g_slot_size || esp_partition_erase_range(g_partition, offset, erase_size) != ESP_OK ||
+        esp_partition_write(g_partition, offset + header_size, image + header_size, size - header_size) != ESP_OK ||
+        esp_partition_write(g_partition, offset, image, header_size) != ESP_OK) {
+        return false;
+    }
+    g_slot = slot;
+    return true;
+}
+
+// ============================================================================
+// LittleFS
+// ============================================================================
+
+// The whole file in PSRAM, or nullptr when it is missing or unreadable
+static uint8_t* read_file(const char* path, uint32_t* size) {
+    if (!LittleFS.exists(path)) return nullptr;
+    File file = LittleFS.open(path, "r");
+    if (!file) return nullptr;
+
+    uint8_t* image = nullptr;
+    uint32_t length = (uint32_t)file.size();
+    if (length >= sizeof(LibraryImageHeader) && length <= LIBRARY_SNAPSHOT_MAX_BYTES) {
+        image = (uint8_t*)heap_caps_malloc(length, MALLOC_CAP_SPIRAM);
+    }
+    if (image && file.read(image, length) != length) {
+        heap_caps_free(image);
+        image = nullptr;
+    }
+    file.close();
+    *size = length;
+    return image;
+}
+
+static bool load_file(void) {
+    // A reset between writing the temp file and the rename leaves a complete temp file
+    static const char* const PATHS[] = {LIBRARY_SNAPSHOT_PATH, LIBRARY_SNAPSHOT_TEMP_PATH};
+    for (const char* path : PATHS) {
+        uint32_t size = 0;
+        uint8_t* image = read_file(path, &size);
+        if (!image) continue;
+        if (library_attach_image(image, size)) {
+            g_loaded = image;
+            note_flash_image((const LibraryImageHeader*)image);
+            return true;
+        }
+        heap_caps_free(image);
+        g_stats.failures++;
+        LOGW(LIBRARY, "Library image %s is corrupt (%u bytes), ignoring it", path, (unsigned)size);
+    }
+    return false;
+}
+
+static bool write_file(const uint8_t* image, uint32_t size) {
+    File file = LittleFS.open(LIBRARY_SNAPSHOT_TEMP_PATH, "w");
+    if (!file) return false;
+    size_t written = file.write(image, size);
+    file.close();
+    if (written != size) {
+        LittleFS.remove(LIBRARY_SNAPSHOT_TEMP_PATH);
+        return false;
+    }
+    // LittleFS renames atomically, replacing the old image in one step
+    return LittleFS.rename(LIBRARY_SNAPSHOT_TEMP_PATH, LIBRARY_SNAPSHOT_PATH);
+}
+
+// ============================================================================
+// Background write
+// ============================================================================
+
+// Owns the image handed over by library_snapshot_save()
+static void write_task(void* arg) {
+    uint8_t* image = (uint8_t*)arg;
+    const LibraryImageHeader* header = (const LibraryImageHeader*)image;
+
+    int64_t start = esp_timer_get_time();
+    bool ok = g_partition ? write_partition(image, header->image_size) : write_file(image, header->image_size);
+    if (ok) {
+        note_flash_image(header);
+        g_stats.saves++;
+        g_stats.write_ms = elapsed_ms(start);
+        LOGI(LIBRARY, "Library image saved: %u playlists, %u artists, %u albums, %u bytes in %u ms",
+             (unsigned)header->collections[LIBRARY_PLAYLISTS].count,
+             (unsigned)header->collections[LIBRARY_ARTISTS].count,
+             (unsigned)header->collections[LIBRARY_ALBUMS].count, (unsigned)header->image_size,
+             (unsigned)g_stats.write_ms);
+    } else {
+        g_stats.failures++;
+        LOGW(LIBRARY, "Library image write failed, keeping the previous one");
+    }
+
+    heap_caps_free(image);
+    g_writing.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+// The library has moved to the arenas: once no reader is left on the versions that read
+// the image, drop the boot mapping or buffer. The slot it mapped may be the next one written.
+static void release_loaded(void) {
+    if (!g_map_active && !g_loaded) return;
+    library_reclaim();
+    if (g_map_active) {
+        esp_partition_munmap(g_map_handle);
+        g_map_active = false;
+    }
+    heap_caps_free(g_loaded);
+    g_loaded = nullptr;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool library_snapshot_init(void) {
+    if (g_ready) return true;
+    g_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           LIBRARY_SNAPSHOT_PARTITION);
+    if (g_partition) {
+        g_slot_size = (g_partition->size / 2) & ~(uint32_t)(FLASH_SECTOR_SIZE - 1);
+        g_stats.mapped = true;
+        g_ready = g_slot_size >= sizeof(LibraryImageHeader);
+        return g_ready;
+    }
+
+    g_ready = LittleFS.begin(true);
+    if (!g_ready) {
+        LOGW(LIBRARY, "No library partition or LittleFS, the library will not persist across reboots");
+    } else if (LittleFS.exists(LEGACY_PATH)) {
+        LittleFS.remove(LEGACY_PATH);
+    }
+    return g_ready;
+}
+
+bool library_snapshot_load(void) {
+    if (!g_ready) return false;
+    int64_t start = esp_timer_get_time();
+    if (!(g_partition ? load_partition() : load_file())) return false;
+
+    g_stats.load_ms = elapsed_ms(start);
+    LOGI(LIBRARY, "Library image attached (%s): %u playlists, %u artists, %u albums, %u bytes in %u ms",
+         g_partition ? "mapped" : "file", (unsigned)library_get_playlist_count(),
+         (unsigned)library_get_artist_count(), (unsigned)library_get_album_count(), (unsigned)g_stats.bytes,
+         (unsigned)g_stats.load_ms);
+    return true;
+}
+
+bool library_snapshot_save(void) {
+    if (!g_ready) return false;
+    if (g_writing.load(std::memory_order_acquire)) {
+        g_stats.busy++;
+        return false;
+    }
+    // Still reading the image from flash - there is nothing newer to save
+    if (library_image_attached()) {
+        g_stats.unchanged++;
+        return false;
+    }
+    release_loaded();
+
+    uint32_t size = library_build_image(nullptr, 0);
+    uint32_t limit = g_partition ? g_slot_size : LIBRARY_SNAPSHOT_MAX_BYTES;
+    uint8_t* image = size <= limit ? (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM) : nullptr;
+    if (!image) {
+        g_stats.failures++;
+        LOGW(LIBRARY, "No room to save the library image (%u bytes)", (unsigned)size);
+        return false;
+    }
+    library_build_image(image, size);
+
+    // Reconnecting to an unchanged library is the common case - no flash wear for it
+    LibraryImageHeader* header = (LibraryImageHeader*)image;
+    if (header->crc == g_flash_crc && size == g_flash_size) {
+        heap_caps_free(image);
+        g_stats.unchanged++;
+        return false;
+    }
+    header->sequence = g_sequence + 1;      // Outside the CRC
+
+    g_writing.store(true, std::memory_order_release);
+    if (xTaskCreate(write_task, "lib_snapshot", LIBRARY_SNAPSHOT_TASK_STACK_SIZE, image,
+                    LIBRARY_SNAPSHOT_TASK_PRIORITY, nullptr) != pdPASS) {
+        heap_caps_free(image);
+        g_writing.store(false, std::memory_order_release);
+        g_stats.failures++;
+        LOGW(LIBRARY, "Failed to create the snapshot task");
+        return false;
+    }
+    return true;
+}
+
+void library_snapshot_get_stats(LibrarySnapshotStats* stats) {
+    *stats = g_stats;
+}
+
+void library_snapshot_log_stats(void) {
+    LOGI(LIBRARY, "Library image %u bytes (%s) saves=%u unchanged=%u busy=%u failures=%u load=%ums write=%ums",
+         (unsigned)g_stats.bytes, g_stats.mapped ? "mapped" : "file", (unsigned)g_stats.saves,
+         (unsigned)g_stats.unchanged, (unsigned)g_stats.busy, (unsigned)g_stats.failures, (unsigned)g_stats.load_ms,
+         (unsigned)g_stats.write_ms);
+}
@@ -0,0 +1,54 @@
+/*
+ * Library Snapshot - Playlists, artists and albums kept in flash across reboots
+ * After a full sync the store is saved as a library image (see library_image.h); at
+ * boot the image is attached before BLE starts, so the library lists work at once
+ * instead of after a re-download, with nothing copied into the arenas
+ *
+ * With a data partition labelled LIBRARY_SNAPSHOT_PARTITION the image is read in place
+ * through a flash mapping. The partition holds two slots written alternately, the
+ * header last, so a reset mid-write leaves the previous image intact; add it to the
+ * sketch's partitions.csv, e.g.  library, data, 0x40, , 1M
+ * Without it the image is a LittleFS file (the Arduino "spiffs" partition), written to
+ * a temp file and renamed over the old one, and read into PSRAM in one go at boot.
+ *
+ * The image is built in the caller (fast, PSRAM to PSRAM) and written to flash by a
+ * short-lived low-priority task, so the loop keeps draining BLE while flash is busy.
+ * Song lists are not included (see song_cache.h).
+ */
+#pragma once
+
+#include <stdint.h>
+#include "library_data.h"
+
+#define LIBRARY_SNAPSHOT_PARTITION          "library"
+#define LIBRARY_SNAPSHOT_PATH               "/library.img"
+#define LIBRARY_SNAPSHOT_TEMP_PATH          "/library.tmp"
+#define LIBRARY_SNAPSHOT_MAX_BYTES          (1024 * 1024)   // Larger images are not saved
+#define LIBRARY_SNAPSHOT_TASK_STACK_SIZE    (4 * 1024)
+#define LIBRARY_SNAPSHOT_TASK_PRIORITY      (1)             // Below the protocol, TX and LVGL tasks
+
+typedef struct {
+    uint32_t saves;             // Images written
+    uint32_t unchanged;         // Full syncs that matched the image already in flash
+    uint32_t busy;              // Full syncs skipped because a write was still running
+    uint32_t failures;          // Writes or loads that failed
+    uint32_t bytes;             // Size of the image in flash
+    uint32_t load_ms;           // Finding, checking and attaching it at boot
+    uint32_t write_ms;          // The last write
+    bool mapped;                // The library partition is in use (else LittleFS)
+} LibrarySnapshotStats;
+
+// Find the library partition, or mount LittleFS (formatting it on first use).
+// Returns false when there is neither.
+bool library_snapshot_init(void);
+
+// Attach the newest valid image in flash (library_attach_image()). Returns false
+// (library untouched) when there is none.
+bool library_snapshot_load(void);
+
+// Save playlists, artists and albums; the flash write finishes in the background.
+// Returns false when nothing is written (unchanged, busy, no memory).
+bool library_snapshot_save(void);
+
+void library_snapshot_get_stats(LibrarySnapshotStats* stats);
+void library_snapshot_log_stats(void);
@@ -0,0 +1,100 @@
+/*
+ * Message Ring - Lock-free single-producer/single-consumer byte ring
+ * Carries length-prefixed messages from the BLE callback to the protocol task
+ */
+
+#include "msg_ring.h"
+#include <string.h>
+
+// Copy into the ring at a free-running position, wrapping at the end
+static void ring_write(MsgRing* ring, uint32_t pos, const uint8_t* src, uint32_t length) {
+    uint32_t offset = pos & (ring->capacity - 1);
+    uint32_t first = ring->capacity - offset;
+    if (first > length) first = length;
+    memcpy(ring->buffer + offset, src, first);
+    if (length > first) {
+        memcpy(ring->buffer, src + first, length - first);
+    }
+}
+
+// Copy out of the ring at a free-running position, wrapping at the end
+static void ring_read(const MsgRing* ring, uint32_t pos, uint8_t* dst, uint32_t length) {
+    uint32_t offset = pos & (ring->capacity - 1);
+    uint32_t first = ring->capacity - offset;
+    if (first > length) first = length;
+    memcpy(dst, ring->buffer + offset, first);
+    if (length > first) {
+        memcpy(dst + first, ring->buffer, length - first);
+    }
+}
+
+bool msg_ring_init(MsgRing* ring, uint8_t* buffer, uint32_t capacity) {
+    if (!ring || !buffer || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    ring->buffer = buffer;
+    ring->capacity = capacity;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->high_water.store(0, std::memory_order_relaxed);
+    ring->dropped.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool msg_ring_push(MsgRing* ring, const uint8_t* data, uint16_t length) {
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    uint32_t used = head - tail;
+    uint32_t needed = MSG_RING_HEADER_SIZE + length;
+
+    if (needed > ring->capacity - used) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint8_t header[MSG_RING_HEADER_SIZE] = {(uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+    ring_write(ring, head, header, MSG_RING_HEADER_SIZE);
+    ring_write(ring, head + MSG_RING_HEADER_SIZE, data, length);
+
+    // Publish the record only after its bytes are in place
+    ring->head.store(head + needed, std::memory_order_release);
+
+    used += needed;
+    if (used > ring->high_water.load(std::memory_order_relaxed)) {
+        ring->high_water.store(used, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+size_t msg_ring_pop(MsgRing* ring, uint8_t* out, size_t out_size) {
+    while (true) {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+        if (head == tail) {
+            return 0;
+        }
+
+        uint8_t header[MSG_RING_HEADER_SIZE];
+        ring_read(ring, tail, header, MSG_RING_HEADER_SIZE);
+        uint16_t length = (uint16_t)header[0] | ((uint16_t)header[1] << 8);
+
+        if (length > out_size) {
+            // Cannot hand this record out - skip it and try the next one
+            ring->tail.store(tail + MSG_RING_HEADER_SIZE + length, std::memory_order_release);
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        ring_read(ring, tail + MSG_RING_HEADER_SIZE, out, length);
+        ring->tail.store(tail + MSG_RING_HEADER_SIZE + length, std::memory_order_release);
+        return length;
+    }
+}
+
+uint32_t msg_ring_used(const MsgRing* ring) {
+    return ring->head.load(std::memory_order_acquire) - ring->tail.load(std::memory_order_acquire);
+}
+
+void msg_ring_clear(MsgRing* ring) {
+    ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+}
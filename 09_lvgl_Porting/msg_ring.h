@@ -0,0 +1,37 @@
+/*
+ * Message Ring - Lock-free single-producer/single-consumer byte ring
+ * Carries length-prefixed messages from the BLE callback to the protocol task
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Each record is stored as a 2-byte little-endian length followed by the bytes
+#define MSG_RING_HEADER_SIZE    2
+
+typedef struct {
+    uint8_t* buffer;
+    uint32_t capacity;                  // Must be a power of two
+    std::atomic<uint32_t> head;         // Free-running write position (producer only)
+    std::atomic<uint32_t> tail;         // Free-running read position (consumer only)
+    std::atomic<uint32_t> high_water;   // Largest number of bytes ever in use
+    std::atomic<uint32_t> dropped;      // Records rejected because the ring was full
+} MsgRing;
+
+// Initialize a ring over caller-owned storage (capacity must be a power of two)
+bool msg_ring_init(MsgRing* ring, uint8_t* buffer, uint32_t capacity);
+
+// Producer: append one record, returns false (and counts a drop) if it does not fit
+bool msg_ring_push(MsgRing* ring, const uint8_t* data, uint16_t length);
+
+// Consumer: remove the oldest record into out, returns its length or 0 if empty.
+// Records larger than out_size are discarded and counted as dropped.
+size_t msg_ring_pop(MsgRing* ring, uint8_t* out, size_t out_size);
+
+// Number of bytes currently in use (headers included)
+uint32_t msg_ring_used(const MsgRing* ring);
+
+// Discard everything (consumer side only)
+void msg_ring_clear(MsgRing* ring);
@@ -0,0 +1,275 @@
+/*
+ * Page Tracker - Delivery state of one paginated response (PLAYLISTS_RESPONSE etc.)
+ */
+
+#include "page_tracker.h"
+#include <string.h>
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#else
+#include <stdlib.h>
+#endif
+
+// Held pages and the page bitmap
+static uint8_t* hold_alloc(size_t size) {
+#ifdef ARDUINO
+    uint8_t* data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    return data ? data : (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    return (uint8_t*)malloc(size);
+#endif
+}
+
+static void hold_free(uint8_t* data) {
+#ifdef ARDUINO
+    heap_caps_free(data);
+#else
+    free(data);
+#endif
+}
+
+static bool page_received(const PageTracker* t, uint32_t page) {
+    return (t->received[(page - 1) / 32] >> ((page - 1) % 32)) & 1;
+}
+
+static void mark_received(PageTracker* t, uint32_t page) {
+    t->received[(page - 1) / 32] |= 1u << ((page - 1) % 32);
+}
+
+static void free_held(PageTracker* t) {
+    for (int i = 0; i < PAGE_TRACKER_HOLD_PAGES; i++) {
+        page_tracker_release(&t->held[i]);
+    }
+    t->held_bytes = 0;
+}
+
+// Back to "asked for, nothing arrived", keeping what the transfer is for
+static void reset_pages(PageTracker* t) {
+    free_held(t);
+    if (t->received) memset(t->received, 0, (t->max_pages + 31) / 32 * sizeof(uint32_t));
+    t->total_pages = 0;
+    t->total_items = 0;
+    t->next_page = 1;
+    t->items_applied = 0;
+    t->any_page = false;
+}
+
+static bool same_context(const PageTracker* t, const PageInfo* info) {
+    const char* context = info->context ? info->context : "";
+    const char* context_id = info->context_id ? info->context_id : "";
+    // Ids were cut to the buffer size when stored
+    return strncmp(t->context, context, sizeof(t->context) - 1) == 0 &&
+           strncmp(t->context_id, context_id, sizeof(t->context_id) - 1) == 0;
+}
+
+static void set_context(PageTracker* t, const char* context, const char* context_id) {
+    strncpy(t->context, context ? context : "", sizeof(t->context) - 1);
+    t->context[sizeof(t->context) - 1] = '\0';
+    strncpy(t->context_id, context_id ? context_id : "", sizeof(t->context_id) - 1);
+    t->context_id[sizeof(t->context_id) - 1] = '\0';
+}
+
+static bool hold_page(PageTracker* t, uint32_t page, const void* message, size_t length) {
+    if (!message || t->held_bytes + length > PAGE_TRACKER_HOLD_BYTES) return false;
+    for (int i = 0; i < PAGE_TRACKER_HOLD_PAGES; i++) {
+        HeldPage* slot = &t->held[i];
+        if (slot->data) continue;
+        slot->data = hold_alloc(length);
+        if (!slot->data) return false;
+        memcpy(slot->data, message, length);
+        slot->length = length;
+        slot->page = page;
+        t->held_bytes += length;
+        return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// API
+// ============================================================================
+
+bool page_tracker_init(PageTracker* t, uint32_t max_pages) {
+    memset(t, 0, sizeof(*t));
+    t->next_page = 1;
+    if (max_pages == 0) max_pages = 1;          // An empty list is one empty page
+    size_t bytes = (max_pages + 31) / 32 * sizeof(uint32_t);
+    t->received = (uint32_t*)hold_alloc(bytes);
+    if (!t->received) return false;
+    memset(t->received, 0, bytes);
+    t->max_pages = max_pages;
+    return true;
+}
+
+void page_tracker_start(PageTracker* t, const char* context, const char* context_id, uint32_t first_item,
+                        uint32_t item_limit, uint32_t request_id, uint32_t now_ms) {
+    reset_pages(t);
+    set_context(t, context, context_id);
+    t->request_id = request_id;
+    t->first_item = first_item;
+    t->item_limit = item_limit;
+    t->active = true;
+    t->retries = 0;
+    t->last_activity_ms = now_ms;
+    t->stats.transfers++;
+}
+
+void page_tracker_cancel(PageTracker* t) {
+    reset_pages(t);
+    t->active = false;
+    t->request_id = 0;
+}
+
+PageAction page_tracker_accept(PageTracker* t, const PageInfo* info, const void* message, size_t length,
+                               uint32_t now_ms) {
+    uint32_t page = info->page;
+    // An app that echoes request ids names the query; any other than the last one sent
+    // was superseded or cancelled
+    if (info->request_id != 0 && info->request_id != t->request_id) {
+        t->stats.stale++;
+        return PAGE_STALE;
+    }
+    if (!t->active) {
+        // Only a first page starts a transfer nobody asked for (or one given up on); one
+        // with the id of a transfer that completed or was given up on is a late copy
+        if (page != 1 || info->request_id != 0) {
+            t->stats.duplicates++;
+            return PAGE_DUPLICATE;
+        }
+        page_tracker_start(t, info->context, info->context_id, info->offset, 0, 0, now_ms);
+    } else if (!same_context(t, info)) {
+        t->stats.foreign++;
+        return PAGE_FOREIGN;
+    }
+
+    if (info->total_pages > t->max_pages) {
+        // More pages than the list can fill at one item each: none of them can be tracked,
+        // and asking again would bring the same
+        reset_pages(t);
+        t->active = false;
+        t->stats.failed++;
+        return PAGE_GIVE_UP;
+    }
+    if (page == 0 || page > info->total_pages) {
+        t->stats.dropped++;
+        return PAGE_DROP;
+    }
+
+    // The app's list changed under the transfer: page boundaries no longer line up
+    bool changed = t->any_page && (info->total_pages != t->total_pages || info->total_items != t->total_items);
+    if (!changed && page == t->next_page && info->total_items != 0) {
+        changed = info->offset != t->first_item + t->items_applied;
+    }
+    if (changed) {
+        reset_pages(t);
+        t->retries++;
+        t->last_activity_ms = now_ms;
+        t->stats.restarts++;
+        return PAGE_RESTART;
+    }
+    t->any_page = true;
+    t->total_pages = info->total_pages;
+    t->total_items = info->total_items;
+
+    if (page < t->next_page || page_received(t, page)) {
+        t->stats.duplicates++;
+        return PAGE_DUPLICATE;
+    }
+    if (page == t->next_page) {
+        mark_received(t, page);
+        t->next_page++;
+        t->retries = 0;
+        t->last_activity_ms = now_ms;
+        return PAGE_APPLY;
+    }
+    if (!hold_page(t, page, message, length)) {
+        t->stats.dropped++;
+        return PAGE_DROP;
+    }
+    mark_received(t, page);
+    t->retries = 0;
+    t->last_activity_ms = now_ms;
+    t->stats.held++;
+    return PAGE_HOLD;
+}
+
+bool page_tracker_applied(PageTracker* t, uint32_t page, uint32_t items) {
+    // A restart or a new query since the page was accepted: it belongs to no transfer
+    if (!t->active || page + 1 != t->next_page) return false;
+    t->items_applied += items;
+    if (page != t->total_pages) return false;
+
+    free_held(t);
+    t->active = false;
+    t->stats.completed++;
+    return true;
+}
+
+bool page_tracker_take_ready(PageTracker* t, HeldPage* out) {
+    if (!t->active) return false;
+    for (int i = 0; i < PAGE_TRACKER_HOLD_PAGES; i++) {
+        HeldPage* slot = &t->held[i];
+        if (!slot->data || slot->page != t->next_page) continue;
+        *out = *slot;
+        t->held_bytes -= slot->length;
+        *slot = {};
+        // The bit stays set; clear it so the replay is accepted as the next page
+        t->received[(out->page - 1) / 32] &= ~(1u << ((out->page - 1) % 32));
+        return true;
+    }
+    return false;
+}
+
+void page_tracker_release(HeldPage* page) {
+    if (page->data) hold_free(page->data);
+    *page = {};
+}
+
+PagePollResult page_tracker_poll(PageTracker* t, uint32_t now_ms, PageRange* ranges, int* range_count) {
+    *range_count = 0;
+    if (!t->active) return PAGE_POLL_IDLE;
+    uint32_t timeout = t->any_page ? PAGE_TRACKER_TIMEOUT_MS : PAGE_TRACKER_FIRST_PAGE_TIMEOUT_MS;
+    if (now_ms - t->last_activity_ms < timeout) return PAGE_POLL_IDLE;
+
+    t->stats.timeouts++;
+    if (++t->retries > PAGE_TRACKER_MAX_RETRIES) {
+        page_tracker_cancel(t);
+        t->stats.failed++;
+        return PAGE_POLL_FAILED;
+    }
+    t->last_activity_ms = now_ms;
+    t->stats.retransmits++;
+    if (!t->any_page) return PAGE_POLL_RETRY;
+
+    // Runs of pages not received; past the last range slot, one range covers the rest
+    for (uint32_t page = t->next_page; page <= t->total_pages; page++) {
+        if (page_received(t, page)) continue;
+        if (*range_count == PAGE_TRACKER_MAX_RANGES) {
+            ranges[*range_count - 1].last = t->total_pages;
+            break;
+        }
+        uint32_t last = page;
+        while (last < t->total_pages && !page_received(t, last + 1)) last++;
+        ranges[(*range_count)++] = {page, last};
+        page = last;
+    }
+    for (int i = 0; i < *range_count; i++) {
+        t->stats.pages_requested += ranges[i].last - ranges[i].first + 1;
+    }
+    return PAGE_POLL_RETRY;
+}
+
+void page_tracker_add_stats(const PageTracker* t, PageTrackerStats* sum) {
+    sum->transfers += t->stats.transfers;
+    sum->completed += t->stats.completed;
+    sum->failed += t->stats.failed;
+    sum->timeouts += t->stats.timeouts;
+    sum->retransmits += t->stats.retransmits;
+    sum->pages_requested += t->stats.pages_requested;
+    sum->held += t->stats.held;
+    sum->dropped += t->stats.dropped;
+    sum->duplicates += t->stats.duplicates;
+    sum->foreign += t->stats.foreign;
+    sum->stale += t->stats.stale;
+    sum->restarts += t->stats.restarts;
+}
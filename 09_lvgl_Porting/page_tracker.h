@@ -0,0 +1,147 @@
+/*
+ * Page Tracker - Delivery state of one paginated response (PLAYLISTS_RESPONSE etc.)
+ * Lets a transfer survive lost and reordered pages without starting over
+ *
+ * A bitmap records the pages that arrived, sized once for the most pages a transfer
+ * can have (a page holds at least one item, so the collection's capacity). Pages are still applied strictly in
+ * order, so the library keeps appending records and updating its indexes one page
+ * at a time: a page that arrives early is copied and held until the gap before it
+ * fills, then handed back by page_tracker_take_ready(). When nothing arrives for
+ * PAGE_TRACKER_TIMEOUT_MS, page_tracker_poll() names the missing page ranges so the
+ * query can be repeated for just those (protocol v1.2 firstPage / lastPage); after
+ * PAGE_TRACKER_MAX_RETRIES rounds without progress the transfer is given up.
+ *
+ * Page counts, item totals and offsets (v1.2 apps) must stay consistent across a
+ * transfer; when they change the app's list changed mid-transfer and it restarts.
+ * A transfer may cover a slice of the list (v1.3 offset / limit): its pages then
+ * count items from the slice's first one.
+ *
+ * Each transfer carries the request id its query was sent with (v1.6). Apps that echo
+ * it let pages of a superseded or cancelled query be told apart from the header alone,
+ * before any item is read; pages without one are matched as before.
+ *
+ * Not thread-safe on its own - the caller serializes access (see the sketch).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAGE_TRACKER_HOLD_PAGES             32              // Early pages held per transfer
+#define PAGE_TRACKER_HOLD_BYTES             (64 * 1024)     // ... and their bytes at most
+#define PAGE_TRACKER_TIMEOUT_MS             1500            // Silence before missing pages are asked for again
+#define PAGE_TRACKER_FIRST_PAGE_TIMEOUT_MS  5000            // The app gathers the whole list before page 1
+#define PAGE_TRACKER_MAX_RETRIES            3               // Rounds without progress before giving up
+#define PAGE_TRACKER_MAX_RANGES             4               // Ranges asked for per round
+#define PAGE_TRACKER_CONTEXT_SIZE           16
+#define PAGE_TRACKER_CONTEXT_ID_SIZE        64
+
+// Page fields of a response
+typedef struct {
+    uint32_t page;              // 1-based
+    uint32_t total_pages;
+    uint32_t total_items;       // 0 when the app does not send it (before v1.2)
+    uint32_t offset;            // Items of the list before this page (v1.2)
+    const char* context;        // Songs responses; nullptr for the other collections
+    const char* context_id;
+    uint32_t request_id;        // Echo of the query's request id (v1.6), 0 when not sent
+} PageInfo;
+
+typedef enum {
+    PAGE_APPLY,                 // Next in order - apply it, then call page_tracker_applied()
+    PAGE_HOLD,                  // Early - copied, handed back by page_tracker_take_ready()
+    PAGE_DUPLICATE,             // Already applied or held, or late for a finished transfer
+    PAGE_DROP,                  // Early with no room (or no copy) to hold it - asked for again later
+    PAGE_FOREIGN,               // Songs of another list than the one asked for
+    PAGE_STALE,                 // Answers a query superseded or cancelled since (request id)
+    PAGE_RESTART,               // Totals changed mid-transfer - repeat the whole query
+    PAGE_GIVE_UP                // More pages than the bitmap covers - the transfer is given up
+} PageAction;
+
+typedef enum {
+    PAGE_POLL_IDLE,             // Nothing to do
+    PAGE_POLL_RETRY,            // Ask for the returned ranges again (none: the whole query)
+    PAGE_POLL_FAILED            // Out of retries - the transfer is given up
+} PagePollResult;
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+} PageRange;
+
+typedef struct {
+    uint32_t transfers;         // Transfers started
+    uint32_t completed;
+    uint32_t failed;            // Given up after PAGE_TRACKER_MAX_RETRIES, or too many pages
+    uint32_t timeouts;          // Rounds of silence
+    uint32_t retransmits;       // Queries repeated (ranges or whole)
+    uint32_t pages_requested;   // Pages named in ranged repeats
+    uint32_t held;              // Pages that arrived early and were held
+    uint32_t dropped;           // ... or could not be held
+    uint32_t duplicates;
+    uint32_t foreign;
+    uint32_t stale;             // Pages of superseded or cancelled queries
+    uint32_t restarts;          // Inconsistent totals or offsets
+} PageTrackerStats;
+
+typedef struct {
+    uint32_t page;
+    uint8_t* data;              // Copy of the whole message
+    size_t length;
+} HeldPage;
+
+typedef struct {
+    bool active;                // Asked for and not yet complete
+    uint32_t request_id;        // Of the query last sent, kept once complete - 0 once cancelled
+    uint32_t total_pages;       // 0 until a page arrives
+    uint32_t total_items;
+    uint32_t next_page;         // Next page to apply
+    uint32_t items_applied;
+    uint32_t first_item;        // Slice asked for (v1.3): offset of page 1 ...
+    uint32_t item_limit;        // ... and its items at most, 0 for the whole list
+    uint32_t last_activity_ms;  // Query sent, or a page applied or held
+    bool any_page;              // A page arrived since the query
+    uint8_t retries;            // Rounds since the last progress
+    char context[PAGE_TRACKER_CONTEXT_SIZE];
+    char context_id[PAGE_TRACKER_CONTEXT_ID_SIZE];
+    uint32_t* received;         // Bit per page, applied or held
+    uint32_t max_pages;         // Pages the bitmap covers
+    HeldPage held[PAGE_TRACKER_HOLD_PAGES];
+    size_t held_bytes;
+    PageTrackerStats stats;
+} PageTracker;
+
+// Reserve the bitmap for transfers of up to max_pages pages (PSRAM when available).
+// Once per tracker; false when it cannot be reserved.
+bool page_tracker_init(PageTracker* t, uint32_t max_pages);
+
+// A query went out: any transfer in progress is forgotten. context / context_id name the
+// song list asked for (nullptr for other collections); first_item / item_limit the slice
+// of it (0 / 0: the whole list); request_id the id the query carries (0: none).
+void page_tracker_start(PageTracker* t, const char* context, const char* context_id, uint32_t first_item,
+                        uint32_t item_limit, uint32_t request_id, uint32_t now_ms);
+
+// Stop tracking and free held pages (disconnect, or the query was cancelled). Late pages
+// are then duplicates, or stale when they carry a request id.
+void page_tracker_cancel(PageTracker* t);
+
+// A response page arrived. message / length is the whole message as received, copied
+// if the page is held; pass nullptr when it cannot be replayed and early pages are dropped.
+PageAction page_tracker_accept(PageTracker* t, const PageInfo* info, const void* message, size_t length,
+                               uint32_t now_ms);
+
+// A PAGE_APPLY page with items items was applied. Returns true when it completed the
+// transfer, so the list can be published.
+bool page_tracker_applied(PageTracker* t, uint32_t page, uint32_t items);
+
+// A held page that is next in order, false if there is none. Replay it like a received
+// message, then free it with page_tracker_release().
+bool page_tracker_take_ready(PageTracker* t, HeldPage* out);
+void page_tracker_release(HeldPage* page);
+
+// Check for silence. On PAGE_POLL_RETRY, ranges holds *range_count ranges to ask for
+// again (0: repeat the whole query, nothing arrived yet).
+PagePollResult page_tracker_poll(PageTracker* t, uint32_t now_ms, PageRange* ranges, int* range_count);
+
+// Add t's counters to *sum
+void page_tracker_add_stats(const PageTracker* t, PageTrackerStats* sum);
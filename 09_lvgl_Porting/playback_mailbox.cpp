@@ -0,0 +1,69 @@
+/*
+ * Playback Mailbox - Latest-value handoff of playback progress to the LVGL task
+ * The protocol task publishes every PLAYBACK_PROGRESS; the UI takes at most one per frame
+ */
+
+#include "playback_mailbox.h"
+#include <atomic>
+#include <string.h>
+
+#define TAKE_RETRIES    4           // Copies attempted while the writer is mid-update
+
+static PlaybackSnapshot g_value;
+static std::atomic<uint32_t> g_seq(0);          // Odd while the writer is updating g_value
+static std::atomic<uint32_t> g_published(0);
+static std::atomic<uint32_t> g_taken(0);
+static std::atomic<uint32_t> g_coalesced(0);
+static uint32_t g_last_taken_seq = 0;           // Reader only
+
+void playback_mailbox_publish(uint32_t elapsed_ms, bool is_playing, const char* song_id) {
+    uint32_t seq = g_seq.load(std::memory_order_relaxed);
+    g_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    g_value.elapsed_ms = elapsed_ms;
+    g_value.is_playing = is_playing;
+    if (song_id) {
+        size_t length = strnlen(song_id, sizeof(g_value.song_id) - 1);
+        memcpy(g_value.song_id, song_id, length);
+        g_value.song_id[length] = '\0';
+    } else {
+        g_value.song_id[0] = '\0';
+    }
+
+    g_seq.store(seq + 2, std::memory_order_release);
+    g_published.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool playback_mailbox_take(PlaybackSnapshot* out) {
+    for (int attempt = 0; attempt < TAKE_RETRIES; attempt++) {
+        uint32_t before = g_seq.load(std::memory_order_acquire);
+        if (before == g_last_taken_seq) {
+            return false;
+        }
+        if (before & 1) {
+            continue;
+        }
+
+        memcpy(out, &g_value, sizeof(*out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (g_seq.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+
+        // Each publish advances the sequence by two
+        uint32_t updates = (before - g_last_taken_seq) / 2;
+        g_last_taken_seq = before;
+        g_taken.fetch_add(1, std::memory_order_relaxed);
+        g_coalesced.fetch_add(updates - 1, std::memory_order_relaxed);
+        return true;
+    }
+    // Writer kept us out; the next frame will get it
+    return false;
+}
+
+void playback_mailbox_get_stats(PlaybackMailboxStats* stats) {
+    stats->published = g_published.load(std::memory_order_relaxed);
+    stats->taken = g_taken.load(std::memory_order_relaxed);
+    stats->coalesced = g_coalesced.load(std::memory_order_relaxed);
+}
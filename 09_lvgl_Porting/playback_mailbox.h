@@ -0,0 +1,33 @@
+/*
+ * Playback Mailbox - Latest-value handoff of playback progress to the LVGL task
+ * The protocol task publishes every PLAYBACK_PROGRESS; the UI takes at most one per frame
+ *
+ * Single writer, single reader, no locks: a sequence counter (seqlock) lets the
+ * reader detect a torn copy and retry. Publishing overwrites whatever the reader
+ * has not taken yet; those skipped values are counted as coalesced.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "library_data.h"
+
+typedef struct {
+    uint32_t elapsed_ms;
+    bool is_playing;
+    char song_id[MAX_ID_LENGTH];
+} PlaybackSnapshot;
+
+typedef struct {
+    uint32_t published;
+    uint32_t taken;
+    uint32_t coalesced;         // Published values replaced before the UI took them
+} PlaybackMailboxStats;
+
+// Writer side (protocol task). song_id may be nullptr.
+void playback_mailbox_publish(uint32_t elapsed_ms, bool is_playing, const char* song_id);
+
+// Reader side (LVGL task). Returns true and fills out if something was published since the last take.
+bool playback_mailbox_take(PlaybackSnapshot* out);
+
+void playback_mailbox_get_stats(PlaybackMailboxStats* stats);
@@ -0,0 +1,220 @@
+/*
+ * Search Index - Word-prefix index over the names of one collection
+ */
+
+#include "search_index.h"
+#include "collate.h"
+#include <string.h>
+
+#define SEARCH_KEY_CHARS    4
+#define SEARCH_QUERY_WORDS  4       // Query words past this are ignored
+
+// Letters, digits and anything outside ASCII (other scripts) make up words
+static bool is_word_char(uint32_t c) {
+    if (c >= 'a' && c <= 'z') return true;
+    if (c >= '0' && c <= '9') return true;
+    return c >= 0x80 && c != 0xD7 && c != 0xF7;     // Not the multiplication / division signs
+}
+
+// Start of the next word at or after s, or nullptr when there is none
+static const char* next_word(const char* s) {
+    while (true) {
+        const char* start = s;
+        uint32_t c = collate_next(&s);
+        if (c == 0) return nullptr;
+        if (is_word_char(c)) return start;
+    }
+}
+
+static const char* skip_word(const char* s) {
+    while (true) {
+        const char* start = s;
+        if (!is_word_char(collate_next(&s))) return start;
+    }
+}
+
+// Key of the word at s and the number of characters it covers
+static uint32_t word_key(const char* s, int* length) {
+    uint32_t key = 0;
+    int i = 0;
+    for (; i < SEARCH_KEY_CHARS; i++) {
+        uint32_t c = collate_next(&s);
+        if (!is_word_char(c)) break;
+        key |= (c < 0xFF ? c : 0xFF) << (8 * (SEARCH_KEY_CHARS - 1 - i));
+    }
+    *length = i;
+    return key;
+}
+
+// Whether the word at word starts with the word at prefix
+static bool word_starts_with(const char* word, const char* prefix) {
+    while (true) {
+        uint32_t p = collate_next(&prefix);
+        if (!is_word_char(p)) return true;
+        if (collate_next(&word) != p) return false;
+    }
+}
+
+// Whether every query word is the start of some word of name
+static bool name_matches(const char* name, const char* const* query_words, int query_count) {
+    for (int q = 0; q < query_count; q++) {
+        bool found = false;
+        for (const char* w = next_word(name); w && !found; w = next_word(skip_word(w))) {
+            found = word_starts_with(w, query_words[q]);
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+bool search_index_init(SearchIndex* index, uint32_t capacity) {
+    index->words = nullptr;
+    index->capacity = 0;
+    index->count = 0;
+    index->sorted = 0;
+    index->dropped = 0;
+    if (!arena_init(&index->storage, (size_t)capacity * sizeof(SearchWord))) return false;
+    index->words = (SearchWord*)arena_alloc(&index->storage, (size_t)capacity * sizeof(SearchWord),
+                                            alignof(SearchWord));
+    if (!index->words && capacity > 0) return false;
+    index->capacity = capacity;
+    return true;
+}
+
+void search_index_reset(SearchIndex* index) {
+    index->count = 0;
+    index->sorted = 0;
+}
+
+void search_index_view(SearchIndex* index, const SearchWord* words, uint32_t count) {
+    index->storage = Arena{};
+    index->words = (SearchWord*)words;
+    index->capacity = count;
+    index->count = count;
+    index->sorted = count;
+    index->dropped = 0;
+}
+
+void search_index_add(SearchIndex* index, lib_index_t record, const char* name) {
+    for (const char* w = next_word(name); w; w = next_word(skip_word(w))) {
+        if (index->count >= index->capacity) {
+            index->dropped++;
+            continue;
+        }
+        int length;
+        index->words[index->count].key = word_key(w, &length);
+        index->words[index->count].record = record;
+        index->count++;
+    }
+}
+
+// First position in words[0..length) whose key is above key - equal keys stay in arrival order
+static uint32_t upper_bound(const SearchWord* words, uint32_t length, uint32_t key) {
+    uint32_t low = 0;
+    uint32_t high = length;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (key < words[mid].key) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+static uint32_t lower_bound(const SearchWord* words, uint32_t length, uint32_t key) {
+    uint32_t low = 0;
+    uint32_t high = length;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (words[mid].key < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void search_index_update(SearchIndex* index, SearchWord* scratch, uint32_t scratch_size) {
+    while (index->sorted < index->count) {
+        uint32_t run = index->count - index->sorted;
+        if (run > scratch_size) run = scratch_size;
+
+        // Sort the run by binary insertion, as sort_index.cpp does
+        for (uint32_t i = 0; i < run; i++) {
+            SearchWord word = index->words[index->sorted + i];
+            uint32_t at = upper_bound(scratch, i, word.key);
+            memmove(&scratch[at + 1], &scratch[at], (i - at) * sizeof(SearchWord));
+            scratch[at] = word;
+        }
+
+        // Merge from the back into words[0..sorted + run); later words are untouched
+        SearchWord* words = index->words;
+        uint32_t end = index->sorted;
+        for (uint32_t j = run; j > 0; j--) {
+            SearchWord word = scratch[j - 1];
+            uint32_t at = upper_bound(words, end, word.key);
+            memmove(&words[at + j], &words[at], (end - at) * sizeof(SearchWord));
+            words[at + j - 1] = word;
+            end = at;
+        }
+        index->sorted += run;
+    }
+}
+
+static bool add_result(lib_index_t record, lib_index_t* results, uint16_t* found) {
+    for (uint16_t i = 0; i < *found; i++) {
+        if (results[i] == record) return false;
+    }
+    results[(*found)++] = record;
+    return true;
+}
+
+uint16_t search_index_query(const SearchIndex* index, const char* query, SearchName name_of, const void* context,
+                            lib_index_t* results, uint16_t max_results) {
+    // Scan the key range of the most selective query word (the fewest indexed words);
+    // every query word is then confirmed per record
+    const char* query_words[SEARCH_QUERY_WORDS];
+    int query_count = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint32_t range_start = 0;
+    uint32_t range_end = 0;
+    for (const char* w = next_word(query); w && query_count < SEARCH_QUERY_WORDS; w = next_word(skip_word(w))) {
+        int length;
+        uint32_t key = word_key(w, &length);
+        // Every key starting with the length characters the word covers
+        uint32_t key_last = key | (length < SEARCH_KEY_CHARS ? 0xFFFFFFFFu >> (8 * length) : 0);
+        uint32_t start = lower_bound(index->words, index->sorted, key);
+        uint32_t end = upper_bound(index->words, index->sorted, key_last);
+        if (query_count == 0 || end - start < range_end - range_start) {
+            first = key;
+            last = key_last;
+            range_start = start;
+            range_end = end;
+        }
+        query_words[query_count++] = w;
+    }
+    if (query_count == 0 || max_results == 0) return 0;
+
+    uint16_t found = 0;
+    for (uint32_t i = range_start; i < range_end; i++) {
+        lib_index_t record = index->words[i].record;
+        if (name_matches(name_of(context, record), query_words, query_count) && add_result(record, results, &found) &&
+            found == max_results) {
+            return found;
+        }
+    }
+
+    for (uint32_t i = index->sorted; i < index->count; i++) {
+        const SearchWord* word = &index->words[i];
+        if (word->key < first || word->key > last) continue;
+        if (name_matches(name_of(context, word->record), query_words, query_count) &&
+            add_result(word->record, results, &found) && found == max_results) {
+            break;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,53 @@
+/*
+ * Search Index - Word-prefix index over the names of one collection
+ * Every word of every name is keyed by its first four folded characters (see collate.h)
+ * and kept sorted, so a query is a binary search plus a scan of the matching range
+ *
+ * Like the sort indexes it is maintained incrementally: words of new records are
+ * appended, then sorted and merged into the ordered part once per page. Words not yet
+ * merged are still searched, linearly.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "arena.h"
+#include "library_data.h"
+
+typedef struct {
+    uint32_t key;               // First four folded characters, big-endian, zero padded
+    lib_index_t record;
+} SearchWord;
+
+// Name of a record, to confirm a candidate against the whole query; context is what
+// search_index_query() was given (the records searched)
+typedef const char* (*SearchName)(const void* context, lib_index_t record);
+
+typedef struct {
+    Arena storage;
+    SearchWord* words;
+    uint32_t capacity;
+    uint32_t count;             // Words held
+    uint32_t sorted;            // words[0..sorted) are in key order
+    uint32_t dropped;           // Words not indexed because the index was full
+} SearchIndex;
+
+// Room for capacity words, PSRAM first
+bool search_index_init(SearchIndex* index, uint32_t capacity);
+
+// Forget every word - O(1)
+void search_index_reset(SearchIndex* index);
+
+// Wrap count words already in key order (a library image) - read only, never add to or
+// update a view
+void search_index_view(SearchIndex* index, const SearchWord* words, uint32_t count);
+
+// Index each word of record's name
+void search_index_add(SearchIndex* index, lib_index_t record, const char* name);
+
+// Merge the words added since the last update into the ordered part, scratch_size at a time
+void search_index_update(SearchIndex* index, SearchWord* scratch, uint32_t scratch_size);
+
+// Records with a word starting with each word of query, in key order, at most
+// max_results. Returns the number found.
+uint16_t search_index_query(const SearchIndex* index, const char* query, SearchName name_of, const void* context,
+                            lib_index_t* results, uint16_t max_results);
@@ -0,0 +1,244 @@
+/*
+ * Song Cache - Recently opened song lists, so detail screens reopen without a BLE round trip
+ */
+
+#include "song_cache.h"
+#include "app_log.h"
+#include <esp_heap_caps.h>
+#include <string.h>
+
+#define CONTEXT_TYPE_LENGTH 16
+
+// Each song is packed as: duration (2 bytes), track (1 byte), then id, title, artist
+// and album as NUL-terminated strings
+typedef struct {
+    char context[CONTEXT_TYPE_LENGTH];
+    char context_id[MAX_ID_LENGTH];
+    uint8_t* data;              // nullptr when the slot is free
+    uint32_t size;
+    lib_index_t count;
+    uint32_t last_used;         // g_clock at the last store or restore
+} CacheEntry;
+
+static CacheEntry g_entries[SONG_CACHE_ENTRIES];
+static uint32_t g_clock = 0;
+static uint32_t g_bytes_used = 0;
+static SongCacheStats g_stats = {};
+
+// The list being built by song_cache_stage_*
+static uint8_t* g_stage = nullptr;
+static uint32_t g_stage_size = 0;
+static lib_index_t g_stage_count = 0;
+static bool g_stage_overflow = false;
+static char g_stage_context[CONTEXT_TYPE_LENGTH];
+static char g_stage_context_id[MAX_ID_LENGTH];
+
+static void copy_key(char* dest, const char* src, size_t size) {
+    size_t length = strnlen(src ? src : "", size - 1);
+    memcpy(dest, src ? src : "", length);
+    dest[length] = '\0';
+}
+
+static CacheEntry* find_entry(const char* context, const char* context_id) {
+    for (int i = 0; i < SONG_CACHE_ENTRIES; i++) {
+        CacheEntry* entry = &g_entries[i];
+        if (entry->data && strcmp(entry->context, context) == 0 && strcmp(entry->context_id, context_id) == 0) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+static void free_entry(CacheEntry* entry) {
+    heap_caps_free(entry->data);
+    g_bytes_used -= entry->size;
+    entry->data = nullptr;
+    entry->size = 0;
+}
+
+// Least recently used entry in use, or nullptr if the cache is empty
+static CacheEntry* oldest_entry(void) {
+    CacheEntry* oldest = nullptr;
+    for (int i = 0; i < SONG_CACHE_ENTRIES; i++) {
+        CacheEntry* entry = &g_entries[i];
+        if (entry->data && (!oldest || entry->last_used < oldest->last_used)) oldest = entry;
+    }
+    return oldest;
+}
+
+static CacheEntry* free_slot(void) {
+    for (int i = 0; i < SONG_CACHE_ENTRIES; i++) {
+        if (!g_entries[i].data) return &g_entries[i];
+    }
+    return nullptr;
+}
+
+static void append(const void* bytes, uint32_t length) {
+    if (g_stage_overflow || length > SONG_CACHE_MAX_LIST_BYTES - g_stage_size) {
+        g_stage_overflow = true;
+        return;
+    }
+    memcpy(g_stage + g_stage_size, bytes, length);
+    g_stage_size += length;
+}
+
+static void append_string(const char* s) {
+    if (!s) s = "";
+    append(s, (uint32_t)strnlen(s, MAX_NAME_LENGTH - 1));
+    append("", 1);
+}
+
+static const char* read_string(const uint8_t** p) {
+    const char* s = (const char*)*p;
+    *p += strlen(s) + 1;
+    return s;
+}
+
+// Rebuild the library's song list from an entry and make it live
+static void load_entry(const CacheEntry* entry) {
+    library_begin_update(LIBRARY_SONGS);
+    library_set_song_context(entry->context, entry->context_id);
+
+    const uint8_t* p = entry->data;
+    for (lib_index_t i = 0; i < entry->count; i++) {
+        uint16_t duration;
+        memcpy(&duration, p, sizeof(duration));
+        uint8_t track = p[2];
+        p += 3;
+        const char* id = read_string(&p);
+        const char* title = read_string(&p);
+        const char* artist = read_string(&p);
+        const char* album = read_string(&p);
+        library_add_song(id, title, artist, album, duration, track);
+    }
+    library_update_sort_indexes(LIBRARY_SONGS);
+    library_update_search_index(LIBRARY_SONGS);
+    library_publish(LIBRARY_SONGS);
+}
+
+bool song_cache_init(void) {
+    if (g_stage) return true;
+    g_stage = (uint8_t*)heap_caps_malloc(SONG_CACHE_MAX_LIST_BYTES, MALLOC_CAP_SPIRAM);
+    if (!g_stage) {
+        LOGW(LIBRARY, "No PSRAM for the song cache, song lists will not be cached");
+        return false;
+    }
+    return true;
+}
+
+bool song_cache_restore(const char* context, const char* context_id) {
+    CacheEntry* entry = g_stage ? find_entry(context, context_id) : nullptr;
+    if (!entry) {
+        g_stats.misses++;
+        return false;
+    }
+    g_stats.hits++;
+    entry->last_used = ++g_clock;
+    load_entry(entry);
+    return true;
+}
+
+void song_cache_store_current(void) {
+    // Only whole lists - a window of a long one would restore as if it were all of it
+    if (library_get_song_list_total() != library_get_song_count()) return;
+    if (!song_cache_stage_begin(library_get_song_context_type(), library_get_song_context_id())) return;
+    lib_index_t count = library_get_song_count();
+    for (lib_index_t i = 0; i < count; i++) {
+        const BLESong* song = library_get_song(i);
+        song_cache_stage_add(song->id, song->title, library_song_artist(song), library_song_album(song),
+                             song->duration_sec, song->track_number);
+    }
+    song_cache_stage_commit(false);
+}
+
+bool song_cache_stage_begin(const char* context, const char* context_id) {
+    if (!g_stage) return false;
+    copy_key(g_stage_context, context, sizeof(g_stage_context));
+    copy_key(g_stage_context_id, context_id, sizeof(g_stage_context_id));
+    g_stage_size = 0;
+    g_stage_count = 0;
+    g_stage_overflow = false;
+    return true;
+}
+
+void song_cache_stage_add(const char* id, const char* title, const char* artist, const char* album,
+                          uint16_t duration, uint8_t track) {
+    if (!g_stage || g_stage_count == LIBRARY_MAX_RECORDS) {
+        g_stage_overflow = true;
+        return;
+    }
+    append(&duration, sizeof(duration));
+    append(&track, 1);
+    append_string(id);
+    append_string(title);
+    append_string(artist);
+    append_string(album);
+    g_stage_count++;
+}
+
+bool song_cache_stage_commit(bool reload_library) {
+    if (!g_stage) return false;
+    if (g_stage_overflow) {
+        g_stats.too_large++;
+        return false;
+    }
+
+    CacheEntry* entry = find_entry(g_stage_context, g_stage_context_id);
+    if (entry && entry->count == g_stage_count && entry->size == g_stage_size &&
+        memcmp(entry->data, g_stage, g_stage_size) == 0) {
+        entry->last_used = ++g_clock;
+        g_stats.revalidated_same++;
+        return false;
+    }
+    if (entry) {
+        g_stats.revalidated_changed++;
+        free_entry(entry);
+    }
+
+    // Make room: least recently used lists go first
+    while (g_bytes_used + g_stage_size > SONG_CACHE_BYTES || !free_slot()) {
+        CacheEntry* oldest = oldest_entry();
+        if (!oldest) break;
+        free_entry(oldest);
+        g_stats.evictions++;
+    }
+
+    entry = free_slot();
+    uint8_t* data = (uint8_t*)heap_caps_malloc(g_stage_size ? g_stage_size : 1, MALLOC_CAP_SPIRAM);
+    if (!entry || !data) {
+        heap_caps_free(data);
+        LOGW(LIBRARY, "Song cache could not store %s %s", g_stage_context, g_stage_context_id);
+        return true;
+    }
+    memcpy(data, g_stage, g_stage_size);
+    memcpy(entry->context, g_stage_context, sizeof(entry->context));
+    memcpy(entry->context_id, g_stage_context_id, sizeof(entry->context_id));
+    entry->data = data;
+    entry->size = g_stage_size;
+    entry->count = g_stage_count;
+    entry->last_used = ++g_clock;
+    g_bytes_used += g_stage_size;
+    g_stats.stored++;
+
+    if (reload_library) load_entry(entry);
+    return true;
+}
+
+void song_cache_get_stats(SongCacheStats* stats) {
+    *stats = g_stats;
+    stats->entries = 0;
+    for (int i = 0; i < SONG_CACHE_ENTRIES; i++) {
+        if (g_entries[i].data) stats->entries++;
+    }
+    stats->bytes_used = g_bytes_used;
+}
+
+void song_cache_log_stats(void) {
+    SongCacheStats stats;
+    song_cache_get_stats(&stats);
+    LOGI(LIBRARY, "Song cache %u lists %u/%u bytes hits=%u misses=%u stored=%u evicted=%u "
+         "revalidated same=%u changed=%u too_large=%u",
+         (unsigned)stats.entries, (unsigned)stats.bytes_used, (unsigned)SONG_CACHE_BYTES, (unsigned)stats.hits,
+         (unsigned)stats.misses, (unsigned)stats.stored, (unsigned)stats.evictions, (unsigned)stats.revalidated_same,
+         (unsigned)stats.revalidated_changed, (unsigned)stats.too_large);
+}
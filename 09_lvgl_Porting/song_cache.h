@@ -0,0 +1,53 @@
+/*
+ * Song Cache - Recently opened song lists, so detail screens reopen without a BLE round trip
+ * LRU over (context type, context id) within a fixed PSRAM byte budget
+ *
+ * A list is cached as a compact copy (strings packed back to back), and restored into
+ * library_data when its playlist / album / artist is opened again. The app is still
+ * asked for the list; that response is staged here instead of replacing the list on
+ * screen, and only swapped in if it turned out different (revalidation).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "library_data.h"
+
+#define SONG_CACHE_BYTES            (256 * 1024)    // Budget for all cached lists
+#define SONG_CACHE_ENTRIES          16              // Lists kept at most
+#define SONG_CACHE_MAX_LIST_BYTES   (96 * 1024)     // Larger lists are not cached
+
+typedef struct {
+    uint32_t hits;                  // Opened from the cache
+    uint32_t misses;
+    uint32_t stored;
+    uint32_t evictions;
+    uint32_t revalidated_same;      // Background refresh matched the cached list
+    uint32_t revalidated_changed;   // ... and was swapped in
+    uint32_t too_large;             // Lists over SONG_CACHE_MAX_LIST_BYTES
+    uint32_t entries;
+    uint32_t bytes_used;
+} SongCacheStats;
+
+// Reserve the staging buffer (PSRAM only - without it the cache stays off)
+bool song_cache_init(void);
+
+// Replace the library's song list with the cached one for the context.
+// Counts a hit or a miss; returns false (library untouched) on a miss.
+bool song_cache_restore(const char* context, const char* context_id);
+
+// Cache the library's current song list under its context, if all of it is held
+void song_cache_store_current(void);
+
+// Build a list from a response without touching the library. Returns false when the
+// cache is off - the caller then loads the library directly.
+bool song_cache_stage_begin(const char* context, const char* context_id);
+void song_cache_stage_add(const char* id, const char* title, const char* artist, const char* album,
+                          uint16_t duration, uint8_t track);
+
+// Store the staged list. Returns whether it differs from the list cached before; if
+// so and reload_library is set, the library's song list is replaced with it.
+bool song_cache_stage_commit(bool reload_library);
+
+void song_cache_get_stats(SongCacheStats* stats);
+void song_cache_log_stats(void);
@@ -0,0 +1,67 @@
+/*
+ * Song Window - Which part of a long song list to keep on the device
+ */
+
+#include "song_window.h"
+
+static_assert(SONG_WINDOW_MAX % SONG_WINDOW_CHUNK == 0 && SONG_WINDOW_MAX >= 2 * SONG_WINDOW_CHUNK,
+              "the window holds whole chunks, at least two");
+
+static uint32_t chunk_floor(uint32_t index) {
+    return index / SONG_WINDOW_CHUNK * SONG_WINDOW_CHUNK;
+}
+
+static uint32_t chunk_ceil(uint32_t index) {
+    return chunk_floor(index + SONG_WINDOW_CHUNK - 1);
+}
+
+void song_window_first(SongWindowFetch* fetch) {
+    *fetch = {0, SONG_WINDOW_CHUNK, 0, 0};
+}
+
+bool song_window_plan(const SongWindow* window, uint32_t first, uint32_t visible, int direction,
+                      SongWindowFetch* fetch) {
+    uint32_t total = window->total;
+    if (total == 0 || first >= total) return false;
+
+    // Rows that should be resident: the screen, plus a margin ahead when paging
+    uint32_t need_lo = first;
+    uint32_t need_hi = first + visible;
+    if (direction < 0) need_lo = need_lo > SONG_WINDOW_MARGIN ? need_lo - SONG_WINDOW_MARGIN : 0;
+    if (direction > 0) need_hi += SONG_WINDOW_MARGIN;
+    if (need_hi > total) need_hi = total;
+
+    uint32_t start = window->start;
+    uint32_t end = window->start + window->count;
+    if (window->count > 0 && need_lo >= start && need_hi <= end) return false;
+
+    uint32_t lo = chunk_floor(need_lo);
+    uint32_t hi = chunk_ceil(need_hi);
+    if (hi > total) hi = total;
+    if (hi - lo > SONG_WINDOW_MAX) hi = lo + SONG_WINDOW_MAX;
+
+    if (window->count > 0 && lo >= start && lo <= end && hi > end) {
+        // Just past the end: extend it, dropping chunks off the front to stay within the maximum
+        uint32_t floor = hi > SONG_WINDOW_MAX ? chunk_ceil(hi - SONG_WINDOW_MAX) : 0;
+        uint32_t keep_start = start > floor ? start : floor;
+        *fetch = {end, hi - end, keep_start, keep_start < end ? end - keep_start : 0};
+    } else if (window->count > 0 && hi >= start && hi <= end && lo < start) {
+        // Just before the start: the same, backward
+        uint32_t keep_end = end < lo + SONG_WINDOW_MAX ? end : lo + SONG_WINDOW_MAX;
+        *fetch = {lo, start - lo, start, keep_end > start ? keep_end - start : 0};
+    } else {
+        // A jump (or wrap) away from the window: nothing resident is of use
+        *fetch = {lo, hi - lo, 0, 0};
+    }
+    if (fetch->keep_count == 0) fetch->keep_start = 0;
+    return true;
+}
+
+void song_window_apply(const SongWindowFetch* fetch, uint32_t total, SongWindow* window) {
+    uint32_t fetched = fetch->offset < total ? total - fetch->offset : 0;
+    if (fetched > fetch->limit) fetched = fetch->limit;
+    bool kept_before = fetch->keep_count > 0 && fetch->keep_start < fetch->offset;
+    window->start = kept_before ? fetch->keep_start : fetch->offset;
+    window->count = fetched + fetch->keep_count;
+    window->total = total;
+}
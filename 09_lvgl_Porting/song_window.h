@@ -0,0 +1,46 @@
+/*
+ * Song Window - Which part of a long song list to keep on the device
+ * Plans the offset / limit song queries (protocol v1.3) behind a paged list screen
+ *
+ * Only a window of the list is resident: SONG_WINDOW_CHUNK-aligned chunks around the
+ * rows on screen, at most SONG_WINDOW_MAX of them. Opening a list asks for its first
+ * chunk only, so the first screen costs the same for 20 songs or 20000. Paging toward
+ * an edge of the window fetches the next chunk in that direction before it is needed;
+ * records already resident on the side kept are not asked for again, and the far side
+ * is dropped so the window never grows past SONG_WINDOW_MAX.
+ *
+ * Pure planning - the sketch sends the queries and builds the library version.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define SONG_WINDOW_CHUNK       48      // Songs per window query (12 screens of 4)
+#define SONG_WINDOW_MAX         144     // Resident songs at most, a multiple of the chunk
+#define SONG_WINDOW_MARGIN      8       // Rows past the screen that should already be resident
+
+// Resident part of the list: records [start, start + count) of total
+typedef struct {
+    uint32_t start;
+    uint32_t count;
+    uint32_t total;             // 0: unknown (nothing resident yet)
+} SongWindow;
+
+// One window query and the resident records that survive it
+typedef struct {
+    uint32_t offset;            // Records to ask for
+    uint32_t limit;
+    uint32_t keep_start;        // Resident records kept beside them (keep_count 0: none)
+    uint32_t keep_count;
+} SongWindowFetch;
+
+// The first chunk of a list that is not resident at all
+void song_window_first(SongWindowFetch* fetch);
+
+// Rows [first, first + visible) are on screen after paging in direction (-1 back,
+// 1 forward, 0 a jump). Returns true with *fetch filled when a query should go out.
+bool song_window_plan(const SongWindow* window, uint32_t first, uint32_t visible, int direction,
+                      SongWindowFetch* fetch);
+
+// The window a fetch leaves resident once its records arrived
+void song_window_apply(const SongWindowFetch* fetch, uint32_t total, SongWindow* window);
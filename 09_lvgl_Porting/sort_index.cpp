@@ -0,0 +1,71 @@
+/*
+ * Sort Index - Record indices of one collection kept in a chosen order
+ */
+
+#include "sort_index.h"
+#include <string.h>
+
+bool sort_index_init(SortIndex* index, lib_index_t capacity) {
+    index->order = nullptr;
+    index->sorted = 0;
+    index->compares = 0;
+    if (!arena_init(&index->storage, (size_t)capacity * sizeof(lib_index_t))) return false;
+    index->order = (lib_index_t*)arena_alloc(&index->storage, (size_t)capacity * sizeof(lib_index_t),
+                                             alignof(lib_index_t));
+    return index->order != nullptr || capacity == 0;
+}
+
+void sort_index_reset(SortIndex* index) {
+    index->sorted = 0;
+}
+
+// First position in order[0..length) that sorts after record - equal records go after
+// the ones already there, which keeps the order stable
+static lib_index_t upper_bound(SortIndex* index, const lib_index_t* order, lib_index_t length, lib_index_t record,
+                               SortCompare compare, const void* context) {
+    lib_index_t low = 0;
+    lib_index_t high = length;
+    while (low < high) {
+        lib_index_t mid = low + (high - low) / 2;
+        index->compares++;
+        if (compare(context, record, order[mid]) < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+void sort_index_update(SortIndex* index, lib_index_t count, SortCompare compare, const void* context,
+                       lib_index_t* scratch) {
+    if (!index->order) return;
+    if (count < index->sorted) index->sorted = 0;   // Collection shrank without a reset
+    lib_index_t run = count - index->sorted;
+    if (run == 0) return;
+
+    // Sort the new records among themselves - a page is small, binary insertion is enough
+    for (lib_index_t i = 0; i < run; i++) {
+        lib_index_t record = index->sorted + i;
+        lib_index_t at = upper_bound(index, scratch, i, record, compare, context);
+        memmove(&scratch[at + 1], &scratch[at], (size_t)(i - at) * sizeof(lib_index_t));
+        scratch[at] = record;
+    }
+
+    // Merge from the back: each new record finds its place by binary search, and the
+    // block of older records after it moves up in one memmove
+    lib_index_t* order = index->order;
+    lib_index_t end = index->sorted;
+    for (lib_index_t j = run; j > 0; j--) {
+        lib_index_t record = scratch[j - 1];
+        lib_index_t at = upper_bound(index, order, end, record, compare, context);
+        memmove(&order[at + j], &order[at], (size_t)(end - at) * sizeof(lib_index_t));
+        order[at + j - 1] = record;
+        end = at;
+    }
+    index->sorted = count;
+}
+
+lib_index_t sort_index_get(const SortIndex* index, lib_index_t position) {
+    return position < index->sorted ? index->order[position] : position;
+}
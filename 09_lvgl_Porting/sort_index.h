@@ -0,0 +1,37 @@
+/*
+ * Sort Index - Record indices of one collection kept in a chosen order
+ * Maintained incrementally: records added since the last update are sorted among
+ * themselves and merged into the ordered prefix, never re-sorting what is already there
+ *
+ * The order is stable - records that compare equal stay in arrival order.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "arena.h"
+#include "library_data.h"
+
+// <0, 0 or >0 as record a sorts before, with or after record b; context is what
+// sort_index_update() was given (the records being ordered)
+typedef int (*SortCompare)(const void* context, lib_index_t a, lib_index_t b);
+
+typedef struct {
+    Arena storage;
+    lib_index_t* order;         // order[0..sorted) are record indices in sorted order
+    lib_index_t sorted;         // Records [0, sorted) are in order, later ones not yet
+    uint32_t compares;          // For the stats line
+} SortIndex;
+
+// Room for capacity records, PSRAM first
+bool sort_index_init(SortIndex* index, lib_index_t capacity);
+
+// Forget every record - O(1)
+void sort_index_reset(SortIndex* index);
+
+// Bring records [sorted, count) into the order. scratch must hold count - sorted entries.
+void sort_index_update(SortIndex* index, lib_index_t count, SortCompare compare, const void* context,
+                       lib_index_t* scratch);
+
+// Record index at position: positions past the sorted prefix read in arrival order,
+// so the index is always a complete permutation of [0, count)
+lib_index_t sort_index_get(const SortIndex* index, lib_index_t position);
@@ -0,0 +1,90 @@
+/*
+ * String Pool - Interned, deduplicated strings behind 16-bit handles
+ * Records store a handle instead of a fixed char array; equal strings share one copy
+ */
+
+#include "string_pool.h"
+#include <string.h>
+
+// FNV-1a over the kept bytes
+static uint32_t hash_bytes(const char* s, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool string_pool_init(StringPool* pool, uint16_t max_strings, size_t char_bytes) {
+    // Table at most half full keeps probe sequences short
+    uint32_t slot_count = 1;
+    while (slot_count < (uint32_t)max_strings * 2) slot_count <<= 1;
+
+    size_t index_bytes = (size_t)max_strings * (sizeof(uint32_t) * 2) + slot_count * sizeof(StrHandle);
+    pool->max_strings = 0;
+    pool->count = 0;
+    pool->stats = StringPoolStats{};
+    if (max_strings == 0 || !arena_init(&pool->chars, char_bytes + 1) || !arena_init(&pool->index, index_bytes)) {
+        return false;
+    }
+
+    pool->offsets = (uint32_t*)arena_alloc(&pool->index, max_strings * sizeof(uint32_t), alignof(uint32_t));
+    pool->hashes = (uint32_t*)arena_alloc(&pool->index, max_strings * sizeof(uint32_t), alignof(uint32_t));
+    pool->slots = (StrHandle*)arena_alloc(&pool->index, slot_count * sizeof(StrHandle), alignof(StrHandle));
+    pool->slot_mask = slot_count - 1;
+    pool->max_strings = max_strings;
+    string_pool_reset(pool);
+    return true;
+}
+
+void string_pool_reset(StringPool* pool) {
+    if (pool->max_strings == 0) return;
+
+    arena_reset(&pool->chars);
+    memset(pool->slots, 0, (pool->slot_mask + 1) * sizeof(StrHandle));
+
+    // Handle 0 is the empty string and never goes in the table
+    char* empty = (char*)arena_alloc(&pool->chars, 1, 1);
+    empty[0] = '\0';
+    pool->offsets[STR_HANDLE_EMPTY] = 0;
+    pool->hashes[STR_HANDLE_EMPTY] = 0;
+    pool->count = 1;
+}
+
+StrHandle string_pool_intern(StringPool* pool, const char* s, size_t max_length) {
+    pool->stats.interned++;
+    if (!s || !s[0] || pool->max_strings == 0) return STR_HANDLE_EMPTY;
+
+    size_t length = strnlen(s, max_length - 1);
+    uint32_t hash = hash_bytes(s, length);
+
+    uint32_t slot = hash & pool->slot_mask;
+    while (pool->slots[slot] != STR_HANDLE_EMPTY) {
+        StrHandle handle = pool->slots[slot];
+        const char* pooled = (const char*)pool->chars.base + pool->offsets[handle];
+        if (pool->hashes[handle] == hash && strncmp(pooled, s, length) == 0 && pooled[length] == '\0') {
+            pool->stats.hits++;
+            return handle;
+        }
+        slot = (slot + 1) & pool->slot_mask;
+    }
+
+    char* copy = pool->count < pool->max_strings ? (char*)arena_alloc(&pool->chars, length + 1, 1) : nullptr;
+    if (!copy) {
+        pool->stats.failed++;
+        return STR_HANDLE_EMPTY;
+    }
+    memcpy(copy, s, length);
+    copy[length] = '\0';
+
+    StrHandle handle = pool->count++;
+    pool->offsets[handle] = (uint32_t)(copy - (char*)pool->chars.base);
+    pool->hashes[handle] = hash;
+    pool->slots[slot] = handle;
+    return handle;
+}
+
+const char* string_pool_get(const StringPool* pool, StrHandle handle) {
+    if (handle >= pool->count) return "";
+    return (const char*)pool->chars.base + pool->offsets[handle];
+}
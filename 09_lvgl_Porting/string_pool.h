@@ -0,0 +1,47 @@
+/*
+ * String Pool - Interned, deduplicated strings behind 16-bit handles
+ * Records store a handle instead of a fixed char array; equal strings share one copy
+ *
+ * Strings live in an arena and are only freed together by string_pool_reset(), so a
+ * pool belongs to one collection and is reset when that collection is cleared.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+
+typedef uint16_t StrHandle;
+
+#define STR_HANDLE_EMPTY    0           // Always the empty string, also returned when the pool is full
+
+typedef struct {
+    uint32_t interned;          // string_pool_intern() calls
+    uint32_t hits;              // ... that found the string already pooled
+    uint32_t failed;            // ... that did not fit and got STR_HANDLE_EMPTY
+} StringPoolStats;
+
+typedef struct {
+    Arena chars;                // NUL-terminated strings back to back
+    Arena index;                // offsets, hashes and slots below
+    uint32_t* offsets;          // Handle -> offset in chars
+    uint32_t* hashes;           // Handle -> hash, so probes rarely need strcmp
+    StrHandle* slots;           // Open-addressing table of handles, STR_HANDLE_EMPTY = free
+    uint32_t slot_mask;
+    uint16_t max_strings;
+    uint16_t count;             // Handles in use, the empty string included
+    StringPoolStats stats;
+} StringPool;
+
+// Reserve room for max_strings distinct strings in char_bytes, terminators included (PSRAM first)
+bool string_pool_init(StringPool* pool, uint16_t max_strings, size_t char_bytes);
+
+// Handle for s (at most max_length - 1 bytes are kept, as with the old fixed fields).
+// nullptr and "" map to STR_HANDLE_EMPTY.
+StrHandle string_pool_intern(StringPool* pool, const char* s, size_t max_length);
+
+// String for a handle; never nullptr
+const char* string_pool_get(const StringPool* pool, StrHandle handle);
+
+// Drop every string - handles from before the reset must not be used again
+void string_pool_reset(StringPool* pool);
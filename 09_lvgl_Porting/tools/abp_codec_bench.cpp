@@ -0,0 +1,213 @@
+/*
+ * ABP Codec Benchmark - Bytes on air and decode time, JSON vs binary (TLV)
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. -I<ArduinoJson>/src tools/abp_codec_bench.cpp abp_codec.cpp abp_frame.cpp -o abp_codec_bench
+ *
+ * Messages are built the way the app sends them; the JSON path decodes with the same
+ * document size and field accesses as on_ble_data(), the binary path with abp_codec.
+ */
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "abp_codec.h"
+#include "abp_frame.h"
+
+static const size_t JSON_DOC_SIZE = 24 * 1024;     // Same as the sketch
+static const size_t BENCH_MTU = 185;               // Typical iOS ATT MTU
+static const int ITERATIONS = 20000;
+static const int SONGS_PER_PAGE = 25;
+
+// Keeps the optimizer from dropping decode results
+static volatile uint32_t g_sink = 0;
+
+// ============================================================================
+// Sample messages
+// ============================================================================
+
+static std::string json_playback_progress() {
+    return "{\"type\":\"PLAYBACK_PROGRESS\",\"timestamp\":1737302400.123456,\"payload\":"
+           "{\"songId\":\"3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a5f43\",\"elapsedTime\":61.25,"
+           "\"duration\":245.0,\"isPlaying\":true}}";
+}
+
+static std::string json_song_started() {
+    return "{\"type\":\"SONG_STARTED\",\"timestamp\":1737302400.123456,\"payload\":"
+           "{\"songId\":\"3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a5f43\",\"title\":\"Bohemian Rhapsody\","
+           "\"artist\":\"Queen\",\"album\":\"A Night at the Opera\",\"duration\":354.0,"
+           "\"playlistName\":\"Classic Rock\"}}";
+}
+
+static std::string json_songs_response() {
+    std::string json = "{\"type\":\"SONGS_RESPONSE\",\"timestamp\":1737302400.123456,\"payload\":{\"songs\":[";
+    for (int i = 0; i < SONGS_PER_PAGE; i++) {
+        char item[256];
+        snprintf(item, sizeof(item),
+                 "%s{\"id\":\"3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a%04d\",\"title\":\"Song Title Number %d\","
+                 "\"artist\":\"Some Artist\",\"album\":\"Some Album Name\",\"duration\":%d.0,\"trackNumber\":%d}",
+                 i ? "," : "", i, i, 180 + i, i + 1);
+        json += item;
+    }
+    json += "],\"context\":\"album\",\"contextId\":\"a1b2c3d4-e5f6-7890-abcd-ef1234567890\",\"page\":1,\"totalPages\":4}}";
+    return json;
+}
+
+static size_t tlv_playback_progress(uint8_t* out, size_t capacity) {
+    AbpTlvWriter w;
+    abp_binary_begin(&w, out, capacity, ABP_MSG_PLAYBACK_PROGRESS);
+    AbpPlaybackProgress msg = {"3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a5f43", 61250, 245000, true};
+    abp_encode_fields_playback_progress(&w, &msg);
+    return w.length;
+}
+
+static size_t tlv_song_started(uint8_t* out, size_t capacity) {
+    AbpTlvWriter w;
+    abp_binary_begin(&w, out, capacity, ABP_MSG_SONG_STARTED);
+    AbpSongStarted msg = {"3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a5f43", "Bohemian Rhapsody", "Queen",
+                          "A Night at the Opera", 354000, "Classic Rock", nullptr};
+    abp_encode_fields_song_started(&w, &msg);
+    return w.length;
+}
+
+static size_t tlv_songs_response(uint8_t* out, size_t capacity) {
+    static uint8_t items[8 * 1024];
+    AbpTlvWriter items_writer;
+    abp_tlv_writer_init(&items_writer, items, sizeof(items));
+    for (int i = 0; i < SONGS_PER_PAGE; i++) {
+        char id[64], title[64];
+        snprintf(id, sizeof(id), "3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a%04d", i);
+        snprintf(title, sizeof(title), "Song Title Number %d", i);
+        AbpSongInfo song = {id, title, "Some Artist", "Some Album Name", (uint32_t)(180 + i) * 1000, (uint32_t)i + 1};
+
+        uint8_t item[256];
+        AbpTlvWriter item_writer;
+        abp_tlv_writer_init(&item_writer, item, sizeof(item));
+        abp_encode_fields_song_info(&item_writer, &song);
+        abp_tlv_write_bytes(&items_writer, 3, item, item_writer.length);
+    }
+
+    AbpTlvWriter w;
+    abp_binary_begin(&w, out, capacity, ABP_MSG_SONGS_RESPONSE);
+    AbpSongsResponse msg = {1, 4, {items, items_writer.length, 3, SONGS_PER_PAGE},
+                            "album", "a1b2c3d4-e5f6-7890-abcd-ef1234567890"};
+    abp_encode_fields_songs_response(&w, &msg);
+    return w.length;
+}
+
+// ============================================================================
+// Decoders - touch the same fields the sketch's handlers use
+// ============================================================================
+
+static DynamicJsonDocument g_doc(JSON_DOC_SIZE);
+
+static void decode_json(const std::string& json) {
+    deserializeJson(g_doc, json.data(), json.size());
+    const char* type = g_doc["type"] | "";
+    JsonObject payload = g_doc["payload"];
+    uint32_t sum = (uint32_t)strlen(type);
+
+    if (strcmp(type, "PLAYBACK_PROGRESS") == 0) {
+        sum += (uint32_t)(payload["elapsedTime"] | 0.0f) + (payload["isPlaying"] | false);
+    } else if (strcmp(type, "SONG_STARTED") == 0) {
+        sum += strlen(payload["title"] | "") + strlen(payload["artist"] | "") + (uint32_t)(payload["duration"] | 0.0f);
+    } else if (strcmp(type, "SONGS_RESPONSE") == 0) {
+        for (JsonObject song : payload["songs"].as<JsonArray>()) {
+            sum += strlen(song["id"] | "") + strlen(song["title"] | "") + (uint32_t)(song["duration"] | 0.0f);
+        }
+    }
+    g_sink += sum;
+}
+
+static void decode_tlv(const uint8_t* data, size_t length) {
+    uint32_t sum = 0;
+    switch (abp_binary_type(data)) {
+        case ABP_MSG_PLAYBACK_PROGRESS: {
+            AbpPlaybackProgress msg;
+            if (abp_decode_message(playback_progress, data, length, &msg)) sum += msg.elapsed_ms + msg.is_playing;
+            break;
+        }
+        case ABP_MSG_SONG_STARTED: {
+            AbpSongStarted msg;
+            if (abp_decode_message(song_started, data, length, &msg)) {
+                sum += strlen(msg.title) + strlen(msg.artist) + msg.duration_ms;
+            }
+            break;
+        }
+        case ABP_MSG_SONGS_RESPONSE: {
+            AbpSongsResponse msg;
+            if (!abp_decode_message(songs_response, data, length, &msg)) break;
+            size_t pos = 0;
+            const uint8_t* item;
+            size_t item_length;
+            while (abp_list_next(&msg.songs, &pos, &item, &item_length)) {
+                AbpSongInfo song;
+                if (abp_decode_song_info(item, item_length, &song)) {
+                    sum += strlen(song.id) + strlen(song.title) + song.duration_ms;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    g_sink += sum;
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+// Notifications needed at BENCH_MTU, framed like bluetooth_send() does
+static size_t packets_on_air(size_t length) {
+    size_t max_notify = BENCH_MTU - 3;
+    if (length <= max_notify) return 1;
+    return abp_frame_count(length, max_notify - ABP_FRAME_HEADER_SIZE);
+}
+
+static size_t bytes_on_air(size_t length) {
+    size_t packets = packets_on_air(length);
+    return packets == 1 ? length : length + packets * ABP_FRAME_HEADER_SIZE;
+}
+
+template <typename F>
+static double time_ns(F fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+static void report(const char* name, const std::string& json, const uint8_t* tlv, size_t tlv_length) {
+    double json_ns = time_ns([&] { decode_json(json); });
+    double tlv_ns = time_ns([&] { decode_tlv(tlv, tlv_length); });
+
+    printf("%-18s %6zu B %3zu pkt %9.0f ns | %6zu B %3zu pkt %9.0f ns | %4.1fx smaller %5.1fx faster\n",
+           name, bytes_on_air(json.size()), packets_on_air(json.size()), json_ns,
+           bytes_on_air(tlv_length), packets_on_air(tlv_length), tlv_ns,
+           (double)json.size() / tlv_length, json_ns / tlv_ns);
+}
+
+int main() {
+    static uint8_t tlv[16 * 1024];
+
+    printf("MTU %zu, %d iterations per message\n\n", BENCH_MTU, ITERATIONS);
+    printf("%-18s %-28s | %-28s |\n", "message", "JSON (air / packets / decode)", "TLV (air / packets / decode)");
+
+    size_t length = tlv_playback_progress(tlv, sizeof(tlv));
+    report("PLAYBACK_PROGRESS", json_playback_progress(), tlv, length);
+
+    length = tlv_song_started(tlv, sizeof(tlv));
+    report("SONG_STARTED", json_song_started(), tlv, length);
+
+    length = tlv_songs_response(tlv, sizeof(tlv));
+    report("SONGS_RESPONSE x25", json_songs_response(), tlv, length);
+
+    printf("\n(checksum %u)\n", (unsigned)g_sink);
+    return 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * ABP Frame Test - Reassembly of fragments that arrive the way a real link delivers them
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -Wall -Wextra -I. tools/abp_frame_test.cpp abp_frame.cpp -o abp_frame_test
+ *
+ * Feeds abp_frame.cpp fragments built with abp_frame_build(): in order, shuffled,
+ * duplicated, truncated, with a corrupted byte, interleaved across messages, left to
+ * time out and pushed out by newer messages. Each case checks what comes out and the
+ * stats it counted; any mismatch fails the tool (exit status 1).
+ */
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "abp_frame.h"
+
+static const size_t FRAG_PAYLOAD = 180;             // A 200-byte write less the header
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAIL line %d: %s\n", __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+// ============================================================================
+// Fragments
+// ============================================================================
+
+// One BLE write; the byte past the end is room for the terminator the reassembler writes
+struct Write {
+    std::vector<uint8_t> data;
+    size_t length;
+};
+
+static std::string make_message(size_t length, uint32_t seed) {
+    std::string message(length, ' ');
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245 + 12345;
+        message[i] = (char)('a' + (seed >> 16) % 26);
+    }
+    return message;
+}
+
+static std::vector<Write> fragment(const std::string& message, uint16_t msg_id) {
+    const uint8_t* bytes = (const uint8_t*)message.data();
+    uint32_t crc = abp_crc32(bytes, message.size());
+    uint16_t count = abp_frame_count(message.size(), FRAG_PAYLOAD);
+
+    std::vector<Write> writes(count);
+    for (uint16_t i = 0; i < count; i++) {
+        writes[i].data.resize(ABP_FRAME_HEADER_SIZE + FRAG_PAYLOAD + 1);
+        writes[i].length = abp_frame_build(writes[i].data.data(), bytes, message.size(), msg_id, i, FRAG_PAYLOAD,
+                                           crc, 0);
+    }
+    return writes;
+}
+
+struct Feeder {
+    AbpReassembler r;
+    std::vector<uint8_t> pool;
+    std::vector<std::string> completed;
+    int errors = 0;
+
+    Feeder() : pool(ABP_REASSEMBLY_POOL_SIZE) {
+        abp_reassembler_init(&r, pool.data());
+    }
+
+    AbpFrameResult feed(Write write, uint32_t now_ms) {
+        uint8_t* message;
+        size_t length;
+        AbpFrameResult result = abp_reassembler_feed(&r, write.data.data(), write.length, now_ms, &message, &length);
+        if (result == ABP_FRAME_COMPLETE) {
+            completed.push_back(std::string((const char*)message, length));
+            // Handed out null-terminated
+            if (message[length] != '\0') errors++;
+        } else if (result == ABP_FRAME_ERROR) {
+            errors++;
+        }
+        return result;
+    }
+
+    void feed_all(const std::vector<Write>& writes, uint32_t now_ms) {
+        for (const Write& w : writes) feed(w, now_ms);
+    }
+};
+
+// ============================================================================
+// Cases
+// ============================================================================
+
+static void test_unframed() {
+    printf("unframed write\n");
+    Feeder f;
+    const char* json = "{\"type\":\"PLAY_PAUSE\"}";
+    Write w = {std::vector<uint8_t>(json, json + strlen(json) + 1), strlen(json)};
+    CHECK(f.feed(w, 0) == ABP_FRAME_COMPLETE);
+    CHECK(f.completed.size() == 1 && f.completed[0] == json);
+    CHECK(f.r.stats.unframed == 1);
+
+    Write empty = {std::vector<uint8_t>(1), 0};
+    CHECK(f.feed(empty, 0) == ABP_FRAME_ERROR);
+}
+
+static void test_single_fragment() {
+    printf("single fragment\n");
+    Feeder f;
+    std::string message = make_message(FRAG_PAYLOAD, 1);
+    f.feed_all(fragment(message, 1), 0);
+    CHECK(f.completed.size() == 1 && f.completed[0] == message);
+    CHECK(f.r.stats.completed == 1 && f.errors == 0);
+    CHECK(!abp_reassembler_pending(&f.r));
+}
+
+static void test_in_order() {
+    printf("in order, every length up to 4 fragments\n");
+    Feeder f;
+    for (size_t length = 1; length <= FRAG_PAYLOAD * 4; length++) {
+        std::string message = make_message(length, (uint32_t)length);
+        f.feed_all(fragment(message, (uint16_t)length), 0);
+        if (f.completed.empty() || f.completed.back() != message) {
+            CHECK(!"message at this length came out wrong");
+            printf("  length %zu\n", length);
+            return;
+        }
+    }
+    CHECK(f.r.stats.completed == FRAG_PAYLOAD * 4 && f.errors == 0);
+    CHECK(!abp_reassembler_pending(&f.r));
+}
+
+static void test_shuffled() {
+    printf("shuffled\n");
+    std::string message = make_message(ABP_MAX_MESSAGE_SIZE, 2);
+    std::vector<Write> writes = fragment(message, 7);
+    CHECK(writes.size() == abp_frame_count(ABP_MAX_MESSAGE_SIZE, FRAG_PAYLOAD));
+
+    uint32_t seed = 12345;
+    for (int run = 0; run < 50; run++) {
+        Feeder f;
+        for (size_t i = writes.size() - 1; i > 0; i--) {
+            seed = seed * 1103515245 + 12345;
+            std::swap(writes[i], writes[(seed >> 8) % (i + 1)]);
+        }
+        f.feed_all(writes, 0);
+        CHECK(f.completed.size() == 1 && f.completed[0] == message);
+        CHECK(f.errors == 0 && !abp_reassembler_pending(&f.r));
+    }
+}
+
+static void test_duplicated() {
+    printf("duplicated\n");
+    Feeder f;
+    std::string message = make_message(FRAG_PAYLOAD * 5 + 17, 3);
+    std::vector<Write> writes = fragment(message, 9);
+    // Every fragment but the last twice, then the last one
+    for (size_t i = 0; i + 1 < writes.size(); i++) {
+        CHECK(f.feed(writes[i], 0) == ABP_FRAME_INCOMPLETE);
+        CHECK(f.feed(writes[i], 0) == ABP_FRAME_INCOMPLETE);
+    }
+    CHECK(f.feed(writes.back(), 0) == ABP_FRAME_COMPLETE);
+    CHECK(f.completed.size() == 1 && f.completed[0] == message);
+    CHECK(f.r.stats.duplicates == writes.size() - 1);
+    CHECK(f.r.stats.fragments == writes.size());
+
+    // A repeat after completion starts over instead of completing twice
+    CHECK(f.feed(writes[0], 0) == ABP_FRAME_INCOMPLETE);
+    CHECK(f.completed.size() == 1);
+}
+
+static void test_truncated() {
+    printf("truncated\n");
+    Feeder f;
+    std::string message = make_message(FRAG_PAYLOAD * 3, 4);
+    std::vector<Write> writes = fragment(message, 11);
+
+    Write short_payload = writes[1];
+    short_payload.length -= 1;
+    CHECK(f.feed(short_payload, 0) == ABP_FRAME_ERROR);
+
+    Write short_last = writes[2];
+    short_last.length = ABP_FRAME_HEADER_SIZE;
+    CHECK(f.feed(short_last, 0) == ABP_FRAME_ERROR);
+
+    // Count that does not match length / size
+    Write bad_count = writes[0];
+    bad_count.data[6] = 9;
+    CHECK(f.feed(bad_count, 0) == ABP_FRAME_ERROR);
+
+    // Index past the count
+    Write bad_index = writes[0];
+    bad_index.data[4] = 3;
+    CHECK(f.feed(bad_index, 0) == ABP_FRAME_ERROR);
+
+    // Longer than the reassembly buffer
+    Write too_long = writes[0];
+    too_long.data[10] = (uint8_t)((ABP_MAX_MESSAGE_SIZE + 1) & 0xFF);
+    too_long.data[11] = (uint8_t)((ABP_MAX_MESSAGE_SIZE + 1) >> 8);
+    CHECK(f.feed(too_long, 0) == ABP_FRAME_ERROR);
+    CHECK(f.r.stats.malformed == 5);
+    CHECK(!abp_reassembler_pending(&f.r));
+
+    // The intact fragments still make the message
+    f.errors = 0;
+    f.feed_all(writes, 0);
+    CHECK(f.completed.size() == 1 && f.completed[0] == message && f.errors == 0);
+}
+
+static void test_crc_mismatch() {
+    printf("CRC mismatch\n");
+    Feeder f;
+    std::string message = make_message(FRAG_PAYLOAD * 4, 5);
+    std::vector<Write> writes = fragment(message, 13);
+    writes[2].data[ABP_FRAME_HEADER_SIZE + 40] ^= 0x01;
+    for (size_t i = 0; i + 1 < writes.size(); i++) CHECK(f.feed(writes[i], 0) == ABP_FRAME_INCOMPLETE);
+    CHECK(f.feed(writes.back(), 0) == ABP_FRAME_ERROR);
+    CHECK(f.completed.empty() && f.r.stats.crc_errors == 1);
+    CHECK(!abp_reassembler_pending(&f.r));
+
+    std::vector<Write> single = fragment(make_message(50, 6), 14);
+    single[0].data[ABP_FRAME_HEADER_SIZE] ^= 0x20;
+    CHECK(f.feed(single[0], 0) == ABP_FRAME_ERROR);
+    CHECK(f.r.stats.crc_errors == 2);
+}
+
+static void test_same_id_new_message() {
+    printf("same id, different message\n");
+    Feeder f;
+    std::vector<Write> old_writes = fragment(make_message(FRAG_PAYLOAD * 3, 7), 20);
+    std::string message = make_message(FRAG_PAYLOAD * 3, 8);
+    std::vector<Write> writes = fragment(message, 20);
+    f.feed(old_writes[0], 0);
+    f.feed(old_writes[1], 0);
+    f.feed_all(writes, 0);
+    CHECK(f.completed.size() == 1 && f.completed[0] == message);
+    CHECK(f.r.stats.malformed == 1 && f.r.stats.evicted == 0);
+}
+
+static void test_interleaved() {
+    printf("interleaved messages\n");
+    Feeder f;
+    std::string a = make_message(FRAG_PAYLOAD * 6 + 3, 9);
+    std::string b = make_message(FRAG_PAYLOAD * 4 + 90, 10);
+    std::vector<Write> wa = fragment(a, 30);
+    std::vector<Write> wb = fragment(b, 31);
+    for (size_t i = 0; i < std::max(wa.size(), wb.size()); i++) {
+        if (i < wb.size()) f.feed(wb[i], (uint32_t)i);
+        if (i < wa.size()) f.feed(wa[i], (uint32_t)i);
+    }
+    CHECK(f.completed.size() == 2 && f.completed[0] == b && f.completed[1] == a);
+    CHECK(f.r.stats.evicted == 0 && f.errors == 0);
+}
+
+static void test_timeout() {
+    printf("timeout\n");
+    Feeder f;
+    std::string message = make_message(FRAG_PAYLOAD * 3, 11);
+    std::vector<Write> writes = fragment(message, 40);
+    f.feed(writes[0], 1000);
+    f.feed(writes[1], 1500);
+
+    abp_reassembler_expire(&f.r, 1500 + ABP_REASSEMBLY_TIMEOUT_MS);
+    CHECK(abp_reassembler_pending(&f.r) && f.r.stats.timeouts == 0);
+    abp_reassembler_expire(&f.r, 1500 + ABP_REASSEMBLY_TIMEOUT_MS + 1);
+    CHECK(!abp_reassembler_pending(&f.r) && f.r.stats.timeouts == 1);
+
+    // The late last fragment starts a new message that never completes on its own
+    CHECK(f.feed(writes[2], 5000) == ABP_FRAME_INCOMPLETE);
+    CHECK(f.completed.empty());
+
+    // Resent in full, it goes through
+    f.feed_all(writes, 5100);
+    CHECK(f.completed.size() == 1 && f.completed[0] == message);
+}
+
+static void test_eviction() {
+    printf("slot eviction\n");
+    Feeder f;
+    std::vector<std::string> messages;
+    std::vector<std::vector<Write>> writes;
+    for (int i = 0; i <= ABP_REASSEMBLY_SLOTS; i++) {
+        messages.push_back(make_message(FRAG_PAYLOAD * 3, 20 + i));
+        writes.push_back(fragment(messages.back(), (uint16_t)(50 + i)));
+    }
+    // One more message in flight than there are slots; the first is idle the longest
+    for (int i = 0; i <= ABP_REASSEMBLY_SLOTS; i++) f.feed(writes[i][0], 100 + i);
+    CHECK(f.r.stats.evicted == 1);
+
+    for (int i = ABP_REASSEMBLY_SLOTS; i >= 1; i--) {
+        f.feed(writes[i][1], 200);
+        f.feed(writes[i][2], 200);
+    }
+    CHECK(f.completed.size() == ABP_REASSEMBLY_SLOTS);
+    for (int i = 1; i <= ABP_REASSEMBLY_SLOTS; i++) {
+        CHECK(std::find(f.completed.begin(), f.completed.end(), messages[i]) != f.completed.end());
+    }
+
+    // The evicted message lost its first fragment with the slot
+    f.feed(writes[0][1], 300);
+    f.feed(writes[0][2], 300);
+    CHECK(f.completed.size() == ABP_REASSEMBLY_SLOTS);
+    CHECK(abp_reassembler_pending(&f.r));
+    CHECK(f.errors == 0);
+}
+
+int main() {
+    test_unframed();
+    test_single_fragment();
+    test_in_order();
+    test_shuffled();
+    test_duplicated();
+    test_truncated();
+    test_crc_mismatch();
+    test_same_id_new_message();
+    test_interleaved();
+    test_timeout();
+    test_eviction();
+
+    printf("\n%s (%d failed)\n", g_failures == 0 ? "ok" : "FAIL", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+/*
+ * ID Lookup Benchmark - library_get_*_by_id() cost as the library grows
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/id_lookup_bench.cpp id_index.cpp arena.cpp -o id_lookup_bench
+ *
+ * scan:  the strcmp loop the lookups used before
+ * index: id_index_find() over the same records, as library_data.cpp does now
+ *
+ * Half the lookups hit (IDs spread over the whole collection), half miss, the way a
+ * SONG_STARTED for a song outside the current list does.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "id_index.h"
+#include "library_data.h"
+
+static const int LOOKUPS = 200000;
+static const lib_index_t SIZES[] = {100, 1000, 10000};
+
+static void make_id(char* out, uint32_t n) {
+    // Same shape as the app's UUIDs
+    snprintf(out, MAX_ID_LENGTH, "%08x-5b7d-4e8f-a1c2-%012x", n * 2654435761u, n);
+}
+
+static const BLEAlbum* find_scan(const std::vector<BLEAlbum>& albums, const char* id) {
+    for (const BLEAlbum& album : albums) {
+        if (strcmp(album.id, id) == 0) return &album;
+    }
+    return nullptr;
+}
+
+template <typename Find>
+static double time_lookups(const std::vector<std::vector<char>>& queries, Find find, size_t* hits) {
+    *hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOOKUPS; i++) {
+        if (find(queries[i % queries.size()].data())) (*hits)++;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / LOOKUPS;
+}
+
+int main() {
+    printf("%8s %12s %12s %8s %14s\n", "records", "scan ns", "index ns", "speedup", "probes/lookup");
+    for (lib_index_t size : SIZES) {
+        std::vector<BLEAlbum> albums(size);
+        IdIndex index;
+        id_index_init(&index, size);
+        for (lib_index_t i = 0; i < size; i++) {
+            make_id(albums[i].id, i);
+            id_index_insert(&index, albums[i].id, i, albums.data(), sizeof(BLEAlbum));
+        }
+
+        std::vector<std::vector<char>> queries;
+        for (int i = 0; i < 1024; i++) {
+            std::vector<char> id(MAX_ID_LENGTH);
+            make_id(id.data(), (i % 2) ? (uint32_t)(i * 7919u % size) : (uint32_t)(size + i));
+            queries.push_back(id);
+        }
+
+        size_t scan_hits, index_hits;
+        double scan_ns = time_lookups(queries, [&](const char* id) { return find_scan(albums, id) != nullptr; },
+                                      &scan_hits);
+        index.lookups = index.probes = 0;
+        double index_ns = time_lookups(queries, [&](const char* id) {
+            return id_index_find(&index, id, albums.data(), sizeof(BLEAlbum)) != ID_INDEX_NONE;
+        }, &index_hits);
+
+        if (scan_hits != index_hits) printf("hit count mismatch: %zu vs %zu\n", scan_hits, index_hits);
+        printf("%8u %12.1f %12.1f %7.0fx %14.2f\n", (unsigned)size, scan_ns, index_ns, scan_ns / index_ns,
+               (double)index.probes / index.lookups);
+    }
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * Ingest Copy Benchmark - Bytes copied per ingested song, before and after the single-copy path
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. -I<ArduinoJson>/src tools/ingest_copy_bench.cpp json_pull.cpp -o ingest_copy_bench
+ *
+ * before: deserializeJson() on a const buffer (every string duplicated into the
+ *         document, unused fields included), then strncpy-style copies that fill
+ *         the whole BLESong field
+ * after:  zero-copy parse of the mutable receive buffer through the SONGS_RESPONSE
+ *         filter, then one copy of each kept string into the record
+ * stream: what the sketch does now - json_pull walks the buffer, no document at all
+ *
+ * The transport copies (BLE stack -> RX ring -> reassembly buffer) are the same
+ * for all three and are not counted.
+ */
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "json_pull.h"
+#include "library_data.h"
+
+static const size_t JSON_DOC_SIZE = 24 * 1024;     // Whole page, as the sketch used before streaming
+static const int ITERATIONS = 2000;
+static const int SONGS_PER_PAGE = 25;
+
+// Field filter for SONGS_RESPONSE (the sketch streams this type now; kept for comparison)
+static const char* SONGS_FILTER =
+    R"({"payload":{"page":true,"totalPages":true,"context":true,"contextId":true,)"
+    R"("songs":[{"id":true,"title":true,"artist":true,"album":true,"duration":true,"trackNumber":true}]}})";
+
+// BLESong as it was before artist/album moved into the string pool - this bench is
+// about the copies the ingest path makes, so it keeps every field inline
+typedef struct {
+    char id[MAX_ID_LENGTH];
+    char title[MAX_NAME_LENGTH];
+    char artist[MAX_NAME_LENGTH];
+    char album[MAX_NAME_LENGTH];
+    uint16_t duration_sec;
+    uint8_t track_number;
+} InlineSong;
+
+static InlineSong g_songs[SONGS_PER_PAGE];
+
+// ============================================================================
+// Sample message - a songs page as the app sends it
+// ============================================================================
+
+static std::string json_songs_response() {
+    std::string json = "{\"type\":\"SONGS_RESPONSE\",\"timestamp\":1737302400.123456,\"payload\":{\"songs\":[";
+    for (int i = 0; i < SONGS_PER_PAGE; i++) {
+        char item[320];
+        snprintf(item, sizeof(item),
+                 "%s{\"id\":\"3f2a9c1e-5b7d-4e8f-a1c2-9d0e7b6a%04d\",\"title\":\"Song Title Number %d\","
+                 "\"artist\":\"Some Artist\",\"album\":\"Some Album Name\",\"duration\":%d.0,\"trackNumber\":%d,"
+                 "\"albumArtist\":\"Some Artist\",\"genre\":\"Rock\",\"year\":1975}",
+                 i ? "," : "", i, i, 180 + i, i + 1);
+        json += item;
+    }
+    json += "],\"context\":\"album\",\"contextId\":\"a1b2c3d4-e5f6-7890-abcd-ef1234567890\",\"page\":1,\"totalPages\":4}}";
+    return json;
+}
+
+// ============================================================================
+// Store copies - library_data.cpp's safe_strcpy before and after
+// ============================================================================
+
+static size_t copy_padded(char* dest, const char* src, size_t dest_size) {
+    strncpy(dest, src, dest_size - 1);
+    dest[dest_size - 1] = '\0';
+    return dest_size;
+}
+
+static size_t copy_once(char* dest, const char* src, size_t dest_size) {
+    size_t length = strnlen(src, dest_size - 1);
+    memcpy(dest, src, length);
+    dest[length] = '\0';
+    return length + 1;
+}
+
+typedef size_t (*CopyFn)(char* dest, const char* src, size_t dest_size);
+
+// Same field accesses the DOM-based songs handler made; returns bytes written to the records
+static size_t store_songs(JsonDocument& doc, CopyFn copy) {
+    size_t written = 0;
+    int index = 0;
+    for (JsonObject song : doc["payload"]["songs"].as<JsonArray>()) {
+        InlineSong* s = &g_songs[index++ % SONGS_PER_PAGE];
+        written += copy(s->id, song["id"] | "", MAX_ID_LENGTH);
+        written += copy(s->title, song["title"] | "Unknown", MAX_NAME_LENGTH);
+        written += copy(s->artist, song["artist"] | "Unknown", MAX_NAME_LENGTH);
+        written += copy(s->album, song["album"] | "Unknown", MAX_NAME_LENGTH);
+        s->duration_sec = (uint16_t)(song["duration"] | 0.0f);
+        s->track_number = song["trackNumber"] | 0;
+    }
+    return written;
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+typedef struct {
+    size_t document_bytes;      // Written into the JsonDocument pool
+    size_t store_bytes;         // Written into song records
+    double ns;                  // Parse + store for one page
+} IngestResult;
+
+static DynamicJsonDocument g_doc(JSON_DOC_SIZE);
+static DynamicJsonDocument g_filter(1024);
+
+static IngestResult ingest_before(const std::string& json) {
+    IngestResult result = {};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        deserializeJson(g_doc, (const char*)json.data(), json.size());
+        result.document_bytes = g_doc.memoryUsage();
+        result.store_bytes = store_songs(g_doc, copy_padded);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    result.ns = std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+    return result;
+}
+
+static IngestResult ingest_after(const std::string& json) {
+    IngestResult result = {};
+    std::vector<char> buffer(json.size() + 1);
+    double total_ns = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        // Zero-copy parsing rewrites the buffer, so every round gets a fresh one (not timed,
+        // on the device it is the reassembly buffer the message already sits in)
+        memcpy(buffer.data(), json.c_str(), json.size() + 1);
+
+        auto start = std::chrono::steady_clock::now();
+        deserializeJson(g_doc, buffer.data(), json.size(), DeserializationOption::Filter(g_filter));
+        result.document_bytes = g_doc.memoryUsage();
+        result.store_bytes = store_songs(g_doc, copy_once);
+        total_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    result.ns = total_ns / ITERATIONS;
+    return result;
+}
+
+// Same walk as stream_songs_response() in the sketch, minus the page header pass
+static size_t stream_songs(char* data, size_t length) {
+    JsonPull p;
+    json_pull_init(&p, data, length);
+    if (!json_pull_find(&p, "payload") || !json_pull_find(&p, "songs") || !json_pull_array_begin(&p)) return 0;
+
+    size_t written = 0;
+    int index = 0;
+    while (json_pull_array_next(&p) && json_pull_object_begin(&p)) {
+        InlineSong* s = &g_songs[index++ % SONGS_PER_PAGE];
+        const char* key;
+        while (json_pull_object_next(&p, &key)) {
+            if (strcmp(key, "id") == 0) written += copy_once(s->id, json_pull_string_or(&p, ""), MAX_ID_LENGTH);
+            else if (strcmp(key, "title") == 0) written += copy_once(s->title, json_pull_string_or(&p, "Unknown"), MAX_NAME_LENGTH);
+            else if (strcmp(key, "artist") == 0) written += copy_once(s->artist, json_pull_string_or(&p, "Unknown"), MAX_NAME_LENGTH);
+            else if (strcmp(key, "album") == 0) written += copy_once(s->album, json_pull_string_or(&p, "Unknown"), MAX_NAME_LENGTH);
+            else if (strcmp(key, "duration") == 0) s->duration_sec = (uint16_t)json_pull_number_or(&p, 0);
+            else if (strcmp(key, "trackNumber") == 0) s->track_number = (uint8_t)json_pull_number_or(&p, 0);
+            else json_pull_skip(&p);
+        }
+    }
+    return written;
+}
+
+static IngestResult ingest_stream(const std::string& json) {
+    IngestResult result = {};
+    std::vector<char> buffer(json.size() + 1);
+    double total_ns = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        memcpy(buffer.data(), json.c_str(), json.size() + 1);
+
+        auto start = std::chrono::steady_clock::now();
+        result.store_bytes = stream_songs(buffer.data(), json.size());
+        total_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    result.ns = total_ns / ITERATIONS;
+    return result;
+}
+
+static void report(const char* name, const IngestResult& r) {
+    printf("%-7s %7zu B doc %7zu B store | %6.1f B/song doc %6.1f B/song store %6.1f B/song total | %8.0f ns/page\n",
+           name, r.document_bytes, r.store_bytes, (double)r.document_bytes / SONGS_PER_PAGE,
+           (double)r.store_bytes / SONGS_PER_PAGE, (double)(r.document_bytes + r.store_bytes) / SONGS_PER_PAGE, r.ns);
+}
+
+int main() {
+    deserializeJson(g_filter, SONGS_FILTER);
+    std::string json = json_songs_response();
+
+    printf("SONGS_RESPONSE, %d songs, %zu bytes of JSON, %d iterations\n\n", SONGS_PER_PAGE, json.size(), ITERATIONS);
+
+    IngestResult before = ingest_before(json);
+    IngestResult after = ingest_after(json);
+    IngestResult stream = ingest_stream(json);
+    report("before", before);
+    report("after", after);
+    report("stream", stream);
+
+    printf("\n%.1fx fewer bytes copied per song\n",
+           (double)(before.document_bytes + before.store_bytes) / (after.document_bytes + after.store_bytes));
+    return 0;
+}
@@ -0,0 +1,363 @@
+/*
+ * Library Data Test - The library store at 10,000 records per collection
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -Wall -Wextra -I. tools/library_data_test.cpp library_data.cpp library_image.cpp \
+ *       id_index.cpp sort_index.cpp search_index.cpp collate.cpp string_pool.cpp arena.cpp abp_frame.cpp \
+ *       -o library_data_test
+ *
+ * Fills every collection of the real library_data.cpp the way a sync does - page by
+ * page, indexes updated after each page, published on the last - and checks:
+ *   add / publish   readers see the old version until the publish, then all records
+ *   id lookup       every ID finds its record, absent IDs find nothing
+ *   sort            every order is a permutation in the order its comparison defines
+ *   search          unique words find their record, prefixes find every match
+ *   capacity        adds past capacity fail and leave the version intact
+ * Any mismatch fails the tool (exit status 1).
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "collate.h"
+#include "library_data.h"
+
+static const lib_index_t RECORDS = 10000;
+static const lib_index_t PAGE_ITEMS = 120;              // Records per ingested page
+
+static int g_failures = 0;
+static int g_capacity_warnings = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("  FAIL line %d: %s\n", __LINE__, #cond); \
+            g_failures++; \
+        } \
+    } while (0)
+
+// library_data logs through app_log; only "Max ... reached" is expected here
+void app_log_write(const char* tag, const char* format, ...) {
+    if (strstr(format, "Max") != nullptr) {
+        g_capacity_warnings++;
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%s] ", tag);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+// ============================================================================
+// Records
+// ============================================================================
+
+static const char* WORDS[] = {"Blue", "the", "Émilie", "NIGHT", "river", "Ångström", "echo", "Zoë", "after", "Light"};
+static const size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+static std::string record_id(const char* prefix, uint32_t i) {
+    char id[MAX_ID_LENGTH];
+    snprintf(id, sizeof(id), "%s-%05u-7b3d4e8a", prefix, (unsigned)i);
+    return id;
+}
+
+// Two shared words, so orders have ties and prefixes many matches, and one word unique
+// to the record ("k" + collection letter + index) for exact search hits
+static std::string record_name(char collection, uint32_t i, bool article) {
+    char name[MAX_NAME_LENGTH];
+    snprintf(name, sizeof(name), "%s%s %s k%c%05u", article ? "The " : "", WORDS[(i * 7) % WORD_COUNT],
+             WORDS[(i / 3) % WORD_COUNT], collection, (unsigned)i);
+    return name;
+}
+
+static std::string artist_name(uint32_t i) {
+    return record_name('r', i % 700, i % 5 == 0);
+}
+
+static std::string album_name(uint32_t i) {
+    return record_name('l', i % 1500, false);
+}
+
+// Collection being filled the way a sync fills it
+static bool add_record(LibraryCollection collection, uint32_t i) {
+    switch (collection) {
+        case LIBRARY_PLAYLISTS:
+            return library_add_playlist(record_id("pl", i).c_str(), record_name('p', i, false).c_str(),
+                                        (uint16_t)(i % 300));
+        case LIBRARY_ARTISTS:
+            return library_add_artist(record_id("ar", i).c_str(), record_name('a', i, i % 4 == 0).c_str(),
+                                      (uint16_t)(i % 20), (uint16_t)(i % 250));
+        case LIBRARY_ALBUMS:
+            return library_add_album(record_id("al", i).c_str(), record_name('b', i, false).c_str(),
+                                     artist_name(i).c_str(), (uint16_t)(i % 18), (uint16_t)(i % 11 == 0 ? 0 : 1960 + i % 60));
+        case LIBRARY_SONGS:
+            return library_add_song(record_id("so", i).c_str(), record_name('s', i, false).c_str(),
+                                    artist_name(i).c_str(), album_name(i).c_str(), (uint16_t)(120 + i % 300),
+                                    (uint8_t)(i % 23));
+        default:
+            return false;
+    }
+}
+
+static lib_index_t count_of(LibraryCollection collection) {
+    switch (collection) {
+        case LIBRARY_PLAYLISTS: return library_get_playlist_count();
+        case LIBRARY_ARTISTS:   return library_get_artist_count();
+        case LIBRARY_ALBUMS:    return library_get_album_count();
+        default:                return library_get_song_count();
+    }
+}
+
+static const char* id_at(LibraryCollection collection, lib_index_t index) {
+    switch (collection) {
+        case LIBRARY_PLAYLISTS: return library_get_playlist(index)->id;
+        case LIBRARY_ARTISTS:   return library_get_artist(index)->id;
+        case LIBRARY_ALBUMS:    return library_get_album(index)->id;
+        default:                return library_get_song(index)->id;
+    }
+}
+
+static const char* name_at(LibraryCollection collection, lib_index_t index) {
+    switch (collection) {
+        case LIBRARY_PLAYLISTS: return library_get_playlist(index)->name;
+        case LIBRARY_ARTISTS:   return library_get_artist(index)->name;
+        case LIBRARY_ALBUMS:    return library_get_album(index)->name;
+        default:                return library_get_song(index)->title;
+    }
+}
+
+static const void* find_id(LibraryCollection collection, const char* id) {
+    switch (collection) {
+        case LIBRARY_PLAYLISTS: return library_get_playlist_by_id(id);
+        case LIBRARY_ARTISTS:   return library_get_artist_by_id(id);
+        case LIBRARY_ALBUMS:    return library_get_album_by_id(id);
+        default:                return library_get_song_by_id(id);
+    }
+}
+
+static const void* record_at(LibraryCollection collection, lib_index_t index) {
+    switch (collection) {
+        case LIBRARY_PLAYLISTS: return library_get_playlist(index);
+        case LIBRARY_ARTISTS:   return library_get_artist(index);
+        case LIBRARY_ALBUMS:    return library_get_album(index);
+        default:                return library_get_song(index);
+    }
+}
+
+// A sync of count records starting at first: page by page, published on the last
+static void sync(LibraryCollection collection, uint32_t first, uint32_t count) {
+    library_begin_update(collection);
+    for (uint32_t i = 0; i < count; i++) {
+        add_record(collection, first + i);
+        if ((i + 1) % PAGE_ITEMS == 0 || i + 1 == count) {
+            library_update_sort_indexes(collection);
+            library_update_search_index(collection);
+        }
+    }
+    library_publish(collection);
+}
+
+// ============================================================================
+// Cases
+// ============================================================================
+
+static const char* COLLECTION_NAMES[] = {"playlists", "artists", "albums", "songs"};
+
+static void test_add_publish(LibraryCollection collection, const char* prefix) {
+    CHECK(library_get_capacity(collection) == RECORDS);
+    sync(collection, 0, RECORDS);
+    CHECK(count_of(collection) == RECORDS);
+    CHECK(record_at(collection, RECORDS) == nullptr);
+
+    // A second sync builds beside the live version: readers see all of the old records
+    // until it is published, and only the new ones after
+    library_begin_update(collection);
+    for (uint32_t i = 0; i < RECORDS / 2; i++) add_record(collection, RECORDS + i);
+    library_update_sort_indexes(collection);
+    library_update_search_index(collection);
+    CHECK(count_of(collection) == RECORDS);
+    const char* first = id_at(collection, 0);
+    CHECK(find_id(collection, first) == record_at(collection, 0));
+    library_publish(collection);
+    CHECK(count_of(collection) == RECORDS / 2);
+    CHECK(strcmp(id_at(collection, 0), record_id(prefix, RECORDS).c_str()) == 0);
+    CHECK(find_id(collection, record_id(prefix, 0).c_str()) == nullptr);
+
+    LibraryStoreStats stats;
+    library_get_store_stats(collection, &stats);
+    CHECK(stats.count == RECORDS / 2 && stats.capacity == RECORDS && stats.high_water == RECORDS);
+
+    // Back to the full set for the other cases
+    sync(collection, 0, RECORDS);
+    CHECK(count_of(collection) == RECORDS);
+}
+
+static void test_id_lookup(LibraryCollection collection, const char* prefix) {
+    int wrong = 0;
+    for (lib_index_t i = 0; i < RECORDS; i++) {
+        std::string id = record_id(prefix, i);
+        const void* found = find_id(collection, id.c_str());
+        if (found != record_at(collection, i)) wrong++;
+    }
+    CHECK(wrong == 0);
+
+    // Misses: past the end, replaced records, near misses
+    CHECK(find_id(collection, record_id(prefix, RECORDS).c_str()) == nullptr);
+    CHECK(find_id(collection, record_id(prefix, RECORDS + RECORDS / 4).c_str()) == nullptr);
+    CHECK(find_id(collection, (record_id(prefix, 42) + "x").c_str()) == nullptr);
+    CHECK(find_id(collection, "") == nullptr);
+}
+
+static bool in_order(LibraryCollection collection, LibraryOrder order, lib_index_t a, lib_index_t b) {
+    switch (collection) {
+        case LIBRARY_ARTISTS:
+            return collate_compare(collate_skip_article(library_get_artist(a)->name),
+                                   collate_skip_article(library_get_artist(b)->name)) <= 0;
+        case LIBRARY_ALBUMS: {
+            const BLEAlbum* x = library_get_album(a);
+            const BLEAlbum* y = library_get_album(b);
+            if (order == LIBRARY_ORDER_YEAR) {
+                // Unknown years (0) go last
+                if (x->year != y->year) return y->year == 0 || (x->year != 0 && x->year < y->year);
+                return collate_compare(x->name, y->name) <= 0;
+            }
+            if (order == LIBRARY_ORDER_ARTIST) {
+                return collate_compare(collate_skip_article(library_album_artist(x)),
+                                       collate_skip_article(library_album_artist(y))) <= 0;
+            }
+            return collate_compare(x->name, y->name) <= 0;
+        }
+        case LIBRARY_SONGS: {
+            const BLESong* x = library_get_song(a);
+            const BLESong* y = library_get_song(b);
+            if (order == LIBRARY_ORDER_TRACK) {
+                int album = collate_compare(library_song_album(x), library_song_album(y));
+                if (album != 0) return album < 0;
+                if (x->track_number != y->track_number) {
+                    return y->track_number == 0 || (x->track_number != 0 && x->track_number < y->track_number);
+                }
+                return true;
+            }
+            if (order == LIBRARY_ORDER_ARTIST) {
+                return collate_compare(collate_skip_article(library_song_artist(x)),
+                                       collate_skip_article(library_song_artist(y))) <= 0;
+            }
+            return collate_compare(x->title, y->title) <= 0;
+        }
+        default:
+            return collate_compare(name_at(collection, a), name_at(collection, b)) <= 0;
+    }
+}
+
+static void test_sort(LibraryCollection collection) {
+    for (int o = LIBRARY_ORDER_NAME; o < LIBRARY_ORDER_COUNT; o++) {
+        LibraryOrder order = (LibraryOrder)o;
+        if (!library_supports_order(collection, order)) continue;
+
+        std::vector<bool> seen(RECORDS, false);
+        int duplicates = 0;
+        int misordered = 0;
+        lib_index_t previous = 0;
+        for (lib_index_t position = 0; position < RECORDS; position++) {
+            lib_index_t record = library_get_sorted_index(collection, order, position);
+            if (record >= RECORDS || seen[record]) {
+                duplicates++;
+                continue;
+            }
+            seen[record] = true;
+            if (position > 0 && !in_order(collection, order, previous, record)) misordered++;
+            previous = record;
+        }
+        if (duplicates || misordered) printf("  order %d: %d repeated, %d out of order\n", o, duplicates, misordered);
+        CHECK(duplicates == 0 && misordered == 0);
+    }
+    CHECK(library_supports_order(collection, LIBRARY_ORDER_ARRIVAL));
+    CHECK(library_get_sorted_index(collection, LIBRARY_ORDER_ARRIVAL, 1234) == 1234);
+}
+
+static void test_search(void) {
+    static LibrarySearchHit hits[256];
+
+    // A word unique to one record finds that record, in whichever collection holds it
+    const struct { char letter; LibraryCollection collection; } UNIQUE[] = {
+        {'p', LIBRARY_PLAYLISTS}, {'a', LIBRARY_ARTISTS}, {'b', LIBRARY_ALBUMS}, {'s', LIBRARY_SONGS}};
+    int missed = 0;
+    for (const auto& u : UNIQUE) {
+        for (uint32_t i = 0; i < RECORDS; i += 97) {
+            char query[16];
+            snprintf(query, sizeof(query), "K%c%05u", u.letter, (unsigned)i);
+            uint16_t found = library_search(query, hits, 256);
+            if (found != 1 || hits[0].collection != u.collection || hits[0].record != i) missed++;
+        }
+    }
+    CHECK(missed == 0);
+
+    // Two words, folded: every hit holds both, and the share per collection is respected
+    uint16_t found = library_search("emil ANGS", hits, 64);
+    CHECK(found == 64);
+    for (uint16_t h = 0; h < found; h++) {
+        std::string name = name_at(hits[h].collection, hits[h].record);
+        if (name.find("Émilie") == std::string::npos || name.find("Ångström") == std::string::npos) {
+            CHECK(!"hit without both words");
+            break;
+        }
+    }
+    CHECK(library_search("qqqq", hits, 256) == 0);
+
+    // A unique word with a word its record lacks finds nothing
+    CHECK(strstr(name_at(LIBRARY_PLAYLISTS, 9999), "echo") == nullptr);
+    CHECK(library_search("kp09999 echo", hits, 256) == 0);
+}
+
+static void test_capacity(LibraryCollection collection, const char* prefix) {
+    g_capacity_warnings = 0;
+    library_begin_update(collection);
+    for (uint32_t i = 0; i < RECORDS; i++) add_record(collection, i);
+    CHECK(!add_record(collection, RECORDS));
+    CHECK(!add_record(collection, RECORDS + 1));
+    CHECK(g_capacity_warnings == 2);
+    library_update_sort_indexes(collection);
+    library_update_search_index(collection);
+    library_publish(collection);
+
+    // The full version is intact: every record, none of the refused
+    CHECK(count_of(collection) == RECORDS);
+    CHECK(find_id(collection, record_id(prefix, RECORDS).c_str()) == nullptr);
+    LibraryStoreStats stats;
+    library_get_store_stats(collection, &stats);
+    CHECK(stats.count == RECORDS && stats.bytes_used <= stats.bytes_capacity);
+}
+
+int main() {
+    LibraryCapacity capacity = {RECORDS, RECORDS, RECORDS, RECORDS};
+    if (!library_data_init(&capacity)) {
+        fprintf(stderr, "store allocation failed\n");
+        return 1;
+    }
+    static const char* PREFIXES[] = {"pl", "ar", "al", "so"};
+
+    for (int i = 0; i < LIBRARY_COLLECTION_COUNT; i++) {
+        LibraryCollection collection = (LibraryCollection)i;
+        printf("%s: add / publish\n", COLLECTION_NAMES[i]);
+        test_add_publish(collection, PREFIXES[i]);
+        printf("%s: id lookup\n", COLLECTION_NAMES[i]);
+        test_id_lookup(collection, PREFIXES[i]);
+        printf("%s: sort\n", COLLECTION_NAMES[i]);
+        test_sort(collection);
+    }
+    printf("search\n");
+    test_search();
+    for (int i = 0; i < LIBRARY_COLLECTION_COUNT; i++) {
+        printf("%s: capacity\n", COLLECTION_NAMES[i]);
+        test_capacity((LibraryCollection)i, PREFIXES[i]);
+        test_id_lookup((LibraryCollection)i, PREFIXES[i]);
+    }
+
+    printf("\n%s (%d failed)\n", g_failures == 0 ? "ok" : "FAIL", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
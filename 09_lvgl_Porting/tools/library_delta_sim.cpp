@@ -0,0 +1,492 @@
+/*
+ * Library Delta Simulator - Reconnects that sync only what changed (protocol v1.4)
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/library_delta_sim.cpp library_delta.cpp library_data.cpp library_image.cpp \
+ *       id_index.cpp sort_index.cpp search_index.cpp collate.cpp string_pool.cpp arena.cpp abp_frame.cpp \
+ *       abp_codec.cpp -o library_delta_sim
+ *
+ * A fake app holds a synthetic catalog of playlists, artists and albums and answers
+ * the device's queries the way BluetoothCommunicationService does: the same revision
+ * gets one empty delta page, a revision it still remembers gets the removed IDs and
+ * the added or changed records, anything else the whole list. Between sessions a share
+ * of the catalog changes (renamed, removed, added).
+ *
+ * The device side runs the real store: binary pages are decoded and applied through
+ * library_delta and library_data as the sketch does, and each session ends with a
+ * reboot - the library image is built and attached in place of the store, like the
+ * flash snapshot, so the next query sends the revision from the image.
+ *
+ * Per mutation rate it prints the TLV bytes a session sends with deltas beside what a
+ * full resync sends, and how many collections fell back to a full list. After every
+ * session the device must hold exactly the app's records at the app's revision; a
+ * difference fails the tool (exit status 1).
+ *
+ *   library_delta_sim            Mutation rates 0 - 10%, 12 sessions each
+ *   library_delta_sim <sessions> ... with that many sessions per rate
+ */
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "abp_codec.h"
+#include "library_data.h"
+#include "library_delta.h"
+#include "library_image.h"
+
+static const uint32_t CATALOG_SIZES[LIBRARY_DELTA_COLLECTIONS] = {150, 800, 1600};
+static const double MUTATION_RATES[] = {0.0, 0.001, 0.01, 0.05, 0.10};
+static const size_t PAGE_BUDGET = 2048;             // Item bytes per page, as the app sizes them for the link
+static const size_t HISTORY = 4;                    // Revisions the app remembers per collection
+static const char* NAMES[LIBRARY_DELTA_COLLECTIONS] = {"playlists", "artists", "albums"};
+
+// library_data logs through app_log; on the host only failures are worth showing
+void app_log_write(const char* tag, const char* format, ...) {
+    if (strstr(format, "Failed") == nullptr && strstr(format, "Max") == nullptr) return;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%s] ", tag);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+// ============================================================================
+// Random numbers (xorshift, so runs repeat exactly)
+// ============================================================================
+
+static uint32_t g_rng = 1;
+
+static uint32_t rng_next(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+// ============================================================================
+// Fake app
+// ============================================================================
+
+typedef struct {
+    std::string id;
+    std::string name;
+    std::string artist;         // Albums
+    uint32_t song_count;
+    uint32_t album_count;       // Artists
+    uint32_t year;              // Albums
+    bool removed;               // Delta entries only
+} Record;
+
+static bool same_record(const Record& a, const Record& b) {
+    return a.name == b.name && a.artist == b.artist && a.song_count == b.song_count &&
+           a.album_count == b.album_count && a.year == b.year;
+}
+
+typedef struct {
+    std::vector<Record> records;
+    uint32_t next_id;
+    uint32_t edits;             // Renames so far, to keep names distinct
+    std::deque<std::pair<uint32_t, std::vector<Record>>> history;    // Revisions sent, newest last
+} AppCollection;
+
+static AppCollection g_app[LIBRARY_DELTA_COLLECTIONS];
+
+static Record make_record(int collection, uint32_t n) {
+    static const char* WORDS[] = {"Velvet", "Harbor", "Neon", "River", "Echo", "Amber", "Static", "Lumen"};
+    Record r;
+    char id[MAX_ID_LENGTH];
+    snprintf(id, sizeof(id), "%c-7e3f9a2c-41d8-4b6e-%08u", "pra"[collection], (unsigned)n);
+    r.id = id;
+    r.name = std::string(WORDS[n % 8]) + " " + WORDS[(n / 8) % 8] + " " + std::to_string(n);
+    r.artist = collection == LIBRARY_ALBUMS ? std::string("Artist ") + std::to_string(n % 400) : "";
+    r.song_count = 1 + n % 40;
+    r.album_count = collection == LIBRARY_ARTISTS ? 1 + n % 6 : 0;
+    r.year = collection == LIBRARY_ALBUMS ? 1960 + n % 60 : 0;
+    r.removed = false;
+    return r;
+}
+
+// FNV-1a over every field of every record in order - equal lists give equal revisions
+// across app restarts; never 0, which means "none"
+static uint32_t revision_of(const std::vector<Record>& records) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const std::string& s) {
+        for (unsigned char c : s) hash = (hash ^ c) * 16777619u;
+        hash = (hash ^ 0x1F) * 16777619u;
+    };
+    for (const Record& r : records) {
+        mix(r.id);
+        mix(r.name);
+        mix(r.artist);
+        mix(std::to_string(r.song_count) + "/" + std::to_string(r.album_count) + "/" + std::to_string(r.year));
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+// Renames, removals and additions - rate of the records each, additions appended
+static void mutate(int collection, double rate) {
+    AppCollection* app = &g_app[collection];
+    uint32_t changes = (uint32_t)(app->records.size() * rate + 0.5);
+    for (uint32_t i = 0; i < changes && !app->records.empty(); i++) {
+        Record& r = app->records[rng_next() % app->records.size()];
+        r.name = "Renamed " + std::to_string(app->edits++) + " " + r.name.substr(0, 40);
+        r.song_count++;
+    }
+    for (uint32_t i = 0; i < changes / 2 && !app->records.empty(); i++) {
+        app->records.erase(app->records.begin() + rng_next() % app->records.size());
+    }
+    for (uint32_t i = 0; i < changes / 2; i++) {
+        app->records.push_back(make_record(collection, app->next_id++));
+    }
+}
+
+// The answer to a query naming revision: the items, and whether they are a delta
+static std::vector<Record> app_answer(int collection, uint32_t revision, bool* delta) {
+    AppCollection* app = &g_app[collection];
+    uint32_t current = revision_of(app->records);
+    if (app->history.empty() || app->history.back().first != current) {
+        app->history.push_back({current, app->records});
+        if (app->history.size() > HISTORY) app->history.pop_front();
+    }
+
+    const std::vector<Record>* base = nullptr;
+    for (const auto& sent : app->history) {
+        if (revision != 0 && sent.first == revision) base = &sent.second;
+    }
+    *delta = false;
+    if (!base) return app->records;
+
+    std::map<std::string, const Record*> before;
+    for (const Record& r : *base) before[r.id] = &r;
+    std::map<std::string, bool> now;
+    for (const Record& r : app->records) now[r.id] = true;
+
+    std::vector<Record> items;
+    for (const Record& r : *base) {
+        if (now.count(r.id)) continue;
+        Record gone = {};
+        gone.id = r.id;
+        gone.removed = true;
+        items.push_back(gone);
+    }
+    for (const Record& r : app->records) {
+        auto it = before.find(r.id);
+        if (it == before.end() || !same_record(*it->second, r)) items.push_back(r);
+    }
+    // A delta the device cannot stage, or about as long as the list, goes out whole
+    if (items.size() > LIBRARY_DELTA_MAX_ENTRIES || items.size() * 2 > app->records.size()) return app->records;
+    *delta = true;
+    return items;
+}
+
+static std::vector<uint8_t> encode_item(int collection, const Record& r) {
+    uint8_t item[256];
+    AbpTlvWriter w;
+    abp_tlv_writer_init(&w, item, sizeof(item));
+    const char* name = r.removed ? nullptr : r.name.c_str();
+    if (collection == LIBRARY_PLAYLISTS) {
+        AbpPlaylistInfo info = {r.id.c_str(), name, r.song_count, r.removed};
+        abp_encode_fields_playlist_info(&w, &info);
+    } else if (collection == LIBRARY_ARTISTS) {
+        AbpArtistInfo info = {r.id.c_str(), name, r.album_count, r.song_count, r.removed};
+        abp_encode_fields_artist_info(&w, &info);
+    } else {
+        AbpAlbumInfo info = {r.id.c_str(), name, r.removed ? nullptr : r.artist.c_str(), r.song_count, r.year,
+                             r.removed};
+        abp_encode_fields_album_info(&w, &info);
+    }
+    return std::vector<uint8_t>(item, item + w.length);
+}
+
+// Pages filled up to PAGE_BUDGET item bytes; at least one, so "unchanged" is one empty page
+static std::vector<std::vector<uint8_t>> encode_pages(int collection, const std::vector<Record>& items,
+                                                      uint32_t revision, bool delta) {
+    std::vector<std::vector<std::vector<uint8_t>>> pages(1);
+    size_t bytes = 0;
+    for (const Record& r : items) {
+        std::vector<uint8_t> item = encode_item(collection, r);
+        if (bytes + item.size() > PAGE_BUDGET && !pages.back().empty()) {
+            pages.emplace_back();
+            bytes = 0;
+        }
+        bytes += item.size();
+        pages.back().push_back(item);
+    }
+
+    std::vector<std::vector<uint8_t>> out;
+    uint32_t offset = 0;
+    for (uint32_t p = 0; p < pages.size(); p++) {
+        std::vector<uint8_t> list(PAGE_BUDGET * 2);
+        AbpTlvWriter list_writer;
+        abp_tlv_writer_init(&list_writer, list.data(), list.size());
+        for (const auto& item : pages[p]) abp_tlv_write_bytes(&list_writer, 3, item.data(), item.size());
+        AbpList abp_list = {list.data(), list_writer.length, 3, (uint16_t)pages[p].size()};
+
+        std::vector<uint8_t> message(list_writer.length + 64);
+        AbpTlvWriter w;
+        uint32_t total_pages = (uint32_t)pages.size();
+        uint32_t total_items = (uint32_t)items.size();
+        if (collection == LIBRARY_PLAYLISTS) {
+            abp_binary_begin(&w, message.data(), message.size(), ABP_MSG_PLAYLISTS_RESPONSE);
+            AbpPlaylistsResponse msg = {p + 1, total_pages, abp_list, offset, total_items, revision, delta, 0};
+            abp_encode_fields_playlists_response(&w, &msg);
+        } else if (collection == LIBRARY_ARTISTS) {
+            abp_binary_begin(&w, message.data(), message.size(), ABP_MSG_ARTISTS_RESPONSE);
+            AbpArtistsResponse msg = {p + 1, total_pages, abp_list, offset, total_items, revision, delta, 0};
+            abp_encode_fields_artists_response(&w, &msg);
+        } else {
+            abp_binary_begin(&w, message.data(), message.size(), ABP_MSG_ALBUMS_RESPONSE);
+            AbpAlbumsResponse msg = {p + 1, total_pages, abp_list, offset, total_items, revision, delta, 0};
+            abp_encode_fields_albums_response(&w, &msg);
+        }
+        message.resize(w.length);
+        out.push_back(message);
+        offset += (uint32_t)pages[p].size();
+    }
+    return out;
+}
+
+// ============================================================================
+// Device - the handlers of the sketch, minus the page tracker (no loss here)
+// ============================================================================
+
+typedef struct {
+    uint32_t page;
+    uint32_t total_pages;
+    uint32_t revision;
+    bool delta;
+    AbpList items;
+} DecodedPage;
+
+static bool decode_page(int collection, const std::vector<uint8_t>& message, DecodedPage* out) {
+    if (collection == LIBRARY_PLAYLISTS) {
+        AbpPlaylistsResponse msg;
+        if (!abp_decode_message(playlists_response, message.data(), message.size(), &msg)) return false;
+        *out = {msg.page, msg.total_pages, msg.revision, msg.delta, msg.playlists};
+    } else if (collection == LIBRARY_ARTISTS) {
+        AbpArtistsResponse msg;
+        if (!abp_decode_message(artists_response, message.data(), message.size(), &msg)) return false;
+        *out = {msg.page, msg.total_pages, msg.revision, msg.delta, msg.artists};
+    } else {
+        AbpAlbumsResponse msg;
+        if (!abp_decode_message(albums_response, message.data(), message.size(), &msg)) return false;
+        *out = {msg.page, msg.total_pages, msg.revision, msg.delta, msg.albums};
+    }
+    return true;
+}
+
+static void apply_item(int collection, bool delta, const uint8_t* item, size_t length) {
+    LibraryCollection c = (LibraryCollection)collection;
+    if (collection == LIBRARY_PLAYLISTS) {
+        AbpPlaylistInfo pl;
+        if (!abp_decode_playlist_info(item, length, &pl)) return;
+        if (!delta) library_add_playlist(pl.id, pl.name, pl.song_count);
+        else if (pl.removed) library_delta_remove(c, pl.id);
+        else library_delta_put_playlist(pl.id, pl.name, pl.song_count);
+    } else if (collection == LIBRARY_ARTISTS) {
+        AbpArtistInfo a;
+        if (!abp_decode_artist_info(item, length, &a)) return;
+        if (!delta) library_add_artist(a.id, a.name, a.album_count, a.song_count);
+        else if (a.removed) library_delta_remove(c, a.id);
+        else library_delta_put_artist(a.id, a.name, a.album_count, a.song_count);
+    } else {
+        AbpAlbumInfo a;
+        if (!abp_decode_album_info(item, length, &a)) return;
+        if (!delta) library_add_album(a.id, a.name, a.artist, a.song_count, a.year);
+        else if (a.removed) library_delta_remove(c, a.id);
+        else library_delta_put_album(a.id, a.name, a.artist, a.song_count, a.year);
+    }
+}
+
+// begin_library_page(), the item loop and finish_library_page(); false when a delta
+// failed and the list has to be asked for whole
+static bool device_receive(int collection, const std::vector<uint8_t>& message, uint32_t base_revision) {
+    LibraryCollection c = (LibraryCollection)collection;
+    DecodedPage page;
+    if (!decode_page(collection, message, &page)) {
+        fprintf(stderr, "undecodable %s page\n", NAMES[collection]);
+        exit(1);
+    }
+    if (page.page == 1) {
+        if (page.delta) {
+            library_delta_begin(c, base_revision);
+        } else {
+            library_begin_update(c);
+            library_set_revision(c, page.revision);
+        }
+    }
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&page.items, &pos, &item, &item_length)) {
+        apply_item(collection, page.delta, item, item_length);
+    }
+    if (!page.delta) {
+        library_update_sort_indexes(c);
+        library_update_search_index(c);
+    }
+    if (page.page != page.total_pages) return true;
+    if (!page.delta) {
+        library_publish(c);
+        return true;
+    }
+    return library_delta_apply(c, page.revision) != LIBRARY_DELTA_FAILED;
+}
+
+// Reboot: the store as the flash snapshot holds it, attached in place
+static std::vector<uint8_t> g_image;
+
+static void device_reboot(void) {
+    library_delta_detach_image();
+    if (library_image_attached()) return;       // Nothing new - the image in flash stays
+    std::vector<uint8_t> image(library_build_image(nullptr, 0));
+    library_build_image(image.data(), (uint32_t)image.size());
+    if (!library_attach_image(image.data(), (uint32_t)image.size())) {
+        fprintf(stderr, "library image does not attach\n");
+        exit(1);
+    }
+    library_reclaim();                          // Nothing reads the old image any more
+    g_image.swap(image);
+}
+
+static bool device_matches(int collection) {
+    const std::vector<Record>& records = g_app[collection].records;
+    if (library_get_revision((LibraryCollection)collection) != revision_of(records)) return false;
+    for (const Record& r : records) {
+        if (collection == LIBRARY_PLAYLISTS) {
+            const BLEPlaylist* pl = library_get_playlist_by_id(r.id.c_str());
+            if (!pl || r.name != pl->name || r.song_count != pl->song_count) return false;
+        } else if (collection == LIBRARY_ARTISTS) {
+            const BLEArtist* a = library_get_artist_by_id(r.id.c_str());
+            if (!a || r.name != a->name || r.song_count != a->song_count || r.album_count != a->album_count) {
+                return false;
+            }
+        } else {
+            const BLEAlbum* a = library_get_album_by_id(r.id.c_str());
+            if (!a || r.name != a->name || r.artist != library_album_artist(a) || r.song_count != a->song_count ||
+                r.year != a->year) {
+                return false;
+            }
+        }
+    }
+    lib_index_t count = collection == LIBRARY_PLAYLISTS ? library_get_playlist_count()
+                        : collection == LIBRARY_ARTISTS ? library_get_artist_count()
+                                                        : library_get_album_count();
+    return count == records.size();
+}
+
+// ============================================================================
+// Runs
+// ============================================================================
+
+typedef struct {
+    uint64_t delta_bytes;       // What the sessions sent with revisions
+    uint64_t full_bytes;        // ... and would have sent as full resyncs
+    uint32_t pages;
+    uint32_t unchanged;         // Collections answered with one empty page
+    uint32_t deltas;
+    uint32_t full;              // Collections sent whole (first sync, or too many changes)
+    uint32_t fallbacks;         // Deltas the device refused, asked for again whole
+    double apply_ms;
+    bool ok;
+} RateResult;
+
+static uint64_t page_bytes(const std::vector<std::vector<uint8_t>>& pages) {
+    uint64_t bytes = 0;
+    for (const auto& page : pages) bytes += page.size();
+    return bytes;
+}
+
+static RateResult run_rate(double rate, int sessions) {
+    RateResult result = {};
+    result.ok = true;
+    g_rng = 1;
+    library_data_clear();
+    for (int c = 0; c < LIBRARY_DELTA_COLLECTIONS; c++) {
+        g_app[c] = AppCollection();
+        for (uint32_t i = 0; i < CATALOG_SIZES[c]; i++) g_app[c].records.push_back(make_record(c, i));
+        g_app[c].next_id = CATALOG_SIZES[c];
+    }
+
+    // Session 0 is the first sync ever (nothing held); only the later ones are counted
+    for (int session = 0; session <= sessions; session++) {
+        if (session > 0) {
+            for (int c = 0; c < LIBRARY_DELTA_COLLECTIONS; c++) mutate(c, rate);
+        }
+        for (int c = 0; c < LIBRARY_DELTA_COLLECTIONS; c++) {
+            uint32_t held = library_get_revision((LibraryCollection)c);
+            bool delta;
+            std::vector<Record> items = app_answer(c, held, &delta);
+            std::vector<std::vector<uint8_t>> pages = encode_pages(c, items, revision_of(g_app[c].records), delta);
+
+            auto start = std::chrono::steady_clock::now();
+            bool applied = true;
+            for (const auto& page : pages) applied &= device_receive(c, page, held);
+            uint64_t sent = page_bytes(pages);
+            uint32_t sent_pages = (uint32_t)pages.size();
+            if (!applied) {
+                // finish_library_page(): ask again against revision 0
+                pages = encode_pages(c, app_answer(c, 0, &delta), revision_of(g_app[c].records), false);
+                for (const auto& page : pages) device_receive(c, page, 0);
+                sent += page_bytes(pages);
+                sent_pages += (uint32_t)pages.size();
+            }
+            result.apply_ms +=
+                session > 0 ? std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                            : 0;
+            if (!device_matches(c)) {
+                fprintf(stderr, "rate %.3f session %d: %s differ from the app\n", rate, session, NAMES[c]);
+                result.ok = false;
+            }
+            if (session == 0) continue;
+
+            result.delta_bytes += sent;
+            result.full_bytes += page_bytes(encode_pages(c, g_app[c].records, revision_of(g_app[c].records), false));
+            result.pages += sent_pages;
+            if (!applied) result.fallbacks++;
+            else if (delta && items.empty()) result.unchanged++;
+            else if (delta) result.deltas++;
+            else result.full++;
+        }
+        device_reboot();
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int sessions = argc > 1 ? atoi(argv[1]) : 12;
+    if (sessions < 1) sessions = 1;
+    LibraryCapacity capacity = {MAX_BLE_PLAYLISTS, MAX_BLE_ARTISTS, MAX_BLE_ALBUMS, 1};
+    if (!library_data_init(&capacity) || !library_delta_init()) {
+        fprintf(stderr, "store allocation failed\n");
+        return 1;
+    }
+
+    printf("Catalog: %u playlists, %u artists, %u albums; %u sessions per rate, each ending in a reboot\n",
+           CATALOG_SIZES[0], CATALOG_SIZES[1], CATALOG_SIZES[2], (unsigned)sessions);
+    printf("Each session renames `rate` of every collection and removes and adds half as many\n\n");
+    printf("%-7s | %12s %12s %7s | %6s %9s %6s %5s %5s %9s %4s\n", "Rate", "Full B/sync", "Delta B/sync",
+           "Saved", "Pages", "Unchanged", "Delta", "Full", "Retry", "Apply ms", "");
+    bool ok = true;
+    for (double rate : MUTATION_RATES) {
+        RateResult r = run_rate(rate, sessions);
+        ok &= r.ok;
+        double full = (double)r.full_bytes / sessions;
+        double delta = (double)r.delta_bytes / sessions;
+        printf("%6.1f%% | %12.0f %12.0f %6.1f%% | %6.1f %9u %6u %5u %5u %9.2f %4s\n", rate * 100, full, delta,
+               full > 0 ? 100.0 * (1.0 - delta / full) : 0.0, (double)r.pages / sessions, r.unchanged, r.deltas,
+               r.full, r.fallbacks, r.apply_ms / sessions, r.ok ? "ok" : "FAIL");
+    }
+    printf("\nUnchanged / Delta / Full / Retry count collections over all sessions\n");
+    printf("%s\n", ok ? "The device held the app's records and revision after every session"
+                      : "The device's library differed from the app's");
+    return ok ? 0 : 1;
+}
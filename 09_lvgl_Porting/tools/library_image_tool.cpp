@@ -0,0 +1,412 @@
+/*
+ * Library Image Tool - Build and check library images (library_image.h) on the host
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/library_image_tool.cpp library_image.cpp library_data.cpp id_index.cpp \
+ *       sort_index.cpp search_index.cpp collate.cpp string_pool.cpp arena.cpp abp_frame.cpp json_pull.cpp \
+ *       -o library_image_tool
+ *
+ *   library_image_tool build <dump.json> <out.img>   dump -> image, built by the firmware's own code
+ *   library_image_tool check <image>                 library_image_check() and library_image_validate()
+ *   library_image_tool selftest                      synthetic catalogs up to 65535 records per
+ *                                                    collection: built, written, read back, attached
+ *                                                    and compared with the store they came from
+ *
+ * A dump holds the three collections with the fields the app sends in its pages:
+ *   {"playlists": [{"id", "name", "songCount"}],
+ *    "artists":   [{"id", "name", "albumCount", "songCount"}],
+ *    "albums":    [{"id", "name", "artist", "songCount", "year"}]}
+ *
+ * An image can be flashed to the library partition's first slot with
+ *   parttool.py write_partition --partition-name library --input library.img
+ */
+
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "abp_frame.h"
+#include "json_pull.h"
+#include "library_data.h"
+#include "library_image.h"
+
+static const uint32_t SELFTEST_SIZES[] = {1000, 20000, 65535};
+static const char* SELFTEST_QUERIES[] = {"v", "velv", "velvet har", "emil", "riv 41", "zzq"};
+static const uint16_t SELFTEST_HITS = 24;
+
+// library_data logs through app_log; on the host only allocation failures are worth showing
+void app_log_write(const char* tag, const char* format, ...) {
+    if (strstr(format, "Failed") == nullptr) return;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%s] ", tag);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool read_file(const char* path, std::vector<uint8_t>* data) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data->resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(data->data(), 1, data->size(), file) == data->size();
+    fclose(file);
+    return ok;
+}
+
+static bool write_file(const char* path, const std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+static void init_store(void) {
+    static bool ready = false;
+    if (ready) return;
+    LibraryCapacity capacity = {LIBRARY_MAX_RECORDS, LIBRARY_MAX_RECORDS, LIBRARY_MAX_RECORDS, 1};
+    ready = library_data_init(&capacity);
+}
+
+static const LibraryCollection IMAGE_COLLECTIONS[] = {LIBRARY_PLAYLISTS, LIBRARY_ARTISTS, LIBRARY_ALBUMS};
+
+// Merge everything added into the sort and search indexes, as finish_*_page() does
+static void update_indexes(void) {
+    for (LibraryCollection collection : IMAGE_COLLECTIONS) {
+        library_update_sort_indexes(collection);
+        library_update_search_index(collection);
+    }
+}
+
+// Last page: make the versions built so far live
+static void publish_all(void) {
+    update_indexes();
+    for (LibraryCollection collection : IMAGE_COLLECTIONS) {
+        library_publish(collection);
+    }
+}
+
+static std::vector<uint8_t> build_image(void) {
+    std::vector<uint8_t> image(library_build_image(nullptr, 0));
+    library_build_image(image.data(), (uint32_t)image.size());
+    return image;
+}
+
+static void print_summary(const LibraryImageHeader* image) {
+    static const char* NAMES[LIBRARY_IMAGE_COLLECTIONS] = {"playlists", "artists", "albums"};
+    printf("image v%u, %u bytes, crc %08x, %u album artist names (%u bytes)\n", image->version,
+           (unsigned)image->image_size, (unsigned)image->crc, (unsigned)image->name_count,
+           (unsigned)image->strings_size);
+    for (int i = 0; i < LIBRARY_IMAGE_COLLECTIONS; i++) {
+        const LibraryImageCollection* c = &image->collections[i];
+        int orders = 0;
+        for (int order = 0; order < LIBRARY_ORDER_COUNT; order++) orders += c->orders[order] != 0;
+        printf("  %-9s %6u records, %6u ID slots, %d sort orders, %7u search words\n", NAMES[i],
+               (unsigned)c->count, (unsigned)c->id_slot_count, orders, (unsigned)c->word_count);
+    }
+}
+
+// ============================================================================
+// build
+// ============================================================================
+
+static bool read_dump(JsonPull* p) {
+    const char* key;
+    if (!json_pull_object_begin(p)) return false;
+    while (json_pull_object_next(p, &key)) {
+        int collection = strcmp(key, "playlists") == 0 ? LIBRARY_PLAYLISTS
+                         : strcmp(key, "artists") == 0 ? LIBRARY_ARTISTS
+                         : strcmp(key, "albums") == 0  ? LIBRARY_ALBUMS
+                                                       : -1;
+        if (collection < 0) {
+            json_pull_skip(p);
+            continue;
+        }
+        if (!json_pull_array_begin(p)) return false;
+        while (json_pull_array_next(p)) {
+            const char* id = "";
+            const char* name = "Unknown";
+            const char* artist = "Unknown";
+            uint16_t album_count = 0;
+            uint16_t song_count = 0;
+            uint16_t year = 0;
+            const char* field;
+            if (!json_pull_object_begin(p)) return false;
+            while (json_pull_object_next(p, &field)) {
+                if (strcmp(field, "id") == 0) id = json_pull_string_or(p, "");
+                else if (strcmp(field, "name") == 0) name = json_pull_string_or(p, "Unknown");
+                else if (strcmp(field, "artist") == 0) artist = json_pull_string_or(p, "Unknown");
+                else if (strcmp(field, "albumCount") == 0) album_count = (uint16_t)json_pull_number_or(p, 0);
+                else if (strcmp(field, "songCount") == 0) song_count = (uint16_t)json_pull_number_or(p, 0);
+                else if (strcmp(field, "year") == 0) year = (uint16_t)json_pull_number_or(p, 0);
+                else json_pull_skip(p);
+            }
+            if (p->error) return false;
+            if (collection == LIBRARY_PLAYLISTS) library_add_playlist(id, name, song_count);
+            else if (collection == LIBRARY_ARTISTS) library_add_artist(id, name, album_count, song_count);
+            else library_add_album(id, name, artist, song_count, year);
+        }
+    }
+    return !p->error;
+}
+
+static int command_build(const char* dump_path, const char* image_path) {
+    std::vector<uint8_t> text;
+    if (!read_file(dump_path, &text)) {
+        fprintf(stderr, "cannot read %s\n", dump_path);
+        return 1;
+    }
+    text.push_back('\0');
+
+    init_store();
+    JsonPull p;
+    json_pull_init(&p, (char*)text.data(), text.size() - 1);
+    if (!read_dump(&p)) {
+        fprintf(stderr, "%s is not a library dump\n", dump_path);
+        return 1;
+    }
+    publish_all();
+
+    std::vector<uint8_t> image = build_image();
+    if (!write_file(image_path, image)) {
+        fprintf(stderr, "cannot write %s\n", image_path);
+        return 1;
+    }
+    print_summary((const LibraryImageHeader*)image.data());
+    return 0;
+}
+
+// ============================================================================
+// check
+// ============================================================================
+
+static int command_check(const char* image_path) {
+    std::vector<uint8_t> image;
+    if (!read_file(image_path, &image)) {
+        fprintf(stderr, "cannot read %s\n", image_path);
+        return 1;
+    }
+    const LibraryImageHeader* header = library_image_check(image.data(), image.size());
+    if (!header) {
+        fprintf(stderr, "%s: bad header, layout or CRC\n", image_path);
+        return 1;
+    }
+    const char* error = library_image_validate(header);
+    if (error) {
+        fprintf(stderr, "%s: %s\n", image_path, error);
+        return 1;
+    }
+    print_summary(header);
+    return 0;
+}
+
+// ============================================================================
+// selftest
+// ============================================================================
+
+static std::string make_name(uint32_t n) {
+    static const char* first[] = {"Velvet", "Blue", "Électric", "Silver", "Northern", "Émilie", "Golden", "The Owls"};
+    static const char* second[] = {"Harbor", "Parade", "Machines", "Rivers", "Lights", "Echoes", "Ångström"};
+    char name[64];
+    snprintf(name, sizeof(name), "%s %s %u", first[n % 8], second[(n / 8) % 7], n);
+    return name;
+}
+
+static void fill_store(uint32_t size) {
+    for (LibraryCollection collection : IMAGE_COLLECTIONS) {
+        library_begin_update(collection);
+    }
+    char id[32];
+    for (uint32_t i = 0; i < size; i++) {
+        // The last record repeats the first ID - lookups must keep finding the first
+        uint32_t n = i + 1 == size ? 0 : i;
+        std::string name = make_name(i * 7919 % size);
+        snprintf(id, sizeof(id), "pl-%u", n);
+        library_add_playlist(id, name.c_str(), (uint16_t)(i % 300));
+        snprintf(id, sizeof(id), "ar-%u", n);
+        library_add_artist(id, name.c_str(), (uint16_t)(i % 20), (uint16_t)(i % 400));
+        snprintf(id, sizeof(id), "al-%u", n);
+        library_add_album(id, name.c_str(), make_name(i / 10).c_str(), (uint16_t)(i % 25),
+                          (uint16_t)(i % 9 == 0 ? 0 : 1950 + i % 75));
+        // Pages of 50, as the app sends them
+        if (i % 50 == 49) update_indexes();
+    }
+    publish_all();
+}
+
+// Everything the UI can read from the store, to compare the image against
+static std::string snapshot_views(void) {
+    std::string out;
+    char line[256];
+    for (lib_index_t i = 0; i < library_get_playlist_count(); i++) {
+        const BLEPlaylist* pl = library_get_playlist(i);
+        snprintf(line, sizeof(line), "P%s|%s|%u\n", pl->id, pl->name, pl->song_count);
+        out += line;
+    }
+    for (lib_index_t i = 0; i < library_get_artist_count(); i++) {
+        const BLEArtist* ar = library_get_artist(i);
+        snprintf(line, sizeof(line), "R%s|%s|%u|%u\n", ar->id, ar->name, ar->album_count, ar->song_count);
+        out += line;
+    }
+    for (lib_index_t i = 0; i < library_get_album_count(); i++) {
+        const BLEAlbum* al = library_get_album(i);
+        snprintf(line, sizeof(line), "A%s|%s|%s|%u|%u\n", al->id, al->name, library_album_artist(al),
+                 al->song_count, al->year);
+        out += line;
+    }
+
+    const LibraryCollection collections[] = {LIBRARY_PLAYLISTS, LIBRARY_ARTISTS, LIBRARY_ALBUMS};
+    const lib_index_t counts[] = {library_get_playlist_count(), library_get_artist_count(),
+                                  library_get_album_count()};
+    for (int c = 0; c < 3; c++) {
+        for (int order = 0; order < LIBRARY_ORDER_COUNT; order++) {
+            if (!library_supports_order(collections[c], (LibraryOrder)order)) continue;
+            out += "O";
+            for (lib_index_t p = 0; p < counts[c]; p++) {
+                out += std::to_string(library_get_sorted_index(collections[c], (LibraryOrder)order, p)) + ",";
+            }
+            out += "\n";
+        }
+    }
+
+    LibrarySearchHit hits[SELFTEST_HITS];
+    for (const char* query : SELFTEST_QUERIES) {
+        uint16_t found = library_search(query, hits, SELFTEST_HITS);
+        out += "S";
+        for (uint16_t h = 0; h < found; h++) {
+            out += std::to_string(hits[h].collection) + ":" + std::to_string(hits[h].record) + ",";
+        }
+        out += "\n";
+    }
+
+    char id[32];
+    for (uint32_t n = 0; n < counts[0]; n += 997) {
+        snprintf(id, sizeof(id), "al-%u", n);
+        const BLEAlbum* al = library_get_album_by_id(id);
+        snprintf(id, sizeof(id), "pl-%u", n);
+        const BLEPlaylist* pl = library_get_playlist_by_id(id);
+        snprintf(line, sizeof(line), "I%s|%s\n", al ? al->name : "-", pl ? pl->name : "-");
+        out += line;
+    }
+    out += library_get_artist_by_id("ar-missing") ? "found missing\n" : "missing ok\n";
+    return out;
+}
+
+static bool expect(bool condition, const char* what, uint32_t size) {
+    if (!condition) fprintf(stderr, "selftest %u: %s\n", (unsigned)size, what);
+    return condition;
+}
+
+// Damage that a correct CRC does not cover: an image written wrongly, then sealed
+static std::vector<uint8_t> reseal(std::vector<uint8_t> image) {
+    LibraryImageHeader* header = (LibraryImageHeader*)image.data();
+    header->crc = abp_crc32(image.data() + header->header_size, header->image_size - header->header_size);
+    return image;
+}
+
+static int command_selftest(void) {
+    init_store();
+    int failures = 0;
+    printf("%8s %10s %10s %10s %10s\n", "records", "image KB", "ingest ms", "build ms", "attach ms");
+    for (uint32_t size : SELFTEST_SIZES) {
+        auto start = std::chrono::steady_clock::now();
+        fill_store(size);
+        double ingest_ms = ms_since(start);
+        std::string expected = snapshot_views();
+
+        start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> image = build_image();
+        double build_ms = ms_since(start);
+        bool ok = expect(build_image() == image, "rebuilding gives different bytes", size);
+
+        // Through a file and back, as the firmware stores it
+        std::string path = "library_selftest_" + std::to_string(size) + ".img";
+        std::vector<uint8_t> loaded;
+        ok &= expect(write_file(path.c_str(), image) && read_file(path.c_str(), &loaded) && loaded == image,
+                     "file round trip", size);
+        remove(path.c_str());
+
+        const LibraryImageHeader* header = library_image_check(loaded.data(), loaded.size());
+        ok &= expect(header != nullptr, "check failed", size);
+        if (header) {
+            const char* error = library_image_validate(header);
+            ok &= expect(error == nullptr, error ? error : "", size);
+        }
+
+        start = std::chrono::steady_clock::now();
+        ok &= expect(library_attach_image(loaded.data(), (uint32_t)loaded.size()), "attach failed", size);
+        double attach_ms = ms_since(start);
+        ok &= expect(library_image_attached(), "not attached", size);
+        ok &= expect(snapshot_views() == expected, "attached image reads differently from the store", size);
+        ok &= expect(build_image() == image, "image built from the attached image differs", size);
+        // A sync builds beside the image; readers stay on it until the publish
+        const BLEAlbum* first = library_get_album(0);
+        library_begin_update(LIBRARY_ALBUMS);
+        library_add_album("al-new", "New", "", 1, 2000);
+        ok &= expect(library_get_album(0) == first && library_get_album_by_id("al-new") == nullptr,
+                     "a record being built showed up", size);
+
+        // Damage anywhere must be caught before anything is read
+        std::vector<uint8_t> damaged = image;
+        damaged[damaged.size() / 2] ^= 0x01;
+        ok &= expect(!library_image_check(damaged.data(), damaged.size()), "flipped byte accepted", size);
+        ok &= expect(!library_image_check(image.data(), image.size() - 1), "truncated image accepted", size);
+        const LibraryImageHeader* sealed = (const LibraryImageHeader*)image.data();
+        const LibraryImageCollection* albums = &sealed->collections[LIBRARY_ALBUMS];
+        std::vector<uint8_t> bad_slot = image;
+        for (uint32_t i = 0; i < albums->id_slot_count; i++) {
+            lib_index_t* slot = (lib_index_t*)(bad_slot.data() + albums->id_slots) + i;
+            if (*slot != LIBRARY_IMAGE_NO_RECORD) {
+                *slot = (lib_index_t)albums->count;
+                break;
+            }
+        }
+        bad_slot = reseal(bad_slot);
+        // With 65535 records the only index past them is the empty marker
+        ok &= expect(albums->count >= LIBRARY_IMAGE_NO_RECORD || !library_image_check(bad_slot.data(), bad_slot.size()),
+                     "ID slot past the records accepted", size);
+        std::vector<uint8_t> bad_name = image;
+        if (sealed->name_count > 0) {
+            uint32_t* name = (uint32_t*)(bad_name.data() + sealed->names) + sealed->name_count - 1;
+            *name = sealed->strings_size;
+        }
+        bad_name = reseal(bad_name);
+        ok &= expect(sealed->name_count == 0 || !library_image_check(bad_name.data(), bad_name.size()),
+                     "name offset past the strings accepted", size);
+        ok &= expect(!library_attach_image(damaged.data(), (uint32_t)damaged.size()) && library_image_attached(),
+                     "damaged image replaced the attached one", size);
+
+        // Publishing moves albums back to their arena; a reader holding a record of the
+        // image keeps reading it
+        library_publish(LIBRARY_ALBUMS);
+        ok &= expect(library_get_album_count() == 1 && library_get_album_by_id("al-new") != nullptr,
+                     "publish did not swap", size);
+        ok &= expect(strcmp(library_album_artist(first), make_name(0).c_str()) == 0, "old record lost its artist",
+                     size);
+        library_data_clear();
+        ok &= expect(!library_image_attached() && library_get_album_count() == 0, "clear did not detach", size);
+
+        printf("%8u %10.1f %10.2f %10.2f %10.3f %s\n", (unsigned)size, image.size() / 1024.0, ingest_ms, build_ms,
+               attach_ms, ok ? "ok" : "FAILED");
+        failures += !ok;
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && strcmp(argv[1], "build") == 0) return command_build(argv[2], argv[3]);
+    if (argc == 3 && strcmp(argv[1], "check") == 0) return command_check(argv[2]);
+    if (argc == 2 && strcmp(argv[1], "selftest") == 0) return command_selftest();
+    fprintf(stderr, "usage: %s build <dump.json> <out.img> | check <image> | selftest\n", argv[0]);
+    return 2;
+}
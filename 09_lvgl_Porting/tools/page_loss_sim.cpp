@@ -0,0 +1,342 @@
+/*
+ * Page Loss Simulator - Paginated transfers over a lossy, reordering link
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/page_loss_sim.cpp page_tracker.cpp abp_codec.cpp -o page_loss_sim
+ *
+ * A fake app paginates a playlist list into binary PLAYLISTS_RESPONSE pages the way
+ * BluetoothCommunicationService does (v1.2: offset, totalItems, page ranges). A fake
+ * link drops messages in both directions and delivers the rest after a random delay,
+ * so pages arrive out of order. The device side runs page_tracker as the sketch does:
+ * apply in order, hold early pages, replay them, poll for silence every loop tick.
+ *
+ * Every run must end with the exact list, in order, or as a reported failure once
+ * the tracker gives up; a wrong or duplicated record fails the tool (exit status 1).
+ * In the superseded row a second query (v1.6 request ids) goes out while the first is
+ * still answered, for a list renamed in between: pages of the first must never mix in.
+ *
+ *   page_loss_sim            Loss rates 0-30%, with and without reordering
+ *   page_loss_sim <runs>     ... with more runs per row (default 200)
+ */
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "abp_codec.h"
+#include "page_tracker.h"
+
+static const uint32_t TICK_MS = 10;                 // Device loop period
+static const uint32_t RUN_LIMIT_MS = 120000;
+static const uint32_t APP_ANSWER_MS = 40;           // App gathers the list before page 1
+static const uint32_t PAGE_INTERVAL_MS = 30;        // Time on air per page (~2.5 KB at ~80 KB/s)
+static const uint32_t SUPERSEDE_MS = 300;           // Second query of the superseded row
+
+// ============================================================================
+// Random numbers (xorshift, so runs repeat exactly)
+// ============================================================================
+
+static uint32_t g_rng = 1;
+
+static uint32_t rng_next(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static bool rng_chance(double p) {
+    return (rng_next() % 100000) < (uint32_t)(p * 100000);
+}
+
+// ============================================================================
+// Link
+// ============================================================================
+
+typedef struct {
+    double loss;                // Per message, each direction
+    uint32_t jitter_ms;         // Extra delivery delay, 0..jitter_ms - reorders pages
+    bool ignores_ranges;        // App before v1.2: every query gets the whole list
+    bool changes_list;          // The app's list grows after the first query
+    bool supersedes;            // A new query, for a renamed list, goes out mid-answer
+} LinkProfile;
+
+typedef struct {
+    uint32_t at_ms;
+    uint32_t seq;
+    std::vector<uint8_t> bytes;
+} InFlight;
+
+static std::vector<InFlight> g_to_device;
+static uint32_t g_seq = 0;
+
+static void link_send(const LinkProfile& link, uint32_t now_ms, std::vector<uint8_t> bytes) {
+    if (rng_chance(link.loss)) return;
+    uint32_t delay = link.jitter_ms ? rng_next() % (link.jitter_ms + 1) : 0;
+    g_to_device.push_back({now_ms + delay, g_seq++, std::move(bytes)});
+}
+
+// ============================================================================
+// Fake app
+// ============================================================================
+
+static std::vector<std::string> g_app_list;
+static std::vector<std::string> g_app_list_before;  // As it was when first asked for
+
+// Pages of 24-40 items, like a byte budget over names of varying length
+static std::vector<std::vector<uint32_t>> paginate(size_t items) {
+    std::vector<std::vector<uint32_t>> pages(1);
+    for (uint32_t i = 0; i < items; i++) {
+        if (pages.back().size() >= 24 + (i * 7919) % 17) pages.emplace_back();
+        pages.back().push_back(i);
+    }
+    return pages;
+}
+
+static std::vector<uint8_t> encode_page(const std::vector<uint32_t>& items, uint32_t page, uint32_t total_pages,
+                                        uint32_t offset, uint32_t total_items, uint32_t request_id) {
+    static uint8_t list[16 * 1024];
+    AbpTlvWriter list_writer;
+    abp_tlv_writer_init(&list_writer, list, sizeof(list));
+    for (uint32_t index : items) {
+        uint8_t item[128];
+        AbpTlvWriter item_writer;
+        abp_tlv_writer_init(&item_writer, item, sizeof(item));
+        AbpPlaylistInfo info = {g_app_list[index].c_str(), "Playlist", index, false};
+        abp_encode_fields_playlist_info(&item_writer, &info);
+        abp_tlv_write_bytes(&list_writer, 3, item, item_writer.length);
+    }
+
+    std::vector<uint8_t> out(list_writer.length + 64);
+    AbpTlvWriter w;
+    abp_binary_begin(&w, out.data(), out.size(), ABP_MSG_PLAYLISTS_RESPONSE);
+    AbpPlaylistsResponse msg = {page, total_pages, {list, list_writer.length, 3, (uint16_t)items.size()}, offset,
+                                total_items, 0, false, request_id};
+    abp_encode_fields_playlists_response(&w, &msg);
+    out.resize(w.length);
+    return out;
+}
+
+// A query reached the app: queue its pages (first_page 0 = all of them), echoing its request id
+static void app_answer(const LinkProfile& link, uint32_t now_ms, uint32_t first_page, uint32_t last_page,
+                       uint32_t request_id) {
+    std::vector<std::vector<uint32_t>> pages = paginate(g_app_list.size());
+    uint32_t offset = 0;
+    uint32_t at = now_ms + APP_ANSWER_MS;
+    for (uint32_t p = 1; p <= pages.size(); p++) {
+        bool wanted = link.ignores_ranges || first_page == 0 || (p >= first_page && p <= last_page);
+        if (wanted) {
+            link_send(link, at, encode_page(pages[p - 1], p, (uint32_t)pages.size(), offset,
+                                            (uint32_t)g_app_list.size(), request_id));
+            at += PAGE_INTERVAL_MS;
+        }
+        offset += (uint32_t)pages[p - 1].size();
+    }
+}
+
+// ============================================================================
+// Device
+// ============================================================================
+
+static PageTracker g_tracker;
+static std::vector<std::string> g_building;         // Version being built
+static std::vector<std::string> g_published;
+static bool g_complete = false;
+static bool g_restart = false;                      // Totals changed - repeat the whole query
+static const uint8_t* g_rx_message = nullptr;
+static size_t g_rx_length = 0;
+
+static void handle_page(const uint8_t* data, size_t length, uint32_t now_ms) {
+    AbpPlaylistsResponse msg;
+    if (!abp_decode_message(playlists_response, data, length, &msg)) {
+        fprintf(stderr, "undecodable page\n");
+        exit(1);
+    }
+    PageInfo info = {msg.page, msg.total_pages, msg.total_items, msg.offset, nullptr, nullptr, msg.request_id};
+    PageAction action = page_tracker_accept(&g_tracker, &info, g_rx_message, g_rx_length, now_ms);
+    if (action == PAGE_RESTART) g_restart = true;
+    if (action != PAGE_APPLY) return;
+
+    if (msg.page == 1) g_building.clear();
+    size_t pos = 0;
+    const uint8_t* item;
+    size_t item_length;
+    while (abp_list_next(&msg.playlists, &pos, &item, &item_length)) {
+        AbpPlaylistInfo pl;
+        if (abp_decode_playlist_info(item, item_length, &pl)) g_building.push_back(pl.id);
+    }
+    if (page_tracker_applied(&g_tracker, msg.page, msg.playlists.count)) {
+        g_published = g_building;
+        g_complete = true;
+    }
+}
+
+// on_ble_data(): dispatch, then replay held pages that are next in order
+static void device_receive(const std::vector<uint8_t>& bytes, uint32_t now_ms) {
+    g_rx_message = bytes.data();
+    g_rx_length = bytes.size();
+    handle_page(bytes.data(), bytes.size(), now_ms);
+
+    HeldPage held;
+    while (page_tracker_take_ready(&g_tracker, &held)) {
+        g_rx_message = held.data;
+        g_rx_length = held.length;
+        handle_page(held.data, held.length, now_ms);
+        page_tracker_release(&held);
+    }
+}
+
+// ============================================================================
+// Runs
+// ============================================================================
+
+typedef enum { RUN_COMPLETE, RUN_GAVE_UP } RunResult;
+
+static RunResult run_transfer(const LinkProfile& link, uint32_t items, uint32_t* finish_ms) {
+    g_app_list.clear();
+    for (uint32_t i = 0; i < items; i++) g_app_list.push_back("3f2a9c1e-5b7d-4e8f-a1c2-" + std::to_string(i));
+    g_to_device.clear();
+    g_building.clear();
+    g_published.clear();
+    g_app_list_before = g_app_list;
+    g_complete = false;
+    g_restart = false;
+
+    // The query itself goes over the lossy link too; a changing list grows once the
+    // first answer is on its way, so repeats of lost pages no longer line up
+    // Only the superseded row's app echoes request ids
+    uint32_t request_id = link.supersedes ? 1 : 0;
+    page_tracker_start(&g_tracker, nullptr, nullptr, 0, 0, request_id, 0);
+    if (!rng_chance(link.loss)) app_answer(link, 0, 0, 0, request_id);
+    if (link.changes_list) {
+        for (uint32_t i = 0; i < 10; i++) g_app_list.push_back("late-" + std::to_string(i));
+    }
+
+    for (uint32_t now = 0; now < RUN_LIMIT_MS; now += TICK_MS) {
+        // Deliver everything due, in arrival order
+        std::sort(g_to_device.begin(), g_to_device.end(), [](const InFlight& a, const InFlight& b) {
+            return a.at_ms != b.at_ms ? a.at_ms < b.at_ms : a.seq < b.seq;
+        });
+        size_t due = 0;
+        while (due < g_to_device.size() && g_to_device[due].at_ms <= now) due++;
+        std::vector<InFlight> arrived(g_to_device.begin(), g_to_device.begin() + due);
+        g_to_device.erase(g_to_device.begin(), g_to_device.begin() + due);
+        for (const InFlight& message : arrived) device_receive(message.bytes, now);
+
+        if (g_complete) {
+            *finish_ms = now;
+            return RUN_COMPLETE;
+        }
+
+        // Same length, other records: pages of the first answer would fit the second one
+        if (link.supersedes && now == SUPERSEDE_MS) {
+            for (uint32_t i = 0; i < g_app_list.size(); i++) g_app_list[i] = "renamed-" + std::to_string(i);
+            g_app_list_before = g_app_list;
+            request_id++;
+            page_tracker_start(&g_tracker, nullptr, nullptr, 0, 0, request_id, now);
+            if (!rng_chance(link.loss)) app_answer(link, now, 0, 0, request_id);
+        }
+
+        if (g_restart) {
+            g_restart = false;
+            if (!rng_chance(link.loss)) app_answer(link, now, 0, 0, request_id);
+        }
+
+        PageRange ranges[PAGE_TRACKER_MAX_RANGES];
+        int range_count = 0;
+        PagePollResult result = page_tracker_poll(&g_tracker, now, ranges, &range_count);
+        if (result == PAGE_POLL_FAILED) return RUN_GAVE_UP;
+        if (result == PAGE_POLL_RETRY) {
+            if (range_count == 0 && !rng_chance(link.loss)) app_answer(link, now, 0, 0, request_id);
+            for (int i = 0; i < range_count; i++) {
+                if (!rng_chance(link.loss)) app_answer(link, now, ranges[i].first, ranges[i].last, request_id);
+            }
+        }
+    }
+    return RUN_GAVE_UP;
+}
+
+// The list as the app had it at one point - never a mix of two
+static bool check_list(void) {
+    return g_published == g_app_list || g_published == g_app_list_before;
+}
+
+static bool run_row(const char* name, const LinkProfile& link, uint32_t items, int runs) {
+    page_tracker_cancel(&g_tracker);
+    g_tracker.stats = {};
+    g_rng = 0x9e3779b9u ^ (uint32_t)(link.loss * 1000) ^ link.jitter_ms;
+
+    int complete = 0;
+    int gave_up = 0;
+    uint64_t total_ms = 0;
+    uint32_t worst_ms = 0;
+    for (int r = 0; r < runs; r++) {
+        uint32_t finish_ms = 0;
+        if (run_transfer(link, items, &finish_ms) == RUN_GAVE_UP) {
+            gave_up++;
+            continue;
+        }
+        if (!check_list()) {
+            printf("%-28s run %d: wrong list (%zu of %zu items)\n", name, r, g_published.size(),
+                   g_app_list.size());
+            return false;
+        }
+        complete++;
+        total_ms += finish_ms;
+        worst_ms = std::max(worst_ms, finish_ms);
+    }
+    page_tracker_cancel(&g_tracker);
+
+    const PageTrackerStats& s = g_tracker.stats;
+    printf("%-28s %4d/%-4d %3d %8.0f %8u %7u %7u %7u %7u %6u %7u %8u %6u\n", name, complete, runs, gave_up,
+           complete ? (double)total_ms / complete : 0.0, (unsigned)worst_ms, (unsigned)s.timeouts,
+           (unsigned)s.retransmits, (unsigned)s.pages_requested, (unsigned)s.held, (unsigned)s.dropped,
+           (unsigned)s.restarts, (unsigned)s.duplicates, (unsigned)s.stale);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int runs = argc > 1 ? atoi(argv[1]) : 200;
+    if (runs <= 0) runs = 200;
+    const uint32_t items = 1500;
+    // Sized as the sketch sizes it, from the capacity the query asks for
+    if (!page_tracker_init(&g_tracker, items)) return 1;
+
+    // A transfer in more pages than that is given up at once, not dropped page by page
+    page_tracker_start(&g_tracker, nullptr, nullptr, 0, 0, 0, 0);
+    PageInfo oversized = {1, items + 1, items + 1, 0, nullptr, nullptr, 0};
+    if (page_tracker_accept(&g_tracker, &oversized, nullptr, 0, 0) != PAGE_GIVE_UP || g_tracker.active) {
+        printf("%u pages for %u items not given up\n", (unsigned)oversized.total_pages, (unsigned)items);
+        return 1;
+    }
+    printf("%u items in %zu pages, %d runs per row\n\n", (unsigned)items, paginate(items).size(), runs);
+    printf("%-28s %9s %3s %8s %8s %7s %7s %7s %7s %6s %7s %8s %6s\n", "link", "complete", "fail", "avg ms",
+           "worst", "timeout", "retrans", "pages", "held", "drop", "restart", "dups", "stale");
+
+    struct {
+        const char* name;
+        LinkProfile link;
+    } rows[] = {
+        {"clean", {0.0, 0, false, false, false}},
+        {"1% loss", {0.01, 0, false, false, false}},
+        {"5% loss", {0.05, 0, false, false, false}},
+        {"10% loss", {0.10, 0, false, false, false}},
+        {"30% loss", {0.30, 0, false, false, false}},
+        {"reorder 150ms", {0.0, 150, false, false, false}},
+        {"5% loss + reorder", {0.05, 150, false, false, false}},
+        {"10% loss + reorder", {0.10, 150, false, false, false}},
+        {"5% loss, app ignores ranges", {0.05, 50, true, false, false}},
+        {"list changes, 5% loss", {0.05, 50, false, true, false}},
+        {"superseded, 5% loss + reord", {0.05, 150, false, false, true}},
+    };
+
+    bool ok = true;
+    for (const auto& row : rows) {
+        ok = run_row(row.name, row.link, items, runs) && ok;
+    }
+    printf("\n%s\n", ok ? "All transfers ended with the exact list or gave up cleanly" : "FAILED");
+    return ok ? 0 : 1;
+}
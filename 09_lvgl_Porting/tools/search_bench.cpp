@@ -0,0 +1,116 @@
+/*
+ * Search Benchmark - search_index_query() latency as the library grows
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/search_bench.cpp search_index.cpp collate.cpp arena.cpp -o search_bench
+ *
+ * scan:  every name checked word by word, what a search without the index would do
+ * index: search_index_query() as the search screen calls it (first 24 hits), and for
+ *        up to 256 hits (a caller that wants a long result list)
+ *
+ * Names are artist-like ("Velvet Harbor 412", "Émilie Rivers 7") so queries hit
+ * realistic shares of the library: one letter matches a lot, a word matches a little.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "collate.h"
+#include "search_index.h"
+
+static const int REPEAT = 2000;
+static const uint16_t SCREEN_HITS = 24;
+static const uint16_t LONG_HITS = 256;
+static const uint32_t SIZES[] = {1000, 10000, 50000};
+static const char* QUERIES[] = {"v", "ve", "velv", "velvet har", "emil", "riv 41", "zzq"};
+
+static std::vector<std::string> g_names;
+
+static const char* name_of(const void*, lib_index_t record) {
+    return g_names[record].c_str();
+}
+
+static std::string make_name(uint32_t n) {
+    static const char* first[] = {"Velvet", "Blue", "Électric", "Silver", "Northern", "Émilie", "Golden", "The Owls"};
+    static const char* second[] = {"Harbor", "Parade", "Machines", "Rivers", "Lights", "Echoes", "Ångström"};
+    char name[64];
+    snprintf(name, sizeof(name), "%s %s %u", first[n % 8], second[(n / 8) % 7], n);
+    return name;
+}
+
+// The scan the index replaces: fold and compare every word of every name
+static bool scan_matches(const char* name, const char* query) {
+    for (const char* q = query; *q;) {
+        while (*q == ' ') q++;
+        if (!*q) break;
+        const char* q_end = strchr(q, ' ');
+        if (!q_end) q_end = q + strlen(q);
+
+        bool found = false;
+        for (const char* w = name; *w && !found;) {
+            const char* a = w;
+            const char* b = q;
+            found = true;
+            while (found && b < q_end) {
+                found = collate_next(&a) == collate_next(&b);
+            }
+            const char* space = strchr(w, ' ');
+            w = space ? space + 1 : w + strlen(w);
+        }
+        if (!found) return false;
+        q = q_end;
+    }
+    return true;
+}
+
+template <typename Query>
+static double time_query(Query query, uint16_t* found) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < REPEAT; i++) *found = query();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / REPEAT;
+}
+
+int main() {
+    printf("%8s %-12s %8s %10s %12s %12s\n", "names", "query", "hits", "scan us", "index us", "index 256 us");
+    std::vector<lib_index_t> results(LONG_HITS);
+    for (uint32_t size : SIZES) {
+        g_names.clear();
+        for (uint32_t i = 0; i < size; i++) g_names.push_back(make_name(i));
+
+        // Ingest a page of 50 names at a time, as the sketch does
+        SearchIndex index;
+        std::vector<SearchWord> scratch(256);
+        search_index_init(&index, size * 5);
+        for (uint32_t i = 0; i < size; i++) {
+            search_index_add(&index, (lib_index_t)i, g_names[i].c_str());
+            if (i % 50 == 49) search_index_update(&index, scratch.data(), scratch.size());
+        }
+        search_index_update(&index, scratch.data(), scratch.size());
+
+        for (const char* query : QUERIES) {
+            uint16_t scan_hits = 0, screen_hits = 0, long_hits = 0;
+            double scan_us = time_query([&] {
+                uint16_t n = 0;
+                for (uint32_t i = 0; i < size && n < SCREEN_HITS; i++) {
+                    if (scan_matches(g_names[i].c_str(), query)) n++;
+                }
+                return n;
+            }, &scan_hits);
+            double index_us = time_query([&] {
+                return search_index_query(&index, query, name_of, nullptr, results.data(), SCREEN_HITS);
+            }, &screen_hits);
+            double long_us = time_query([&] {
+                return search_index_query(&index, query, name_of, nullptr, results.data(), LONG_HITS);
+            }, &long_hits);
+
+            if (scan_hits != screen_hits) printf("hit count mismatch: %u vs %u\n", scan_hits, screen_hits);
+            printf("%8u %-12s %8u %10.2f %12.2f %12.2f\n", (unsigned)size, query, long_hits, scan_us, index_us,
+                   long_us);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * Song Window Simulator - Paging through long song lists held as a window
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/song_window_sim.cpp song_window.cpp library_data.cpp library_image.cpp \
+ *       id_index.cpp sort_index.cpp search_index.cpp collate.cpp string_pool.cpp arena.cpp abp_frame.cpp \
+ *       -o song_window_sim
+ *
+ * A user opens a song list, pages forward to its end and back to the start, one
+ * screen of 4 rows every view_ms. The device runs song_window as the sketch does: the
+ * first chunk on open, then one window query at a time toward the rows last shown.
+ * The app answers a query after APP_ANSWER_MS plus air time per song.
+ *
+ * Per list length it prints the time to the first screen, songs held at most, songs
+ * transferred, and how long screens waited on "Loading..." rows - beside what fetching
+ * the whole list costs (v1.2 and earlier). After every query the window is stored in
+ * the library as the sketch stores it and read back: its contents, list positions and
+ * total are checked against the list, past 65535 songs too; a wrong record or position
+ * fails the tool (exit status 1).
+ *
+ *   song_window_sim            Paging every 150 ms (flicking), 400 ms (fast) and 1500 ms (reading)
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "library_data.h"
+#include "song_window.h"
+
+static const uint32_t TICK_MS = 10;                 // Device loop period
+static const uint32_t ROWS = 4;                     // ITEMS_PER_PAGE
+static const uint32_t APP_ANSWER_MS = 40;           // App gathers the slice before page 1
+static const uint32_t SONG_AIR_US = 1000;           // ~32 songs per 30 ms page
+
+typedef struct {
+    uint32_t first_screen_ms;
+    uint32_t peak_resident;
+    uint64_t transferred;
+    uint32_t queries;
+    uint32_t waiting_ms;        // Screen showed rows not yet held
+    bool ok;
+} RunResult;
+
+// library_data logs through app_log; on the host only problems are worth showing
+void app_log_write(const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "[%s] ", tag);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static uint32_t air_ms(uint32_t songs) {
+    return APP_ANSWER_MS + songs * SONG_AIR_US / 1000;
+}
+
+// Build the window a fetch leaves, the way the sketch does: kept records before the
+// fetched ones are copied first, those after them once the last page is in
+static std::vector<uint32_t> apply_fetch(const std::vector<uint32_t>& held, const SongWindow& window,
+                                         const SongWindowFetch& fetch, uint32_t total) {
+    std::vector<uint32_t> next;
+    bool before = fetch.keep_count > 0 && fetch.keep_start < fetch.offset;
+    if (before) {
+        for (uint32_t i = 0; i < fetch.keep_count; i++) next.push_back(held[fetch.keep_start - window.start + i]);
+    }
+    for (uint32_t i = fetch.offset; i < fetch.offset + fetch.limit && i < total; i++) next.push_back(i);
+    if (!before) {
+        for (uint32_t i = 0; i < fetch.keep_count; i++) next.push_back(held[fetch.keep_start - window.start + i]);
+    }
+    return next;
+}
+
+// Store the window as the sketch does - a songs version holding the records, placed in the
+// list by library_set_song_window() - and read it back from the live version
+static bool store_window(const std::vector<uint32_t>& held, const SongWindow& window) {
+    library_begin_update(LIBRARY_SONGS);
+    library_set_song_window(window.start, window.total);
+    for (uint32_t position : held) {
+        char id[16];
+        snprintf(id, sizeof(id), "s%u", (unsigned)position);
+        library_add_song(id, id, "Artist", "Album", 180, 1);
+    }
+    library_publish(LIBRARY_SONGS);
+
+    uint32_t start, total;
+    lib_index_t count;
+    library_get_song_window(&start, &count, &total);
+    if (start != window.start || count != window.count || total != window.total) return false;
+    for (lib_index_t i = 0; i < count; i++) {
+        char id[16];
+        snprintf(id, sizeof(id), "s%u", (unsigned)(start + i));
+        if (strcmp(library_get_song(i)->id, id) != 0) return false;
+    }
+    return true;
+}
+
+static RunResult run_windowed(uint32_t total, uint32_t view_ms) {
+    RunResult r = {0, 0, 0, 0, 0, true};
+    SongWindow window = {0, 0, 0};
+    std::vector<uint32_t> held;
+
+    // Open: the first chunk
+    SongWindowFetch fetch;
+    song_window_first(&fetch);
+    bool in_flight = true;
+    uint32_t done_ms = air_ms(fetch.limit < total ? fetch.limit : total);
+
+    uint32_t last_screen = (total - 1) / ROWS;
+    uint32_t screen = 0;
+    int direction = 1;
+    bool returning = false;
+    bool pending = false;
+    uint32_t next_page_ms = 0;      // Set once the first screen shows
+
+    for (uint32_t now = 0;; now += TICK_MS) {
+        if (in_flight && now >= done_ms) {
+            in_flight = false;
+            uint32_t fetched = fetch.offset < total ? total - fetch.offset : 0;
+            if (fetched > fetch.limit) fetched = fetch.limit;
+            r.transferred += fetched;
+            r.queries++;
+            held = apply_fetch(held, window, fetch, total);
+            song_window_apply(&fetch, total, &window);
+            if (held.size() != window.count || window.count > SONG_WINDOW_MAX) r.ok = false;
+            for (uint32_t i = 0; i < held.size(); i++) {
+                if (held[i] != window.start + i) r.ok = false;
+            }
+            if (!store_window(held, window)) r.ok = false;
+            if (window.count > r.peak_resident) r.peak_resident = window.count;
+            if (r.first_screen_ms == 0) {
+                r.first_screen_ms = now;
+                next_page_ms = now + view_ms;
+            }
+        }
+        if (r.first_screen_ms == 0) continue;
+
+        // The user pages to the end, then back to the start
+        if (now >= next_page_ms) {
+            if (returning && screen == 0) break;
+            if (!returning && screen == last_screen) {
+                returning = true;
+                direction = -1;
+            }
+            screen += direction;
+            pending = true;
+            next_page_ms = now + view_ms;
+        }
+
+        uint32_t first = screen * ROWS;
+        uint32_t last = first + ROWS < total ? first + ROWS : total;
+        if (first < window.start || last > window.start + window.count) r.waiting_ms += TICK_MS;
+
+        if (pending && !in_flight) {
+            if (song_window_plan(&window, first, ROWS, direction, &fetch)) {
+                in_flight = true;
+                done_ms = now + air_ms(fetch.limit);
+            } else {
+                pending = false;
+            }
+        }
+    }
+    return r;
+}
+
+int main(void) {
+    static const uint32_t LENGTHS[] = {20, 100, 500, 2000, 5000, 20000, 100000};
+    static const uint32_t VIEWS_MS[] = {150, 400, 1500};
+    bool ok = true;
+    if (!library_data_init()) {
+        fprintf(stderr, "store allocation failed\n");
+        return 1;
+    }
+
+    printf("Window: %u-song chunks, %u held at most, %u rows of margin\n\n", SONG_WINDOW_CHUNK, SONG_WINDOW_MAX,
+           SONG_WINDOW_MARGIN);
+    printf("%-8s %-6s | %-27s | %-48s\n", "", "", "Whole list (v1.2)", "Windowed (v1.3)");
+    printf("%-8s %-6s | %9s %8s %8s | %9s %8s %8s %7s %9s %4s\n", "Songs", "View", "1st ms", "held", "sent",
+           "1st ms", "held", "sent", "queries", "wait ms", "");
+    for (uint32_t view_ms : VIEWS_MS) {
+        for (uint32_t total : LENGTHS) {
+            RunResult r = run_windowed(total, view_ms);
+            ok &= r.ok;
+            uint32_t whole_held = total < MAX_BLE_SONGS ? total : MAX_BLE_SONGS;
+            printf("%-8u %4ums | %9u %7u%s %8u | %9u %8u %8llu %7u %9u %4s\n", total, view_ms, air_ms(total),
+                   whole_held, total > MAX_BLE_SONGS ? "!" : " ", total, r.first_screen_ms, r.peak_resident,
+                   (unsigned long long)r.transferred, r.queries, r.waiting_ms, r.ok ? "ok" : "FAIL");
+        }
+        printf("\n");
+    }
+    printf("! whole lists past MAX_BLE_SONGS (%u) are cut off\n", MAX_BLE_SONGS);
+    printf("%s\n", ok ? "Every window held exactly the list positions it claimed" : "Window contents were wrong");
+    return ok ? 0 : 1;
+}
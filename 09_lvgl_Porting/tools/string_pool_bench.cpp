@@ -0,0 +1,150 @@
+/*
+ * String Pool Benchmark - Bytes per song with inline name fields vs interned handles
+ * Host-side tool, not part of the sketch
+ *
+ * Build (from 09_lvgl_Porting/):
+ *   g++ -O2 -std=c++17 -I. tools/string_pool_bench.cpp string_pool.cpp arena.cpp -o string_pool_bench
+ *
+ * inline: the record layout before the pool - artist and album as char[64] in every song
+ * pooled: BLESong with two StrHandles, plus the pool's share per song (string bytes,
+ *         per-string offset/hash, and the probe table)
+ *
+ * Both the whole record and the artist/album part alone are reported; id and title
+ * stay inline, so the record as a whole shrinks less than the names do.
+ *
+ * Catalogs are generated with the shapes real libraries have: albums of 8-14 tracks
+ * by one artist, compilations where every track has its own artist, and so on.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "library_data.h"
+#include "string_pool.h"
+
+typedef struct {
+    char id[MAX_ID_LENGTH];
+    char title[MAX_NAME_LENGTH];
+    char artist[MAX_NAME_LENGTH];
+    char album[MAX_NAME_LENGTH];
+    uint16_t duration_sec;
+    uint8_t track_number;
+} InlineSong;
+
+typedef struct {
+    std::string artist;
+    std::string album;
+} SongNames;
+
+typedef struct {
+    const char* name;
+    int artists;
+    int albums_per_artist;
+    int tracks_per_album;
+    int compilation_albums;     // Extra albums with a different artist on every track
+} CatalogShape;
+
+static const CatalogShape SHAPES[] = {
+    {"one artist discography", 1, 20, 12, 0},
+    {"typical collection", 60, 3, 11, 0},
+    {"broad collection", 400, 1, 10, 0},
+    {"with compilations", 60, 3, 11, 20},
+    {"singles only", 2000, 1, 1, 0},
+};
+
+// Deterministic names of realistic length (artists ~14 chars, albums ~22)
+static std::string artist_name(int a) {
+    static const char* first[] = {"The Midnight", "Blue", "Electric", "Silver", "Northern", "Velvet", "Golden"};
+    static const char* second[] = {"Owls", "Parade", "Machines", "Rivers", "Lights", "Harbor", "Echoes"};
+    char name[64];
+    snprintf(name, sizeof(name), "%s %s %d", first[a % 7], second[(a / 7) % 7], a);
+    return name;
+}
+
+static std::string album_name(int a, int b) {
+    static const char* words[] = {"Songs From the", "Live at the", "Return to", "Nights in", "Letters to"};
+    static const char* places[] = {"Northern Coast", "Old Theatre", "Glass House", "City of Rain"};
+    char name[64];
+    snprintf(name, sizeof(name), "%s %s Vol. %d", words[(a + b) % 5], places[b % 4], a * 31 + b);
+    return name;
+}
+
+static std::vector<SongNames> build_catalog(const CatalogShape& shape) {
+    std::vector<SongNames> songs;
+    for (int a = 0; a < shape.artists; a++) {
+        for (int b = 0; b < shape.albums_per_artist; b++) {
+            for (int t = 0; t < shape.tracks_per_album; t++) {
+                songs.push_back({artist_name(a), album_name(a, b)});
+            }
+        }
+    }
+    for (int c = 0; c < shape.compilation_albums; c++) {
+        for (int t = 0; t < 16; t++) {
+            songs.push_back({artist_name(100000 + c * 16 + t), album_name(-1, c)});
+        }
+    }
+    return songs;
+}
+
+typedef struct {
+    size_t songs;
+    size_t unique;
+    double inline_bytes;        // Whole record, per song
+    double pooled_bytes;        // Whole record plus pool share, per song
+    double inline_name_bytes;   // Artist and album only, per song
+    double pooled_name_bytes;
+    double intern_ns;           // Per name
+} PoolResult;
+
+static PoolResult measure(const std::vector<SongNames>& catalog) {
+    PoolResult result = {};
+    result.songs = catalog.size();
+    uint16_t max_strings = (uint16_t)(catalog.size() * 2 + 1 > 65535 ? 65535 : catalog.size() * 2 + 1);
+
+    StringPool pool;
+    string_pool_init(&pool, max_strings, catalog.size() * 2 * MAX_NAME_LENGTH);
+    std::vector<BLESong> records(catalog.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < catalog.size(); i++) {
+        records[i].artist = string_pool_intern(&pool, catalog[i].artist.c_str(), MAX_NAME_LENGTH);
+        records[i].album = string_pool_intern(&pool, catalog[i].album.c_str(), MAX_NAME_LENGTH);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    result.intern_ns = std::chrono::duration<double, std::nano>(elapsed).count() / (catalog.size() * 2);
+
+    // Sanity check - every handle resolves to the name it was made from
+    for (size_t i = 0; i < catalog.size(); i++) {
+        if (catalog[i].artist != string_pool_get(&pool, records[i].artist) ||
+            catalog[i].album != string_pool_get(&pool, records[i].album)) {
+            printf("mismatch at song %zu\n", i);
+        }
+    }
+
+    // Only what the catalog needs: a pool sized for it would hold exactly this
+    result.unique = pool.count;
+    size_t pool_bytes = pool.chars.used + pool.count * sizeof(uint32_t) * 2;
+    size_t slot_count = 1;
+    while (slot_count < (size_t)pool.count * 2) slot_count <<= 1;
+    pool_bytes += slot_count * sizeof(StrHandle);
+
+    result.inline_bytes = sizeof(InlineSong);
+    result.pooled_bytes = sizeof(BLESong) + (double)pool_bytes / catalog.size();
+    result.inline_name_bytes = MAX_NAME_LENGTH * 2;
+    result.pooled_name_bytes = sizeof(StrHandle) * 2 + (double)pool_bytes / catalog.size();
+    return result;
+}
+
+int main() {
+    printf("%-24s %6s %6s | %14s %14s %6s | %14s %14s %6s | %9s\n", "catalog", "songs", "names",
+           "record inline", "record pooled", "ratio", "names inline", "names pooled", "ratio", "ns/intern");
+    for (const CatalogShape& shape : SHAPES) {
+        PoolResult r = measure(build_catalog(shape));
+        printf("%-24s %6zu %6zu | %12.1f B %12.1f B %5.1fx | %12.1f B %12.1f B %5.1fx | %9.1f\n", shape.name,
+               r.songs, r.unique - 1, r.inline_bytes, r.pooled_bytes, r.inline_bytes / r.pooled_bytes,
+               r.inline_name_bytes, r.pooled_name_bytes, r.inline_name_bytes / r.pooled_name_bytes, r.intern_ns);
+    }
+    return 0;
+}
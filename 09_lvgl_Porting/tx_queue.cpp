@@ -0,0 +1,165 @@
+/*
+ * TX Queue - Bounded outbound message queue for the BLE transmit task
+ * Producers enqueue and return immediately; the TX task sends entries in order
+ */
+
+#include "tx_queue.h"
+#include <string.h>
+
+static void add_completion(TxQueue* q, TxDoneCallback done, void* ctx, TxStatus status) {
+    if (!done || q->completion_count >= TX_QUEUE_COMPLETIONS) {
+        return;
+    }
+    uint8_t index = (q->completion_head + q->completion_count) % TX_QUEUE_COMPLETIONS;
+    q->completions[index].done = done;
+    q->completions[index].ctx = ctx;
+    q->completions[index].status = status;
+    q->completion_count++;
+}
+
+static void release(TxQueue* q, TxEntry* entry, TxStatus status) {
+    add_completion(q, entry->done, entry->ctx, status);
+    entry->used = false;
+    entry->in_flight = false;
+    q->stats.depth--;
+
+    switch (status) {
+        case TX_STATUS_SENT:    q->stats.sent++; break;
+        case TX_STATUS_MERGED:  q->stats.merged++; break;
+        case TX_STATUS_DROPPED: q->stats.dropped++; break;
+        case TX_STATUS_FAILED:  q->stats.failed++; break;
+    }
+}
+
+// Oldest waiting entry that may be dropped to make room, or nullptr
+static TxEntry* oldest_mergeable(TxQueue* q) {
+    TxEntry* oldest = nullptr;
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        TxEntry* e = &q->slots[i];
+        if (e->used && !e->in_flight && e->merge_key != 0 && (!oldest || e->seq < oldest->seq)) {
+            oldest = e;
+        }
+    }
+    return oldest;
+}
+
+void tx_queue_init(TxQueue* q, uint8_t* pool) {
+    memset(q, 0, sizeof(*q));
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        q->slots[i].data = pool + (size_t)i * TX_QUEUE_SLOT_SIZE;
+    }
+}
+
+bool tx_queue_push(TxQueue* q, const uint8_t* data, size_t length, uint32_t merge_key,
+                   TxDoneCallback done, void* ctx, uint32_t now_ms) {
+    if (length == 0 || length > TX_QUEUE_SLOT_SIZE) {
+        q->stats.dropped++;
+        add_completion(q, done, ctx, TX_STATUS_DROPPED);
+        return false;
+    }
+
+    TxEntry* slot = nullptr;
+
+    // Latest wins: overwrite a waiting entry with the same key, keeping its place in line
+    if (merge_key != 0) {
+        for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+            TxEntry* e = &q->slots[i];
+            if (e->used && !e->in_flight && e->merge_key == merge_key) {
+                add_completion(q, e->done, e->ctx, TX_STATUS_MERGED);
+                q->stats.merged++;
+                memcpy(e->data, data, length);
+                e->length = (uint16_t)length;
+                // The bytes are new, so staleness counts from now
+                e->enqueued_ms = now_ms;
+                e->done = done;
+                e->ctx = ctx;
+                q->stats.enqueued++;
+                return true;
+            }
+        }
+    }
+
+    for (int i = 0; i < TX_QUEUE_SLOTS && !slot; i++) {
+        if (!q->slots[i].used) slot = &q->slots[i];
+    }
+    if (!slot) {
+        // Full - make room by dropping the oldest message that only matters as "latest"
+        slot = oldest_mergeable(q);
+        if (!slot) {
+            q->stats.dropped++;
+            add_completion(q, done, ctx, TX_STATUS_DROPPED);
+            return false;
+        }
+        release(q, slot, TX_STATUS_DROPPED);
+    }
+
+    memcpy(slot->data, data, length);
+    slot->length = (uint16_t)length;
+    slot->merge_key = merge_key;
+    slot->seq = q->next_seq++;
+    slot->enqueued_ms = now_ms;
+    slot->done = done;
+    slot->ctx = ctx;
+    slot->used = true;
+    slot->in_flight = false;
+
+    q->stats.enqueued++;
+    q->stats.depth++;
+    if (q->stats.depth > q->stats.high_water) {
+        q->stats.high_water = q->stats.depth;
+    }
+    return true;
+}
+
+TxEntry* tx_queue_front(TxQueue* q, uint32_t now_ms) {
+    TxEntry* oldest = nullptr;
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        TxEntry* e = &q->slots[i];
+        if (!e->used || e->in_flight) continue;
+
+        if (e->merge_key != 0 && now_ms - e->enqueued_ms > TX_QUEUE_STALE_MS) {
+            release(q, e, TX_STATUS_DROPPED);
+            continue;
+        }
+        if (!oldest || e->seq < oldest->seq) {
+            oldest = e;
+        }
+    }
+    if (oldest) {
+        oldest->in_flight = true;
+    }
+    return oldest;
+}
+
+void tx_queue_complete(TxQueue* q, TxEntry* entry, TxStatus status, uint32_t now_ms) {
+    if (status == TX_STATUS_SENT) {
+        uint32_t waited = now_ms - entry->enqueued_ms;
+        if (waited > q->stats.max_wait_ms) {
+            q->stats.max_wait_ms = waited;
+        }
+    }
+    release(q, entry, status);
+}
+
+void tx_queue_fail_all(TxQueue* q) {
+    for (int i = 0; i < TX_QUEUE_SLOTS; i++) {
+        if (q->slots[i].used && !q->slots[i].in_flight) {
+            release(q, &q->slots[i], TX_STATUS_FAILED);
+        }
+    }
+}
+
+void tx_queue_fail(TxQueue* q, TxDoneCallback done, void* ctx) {
+    q->stats.failed++;
+    add_completion(q, done, ctx, TX_STATUS_FAILED);
+}
+
+bool tx_queue_pop_completion(TxQueue* q, TxCompletion* completion) {
+    if (q->completion_count == 0) {
+        return false;
+    }
+    *completion = q->completions[q->completion_head];
+    q->completion_head = (q->completion_head + 1) % TX_QUEUE_COMPLETIONS;
+    q->completion_count--;
+    return true;
+}
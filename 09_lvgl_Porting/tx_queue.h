@@ -0,0 +1,91 @@
+/*
+ * TX Queue - Bounded outbound message queue for the BLE transmit task
+ * Producers enqueue and return immediately; the TX task sends entries in order
+ *
+ * Entries with a merge key are "latest wins": enqueueing a key that is already
+ * waiting replaces that entry's bytes in place, and such entries are dropped
+ * once their latest bytes have waited longer than TX_QUEUE_STALE_MS.
+ *
+ * Not thread-safe on its own - the caller serializes access (see bluetooth.cpp).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TX_QUEUE_SLOTS          16
+#define TX_QUEUE_SLOT_SIZE      512         // Largest message that can be queued
+#define TX_QUEUE_STALE_MS       3000        // Mergeable entries older than this are dropped
+#define TX_QUEUE_COMPLETIONS    (TX_QUEUE_SLOTS * 2)
+
+// Bytes needed for the slot pool passed to tx_queue_init()
+#define TX_QUEUE_POOL_SIZE      (TX_QUEUE_SLOTS * TX_QUEUE_SLOT_SIZE)
+
+typedef enum {
+    TX_STATUS_SENT,         // Every fragment was handed to the stack
+    TX_STATUS_MERGED,       // Replaced by a newer message with the same merge key
+    TX_STATUS_DROPPED,      // Queue full or entry went stale
+    TX_STATUS_FAILED        // Disconnected or the stack rejected the notification
+} TxStatus;
+
+typedef void (*TxDoneCallback)(TxStatus status, void* ctx);
+
+typedef struct {
+    uint8_t* data;              // TX_QUEUE_SLOT_SIZE bytes from the pool
+    uint16_t length;
+    uint32_t merge_key;         // 0 = never merged or dropped as stale
+    uint32_t seq;               // Enqueue order
+    uint32_t enqueued_ms;       // Of the latest bytes - a merge restarts it
+    TxDoneCallback done;
+    void* ctx;
+    bool used;
+    bool in_flight;             // Being sent - not touched by merges or drops
+} TxEntry;
+
+typedef struct {
+    TxDoneCallback done;
+    void* ctx;
+    TxStatus status;
+} TxCompletion;
+
+typedef struct {
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t merged;
+    uint32_t dropped;
+    uint32_t failed;
+    uint32_t depth;             // Entries waiting or in flight
+    uint32_t high_water;        // Deepest the queue has been
+    uint32_t max_wait_ms;       // Longest time from enqueue to sent
+} TxQueueStats;
+
+typedef struct {
+    TxEntry slots[TX_QUEUE_SLOTS];
+    uint32_t next_seq;
+    TxCompletion completions[TX_QUEUE_COMPLETIONS];
+    uint8_t completion_head;
+    uint8_t completion_count;
+    TxQueueStats stats;
+} TxQueue;
+
+// Pool must hold TX_QUEUE_POOL_SIZE bytes
+void tx_queue_init(TxQueue* q, uint8_t* pool);
+
+// Enqueue a copy of data. Returns false if it was dropped (too large, or full with nothing stale to evict).
+bool tx_queue_push(TxQueue* q, const uint8_t* data, size_t length, uint32_t merge_key,
+                   TxDoneCallback done, void* ctx, uint32_t now_ms);
+
+// Oldest waiting entry, marked in flight, or nullptr. Drops stale mergeable entries first.
+TxEntry* tx_queue_front(TxQueue* q, uint32_t now_ms);
+
+// Finish an in-flight entry and free its slot
+void tx_queue_complete(TxQueue* q, TxEntry* entry, TxStatus status, uint32_t now_ms);
+
+// Fail everything that is not in flight (used on disconnect)
+void tx_queue_fail_all(TxQueue* q);
+
+// Report a message that never got a slot as failed (sent while disconnected)
+void tx_queue_fail(TxQueue* q, TxDoneCallback done, void* ctx);
+
+// Completion callbacks are collected here and run by the caller outside its lock
+bool tx_queue_pop_completion(TxQueue* q, TxCompletion* completion);
@@ -4,6 +4,9 @@
  */
 #include "ui.h"
 #include "library_data.h"
+#include "playback_mailbox.h"
+#include "app_log.h"
+#include <esp_timer.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -54,7 +57,7 @@ static playback_state_t g_playback = {
 
 // Navigation state
 static screen_t g_current_screen = SCREEN_NOW_PLAYING;
-static uint8_t g_list_page = 0;
+static uint32_t g_list_page = 0;            // Wide enough for a song list of any length
 static const Playlist* g_selected_playlist = nullptr;
 static const Album* g_selected_album = nullptr;
 static const Artist* g_selected_artist = nullptr;
@@ -84,6 +87,10 @@ static char g_ble_song_album[128] = {0};
 static uint16_t g_ble_song_duration = 0;
 static bool g_using_ble_song = false;
 
+// Progress / play state currently on the Now Playing widgets
+static uint16_t g_shown_progress = 0;
+static bool g_shown_playing = false;
+
 // BLE detail screen state
 static char g_ble_detail_name[64] = {0};
 static char g_ble_detail_id[48] = {0};
@@ -101,6 +108,12 @@ static PlayCallback g_play_callback = nullptr;
 typedef void (*CommandCallback)(const char* command);
 static CommandCallback g_command_callback = nullptr;
 
+// Song window callback - the rows a long song list shows changed
+static UISongWindowCallback g_song_window_callback = nullptr;
+// Songs closed callback - the user left the song list
+static UISongsClosedCallback g_songs_closed_callback = nullptr;
+static lv_obj_t* g_ble_songs_screen = nullptr;     // The BLE songs screen while it exists
+
 // ============================================================================
 // FORWARD DECLARATIONS
 // ============================================================================
@@ -116,6 +129,7 @@ static void create_artist_albums_screen(const Artist* artist);
 static void create_ble_songs_screen(void);
 
 static void update_now_playing_display(void);
+static void update_progress_display(void);
 static void on_library_btn_click(lv_event_t* e);
 static void on_back_btn_click(lv_event_t* e);
 static void on_now_playing_btn_click(lv_event_t* e);
@@ -124,7 +138,9 @@ static void on_now_playing_btn_click(lv_event_t* e);
 // UI HELPERS
 // ============================================================================
 
-static lv_obj_t* create_header(const char* title, bool show_back, bool show_now_playing) {
+// on_title_click makes the title tappable (list screens use it to change the order)
+static lv_obj_t* create_header(const char* title, bool show_back, bool show_now_playing,
+                               lv_event_cb_t on_title_click = nullptr, void* title_user_data = nullptr) {
     lv_obj_t* header = lv_obj_create(g_screen);
     lv_obj_set_size(header, SCREEN_WIDTH, HEADER_HEIGHT);
     lv_obj_set_pos(header, 0, 0);
@@ -156,6 +172,11 @@ static lv_obj_t* create_header(const char* title, bool show_back, bool show_now_
     lv_obj_set_style_text_color(lbl_title, COLOR_PRIMARY, 0);
     lv_obj_set_style_text_font(lbl_title, &lv_font_montserrat_30, 0);
     lv_obj_align(lbl_title, LV_ALIGN_CENTER, 0, 0);
+    if (on_title_click) {
+        lv_obj_add_flag(lbl_title, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_ext_click_area(lbl_title, 20);
+        lv_obj_add_event_cb(lbl_title, on_title_click, LV_EVENT_CLICKED, title_user_data);
+    }
 
     // Now Playing button
     if (show_now_playing) {
@@ -176,8 +197,78 @@ static lv_obj_t* create_header(const char* title, bool show_back, bool show_now_
     return header;
 }
 
+// Order each BLE list is shown in, changed by tapping the list's title
+static LibraryOrder g_list_order[LIBRARY_COLLECTION_COUNT] = {
+    LIBRARY_ORDER_NAME,         // Playlists
+    LIBRARY_ORDER_NAME,         // Artists
+    LIBRARY_ORDER_NAME,         // Albums
+    LIBRARY_ORDER_ARRIVAL,      // Songs - the playlist's or album's own order
+};
+static const char* ORDER_LABELS[LIBRARY_ORDER_COUNT] = {"As sent", "A-Z", "Artist", "Year", "Track"};
+
+// Only a window of a long song list is held - sorting that would mislead, so it shows as sent
+static bool list_sortable(LibraryCollection collection) {
+    return collection != LIBRARY_SONGS || library_get_song_list_total() == library_get_song_count();
+}
+
+// Record shown at a list position of a BLE list
+static lib_index_t list_record(LibraryCollection collection, lib_index_t position) {
+    if (!list_sortable(collection)) return position;
+    return library_get_sorted_index(collection, g_list_order[collection], position);
+}
+
+// Boot to the first frame of a library list (playlists, albums or artists) with records
+// in it - with the flash snapshot this no longer waits for the app. Logged once.
+static bool g_first_list_frame_seen = false;
+
+static void on_first_list_frame(lv_event_t* e) {
+    if (g_first_list_frame_seen) return;
+    g_first_list_frame_seen = true;
+    LOGI(UI, "First library list frame %u ms after boot", (unsigned)(esp_timer_get_time() / 1000));
+}
+
+static void watch_first_list_frame(void) {
+    if (g_first_list_frame_seen || !library_has_ble_data()) return;
+    lv_obj_add_event_cb(g_screen, on_first_list_frame, LV_EVENT_DRAW_POST_END, nullptr);
+}
+
+static void on_list_order_click(lv_event_t* e) {
+    LibraryCollection collection = (LibraryCollection)(uintptr_t)lv_event_get_user_data(e);
+    LibraryOrder order = g_list_order[collection];
+    do {
+        order = (LibraryOrder)((order + 1) % LIBRARY_ORDER_COUNT);
+    } while (!library_supports_order(collection, order));
+    g_list_order[collection] = order;
+    g_list_page = 0;
+
+    switch (collection) {
+        case LIBRARY_PLAYLISTS:
+            create_playlists_screen();
+            break;
+        case LIBRARY_ARTISTS:
+            create_artists_screen();
+            break;
+        case LIBRARY_ALBUMS:
+            create_albums_screen();
+            break;
+        default:
+            create_ble_songs_screen();
+            break;
+    }
+}
+
+// Header of a list screen - with BLE data the title shows the order and changes it
+static lv_obj_t* create_list_header(const char* title, LibraryCollection collection) {
+    if ((!library_has_ble_data() && collection != LIBRARY_SONGS) || !list_sortable(collection)) {
+        return create_header(title, true, true);
+    }
+    static char text[96];
+    snprintf(text, sizeof(text), "%s  " LV_SYMBOL_LIST " %s", title, ORDER_LABELS[g_list_order[collection]]);
+    return create_header(text, true, true, on_list_order_click, (void*)(uintptr_t)collection);
+}
+
 // Creates side navigation buttons on left side (prev on top, next on bottom)
-static void create_side_navigation(uint8_t current_page, uint8_t total_pages,
+static void create_side_navigation(uint32_t current_page, uint32_t total_pages,
                                    void (*on_prev)(lv_event_t*),
                                    void (*on_next)(lv_event_t*)) {
     int content_height = SCREEN_HEIGHT - HEADER_HEIGHT;
@@ -370,9 +461,58 @@ static void update_now_playing_display(void) {
     } else {
         lv_obj_set_style_bg_color(g_np_btn_shuffle, COLOR_BUTTON_BG, 0);
     }
+
+    g_shown_progress = g_playback.progress_sec;
+    g_shown_playing = g_playback.is_playing;
+}
+
+// Only the widgets playback progress touches, skipped when nothing visible changed
+static void update_progress_display(void) {
+    if (!g_np_song_title) return;
+    if (g_playback.progress_sec == g_shown_progress && g_playback.is_playing == g_shown_playing) return;
+    g_shown_progress = g_playback.progress_sec;
+    g_shown_playing = g_playback.is_playing;
+
+    uint16_t duration = g_using_ble_song ? g_ble_song_duration
+                                         : (g_playback.current_song ? g_playback.current_song->duration_sec : 0);
+    if (duration > 0) {
+        lv_bar_set_value(g_np_progress_bar, (g_playback.progress_sec * 100) / duration, LV_ANIM_OFF);
+    }
+    lv_label_set_text(g_np_time_current, format_duration(g_playback.progress_sec));
+
+    lv_obj_t* play_lbl = lv_obj_get_child(g_np_btn_play, 0);
+    if (play_lbl) {
+        lv_label_set_text(play_lbl, g_playback.is_playing ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY);
+    }
+}
+
+// Copy the newest published progress into g_playback, true if there was one
+static bool take_playback_progress(void) {
+    PlaybackSnapshot snapshot;
+    if (!playback_mailbox_take(&snapshot)) return false;
+    g_playback.progress_sec = (uint16_t)(snapshot.elapsed_ms / 1000);
+    g_playback.is_playing = snapshot.is_playing;
+    return true;
+}
+
+// Runs once per frame in the LVGL task. Off Now Playing the value stays in the
+// mailbox and is picked up when the screen is shown again.
+static void on_progress_timer(lv_timer_t* timer) {
+    if (g_current_screen != SCREEN_NOW_PLAYING) return;
+    if (take_playback_progress()) {
+        update_progress_display();
+    }
+}
+
+// Ticks the library's frame count: library versions replaced by a sync are reused only
+// after this has run twice, so no list or search in between can still be reading them
+static void on_frame_timer(lv_timer_t* timer) {
+    library_note_frame();
 }
 
 static void create_now_playing_screen(void) {
+    take_playback_progress();
+
     lv_obj_t* old_screen = g_screen;
     g_screen = lv_obj_create(nullptr);
     lv_obj_set_style_bg_color(g_screen, COLOR_BG, 0);
@@ -559,6 +699,10 @@ static void on_artists_btn_click(lv_event_t* e) {
     ui_show_artists();
 }
 
+static void on_search_btn_click(lv_event_t* e) {
+    ui_show_search();
+}
+
 static void on_back_btn_click(lv_event_t* e) {
     // Navigate back based on current screen
     switch (g_current_screen) {
@@ -568,6 +712,7 @@ static void on_back_btn_click(lv_event_t* e) {
         case SCREEN_PLAYLISTS:
         case SCREEN_ALBUMS:
         case SCREEN_ARTISTS:
+        case SCREEN_SEARCH:
             ui_show_library();
             break;
         case SCREEN_PLAYLIST_DETAIL:
@@ -602,12 +747,12 @@ static void create_library_screen(void) {
 
     lv_obj_t* content = create_content_area();
 
-    // Three large buttons for navigation
+    // Three large buttons for navigation, search bar below
     int btn_width = 220;
-    int btn_height = 180;
+    int btn_height = 150;
     int spacing = 40;
     int start_x = (SCREEN_WIDTH - (3 * btn_width + 2 * spacing)) / 2;
-    int btn_y = (CONTENT_HEIGHT - btn_height) / 2 - 20;
+    int btn_y = 0;
 
     // Playlists button
     lv_obj_t* btn_playlists = lv_btn_create(content);
@@ -672,6 +817,21 @@ static void create_library_screen(void) {
     lv_obj_set_style_text_font(lbl_ar, &lv_font_montserrat_20, 0);
     lv_obj_align(lbl_ar, LV_ALIGN_CENTER, 0, 40);
 
+    // Search button
+    lv_obj_t* btn_search = lv_btn_create(content);
+    lv_obj_set_size(btn_search, 3 * btn_width + 2 * spacing, 60);
+    lv_obj_set_pos(btn_search, start_x - 20, btn_y + btn_height + 20);
+    lv_obj_set_style_bg_color(btn_search, COLOR_BUTTON_BG, 0);
+    lv_obj_set_style_bg_color(btn_search, COLOR_BUTTON_PRESS, LV_STATE_PRESSED);
+    lv_obj_set_style_radius(btn_search, 15, 0);
+    lv_obj_add_event_cb(btn_search, on_search_btn_click, LV_EVENT_CLICKED, nullptr);
+
+    lv_obj_t* lbl_search = lv_label_create(btn_search);
+    lv_label_set_text(lbl_search, LV_SYMBOL_EYE_OPEN "  Search");
+    lv_obj_set_style_text_color(lbl_search, COLOR_PRIMARY, 0);
+    lv_obj_set_style_text_font(lbl_search, &lv_font_montserrat_24, 0);
+    lv_obj_center(lbl_search);
+
     lv_scr_load(g_screen);
     if (old_screen != nullptr) {
         lv_obj_del(old_screen);
@@ -683,7 +843,7 @@ static void create_library_screen(void) {
 // PLAYLISTS SCREEN
 // ============================================================================
 
-static uint8_t get_playlists_count(void) {
+static lib_index_t get_playlists_count(void) {
     if (library_has_ble_data()) {
         return library_get_playlist_count();
     }
@@ -692,14 +852,14 @@ static uint8_t get_playlists_count(void) {
 
 static void on_playlist_click(lv_event_t* e) {
     uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
+    lib_index_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
 
     // Save selection for next time
     library_set_last_playlist_index(actual_index);
     library_save_selections();
 
     if (library_has_ble_data()) {
-        const BLEPlaylist* pl = library_get_playlist(actual_index);
+        const BLEPlaylist* pl = library_get_playlist(list_record(LIBRARY_PLAYLISTS, actual_index));
         if (pl) {
             strncpy(g_selected_ble_playlist_id, pl->id, sizeof(g_selected_ble_playlist_id) - 1);
             ui_show_ble_playlist_detail(pl->id, pl->name);
@@ -710,8 +870,8 @@ static void on_playlist_click(lv_event_t* e) {
 }
 
 static void on_playlists_prev(lv_event_t* e) {
-    uint8_t count = get_playlists_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_playlists_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page > 0) {
@@ -724,8 +884,8 @@ static void on_playlists_prev(lv_event_t* e) {
 }
 
 static void on_playlists_next(lv_event_t* e) {
-    uint8_t count = get_playlists_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_playlists_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page < total_pages - 1) {
@@ -742,10 +902,10 @@ static void create_playlists_screen(void) {
     g_screen = lv_obj_create(nullptr);
     lv_obj_set_style_bg_color(g_screen, COLOR_BG, 0);
 
-    create_header("Playlists", true, true);
+    create_list_header("Playlists", LIBRARY_PLAYLISTS);
 
-    uint8_t count = get_playlists_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_playlists_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_playlists_prev, on_playlists_next);
 
@@ -754,17 +914,17 @@ static void create_playlists_screen(void) {
     lv_obj_set_flex_align(content, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_row(content, LIST_ITEM_SPACING, 0);
 
-    uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-    uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
+    lib_index_t start_idx = g_list_page * ITEMS_PER_PAGE;
+    lib_index_t end_idx = start_idx + ITEMS_PER_PAGE;
     if (end_idx > count) end_idx = count;
 
-    for (uint8_t i = start_idx; i < end_idx; i++) {
+    for (lib_index_t i = start_idx; i < end_idx; i++) {
         static char subtitle[32];
         const char* name;
         uint16_t song_count;
 
         if (library_has_ble_data()) {
-            const BLEPlaylist* pl = library_get_playlist(i);
+            const BLEPlaylist* pl = library_get_playlist(list_record(LIBRARY_PLAYLISTS, i));
             name = pl ? pl->name : "Unknown";
             song_count = pl ? pl->song_count : 0;
         } else {
@@ -777,6 +937,7 @@ static void create_playlists_screen(void) {
         create_list_item(content, name, subtitle, i - start_idx, on_playlist_click);
     }
 
+    watch_first_list_frame();
     lv_scr_load(g_screen);
     if (old_screen != nullptr) {
         lv_obj_del(old_screen);
@@ -788,7 +949,7 @@ static void create_playlists_screen(void) {
 // ALBUMS SCREEN
 // ============================================================================
 
-static uint8_t get_albums_count(void) {
+static lib_index_t get_albums_count(void) {
     if (library_has_ble_data()) {
         return library_get_album_count();
     }
@@ -797,14 +958,14 @@ static uint8_t get_albums_count(void) {
 
 static void on_album_click(lv_event_t* e) {
     uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
+    lib_index_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
 
     // Save selection for next time
     library_set_last_album_index(actual_index);
     library_save_selections();
 
     if (library_has_ble_data()) {
-        const BLEAlbum* album = library_get_album(actual_index);
+        const BLEAlbum* album = library_get_album(list_record(LIBRARY_ALBUMS, actual_index));
         if (album) {
             strncpy(g_selected_ble_album_id, album->id, sizeof(g_selected_ble_album_id) - 1);
             g_selected_ble_artist_id[0] = '\0';  // Not from artist view
@@ -817,8 +978,8 @@ static void on_album_click(lv_event_t* e) {
 }
 
 static void on_albums_prev(lv_event_t* e) {
-    uint8_t count = get_albums_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_albums_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page > 0) {
@@ -831,8 +992,8 @@ static void on_albums_prev(lv_event_t* e) {
 }
 
 static void on_albums_next(lv_event_t* e) {
-    uint8_t count = get_albums_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_albums_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page < total_pages - 1) {
@@ -849,10 +1010,10 @@ static void create_albums_screen(void) {
     g_screen = lv_obj_create(nullptr);
     lv_obj_set_style_bg_color(g_screen, COLOR_BG, 0);
 
-    create_header("Albums", true, true);
+    create_list_header("Albums", LIBRARY_ALBUMS);
 
-    uint8_t count = get_albums_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_albums_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_albums_prev, on_albums_next);
 
@@ -861,18 +1022,18 @@ static void create_albums_screen(void) {
     lv_obj_set_flex_align(content, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_row(content, LIST_ITEM_SPACING, 0);
 
-    uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-    uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
+    lib_index_t start_idx = g_list_page * ITEMS_PER_PAGE;
+    lib_index_t end_idx = start_idx + ITEMS_PER_PAGE;
     if (end_idx > count) end_idx = count;
 
-    for (uint8_t i = start_idx; i < end_idx; i++) {
+    for (lib_index_t i = start_idx; i < end_idx; i++) {
         const char* name;
         const char* artist;
 
         if (library_has_ble_data()) {
-            const BLEAlbum* album = library_get_album(i);
+            const BLEAlbum* album = library_get_album(list_record(LIBRARY_ALBUMS, i));
             name = album ? album->name : "Unknown";
-            artist = album ? album->artist : "Unknown";
+            artist = album ? library_album_artist(album) : "Unknown";
         } else {
             const Album* album = ALL_ALBUMS[i];
             name = album->name;
@@ -882,6 +1043,7 @@ static void create_albums_screen(void) {
         create_list_item(content, name, artist, i - start_idx, on_album_click);
     }
 
+    watch_first_list_frame();
     lv_scr_load(g_screen);
     if (old_screen != nullptr) {
         lv_obj_del(old_screen);
@@ -893,7 +1055,7 @@ static void create_albums_screen(void) {
 // ARTISTS SCREEN
 // ============================================================================
 
-static uint8_t get_artists_count(void) {
+static lib_index_t get_artists_count(void) {
     if (library_has_ble_data()) {
         return library_get_artist_count();
     }
@@ -902,14 +1064,14 @@ static uint8_t get_artists_count(void) {
 
 static void on_artist_click(lv_event_t* e) {
     uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
+    lib_index_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
 
     // Save selection for next time
     library_set_last_artist_index(actual_index);
     library_save_selections();
 
     if (library_has_ble_data()) {
-        const BLEArtist* artist = library_get_artist(actual_index);
+        const BLEArtist* artist = library_get_artist(list_record(LIBRARY_ARTISTS, actual_index));
         if (artist) {
             strncpy(g_selected_ble_artist_id, artist->id, sizeof(g_selected_ble_artist_id) - 1);
             ui_show_ble_artist_albums(artist->id, artist->name);
@@ -920,8 +1082,8 @@ static void on_artist_click(lv_event_t* e) {
 }
 
 static void on_artists_prev(lv_event_t* e) {
-    uint8_t count = get_artists_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_artists_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page > 0) {
@@ -934,8 +1096,8 @@ static void on_artists_prev(lv_event_t* e) {
 }
 
 static void on_artists_next(lv_event_t* e) {
-    uint8_t count = get_artists_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_artists_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page < total_pages - 1) {
@@ -952,10 +1114,10 @@ static void create_artists_screen(void) {
     g_screen = lv_obj_create(nullptr);
     lv_obj_set_style_bg_color(g_screen, COLOR_BG, 0);
 
-    create_header("Artists", true, true);
+    create_list_header("Artists", LIBRARY_ARTISTS);
 
-    uint8_t count = get_artists_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    lib_index_t count = get_artists_count();
+    uint16_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_artists_prev, on_artists_next);
 
@@ -964,17 +1126,17 @@ static void create_artists_screen(void) {
     lv_obj_set_flex_align(content, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_row(content, LIST_ITEM_SPACING, 0);
 
-    uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-    uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
+    lib_index_t start_idx = g_list_page * ITEMS_PER_PAGE;
+    lib_index_t end_idx = start_idx + ITEMS_PER_PAGE;
     if (end_idx > count) end_idx = count;
 
-    for (uint8_t i = start_idx; i < end_idx; i++) {
+    for (lib_index_t i = start_idx; i < end_idx; i++) {
         static char subtitle[32];
         const char* name;
-        uint8_t album_count;
+        lib_index_t album_count;
 
         if (library_has_ble_data()) {
-            const BLEArtist* artist = library_get_artist(i);
+            const BLEArtist* artist = library_get_artist(list_record(LIBRARY_ARTISTS, i));
             name = artist ? artist->name : "Unknown";
             album_count = artist ? artist->album_count : 0;
         } else {
@@ -987,6 +1149,7 @@ static void create_artists_screen(void) {
         create_list_item(content, name, subtitle, i - start_idx, on_artist_click);
     }
 
+    watch_first_list_frame();
     lv_scr_load(g_screen);
     if (old_screen != nullptr) {
         lv_obj_del(old_screen);
@@ -1000,7 +1163,7 @@ static void create_artists_screen(void) {
 
 static void on_playlist_song_click(lv_event_t* e) {
     uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
+    lib_index_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
     if (g_selected_playlist && actual_index < g_selected_playlist->song_count) {
         g_playback.current_song = g_selected_playlist->songs[actual_index];
         g_playback.progress_sec = 0;
@@ -1018,7 +1181,7 @@ static void on_playlist_detail_prev(lv_event_t* e) {
 
 static void on_playlist_detail_next(lv_event_t* e) {
     if (g_selected_playlist) {
-        uint8_t total_pages = (g_selected_playlist->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+        uint16_t total_pages = (g_selected_playlist->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
         if (g_list_page < total_pages - 1) {
             g_list_page++;
             create_playlist_detail_screen(g_selected_playlist);
@@ -1033,7 +1196,7 @@ static void create_playlist_detail_screen(const Playlist* playlist) {
 
     create_header(playlist->name, true, true);
 
-    uint8_t total_pages = (playlist->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    uint16_t total_pages = (playlist->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_playlist_detail_prev, on_playlist_detail_next);
 
@@ -1042,11 +1205,11 @@ static void create_playlist_detail_screen(const Playlist* playlist) {
     lv_obj_set_flex_align(content, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_row(content, LIST_ITEM_SPACING, 0);
 
-    uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-    uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
+    lib_index_t start_idx = g_list_page * ITEMS_PER_PAGE;
+    lib_index_t end_idx = start_idx + ITEMS_PER_PAGE;
     if (end_idx > playlist->song_count) end_idx = playlist->song_count;
 
-    for (uint8_t i = start_idx; i < end_idx; i++) {
+    for (lib_index_t i = start_idx; i < end_idx; i++) {
         const Song* song = playlist->songs[i];
         static char subtitle[64];
         snprintf(subtitle, sizeof(subtitle), "%s - %s", song->artist, format_duration(song->duration_sec));
@@ -1066,7 +1229,7 @@ static void create_playlist_detail_screen(const Playlist* playlist) {
 
 static void on_album_song_click(lv_event_t* e) {
     uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
+    lib_index_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
     if (g_selected_album && actual_index < g_selected_album->song_count) {
         g_playback.current_song = g_selected_album->songs[actual_index];
         g_playback.progress_sec = 0;
@@ -1084,7 +1247,7 @@ static void on_album_detail_prev(lv_event_t* e) {
 
 static void on_album_detail_next(lv_event_t* e) {
     if (g_selected_album) {
-        uint8_t total_pages = (g_selected_album->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+        uint16_t total_pages = (g_selected_album->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
         if (g_list_page < total_pages - 1) {
             g_list_page++;
             create_album_detail_screen(g_selected_album);
@@ -1101,7 +1264,7 @@ static void create_album_detail_screen(const Album* album) {
     snprintf(header_text, sizeof(header_text), "%s", album->name);
     create_header(header_text, true, true);
 
-    uint8_t total_pages = (album->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    uint16_t total_pages = (album->song_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_album_detail_prev, on_album_detail_next);
 
@@ -1110,11 +1273,11 @@ static void create_album_detail_screen(const Album* album) {
     lv_obj_set_flex_align(content, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_row(content, LIST_ITEM_SPACING, 0);
 
-    uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-    uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
+    lib_index_t start_idx = g_list_page * ITEMS_PER_PAGE;
+    lib_index_t end_idx = start_idx + ITEMS_PER_PAGE;
     if (end_idx > album->song_count) end_idx = album->song_count;
 
-    for (uint8_t i = start_idx; i < end_idx; i++) {
+    for (lib_index_t i = start_idx; i < end_idx; i++) {
         const Song* song = album->songs[i];
         create_list_item(content, song->title, format_duration(song->duration_sec),
                         i - start_idx, on_album_song_click);
@@ -1133,7 +1296,7 @@ static void create_album_detail_screen(const Album* album) {
 
 static void on_artist_album_click(lv_event_t* e) {
     uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
+    lib_index_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
     if (g_selected_artist && actual_index < g_selected_artist->album_count) {
         ui_show_album_detail(g_selected_artist->albums[actual_index]);
     }
@@ -1148,7 +1311,7 @@ static void on_artist_albums_prev(lv_event_t* e) {
 
 static void on_artist_albums_next(lv_event_t* e) {
     if (g_selected_artist) {
-        uint8_t total_pages = (g_selected_artist->album_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+        uint16_t total_pages = (g_selected_artist->album_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
         if (g_list_page < total_pages - 1) {
             g_list_page++;
             create_artist_albums_screen(g_selected_artist);
@@ -1163,7 +1326,7 @@ static void create_artist_albums_screen(const Artist* artist) {
 
     create_header(artist->name, true, true);
 
-    uint8_t total_pages = (artist->album_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    uint16_t total_pages = (artist->album_count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_artist_albums_prev, on_artist_albums_next);
 
@@ -1172,11 +1335,11 @@ static void create_artist_albums_screen(const Artist* artist) {
     lv_obj_set_flex_align(content, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
     lv_obj_set_style_pad_row(content, LIST_ITEM_SPACING, 0);
 
-    uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-    uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
+    lib_index_t start_idx = g_list_page * ITEMS_PER_PAGE;
+    lib_index_t end_idx = start_idx + ITEMS_PER_PAGE;
     if (end_idx > artist->album_count) end_idx = artist->album_count;
 
-    for (uint8_t i = start_idx; i < end_idx; i++) {
+    for (lib_index_t i = start_idx; i < end_idx; i++) {
         const Album* album = artist->albums[i];
         static char subtitle[32];
         snprintf(subtitle, sizeof(subtitle), "%d songs", album->song_count);
@@ -1202,6 +1365,10 @@ void ui_init(void) {
 
     // Create and show the Now Playing screen
     create_now_playing_screen();
+
+    // Playback progress arrives through the mailbox, applied at most once per frame
+    lv_timer_create(on_progress_timer, LV_DISP_DEF_REFR_PERIOD, nullptr);
+    lv_timer_create(on_frame_timer, LV_DISP_DEF_REFR_PERIOD, nullptr);
 }
 
 void ui_show_screen(screen_t screen) {
@@ -1238,21 +1405,21 @@ void ui_show_library(void) {
 
 void ui_show_playlists(void) {
     // Start at page containing last selected item
-    uint8_t last_index = library_get_last_playlist_index();
+    lib_index_t last_index = library_get_last_playlist_index();
     g_list_page = last_index / ITEMS_PER_PAGE;
     create_playlists_screen();
 }
 
 void ui_show_albums(void) {
     // Start at page containing last selected item
-    uint8_t last_index = library_get_last_album_index();
+    lib_index_t last_index = library_get_last_album_index();
     g_list_page = last_index / ITEMS_PER_PAGE;
     create_albums_screen();
 }
 
 void ui_show_artists(void) {
     // Start at page containing last selected item
-    uint8_t last_index = library_get_last_artist_index();
+    lib_index_t last_index = library_get_last_artist_index();
     g_list_page = last_index / ITEMS_PER_PAGE;
     create_artists_screen();
 }
@@ -1369,6 +1536,14 @@ void ui_set_command_callback(UICommandCallback callback) {
     g_command_callback = (CommandCallback)callback;
 }
 
+void ui_set_song_window_callback(UISongWindowCallback callback) {
+    g_song_window_callback = callback;
+}
+
+void ui_set_songs_closed_callback(UISongsClosedCallback callback) {
+    g_songs_closed_callback = callback;
+}
+
 // ============================================================================
 // BLE DETAIL SCREENS
 // ============================================================================
@@ -1421,70 +1596,116 @@ void ui_show_ble_songs(void) {
     create_ble_songs_screen();
 }
 
-// BLE songs screen - shows songs from library_data
-static void on_ble_song_click(lv_event_t* e) {
-    uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
-    uint8_t actual_index = g_list_page * ITEMS_PER_PAGE + index;
-    const BLESong* song = library_get_song(actual_index);
+void ui_refresh_ble_songs(void) {
+    if (g_ble_songs_screen != nullptr && g_screen == g_ble_songs_screen) {
+        create_ble_songs_screen();
+    }
+}
+
+// Ask the app to play a song of the current song list (from the list or a search)
+static void play_ble_song(lib_index_t song_index) {
+    const BLESong* song = library_get_song(song_index);
 
     if (song) {
-        // Send play command to app
+        // Send play command to app - it indexes the whole list, not the window held
         if (g_play_callback) {
             const char* context = library_get_song_context_type();
             const char* context_id = library_get_song_context_id();
+            int list_index = library_get_song_window_start() + song_index;
             // Use context if available, otherwise pass NULL
             if (context && strlen(context) > 0) {
-                g_play_callback(song->id, context, context_id, actual_index);
+                g_play_callback(song->id, context, context_id, list_index);
             } else {
-                g_play_callback(song->id, nullptr, nullptr, actual_index);
+                g_play_callback(song->id, nullptr, nullptr, list_index);
             }
         }
 
         // Update UI immediately (will be updated again when app sends SONG_STARTED)
-        ui_set_song_info(song->title, song->artist, song->album, song->duration_sec);
+        ui_set_song_info(song->title, library_song_artist(song), library_song_album(song), song->duration_sec);
         ui_set_playing(true);
         ui_set_progress(0);
         ui_show_now_playing();
     }
 }
 
+// BLE songs screen - shows songs from library_data
+static void on_ble_song_click(lv_event_t* e) {
+    uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
+    uint32_t position = (uint32_t)g_list_page * ITEMS_PER_PAGE + index;
+    // Positions count the whole list; only the window from its start is held
+    uint32_t window_start = library_get_song_window_start();
+    if (position < window_start || position - window_start >= library_get_song_count()) return;
+    // The app indexes its queue in the order it sent, whatever order the list shows
+    play_ble_song(list_record(LIBRARY_SONGS, (lib_index_t)(position - window_start)));
+}
+
+// Tell the sketch which rows are on screen so the window follows them
+static void song_rows_shown(int direction) {
+    if (g_song_window_callback) {
+        g_song_window_callback((uint32_t)g_list_page * ITEMS_PER_PAGE, ITEMS_PER_PAGE, direction);
+    }
+}
+
 static void on_ble_songs_prev(lv_event_t* e) {
-    uint8_t count = library_get_song_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    uint32_t total = library_get_song_list_total();
+    uint32_t total_pages = (total + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page > 0) {
         g_list_page--;
+        song_rows_shown(-1);
     } else {
         // Wrap to last page
         g_list_page = total_pages - 1;
+        song_rows_shown(0);
     }
     create_ble_songs_screen();
 }
 
 static void on_ble_songs_next(lv_event_t* e) {
-    uint8_t count = library_get_song_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    uint32_t total = library_get_song_list_total();
+    uint32_t total_pages = (total + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
 
     if (g_list_page < total_pages - 1) {
         g_list_page++;
+        song_rows_shown(1);
     } else {
         // Wrap to first page
         g_list_page = 0;
+        song_rows_shown(0);
     }
     create_ble_songs_screen();
 }
 
+// A redraw replaces the screen before deleting the old one, so only leaving the list
+// deletes the current songs screen
+static void on_ble_songs_screen_delete(lv_event_t* e) {
+    if (lv_event_get_target(e) != g_ble_songs_screen) return;
+    g_ble_songs_screen = nullptr;
+    if (g_songs_closed_callback) g_songs_closed_callback();
+}
+
 static void create_ble_songs_screen(void) {
     lv_obj_t* old_screen = g_screen;
     g_screen = lv_obj_create(nullptr);
     lv_obj_set_style_bg_color(g_screen, COLOR_BG, 0);
-
-    create_header(g_ble_detail_name, true, true);
-
-    uint8_t count = library_get_song_count();
-    uint8_t total_pages = (count + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
+    g_ble_songs_screen = g_screen;
+    lv_obj_add_event_cb(g_screen, on_ble_songs_screen_delete, LV_EVENT_DELETE, nullptr);
+
+    create_list_header(g_ble_detail_name, LIBRARY_SONGS);
+
+    // Pages cover the whole list; rows outside the window held show until it moves there.
+    // Until the sketch has restored or loaded this screen's list, another one may be held.
+    uint32_t window_start, total;
+    lib_index_t count;
+    library_get_song_window(&window_start, &count, &total);
+    if (strcmp(library_get_song_context_type(), g_ble_detail_type) != 0 ||
+        strcmp(library_get_song_context_id(), g_ble_detail_id) != 0) {
+        count = 0;
+        total = 0;
+    }
+    uint32_t total_pages = (total + ITEMS_PER_PAGE - 1) / ITEMS_PER_PAGE;
     if (total_pages == 0) total_pages = 1;
     create_side_navigation(g_list_page, total_pages, on_ble_songs_prev, on_ble_songs_next);
 
@@ -1500,15 +1721,20 @@ static void create_ble_songs_screen(void) {
         lv_obj_set_style_text_color(lbl, COLOR_SECONDARY, 0);
         lv_obj_set_style_text_font(lbl, &lv_font_montserrat_24, 0);
     } else {
-        uint8_t start_idx = g_list_page * ITEMS_PER_PAGE;
-        uint8_t end_idx = start_idx + ITEMS_PER_PAGE;
-        if (end_idx > count) end_idx = count;
-
-        for (uint8_t i = start_idx; i < end_idx; i++) {
-            const BLESong* song = library_get_song(i);
+        uint32_t start_idx = (uint32_t)g_list_page * ITEMS_PER_PAGE;
+        uint32_t end_idx = start_idx + ITEMS_PER_PAGE;
+        if (end_idx > total) end_idx = total;
+
+        for (uint32_t i = start_idx; i < end_idx; i++) {
+            if (i < window_start || i - window_start >= count) {
+                lv_obj_t* item = create_list_item(content, "Loading...", nullptr, i - start_idx, on_ble_song_click);
+                lv_obj_add_state(item, LV_STATE_DISABLED);
+                continue;
+            }
+            const BLESong* song = library_get_song(list_record(LIBRARY_SONGS, (lib_index_t)(i - window_start)));
             if (song) {
                 static char subtitle[64];
-                snprintf(subtitle, sizeof(subtitle), "%s", song->artist);
+                snprintf(subtitle, sizeof(subtitle), "%s", library_song_artist(song));
                 create_list_item(content, song->title, subtitle, i - start_idx, on_ble_song_click);
             }
         }
@@ -1528,3 +1754,147 @@ static void create_ble_songs_screen(void) {
         g_current_screen = SCREEN_ARTIST_ALBUMS;
     }
 }
+
+// ============================================================================
+// SEARCH SCREEN
+// ============================================================================
+
+#define SEARCH_MAX_HITS         24
+#define SEARCH_KEYBOARD_HEIGHT  200
+
+static char g_search_query[MAX_NAME_LENGTH] = {0};     // Kept while a result is open
+static LibrarySearchHit g_search_hits[SEARCH_MAX_HITS];
+static uint16_t g_search_hit_count = 0;
+static lv_obj_t* g_search_results = nullptr;
+
+static void on_search_hit_click(lv_event_t* e) {
+    uint8_t index = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
+    if (index >= g_search_hit_count) return;
+    const LibrarySearchHit* hit = &g_search_hits[index];
+
+    switch (hit->collection) {
+        case LIBRARY_PLAYLISTS: {
+            const BLEPlaylist* pl = library_get_playlist(hit->record);
+            if (pl) ui_show_ble_playlist_detail(pl->id, pl->name);
+            break;
+        }
+        case LIBRARY_ARTISTS: {
+            const BLEArtist* artist = library_get_artist(hit->record);
+            if (artist) ui_show_ble_artist_albums(artist->id, artist->name);
+            break;
+        }
+        case LIBRARY_ALBUMS: {
+            const BLEAlbum* album = library_get_album(hit->record);
+            if (album) ui_show_ble_album_detail(album->id, album->name);
+            break;
+        }
+        default:
+            play_ble_song(hit->record);
+            break;
+    }
+}
+
+// Run the query and rebuild the result list - called on every keypress
+static void show_search_results(void) {
+    lv_obj_clean(g_search_results);
+    g_search_hit_count = library_search(g_search_query, g_search_hits, SEARCH_MAX_HITS);
+
+    if (g_search_hit_count == 0) {
+        lv_obj_t* lbl = lv_label_create(g_search_results);
+        if (!library_has_ble_data()) {
+            lv_label_set_text(lbl, "Connect to Amperfy to search the library");
+        } else {
+            lv_label_set_text(lbl, g_search_query[0] ? "No matches" : "Type to search");
+        }
+        lv_obj_set_style_text_color(lbl, COLOR_SECONDARY, 0);
+        lv_obj_set_style_text_font(lbl, &lv_font_montserrat_24, 0);
+        return;
+    }
+
+    for (uint16_t i = 0; i < g_search_hit_count; i++) {
+        const LibrarySearchHit* hit = &g_search_hits[i];
+        const char* name = "Unknown";
+        const char* subtitle = "";
+
+        if (hit->collection == LIBRARY_PLAYLISTS) {
+            const BLEPlaylist* pl = library_get_playlist(hit->record);
+            if (pl) name = pl->name;
+            subtitle = "Playlist";
+        } else if (hit->collection == LIBRARY_ARTISTS) {
+            const BLEArtist* artist = library_get_artist(hit->record);
+            if (artist) name = artist->name;
+            subtitle = "Artist";
+        } else if (hit->collection == LIBRARY_ALBUMS) {
+            const BLEAlbum* album = library_get_album(hit->record);
+            if (album) {
+                name = album->name;
+                subtitle = library_album_artist(album);
+            }
+        } else {
+            const BLESong* song = library_get_song(hit->record);
+            if (song) {
+                name = song->title;
+                subtitle = library_song_artist(song);
+            }
+        }
+        create_list_item(g_search_results, name, subtitle, (uint8_t)i, on_search_hit_click);
+    }
+}
+
+static void on_search_changed(lv_event_t* e) {
+    lv_obj_t* ta = lv_event_get_target(e);
+    strncpy(g_search_query, lv_textarea_get_text(ta), sizeof(g_search_query) - 1);
+    show_search_results();
+}
+
+static void create_search_screen(void) {
+    lv_obj_t* old_screen = g_screen;
+    g_screen = lv_obj_create(nullptr);
+    lv_obj_set_style_bg_color(g_screen, COLOR_BG, 0);
+
+    // Query field takes the title's place, between Back and Now Playing
+    lv_obj_t* header = create_header("", true, true);
+    lv_obj_t* ta = lv_textarea_create(header);
+    lv_textarea_set_one_line(ta, true);
+    lv_textarea_set_max_length(ta, sizeof(g_search_query) - 1);
+    lv_textarea_set_placeholder_text(ta, "Search");
+    lv_obj_set_size(ta, 330, 70);
+    lv_obj_align(ta, LV_ALIGN_CENTER, -40, 0);
+    lv_obj_set_style_bg_color(ta, COLOR_BUTTON_BG, 0);
+    lv_obj_set_style_border_width(ta, 0, 0);
+    lv_obj_set_style_text_color(ta, COLOR_PRIMARY, 0);
+    lv_obj_set_style_text_font(ta, &lv_font_montserrat_24, 0);
+    lv_textarea_set_text(ta, g_search_query);
+    lv_obj_add_state(ta, LV_STATE_FOCUSED);
+
+    g_search_results = lv_obj_create(g_screen);
+    lv_obj_set_size(g_search_results, SCREEN_WIDTH, SCREEN_HEIGHT - HEADER_HEIGHT - SEARCH_KEYBOARD_HEIGHT);
+    lv_obj_set_pos(g_search_results, 0, HEADER_HEIGHT);
+    lv_obj_set_style_bg_color(g_search_results, COLOR_BG, 0);
+    lv_obj_set_style_border_width(g_search_results, 0, 0);
+    lv_obj_set_style_radius(g_search_results, 0, 0);
+    lv_obj_set_style_pad_all(g_search_results, 10, 0);
+    lv_obj_set_style_pad_row(g_search_results, LIST_ITEM_SPACING, 0);
+    lv_obj_set_flex_flow(g_search_results, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_scroll_dir(g_search_results, LV_DIR_VER);
+
+    lv_obj_t* kb = lv_keyboard_create(g_screen);
+    lv_obj_set_size(kb, SCREEN_WIDTH, SEARCH_KEYBOARD_HEIGHT);
+    lv_obj_align(kb, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_text_font(kb, &lv_font_montserrat_24, 0);
+    lv_keyboard_set_textarea(kb, ta);
+
+    // Registered after the text is set, so only keypresses search
+    lv_obj_add_event_cb(ta, on_search_changed, LV_EVENT_VALUE_CHANGED, nullptr);
+    show_search_results();
+
+    lv_scr_load(g_screen);
+    if (old_screen != nullptr) {
+        lv_obj_del(old_screen);
+    }
+    g_current_screen = SCREEN_SEARCH;
+}
+
+void ui_show_search(void) {
+    create_search_screen();
+}
@@ -16,7 +16,8 @@ typedef enum {
     SCREEN_ARTISTS,
     SCREEN_PLAYLIST_DETAIL,
     SCREEN_ALBUM_DETAIL,
-    SCREEN_ARTIST_ALBUMS
+    SCREEN_ARTIST_ALBUMS,
+    SCREEN_SEARCH
 } screen_t;
 
 // Playback state
@@ -47,6 +48,8 @@ void ui_show_ble_playlist_detail(const char* playlist_id, const char* name);
 void ui_show_ble_album_detail(const char* album_id, const char* name);
 void ui_show_ble_artist_albums(const char* artist_id, const char* name);
 void ui_show_ble_songs(void);  // Shows songs after they're loaded from BLE
+void ui_refresh_ble_songs(void);  // Redraws the songs screen if it is showing (a window arrived)
+void ui_show_search(void);     // Name search over the BLE library
 
 // Update now playing information (called externally)
 void ui_set_current_song(const Song* song);
@@ -75,3 +78,12 @@ void ui_set_play_callback(UIPlayCallback callback);
 // Commands: "PLAY_PAUSE", "NEXT_SONG", "PREV_SONG"
 typedef void (*UICommandCallback)(const char* command);
 void ui_set_command_callback(UICommandCallback callback);
+
+// Song window callback - called when paging a song list shows rows first .. first + visible - 1
+// Parameters: first, visible, direction (-1 back, 1 forward, 0 a jump such as a wrap)
+typedef void (*UISongWindowCallback)(uint32_t first, uint32_t visible, int direction);
+void ui_set_song_window_callback(UISongWindowCallback callback);
+
+// Songs closed callback - called when the user leaves the BLE songs screen (not when it is redrawn)
+typedef void (*UISongsClosedCallback)(void);
+void ui_set_songs_closed_callback(UISongsClosedCallback callback);
@@ -33,6 +33,24 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
   private let logger = Logger(subsystem: "io.github.amperfy", category: "BluetoothComm")
   private var progressTimer: Timer?
   private var currentSongId: String?
+  private var nextMessageId: UInt16 = 0
+  private var reassembler = BluetoothReassembler()
+  private var linkCapabilities = BluetoothLinkCapabilities.legacy
+
+  // Library lists as last sent, kept across connections so a reconnecting device gets
+  // only what changed (v1.4)
+  private var playlistHistory = BluetoothListHistory<PlaylistInfo>()
+  private var artistHistory = BluetoothListHistory<ArtistInfo>()
+  private var albumHistory = BluetoothListHistory<AlbumInfo>()
+
+  // Queries being answered, by the id the device gave them (v1.6), counted because a
+  // repeat for missing pages reuses the id. A CANCEL removes one; its pages not sent yet
+  // are dropped.
+  private var activeRequests: [UInt32: Int] = [:]
+  // Fragments handed to CoreBluetooth and not acknowledged yet, and senders waiting for
+  // them to drain - pages go out one at a time, so a CANCEL finds the rest still unsent
+  private var writesInFlight = 0
+  private var writeWaiters: [(limit: Int, continuation: CheckedContinuation<Void, Never>)] = []
   
   // References to app components (to be injected)
   weak var player: PlayerFacade?
@@ -71,6 +89,14 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
     txCharacteristic = nil
     rxCharacteristic = nil
     currentSongId = nil
+    reassembler.reset()
+    linkCapabilities = .legacy
+    // Nobody is left to answer; senders still waiting on writes give up
+    activeRequests.removeAll()
+    writesInFlight = 0
+    let waiters = writeWaiters
+    writeWaiters.removeAll()
+    waiters.forEach { $0.continuation.resume() }
     logger.info("Cleaned up communication service after disconnect")
   }
   
@@ -148,23 +174,63 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
   
   // MARK: - Message Sending
   
-  private func sendMessage(_ message: BluetoothMessage) {
+  /// Writes a message, returns the fragments it took (0 if it could not be sent)
+  @discardableResult
+  private func sendMessage(_ message: BluetoothMessage) -> Int {
+    // Binary once the handshake agreed on it, JSON for everything without a binary layout
+    let binary = linkCapabilities.encoding == .tlv ? BluetoothBinaryCodec.encode(message) : nil
     guard let txCharacteristic = txCharacteristic,
           let peripheral = txCharacteristic.service?.peripheral,
-          let data = message.toData() else {
+          let data = binary ?? message.toData() else {
       logger.warning("Cannot send message: missing characteristic or peripheral")
-      return
+      return 0
     }
     
-    // Check if message is too large
-    if data.count > BluetoothProtocolConstants.maxMessageSize {
+    // Check if message is too large for the device to reassemble
+    if data.count > linkCapabilities.maxMessageSize {
       logger.error("Message too large: \(data.count) bytes")
       sendError(code: "MESSAGE_TOO_LARGE", message: "Message exceeds max size")
-      return
+      return 0
     }
-    
-    peripheral.writeValue(data, for: txCharacteristic, type: .withResponse)
-    logger.debug("Sent message: \(message.type.rawValue) (\(data.count) bytes)")
+
+    // ABP v1.0 devices never said HELLO and expect one unframed write per message
+    guard linkCapabilities.supportsFraming else {
+      peripheral.writeValue(data, for: txCharacteristic, type: .withResponse)
+      writesInFlight += 1
+      logger.debug("Sent message: \(message.type.rawValue) (\(data.count) bytes, unframed)")
+      return 1
+    }
+
+    // Split into fragments that each fit one write; writes with response are queued in order
+    let maxFrameSize = min(
+      peripheral.maximumWriteValueLength(for: .withResponse),
+      linkCapabilities.maxWriteLength
+    )
+    let frames = BluetoothFraming.fragments(of: data, messageId: nextMessageId, maxFrameSize: maxFrameSize)
+    nextMessageId &+= 1
+
+    for frame in frames {
+      peripheral.writeValue(frame, for: txCharacteristic, type: .withResponse)
+    }
+    writesInFlight += frames.count
+    logger.debug("Sent message: \(message.type.rawValue) (\(data.count) bytes, \(frames.count) fragments)")
+    return frames.count
+  }
+
+  /// Returns once at most `limit` written fragments still wait for their acknowledgement
+  private func writesDrained(to limit: Int) async {
+    guard writesInFlight > limit else { return }
+    await withCheckedContinuation { continuation in
+      writeWaiters.append((limit, continuation))
+    }
+  }
+
+  /// A write was acknowledged (didWriteValueFor); wakes the senders it drained enough for
+  private func writeCompleted() {
+    writesInFlight = max(writesInFlight - 1, 0)
+    let ready = writeWaiters.filter { writesInFlight <= $0.limit }
+    writeWaiters.removeAll { writesInFlight <= $0.limit }
+    ready.forEach { $0.continuation.resume() }
   }
   
   private func sendError(code: String, message: String) {
@@ -175,13 +241,19 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
   
   // MARK: - Message Receiving & Query Handling
   
-  private func handleReceivedData(_ data: Data) {
+  private func handleReceivedData(_ fragment: Data) {
+    // Notifications larger than the MTU arrive as fragments
+    guard let data = reassembler.feed(fragment) else { return }
+
     // Log raw data for debugging
     if let jsonString = String(data: data, encoding: .utf8) {
       logger.info("Received raw data: \(jsonString)")
     }
 
-    guard let message = BluetoothMessage.from(data: data) else {
+    let decoded = data.first == BluetoothBinaryCodec.magic
+      ? BluetoothBinaryCodec.decode(data)
+      : BluetoothMessage.from(data: data)
+    guard let message = decoded else {
       logger.error("Failed to decode received message")
       if let jsonString = String(data: data, encoding: .utf8) {
         logger.error("Raw data was: \(jsonString)")
@@ -192,13 +264,72 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
 
     logger.info("Received message type: \(message.type.rawValue)")
 
+    // The handshake does not need the library, answer it before the storage check
+    if message.type == .hello {
+      handleHello(message)
+      return
+    }
+
+    // Before any query task runs, so it applies to one already sending pages
+    if message.type == .cancel {
+      handleCancel(message)
+      return
+    }
+
+    // Registered now, so a CANCEL right behind the query finds it
+    let requestId = message.decode(as: QueryRequestPayload.self)?.requestId.flatMap { $0 == 0 ? nil : $0 }
+    if let requestId = requestId {
+      activeRequests[requestId, default: 0] += 1
+    }
+
     Task { @MainActor [weak self] in
       guard let self = self else { return }
-      await self.handleQuery(message)
+      await self.handleQuery(message, requestId: requestId)
+    }
+  }
+
+  /// CANCEL (v1.6): the device no longer waits for that query - e.g. the user left the
+  /// song list it was for - so the pages not sent yet are dropped
+  private func handleCancel(_ message: BluetoothMessage) {
+    guard let requestId = message.decode(as: CancelPayload.self)?.requestId else { return }
+    if activeRequests.removeValue(forKey: requestId) != nil {
+      logger.info("Request \(requestId) cancelled")
     }
   }
+
+  /// Whether a query is still to be answered; one without an id cannot be cancelled
+  private func isAnswering(_ requestId: UInt32?) -> Bool {
+    guard let requestId = requestId else { return true }
+    return activeRequests[requestId] != nil
+  }
+
+  private func finishRequest(_ requestId: UInt32?) {
+    guard let requestId = requestId, let count = activeRequests[requestId] else { return }
+    activeRequests[requestId] = count > 1 ? count - 1 : nil
+  }
   
-  private func handleQuery(_ message: BluetoothMessage) async {
+  private func handleHello(_ message: BluetoothMessage) {
+    guard let hello = message.decode(as: HelloPayload.self) else {
+      sendError(code: "INVALID_MESSAGE", message: "Could not decode HELLO")
+      return
+    }
+
+    let capabilities = BluetoothLinkCapabilities(hello: hello)
+    let payload = CapabilitiesPayload(
+      protocolVersion: BluetoothProtocolConstants.protocolVersion,
+      encoding: capabilities.encoding.rawValue,
+      pageBudget: capabilities.pageBudget
+    )
+    sendMessage(BluetoothMessage(type: .capabilities, payload: payload))
+
+    // Switch after sending, CAPABILITIES itself still goes out as one unframed write
+    linkCapabilities = capabilities
+
+    logger.info("Device HELLO v\(hello.protocolVersion): mtu=\(hello.mtu), maxMessage=\(hello.maxMessageSize), pageBudget=\(capabilities.pageBudget), encoding=\(capabilities.encoding.rawValue), maxDelta=\(capabilities.maxDeltaItems)")
+  }
+
+  private func handleQuery(_ message: BluetoothMessage, requestId: UInt32?) async {
+    defer { finishRequest(requestId) }
     let storageAvailable = self.storage != nil
     logger.info("Handling query: \(message.type.rawValue), storage available: \(storageAvailable)")
 
@@ -208,32 +339,47 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
       return
     }
     
+    // A device that missed pages asks for just those again; one holding a window of a
+    // long song list asks for the songs around it, one holding a library list names its
+    // revision
+    let pages = message.decode(as: QueryPagesPayload.self)?.pageRange
+    let slice = message.decode(as: QuerySlicePayload.self)
+    let revision = message.decode(as: QueryRevisionPayload.self)?.revision
+
     switch message.type {
     case .queryPlaylists:
-      await handleQueryPlaylists(storage: storage)
+      await handleQueryPlaylists(storage: storage, revision: revision, pages: pages, requestId: requestId)
       
     case .queryArtists:
-      await handleQueryArtists(storage: storage)
+      await handleQueryArtists(storage: storage, revision: revision, pages: pages, requestId: requestId)
       
     case .queryAlbums:
-      await handleQueryAlbums(storage: storage)
+      await handleQueryAlbums(storage: storage, revision: revision, pages: pages, requestId: requestId)
+
+    case .queryLibrary:
+      if let payload = message.decode(as: QueryLibraryPayload.self) {
+        await handleQueryLibrary(storage: storage, payload: payload, requestId: requestId)
+      }
       
     case .querySongs:
-      await handleQuerySongs(storage: storage)
+      await handleQuerySongs(storage: storage, slice: slice, pages: pages, requestId: requestId)
       
     case .queryPlaylistSongs:
       if let payload = message.decode(as: QueryPlaylistSongsPayload.self) {
-        await handleQueryPlaylistSongs(storage: storage, playlistId: payload.playlistId)
+        await handleQueryPlaylistSongs(
+          storage: storage, playlistId: payload.playlistId, slice: slice, pages: pages, requestId: requestId)
       }
       
     case .queryArtistSongs:
       if let payload = message.decode(as: QueryArtistSongsPayload.self) {
-        await handleQueryArtistSongs(storage: storage, artistId: payload.artistId)
+        await handleQueryArtistSongs(
+          storage: storage, artistId: payload.artistId, slice: slice, pages: pages, requestId: requestId)
       }
       
     case .queryAlbumSongs:
       if let payload = message.decode(as: QueryAlbumSongsPayload.self) {
-        await handleQueryAlbumSongs(storage: storage, albumId: payload.albumId)
+        await handleQueryAlbumSongs(
+          storage: storage, albumId: payload.albumId, slice: slice, pages: pages, requestId: requestId)
       }
 
     case .playSong:
@@ -257,15 +403,121 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
   
   // MARK: - Query Handlers
 
-  // Items per page to fit within 512 byte BLE message limit
-  // Songs have more fields so need fewer per page
-  private let playlistsPerPage = 4
-  private let artistsPerPage = 4
-  private let albumsPerPage = 3
-  private let songsPerPage = 2  // Songs have the most data per item
-  private let delayBetweenPages: UInt64 = 50_000_000  // 50ms in nanoseconds
+  // Pages are filled by encoded size up to the budget derived from the device's HELLO,
+  // and never carry more items than the device said it can hold. Every page says where
+  // it sits in the whole list (offset, totalItems), so a device can ask again for just
+  // the pages it missed (`pages`, nil for all of them).
+  //
+  // Playlists, artists and albums carry a revision for devices that take deltas (v1.4).
+  // A device naming a revision still in the history gets the changes since, or a
+  // single empty page when there are none.
+  //
+  // Every page echoes the query's request id (v1.6) and goes out once the page before it
+  // was written, so the device drops pages of a query it moved on from unread, and a
+  // CANCEL stops the pages not sent yet instead of a whole list queued in CoreBluetooth.
+
+  /// The list, or its changes since base, and the revision the device holds after
+  /// applying them; the whole list without a revision for devices before v1.4
+  private func listAnswer<Item: BluetoothListItem>(
+    _ items: [Item], capacity: Int, base: UInt32?, history: inout BluetoothListHistory<Item>
+  ) -> (items: [Item], revision: UInt32?, delta: Bool?) {
+    guard linkCapabilities.maxDeltaItems > 0 else { return (items, nil, nil) }
+    // Revisions are of what the device can hold, as paginate() cuts it
+    let answer = history.answer(
+      Array(items.prefix(capacity)), base: base, maxDelta: min(linkCapabilities.maxDeltaItems, capacity)
+    )
+    return (answer.items, answer.revision, answer.delta)
+  }
+
+  private func handleQueryPlaylists(
+    storage: LibraryStorage, revision base: UInt32?, pages requested: ClosedRange<Int>?, requestId: UInt32?
+  ) async {
+    await sendPages(playlistPages(storage: storage, base: base, limit: nil, requestId: requestId), pages: requested,
+                    requestId: requestId)
+  }
+
+  private func handleQueryArtists(
+    storage: LibraryStorage, revision base: UInt32?, pages requested: ClosedRange<Int>?, requestId: UInt32?
+  ) async {
+    await sendPages(artistPages(storage: storage, base: base, limit: nil, requestId: requestId), pages: requested,
+                    requestId: requestId)
+  }
+
+  private func handleQueryAlbums(
+    storage: LibraryStorage, revision base: UInt32?, pages requested: ClosedRange<Int>?, requestId: UInt32?
+  ) async {
+    await sendPages(albumPages(storage: storage, base: base, limit: nil, requestId: requestId), pages: requested,
+                    requestId: requestId)
+  }
+
+  /// One stream for several lists (v1.5): a page of each in turn, so every list starts
+  /// arriving at once and the device is not left waiting on one long list for the others.
+  /// The response types tell the device which list a page belongs to.
+  private func handleQueryLibrary(storage: LibraryStorage, payload: QueryLibraryPayload, requestId: UInt32?) async {
+    var streams: [[BluetoothMessage]] = []
+    for request in payload.collections {
+      switch request.collection {
+      case "playlists":
+        streams.append(playlistPages(storage: storage, base: request.revision, limit: request.limit, requestId: requestId))
+      case "artists":
+        streams.append(artistPages(storage: storage, base: request.revision, limit: request.limit, requestId: requestId))
+      case "albums":
+        streams.append(albumPages(storage: storage, base: request.revision, limit: request.limit, requestId: requestId))
+      default:
+        logger.warning("QUERY_LIBRARY: unknown collection \(request.collection)")
+      }
+    }
+
+    var interleaved: [BluetoothMessage] = []
+    let longest = streams.map(\.count).max() ?? 0
+    for index in 0..<longest {
+      for stream in streams where index < stream.count {
+        interleaved.append(stream[index])
+      }
+    }
+    let sent = await sendPages(interleaved, pages: nil, requestId: requestId)
+    logger.info("Sent \(sent) of \(interleaved.count) pages of \(streams.count) lists interleaved")
+  }
+
+  /// Sends a response's pages in order, only those requested (nil for all of them), each
+  /// once the one before it was written. Stops when the query is cancelled; returns the
+  /// pages sent.
+  @discardableResult
+  private func sendPages(_ pages: [BluetoothMessage], pages requested: ClosedRange<Int>?, requestId: UInt32?) async -> Int {
+    var sent = 0
+    var lastFrames = 0
+    for (page, message) in pages.enumerated() {
+      if let requested = requested, !requested.contains(page + 1) { continue }
+      if lastFrames > 0 {
+        await writesDrained(to: lastFrames)
+      }
+      guard isAnswering(requestId) else {
+        logger.info("Request \(requestId ?? 0) cancelled after \(sent) pages")
+        break
+      }
+      lastFrames = sendMessage(message)
+      sent += 1
+      logger.debug("Sent \(message.type.rawValue) page \(page + 1)/\(pages.count)")
+    }
+    return sent
+  }
 
-  private func handleQueryPlaylists(storage: LibraryStorage) async {
+  /// Items of a list a device can take: what it can hold, or fewer if it asked for fewer
+  private func listCapacity(_ capacity: Int, limit: Int?) -> Int {
+    guard let limit = limit, limit > 0 else { return capacity }
+    return min(capacity, limit)
+  }
+
+  /// Items paginated for the device; what it cannot hold is left out, and said so
+  private func pageItems<Item: Encodable>(_ items: [Item], capacity: Int, of list: String) -> [[Item]] {
+    let paginated = linkCapabilities.paginate(items, capacity: capacity)
+    if paginated.truncated > 0 {
+      logger.warning("Device holds \(capacity) \(list): \(paginated.truncated) of \(items.count) not sent")
+    }
+    return paginated.pages
+  }
+
+  private func playlistPages(storage: LibraryStorage, base: UInt32?, limit: Int?, requestId: UInt32?) -> [BluetoothMessage] {
     let playlists = storage.getAllPlaylists(areSystemPlaylistsIncluded: false)
     let playlistInfos = playlists.map { playlist in
       PlaylistInfo(
@@ -275,36 +527,30 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
       )
     }
 
-    await sendPaginatedPlaylists(playlistInfos)
-    logger.info("Sent all \(playlistInfos.count) playlists")
-  }
-
-  private func sendPaginatedPlaylists(_ items: [PlaylistInfo]) async {
-    let perPage = playlistsPerPage
-    let totalPages = max(1, (items.count + perPage - 1) / perPage)
-
-    for page in 0..<totalPages {
-      let start = page * perPage
-      let end = min(start + perPage, items.count)
-      let pageItems = Array(items[start..<end])
+    let capacity = listCapacity(linkCapabilities.capacities.playlists, limit: limit)
+    let answer = listAnswer(playlistInfos, capacity: capacity, base: base, history: &playlistHistory)
+    let pages = pageItems(answer.items, capacity: capacity, of: "playlists")
+    let totalItems = pages.reduce(0) { $0 + $1.count }
+    var offset = 0
+    logger.info("Paginated \(answer.delta == true ? "changes to" : "all") \(playlistInfos.count) playlists: \(totalItems) items")
 
+    return pages.enumerated().map { page, pageItems in
+      defer { offset += pageItems.count }
       let payload = PlaylistsResponsePayload(
         playlists: pageItems,
         page: page + 1,
-        totalPages: totalPages
+        totalPages: pages.count,
+        offset: offset,
+        totalItems: totalItems,
+        revision: answer.revision,
+        delta: answer.delta,
+        requestId: requestId
       )
-      let message = BluetoothMessage(type: .playlistsResponse, payload: payload)
-      sendMessage(message)
-
-      logger.debug("Sent playlists page \(page + 1)/\(totalPages)")
-
-      if page < totalPages - 1 {
-        try? await Task.sleep(nanoseconds: delayBetweenPages)
-      }
+      return BluetoothMessage(type: .playlistsResponse, payload: payload)
     }
   }
 
-  private func handleQueryArtists(storage: LibraryStorage) async {
+  private func artistPages(storage: LibraryStorage, base: UInt32?, limit: Int?, requestId: UInt32?) -> [BluetoothMessage] {
     let artists = storage.getAllArtists()
     let artistInfos = artists.map { artist in
       ArtistInfo(
@@ -315,36 +561,30 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
       )
     }
 
-    await sendPaginatedArtists(artistInfos)
-    logger.info("Sent all \(artistInfos.count) artists")
-  }
-
-  private func sendPaginatedArtists(_ items: [ArtistInfo]) async {
-    let perPage = artistsPerPage
-    let totalPages = max(1, (items.count + perPage - 1) / perPage)
-
-    for page in 0..<totalPages {
-      let start = page * perPage
-      let end = min(start + perPage, items.count)
-      let pageItems = Array(items[start..<end])
+    let capacity = listCapacity(linkCapabilities.capacities.artists, limit: limit)
+    let answer = listAnswer(artistInfos, capacity: capacity, base: base, history: &artistHistory)
+    let pages = pageItems(answer.items, capacity: capacity, of: "artists")
+    let totalItems = pages.reduce(0) { $0 + $1.count }
+    var offset = 0
+    logger.info("Paginated \(answer.delta == true ? "changes to" : "all") \(artistInfos.count) artists: \(totalItems) items")
 
+    return pages.enumerated().map { page, pageItems in
+      defer { offset += pageItems.count }
       let payload = ArtistsResponsePayload(
         artists: pageItems,
         page: page + 1,
-        totalPages: totalPages
+        totalPages: pages.count,
+        offset: offset,
+        totalItems: totalItems,
+        revision: answer.revision,
+        delta: answer.delta,
+        requestId: requestId
       )
-      let message = BluetoothMessage(type: .artistsResponse, payload: payload)
-      sendMessage(message)
-
-      logger.debug("Sent artists page \(page + 1)/\(totalPages)")
-
-      if page < totalPages - 1 {
-        try? await Task.sleep(nanoseconds: delayBetweenPages)
-      }
+      return BluetoothMessage(type: .artistsResponse, payload: payload)
     }
   }
 
-  private func handleQueryAlbums(storage: LibraryStorage) async {
+  private func albumPages(storage: LibraryStorage, base: UInt32?, limit: Int?, requestId: UInt32?) -> [BluetoothMessage] {
     let albums = storage.getAllAlbums()
     let albumInfos = albums.map { album in
       AlbumInfo(
@@ -356,71 +596,74 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
       )
     }
 
-    await sendPaginatedAlbums(albumInfos)
-    logger.info("Sent all \(albumInfos.count) albums")
-  }
-
-  private func sendPaginatedAlbums(_ items: [AlbumInfo]) async {
-    let perPage = albumsPerPage
-    let totalPages = max(1, (items.count + perPage - 1) / perPage)
-
-    for page in 0..<totalPages {
-      let start = page * perPage
-      let end = min(start + perPage, items.count)
-      let pageItems = Array(items[start..<end])
+    let capacity = listCapacity(linkCapabilities.capacities.albums, limit: limit)
+    let answer = listAnswer(albumInfos, capacity: capacity, base: base, history: &albumHistory)
+    let pages = pageItems(answer.items, capacity: capacity, of: "albums")
+    let totalItems = pages.reduce(0) { $0 + $1.count }
+    var offset = 0
+    logger.info("Paginated \(answer.delta == true ? "changes to" : "all") \(albumInfos.count) albums: \(totalItems) items")
 
+    return pages.enumerated().map { page, pageItems in
+      defer { offset += pageItems.count }
       let payload = AlbumsResponsePayload(
         albums: pageItems,
         page: page + 1,
-        totalPages: totalPages
+        totalPages: pages.count,
+        offset: offset,
+        totalItems: totalItems,
+        revision: answer.revision,
+        delta: answer.delta,
+        requestId: requestId
       )
-      let message = BluetoothMessage(type: .albumsResponse, payload: payload)
-      sendMessage(message)
-
-      logger.debug("Sent albums page \(page + 1)/\(totalPages)")
-
-      if page < totalPages - 1 {
-        try? await Task.sleep(nanoseconds: delayBetweenPages)
-      }
+      return BluetoothMessage(type: .albumsResponse, payload: payload)
     }
   }
 
-  private func handleQuerySongs(storage: LibraryStorage) async {
+  private func handleQuerySongs(
+    storage: LibraryStorage, slice: QuerySlicePayload?, pages requested: ClosedRange<Int>?, requestId: UInt32?
+  ) async {
     let songs = storage.getAllSongs()
-    let songInfos = songs.map { createSongInfo(from: $0) }
-
-    await sendPaginatedSongs(songInfos, context: nil, contextId: nil)
-    logger.info("Sent all \(songInfos.count) songs")
-  }
-
-  private func sendPaginatedSongs(_ items: [SongInfo], context: String?, contextId: String?) async {
-    let perPage = songsPerPage
-    let totalPages = max(1, (items.count + perPage - 1) / perPage)
-
-    for page in 0..<totalPages {
-      let start = page * perPage
-      let end = min(start + perPage, items.count)
-      let pageItems = Array(items[start..<end])
 
+    let sent = await sendPaginatedSongs(
+      songs, context: nil, contextId: nil, slice: slice, pages: requested, requestId: requestId)
+    logger.info("Sent \(sent) of \(songs.count) songs")
+  }
+
+  /// Paginates the requested slice of songs (all of them without one); offsets count from
+  /// the start of the whole list and totalItems is its length. Returns the songs paginated.
+  private func sendPaginatedSongs(
+    _ songs: [Song], context: String?, contextId: String?, slice: QuerySlicePayload?,
+    pages requested: ClosedRange<Int>?, requestId: UInt32?
+  ) async -> Int {
+    let range = slice?.itemRange(count: songs.count) ?? 0..<songs.count
+    let items = songs[range].map { createSongInfo(from: $0) }
+    let pages = pageItems(items, capacity: linkCapabilities.capacities.songs, of: "songs")
+    // Still the whole list's length: a device holding a window asks for the rest by offset
+    let totalItems = songs.count
+    var offset = range.lowerBound
+
+    let messages = pages.enumerated().map { page, pageItems in
+      defer { offset += pageItems.count }
       let payload = SongsResponsePayload(
         songs: pageItems,
         context: context,
         contextId: contextId,
         page: page + 1,
-        totalPages: totalPages
+        totalPages: pages.count,
+        offset: offset,
+        totalItems: totalItems,
+        requestId: requestId
       )
-      let message = BluetoothMessage(type: .songsResponse, payload: payload)
-      sendMessage(message)
-
-      logger.debug("Sent songs page \(page + 1)/\(totalPages)")
-
-      if page < totalPages - 1 {
-        try? await Task.sleep(nanoseconds: delayBetweenPages)
-      }
+      return BluetoothMessage(type: .songsResponse, payload: payload)
     }
+    await sendPages(messages, pages: requested, requestId: requestId)
+    return items.count
   }
 
-  private func handleQueryPlaylistSongs(storage: LibraryStorage, playlistId: String) async {
+  private func handleQueryPlaylistSongs(
+    storage: LibraryStorage, playlistId: String, slice: QuerySlicePayload?, pages requested: ClosedRange<Int>?,
+    requestId: UInt32?
+  ) async {
     let playlists = storage.getAllPlaylists(areSystemPlaylistsIncluded: true)
     guard let playlist = playlists.first(where: { $0.id == playlistId }) else {
       sendError(code: "PLAYLIST_NOT_FOUND", message: "Playlist with ID \(playlistId) not found")
@@ -428,13 +671,16 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
     }
 
     let songs = playlist.playables.compactMap { $0 as? Song }
-    let songInfos = songs.map { createSongInfo(from: $0) }
 
-    await sendPaginatedSongs(songInfos, context: "playlist", contextId: playlistId)
-    logger.info("Sent all \(songInfos.count) songs from playlist \(playlist.name)")
+    let sent = await sendPaginatedSongs(
+      songs, context: "playlist", contextId: playlistId, slice: slice, pages: requested, requestId: requestId)
+    logger.info("Sent \(sent) of \(songs.count) songs from playlist \(playlist.name)")
   }
 
-  private func handleQueryArtistSongs(storage: LibraryStorage, artistId: String) async {
+  private func handleQueryArtistSongs(
+    storage: LibraryStorage, artistId: String, slice: QuerySlicePayload?, pages requested: ClosedRange<Int>?,
+    requestId: UInt32?
+  ) async {
     let artists = storage.getAllArtists()
     guard let artist = artists.first(where: { $0.id == artistId }) else {
       sendError(code: "ARTIST_NOT_FOUND", message: "Artist with ID \(artistId) not found")
@@ -442,13 +688,16 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
     }
 
     let songs = artist.songs.compactMap { $0 as? Song }
-    let songInfos = songs.map { createSongInfo(from: $0) }
 
-    await sendPaginatedSongs(songInfos, context: "artist", contextId: artistId)
-    logger.info("Sent all \(songInfos.count) songs from artist \(artist.name)")
+    let sent = await sendPaginatedSongs(
+      songs, context: "artist", contextId: artistId, slice: slice, pages: requested, requestId: requestId)
+    logger.info("Sent \(sent) of \(songs.count) songs from artist \(artist.name)")
   }
 
-  private func handleQueryAlbumSongs(storage: LibraryStorage, albumId: String) async {
+  private func handleQueryAlbumSongs(
+    storage: LibraryStorage, albumId: String, slice: QuerySlicePayload?, pages requested: ClosedRange<Int>?,
+    requestId: UInt32?
+  ) async {
     let albums = storage.getAllAlbums()
     guard let album = albums.first(where: { $0.id == albumId }) else {
       sendError(code: "ALBUM_NOT_FOUND", message: "Album with ID \(albumId) not found")
@@ -456,10 +705,10 @@ class BluetoothCommunicationService: NSObject, ObservableObject {
     }
 
     let songs = album.songs.compactMap { $0 as? Song }
-    let songInfos = songs.map { createSongInfo(from: $0) }
 
-    await sendPaginatedSongs(songInfos, context: "album", contextId: albumId)
-    logger.info("Sent all \(songInfos.count) songs from album \(album.name)")
+    let sent = await sendPaginatedSongs(
+      songs, context: "album", contextId: albumId, slice: slice, pages: requested, requestId: requestId)
+    logger.info("Sent \(sent) of \(songs.count) songs from album \(album.name)")
   }
 
   // MARK: - Playback Command Handlers
@@ -649,6 +898,8 @@ extension BluetoothCommunicationService: CBPeripheralDelegate {
       if let error = error {
         logger.error("Error writing characteristic: \(error.localizedDescription)")
       }
+      // Failed or not, the write left the queue
+      writeCompleted()
     }
   }
 }
@@ -23,8 +23,9 @@ import Foundation
 
 // MARK: - Amperfy Bluetooth Protocol (ABP)
 
-/// Protocol version 1.0
-/// All messages are JSON-encoded and sent as UTF-8 data
+/// Protocol version 1.1
+/// Messages are JSON-encoded UTF-8, or TLV once both sides agree (see `BluetoothBinaryCodec`),
+/// and are split into fragments (see `BluetoothFraming`)
 
 // MARK: - Message Types
 
@@ -34,6 +35,10 @@ enum MessageType: String, Codable {
   case songStopped = "SONG_STOPPED"
   case playbackProgress = "PLAYBACK_PROGRESS"
 
+  // Handshake
+  case hello = "HELLO"  // Device -> App, right after subscribing
+  case capabilities = "CAPABILITIES"  // App -> Device, answer to HELLO
+
   // Device -> App queries
   case queryPlaylists = "QUERY_PLAYLISTS"
   case queryArtists = "QUERY_ARTISTS"
@@ -42,6 +47,8 @@ enum MessageType: String, Codable {
   case queryPlaylistSongs = "QUERY_PLAYLIST_SONGS"
   case queryArtistSongs = "QUERY_ARTIST_SONGS"
   case queryAlbumSongs = "QUERY_ALBUM_SONGS"
+  case queryLibrary = "QUERY_LIBRARY"  // Several library lists in one interleaved response stream (v1.5)
+  case cancel = "CANCEL"  // Stop sending the pages of a query (v1.6)
 
   // Device -> App commands
   case playSong = "PLAY_SONG"
@@ -87,20 +94,26 @@ struct BluetoothMessage {
     return try? JSONDecoder().decode(type, from: payloadData)
   }
   
-  /// Converts the message to JSON data with payload as a nested JSON object (not base64)
+  /// Converts the message to JSON data with payload as a nested JSON object (not base64).
+  /// "type" goes first: the device reads it and stops, so a page is only walked by the
+  /// handler that reads it (a dictionary would put the keys in any order).
   func toData() -> Data? {
-    var dict: [String: Any] = [
-      "type": type.rawValue,
-      "timestamp": timestamp
-    ]
-    
-    // If we have a payload, decode it to a JSON object and embed it directly
-    if let payloadData = payloadData,
-       let payloadObject = try? JSONSerialization.jsonObject(with: payloadData, options: []) {
-      dict["payload"] = payloadObject
+    guard let typeData = try? JSONSerialization.data(withJSONObject: type.rawValue, options: [.fragmentsAllowed]),
+          let timestampData = try? JSONSerialization.data(withJSONObject: timestamp, options: [.fragmentsAllowed]) else {
+      return nil
     }
-    
-    return try? JSONSerialization.data(withJSONObject: dict, options: [])
+    var data = Data("{\"type\":".utf8)
+    data.append(typeData)
+    data.append(Data(",\"timestamp\":".utf8))
+    data.append(timestampData)
+
+    // The encoded payload is already a JSON object - embed it as is
+    if let payloadData = payloadData {
+      data.append(Data(",\"payload\":".utf8))
+      data.append(payloadData)
+    }
+    data.append(Data("}".utf8))
+    return data
   }
   
   /// Parses a message from JSON data with payload as a nested JSON object
@@ -121,6 +134,31 @@ struct BluetoothMessage {
   }
 }
 
+// MARK: - Handshake Payloads
+
+struct CollectionCapacities: Codable {
+  let playlists: Int
+  let artists: Int
+  let albums: Int
+  let songs: Int
+}
+
+struct HelloPayload: Codable {
+  let protocolVersion: String
+  let mtu: Int  // Negotiated ATT MTU
+  let maxMessageSize: Int  // Largest reassembled message the device can parse
+  let maxWriteLength: Int  // Largest single write (one fragment) the device accepts
+  let capacities: CollectionCapacities  // How many items the device can hold per collection
+  let encodings: [String]
+  let maxDeltaItems: Int?  // Delta entries the device can stage per list (v1.4), absent = no deltas
+}
+
+struct CapabilitiesPayload: Codable {
+  let protocolVersion: String
+  let encoding: String  // Encoding the app will use for this connection
+  let pageBudget: Int  // Bytes of list items the app puts in one response page
+}
+
 // MARK: - Event Payloads
 
 struct SongStartedPayload: Codable {
@@ -146,16 +184,82 @@ struct PlaybackProgressPayload: Codable {
 
 // MARK: - Query Payloads
 
+/// Pages of the response a query asks for (v1.2). Absent means all of them; a device
+/// sends a range to ask again for pages it missed.
+struct QueryPagesPayload: Codable {
+  let firstPage: Int?
+  let lastPage: Int?
+
+  /// 1-based page range, nil for the whole response
+  var pageRange: ClosedRange<Int>? {
+    guard let firstPage = firstPage, firstPage > 0 else { return nil }
+    return firstPage...max(firstPage, lastPage ?? Int.max)
+  }
+}
+
+/// Slice of a song list a query asks for (v1.3). Absent means the whole list; a device
+/// holding only a window of a long list asks for the songs around the rows it shows.
+struct QuerySlicePayload: Codable {
+  let offset: Int?
+  let limit: Int?
+
+  /// Song positions to send out of a list of count, nil for all of them
+  func itemRange(count: Int) -> Range<Int>? {
+    guard let limit = limit, limit > 0 else { return nil }
+    let start = min(max(offset ?? 0, 0), count)
+    return start..<min(start + limit, count)
+  }
+}
+
+/// Revision of the list the device holds (v1.4). Absent or 0 means none; an app that
+/// still knows the revision answers with only what changed since.
+struct QueryRevisionPayload: Codable {
+  let revision: UInt32?
+}
+
+/// Id the device gave a query (v1.6). Absent or 0 means none; otherwise every response
+/// page echoes it, and a CANCEL naming it stops the pages not sent yet.
+struct QueryRequestPayload: Codable {
+  let requestId: UInt32?
+}
+
+struct CancelPayload: Codable {
+  let requestId: UInt32
+}
+
+/// One list a QUERY_LIBRARY asks for (v1.5)
+struct LibraryListRequest: Codable {
+  let collection: String  // "playlists", "artists" or "albums"
+  let revision: UInt32?  // As in QueryRevisionPayload
+  let limit: Int?  // Items wanted at most, absent = as many as the device can hold
+}
+
+struct QueryLibraryPayload: Codable {
+  let collections: [LibraryListRequest]
+}
+
 struct QueryPlaylistSongsPayload: Codable {
   let playlistId: String
+  let firstPage: Int?
+  let lastPage: Int?
+  let offset: Int?
+  let limit: Int?
 }
 
 struct QueryArtistSongsPayload: Codable {
   let artistId: String
+  let firstPage: Int?
+  let lastPage: Int?
+  let offset: Int?
+  let limit: Int?
 }
 
 struct QueryAlbumSongsPayload: Codable {
   let albumId: String
+  let firstPage: Int?
+  let lastPage: Int?
+  let offset: Int?
+  let limit: Int?
 }
 
 // MARK: - Command Payloads
@@ -169,25 +273,30 @@ struct PlaySongPayload: Codable {
 
 // MARK: - Response Payloads
 
-struct PlaylistInfo: Codable {
+// In a delta (v1.4) a removed record is its id with `removed` set; the other fields are empty
+
+struct PlaylistInfo: Codable, Equatable {
   let id: String
   let name: String
   let songCount: Int
+  var removed: Bool? = nil
 }
 
-struct ArtistInfo: Codable {
+struct ArtistInfo: Codable, Equatable {
   let id: String
   let name: String
   let albumCount: Int
   let songCount: Int
+  var removed: Bool? = nil
 }
 
-struct AlbumInfo: Codable {
+struct AlbumInfo: Codable, Equatable {
   let id: String
   let name: String
   let artist: String?
   let songCount: Int
   let year: Int?
+  var removed: Bool? = nil
 }
 
 struct SongInfo: Codable {
@@ -203,18 +312,33 @@ struct PlaylistsResponsePayload: Codable {
   let playlists: [PlaylistInfo]
   let page: Int
   let totalPages: Int
+  let offset: Int  // Items on the pages before this one
+  let totalItems: Int
+  let revision: UInt32?  // Revision of the list once these pages are applied (v1.4)
+  let delta: Bool?  // Items are the changes since the revision the query named
+  let requestId: UInt32?  // Of the query answered (v1.6)
 }
 
 struct ArtistsResponsePayload: Codable {
   let artists: [ArtistInfo]
   let page: Int
   let totalPages: Int
+  let offset: Int  // Items on the pages before this one
+  let totalItems: Int
+  let revision: UInt32?  // Revision of the list once these pages are applied (v1.4)
+  let delta: Bool?  // Items are the changes since the revision the query named
+  let requestId: UInt32?  // Of the query answered (v1.6)
 }
 
 struct AlbumsResponsePayload: Codable {
   let albums: [AlbumInfo]
   let page: Int
   let totalPages: Int
+  let offset: Int  // Items on the pages before this one
+  let totalItems: Int
+  let revision: UInt32?  // Revision of the list once these pages are applied (v1.4)
+  let delta: Bool?  // Items are the changes since the revision the query named
+  let requestId: UInt32?  // Of the query answered (v1.6)
 }
 
 struct SongsResponsePayload: Codable {
@@ -223,6 +347,9 @@ struct SongsResponsePayload: Codable {
   let contextId: String?
   let page: Int
   let totalPages: Int
+  let offset: Int
+  let totalItems: Int
+  let requestId: UInt32?  // Of the query answered (v1.6)
 }
 
 struct ErrorPayload: Codable {
@@ -230,10 +357,616 @@ struct ErrorPayload: Codable {
   let message: String
 }
 
+// MARK: - Framing
+
+/// Splits a message into fragments that each fit a single BLE write.
+/// Every fragment starts with a 16-byte little-endian header:
+/// magic (0xAB), flags, message id, fragment index, fragment count,
+/// fragment size, total length and the CRC-32 of the complete message.
+/// The device reassembles the fragments before parsing.
+enum BluetoothFraming {
+  static let magic: UInt8 = 0xAB
+  static let headerSize = 16
+
+  static func fragments(of data: Data, messageId: UInt16, maxFrameSize: Int, flags: UInt8 = 0) -> [Data] {
+    let payloadSize = max(1, maxFrameSize - headerSize)
+    let count = max(1, (data.count + payloadSize - 1) / payloadSize)
+    let crc = crc32(data)
+
+    var frames: [Data] = []
+    frames.reserveCapacity(count)
+    for index in 0 ..< count {
+      let start = data.startIndex + index * payloadSize
+      let end = min(start + payloadSize, data.endIndex)
+
+      var frame = Data(capacity: headerSize + (end - start))
+      frame.append(magic)
+      frame.append(flags)
+      frame.appendLittleEndian(messageId)
+      frame.appendLittleEndian(UInt16(index))
+      frame.appendLittleEndian(UInt16(count))
+      frame.appendLittleEndian(UInt16(payloadSize))
+      frame.appendLittleEndian(UInt16(data.count))
+      frame.appendLittleEndian(crc)
+      frame.append(data[start ..< end])
+      frames.append(frame)
+    }
+    return frames
+  }
+
+  /// CRC-32 (IEEE 802.3, as used by zlib)
+  static func crc32(_ data: Data) -> UInt32 {
+    var crc: UInt32 = 0xFFFF_FFFF
+    for byte in data {
+      crc = crcTable[Int((crc ^ UInt32(byte)) & 0xFF)] ^ (crc >> 8)
+    }
+    return crc ^ 0xFFFF_FFFF
+  }
+
+  private static let crcTable: [UInt32] = (0 ..< 256).map { index in
+    var value = UInt32(index)
+    for _ in 0 ..< 8 {
+      value = (value & 1) != 0 ? (0xEDB8_8320 ^ (value >> 1)) : (value >> 1)
+    }
+    return value
+  }
+}
+
+extension BluetoothFraming {
+  struct Header {
+    let flags: UInt8
+    let messageId: UInt16
+    let fragmentIndex: Int
+    let fragmentCount: Int
+    let fragmentSize: Int
+    let totalLength: Int
+    let crc: UInt32
+
+    init?(_ data: Data) {
+      guard data.count >= BluetoothFraming.headerSize, data[data.startIndex] == BluetoothFraming.magic else {
+        return nil
+      }
+      flags = data[data.startIndex + 1]
+      messageId = data.readLittleEndian(at: 2)
+      fragmentIndex = Int(data.readLittleEndian(at: 4) as UInt16)
+      fragmentCount = Int(data.readLittleEndian(at: 6) as UInt16)
+      fragmentSize = Int(data.readLittleEndian(at: 8) as UInt16)
+      totalLength = Int(data.readLittleEndian(at: 10) as UInt16)
+      crc = data.readLittleEndian(at: 12)
+    }
+  }
+}
+
+// MARK: - Reassembly
+
+/// Reassembles fragmented messages sent by the device.
+/// Unframed writes (ABP v1.0) are returned unchanged.
+struct BluetoothReassembler {
+  static let timeout: TimeInterval = 2
+
+  private struct Partial {
+    let header: BluetoothFraming.Header
+    var buffer: Data
+    var received = Set<Int>()
+    var lastUpdate = Date()
+  }
+
+  private var partials: [UInt16: Partial] = [:]
+
+  mutating func reset() {
+    partials.removeAll()
+  }
+
+  /// Returns the complete message once its last fragment arrives
+  mutating func feed(_ data: Data) -> Data? {
+    guard let header = BluetoothFraming.Header(data) else {
+      return data
+    }
+
+    let now = Date()
+    partials = partials.filter { now.timeIntervalSince($0.value.lastUpdate) < Self.timeout }
+
+    let payload = data.dropFirst(BluetoothFraming.headerSize)
+    let offset = header.fragmentIndex * header.fragmentSize
+    guard header.fragmentCount > 0, header.fragmentIndex < header.fragmentCount,
+          offset + payload.count <= header.totalLength else {
+      return nil
+    }
+
+    var partial = partials[header.messageId]
+    if partial?.header.crc != header.crc || partial?.header.fragmentCount != header.fragmentCount {
+      partial = Partial(header: header, buffer: Data(count: header.totalLength))
+    }
+    guard var current = partial else { return nil }
+
+    current.buffer.replaceSubrange(offset ..< offset + payload.count, with: payload)
+    current.received.insert(header.fragmentIndex)
+    current.lastUpdate = now
+
+    guard current.received.count == header.fragmentCount else {
+      partials[header.messageId] = current
+      return nil
+    }
+
+    partials[header.messageId] = nil
+    return BluetoothFraming.crc32(current.buffer) == header.crc ? current.buffer : nil
+  }
+}
+
+extension Data {
+  fileprivate mutating func appendLittleEndian<T: FixedWidthInteger>(_ value: T) {
+    withUnsafeBytes(of: value.littleEndian) { append(contentsOf: $0) }
+  }
+
+  fileprivate func readLittleEndian<T: FixedWidthInteger>(at offset: Int) -> T {
+    var value: T = 0
+    for index in 0 ..< MemoryLayout<T>.size {
+      value |= T(self[startIndex + offset + index]) << (8 * index)
+    }
+    return value
+  }
+}
+
+// MARK: - Binary Encoding
+
+/// Payload encodings a connection can use, agreed in the HELLO/CAPABILITIES handshake
+enum BluetoothWireEncoding: String {
+  case json
+  case tlv
+}
+
+/// Compact TLV encoding of ABP messages: [0xB1][type id][fields...].
+/// Each field is a key byte (number << 3 | wire type) followed by a varint (wire type 0)
+/// or a varint length plus bytes (wire type 2). Strings carry a trailing NUL so the
+/// device can use them in place. Zero, false and missing values are not sent.
+/// Mirrors abp_schema.h in the firmware - keep both in sync.
+enum BluetoothBinaryCodec {
+  static let magic: UInt8 = 0xB1
+
+  private static let wireVarint: UInt8 = 0
+  private static let wireBytes: UInt8 = 2
+
+  indirect enum FieldKind {
+    case string
+    case uint
+    case millis  // Seconds (Double) in JSON, milliseconds on the wire
+    case bool
+    case list([Field])
+  }
+
+  struct Field {
+    let number: UInt8
+    let name: String
+    let kind: FieldKind
+
+    init(_ number: UInt8, _ name: String, _ kind: FieldKind) {
+      self.number = number
+      self.name = name
+      self.kind = kind
+    }
+  }
+
+  static let typeIds: [MessageType: UInt8] = [
+    .songStarted: 1, .songStopped: 2, .playbackProgress: 3,
+    .hello: 8, .capabilities: 9,
+    .queryPlaylists: 10, .queryArtists: 11, .queryAlbums: 12, .querySongs: 13,
+    .queryPlaylistSongs: 14, .queryArtistSongs: 15, .queryAlbumSongs: 16, .queryLibrary: 17, .cancel: 18,
+    .playSong: 20, .playPause: 21, .nextSong: 22, .prevSong: 23,
+    .playlistsResponse: 30, .artistsResponse: 31, .albumsResponse: 32, .songsResponse: 33,
+    .error: 40,
+  ]
+
+  private static let messageTypes = Dictionary(uniqueKeysWithValues: typeIds.map { ($0.value, $0.key) })
+
+  private static let playlistInfo = [
+    Field(1, "id", .string), Field(2, "name", .string), Field(3, "songCount", .uint), Field(9, "removed", .bool),
+  ]
+  private static let artistInfo = [
+    Field(1, "id", .string), Field(2, "name", .string), Field(3, "albumCount", .uint), Field(4, "songCount", .uint),
+    Field(9, "removed", .bool),
+  ]
+  private static let albumInfo = [
+    Field(1, "id", .string), Field(2, "name", .string), Field(3, "artist", .string),
+    Field(4, "songCount", .uint), Field(5, "year", .uint), Field(9, "removed", .bool),
+  ]
+  private static let songInfo = [
+    Field(1, "id", .string), Field(2, "title", .string), Field(3, "artist", .string),
+    Field(4, "album", .string), Field(5, "duration", .millis), Field(6, "trackNumber", .uint),
+  ]
+
+  /// Page range of every query (v1.2)
+  private static let pageRange = [Field(2, "firstPage", .uint), Field(3, "lastPage", .uint)]
+  /// Slice of a song list (v1.3)
+  private static let songSlice = [Field(4, "offset", .uint), Field(5, "limit", .uint)]
+  /// One list of a QUERY_LIBRARY (v1.5)
+  private static let libraryListRequest = [
+    Field(1, "collection", .string), Field(2, "revision", .uint), Field(3, "limit", .uint),
+  ]
+  /// Where a response page sits in the whole list (v1.2)
+  private static let pagePosition = [Field(6, "offset", .uint), Field(7, "totalItems", .uint)]
+  /// Revision a device holds of a library list (v1.4)
+  private static let listRevision = [Field(6, "revision", .uint)]
+  /// Revision a library list response leaves, and whether it is a delta (v1.4)
+  private static let responseRevision = [Field(8, "revision", .uint), Field(9, "delta", .bool)]
+  /// Id of the query, and its echo in every response page (v1.6)
+  private static let queryRequest = [Field(7, "requestId", .uint)]
+  private static let responseRequest = [Field(10, "requestId", .uint)]
+
+  /// Field layout per message type. HELLO and CAPABILITIES have none: they are always
+  /// JSON because the encoding is not agreed yet.
+  static let schemas: [MessageType: [Field]] = [
+    .songStarted: [
+      Field(1, "songId", .string), Field(2, "title", .string), Field(3, "artist", .string),
+      Field(4, "album", .string), Field(5, "duration", .millis), Field(6, "playlistName", .string),
+      Field(7, "playlistId", .string),
+    ],
+    .songStopped: [Field(1, "songId", .string)],
+    .playbackProgress: [
+      Field(1, "songId", .string), Field(2, "elapsedTime", .millis), Field(3, "duration", .millis),
+      Field(4, "isPlaying", .bool),
+    ],
+    .queryPlaylists: pageRange + listRevision + queryRequest, .queryArtists: pageRange + listRevision + queryRequest,
+    .queryAlbums: pageRange + listRevision + queryRequest,
+    .querySongs: pageRange + songSlice + queryRequest,
+    .queryPlaylistSongs: [Field(1, "playlistId", .string)] + pageRange + songSlice + queryRequest,
+    .queryArtistSongs: [Field(1, "artistId", .string)] + pageRange + songSlice + queryRequest,
+    .queryAlbumSongs: [Field(1, "albumId", .string)] + pageRange + songSlice + queryRequest,
+    .queryLibrary: [Field(1, "collections", .list(libraryListRequest)), Field(2, "requestId", .uint)],
+    .cancel: [Field(1, "requestId", .uint)],
+    .playSong: [
+      Field(1, "songId", .string), Field(2, "context", .string), Field(3, "contextId", .string),
+      Field(4, "songIndex", .uint),
+    ],
+    .playPause: [], .nextSong: [], .prevSong: [],
+    .playlistsResponse: [
+      Field(1, "page", .uint), Field(2, "totalPages", .uint), Field(3, "playlists", .list(playlistInfo)),
+    ] + pagePosition + responseRevision + responseRequest,
+    .artistsResponse: [
+      Field(1, "page", .uint), Field(2, "totalPages", .uint), Field(3, "artists", .list(artistInfo)),
+    ] + pagePosition + responseRevision + responseRequest,
+    .albumsResponse: [
+      Field(1, "page", .uint), Field(2, "totalPages", .uint), Field(3, "albums", .list(albumInfo)),
+    ] + pagePosition + responseRevision + responseRequest,
+    .songsResponse: [
+      Field(1, "page", .uint), Field(2, "totalPages", .uint), Field(3, "songs", .list(songInfo)),
+      Field(4, "context", .string), Field(5, "contextId", .string),
+    ] + pagePosition + responseRequest,
+    .error: [Field(1, "code", .string), Field(2, "message", .string)],
+  ]
+
+  /// Binary form of a message, nil if its type has no binary layout
+  static func encode(_ message: BluetoothMessage) -> Data? {
+    guard let typeId = typeIds[message.type], let schema = schemas[message.type] else { return nil }
+    var data = Data([magic, typeId])
+    appendFields(message.payloadObject ?? [:], schema: schema, to: &data)
+    return data
+  }
+
+  /// Parses a binary message, nil if it is malformed or of an unknown type
+  static func decode(_ data: Data) -> BluetoothMessage? {
+    guard data.count >= 2, data[data.startIndex] == magic,
+          let type = messageTypes[data[data.startIndex + 1]],
+          let schema = schemas[type],
+          let payload = decodeFields(data.dropFirst(2), schema: schema) else {
+      return nil
+    }
+    return BluetoothMessage(type: type, payloadObject: schema.isEmpty ? nil : payload)
+  }
+
+  // MARK: Encoding
+
+  private static func appendFields(_ object: [String: Any], schema: [Field], to data: inout Data) {
+    for field in schema {
+      guard let value = object[field.name], !(value is NSNull) else { continue }
+
+      switch field.kind {
+      case .string:
+        guard let string = value as? String else { continue }
+        appendBytes(Data(string.utf8) + [0], number: field.number, to: &data)
+      case .uint:
+        guard let number = (value as? NSNumber)?.int64Value, number > 0 else { continue }
+        appendVarint(UInt32(clamping: number), number: field.number, to: &data)
+      case .millis:
+        guard let seconds = (value as? NSNumber)?.doubleValue, seconds > 0 else { continue }
+        appendVarint(UInt32(clamping: Int64((seconds * 1000).rounded())), number: field.number, to: &data)
+      case .bool:
+        guard (value as? NSNumber)?.boolValue == true else { continue }
+        appendVarint(1, number: field.number, to: &data)
+      case let .list(itemSchema):
+        guard let items = value as? [[String: Any]] else { continue }
+        for item in items {
+          var itemData = Data()
+          appendFields(item, schema: itemSchema, to: &itemData)
+          appendBytes(itemData, number: field.number, to: &data)
+        }
+      }
+    }
+  }
+
+  private static func appendVarint(_ value: UInt32, number: UInt8, to data: inout Data) {
+    data.append(number << 3 | wireVarint)
+    appendRawVarint(value, to: &data)
+  }
+
+  private static func appendBytes(_ bytes: Data, number: UInt8, to data: inout Data) {
+    data.append(number << 3 | wireBytes)
+    appendRawVarint(UInt32(bytes.count), to: &data)
+    data.append(bytes)
+  }
+
+  private static func appendRawVarint(_ value: UInt32, to data: inout Data) {
+    var remaining = value
+    repeat {
+      let byte = UInt8(remaining & 0x7F)
+      remaining >>= 7
+      data.append(remaining == 0 ? byte : byte | 0x80)
+    } while remaining != 0
+  }
+
+  // MARK: Decoding
+
+  private static func decodeFields(_ data: Data, schema: [Field]) -> [String: Any]? {
+    var object: [String: Any] = [:]
+    var index = data.startIndex
+
+    while index < data.endIndex {
+      let key = data[index]
+      index += 1
+      guard let value = readVarint(data, at: &index) else { return nil }
+
+      var bytes: Data?
+      switch key & 0x07 {
+      case wireVarint:
+        break
+      case wireBytes:
+        guard data.endIndex - index >= Int(value) else { return nil }
+        bytes = data[index ..< index + Int(value)]
+        index += Int(value)
+      default:
+        return nil
+      }
+
+      // Unknown fields are skipped so newer senders can add them
+      guard let field = schema.first(where: { $0.number == key >> 3 }) else { continue }
+
+      switch field.kind {
+      case .string:
+        guard let bytes = bytes, bytes.last == 0 else { return nil }
+        object[field.name] = String(decoding: bytes.dropLast(), as: UTF8.self)
+      case .uint:
+        object[field.name] = Int(value)
+      case .millis:
+        object[field.name] = Double(value) / 1000
+      case .bool:
+        object[field.name] = value != 0
+      case let .list(itemSchema):
+        guard let bytes = bytes, let item = decodeFields(bytes, schema: itemSchema) else { return nil }
+        object[field.name] = (object[field.name] as? [[String: Any]] ?? []) + [item]
+      }
+    }
+
+    // Zero values are not sent - put them back so non-optional payload fields decode
+    for field in schema where object[field.name] == nil {
+      switch field.kind {
+      case .string: break
+      case .uint: object[field.name] = 0
+      case .millis: object[field.name] = 0.0
+      case .bool: object[field.name] = false
+      case .list: object[field.name] = [[String: Any]]()
+      }
+    }
+    return object
+  }
+
+  private static func readVarint(_ data: Data, at index: inout Data.Index) -> UInt32? {
+    var result: UInt32 = 0
+    var shift: UInt32 = 0
+    while index < data.endIndex, shift < 35 {
+      let byte = data[index]
+      index += 1
+      result |= UInt32(byte & 0x7F) << shift
+      if byte & 0x80 == 0 {
+        return result
+      }
+      shift += 7
+    }
+    return nil
+  }
+}
+
+extension BluetoothMessage {
+  /// Payload as a JSON object, as used by the binary codec
+  fileprivate var payloadObject: [String: Any]? {
+    guard let payloadData = payloadData else { return nil }
+    return (try? JSONSerialization.jsonObject(with: payloadData, options: [])) as? [String: Any]
+  }
+
+  fileprivate init(type: MessageType, payloadObject: [String: Any]?) {
+    self.init(
+      type: type,
+      timestamp: Date().timeIntervalSince1970,
+      payloadData: payloadObject.flatMap { try? JSONSerialization.data(withJSONObject: $0, options: []) }
+    )
+  }
+}
+
+// MARK: - Link Capabilities
+
+/// What the connected device reported in HELLO, used to size response pages
+struct BluetoothLinkCapabilities {
+  let mtu: Int
+  let maxMessageSize: Int
+  let maxWriteLength: Int
+  let capacities: CollectionCapacities
+  let encodings: [String]
+  let supportsFraming: Bool
+  let maxDeltaItems: Int  // 0 = the device does not take deltas (before v1.4)
+
+  /// Encoding the app uses once the handshake is done - binary when the device can decode it
+  var encoding: BluetoothWireEncoding {
+    encodings.contains(BluetoothWireEncoding.tlv.rawValue) ? .tlv : .json
+  }
+
+  /// Assumed until the device says HELLO - ABP v1.0 devices never do and
+  /// expect each message in a single unframed write
+  static let legacy = BluetoothLinkCapabilities(
+    mtu: 23,
+    maxMessageSize: 512,
+    maxWriteLength: 512,
+    capacities: CollectionCapacities(playlists: 50, artists: 100, albums: 100, songs: 200),
+    encodings: ["json"],
+    supportsFraming: false,
+    maxDeltaItems: 0
+  )
+
+  init(
+    mtu: Int,
+    maxMessageSize: Int,
+    maxWriteLength: Int,
+    capacities: CollectionCapacities,
+    encodings: [String],
+    supportsFraming: Bool,
+    maxDeltaItems: Int
+  ) {
+    self.mtu = mtu
+    self.maxMessageSize = maxMessageSize
+    self.maxWriteLength = maxWriteLength
+    self.capacities = capacities
+    self.encodings = encodings
+    self.supportsFraming = supportsFraming
+    self.maxDeltaItems = maxDeltaItems
+  }
+
+  init(hello: HelloPayload) {
+    self.init(
+      mtu: hello.mtu,
+      maxMessageSize: min(hello.maxMessageSize, BluetoothProtocolConstants.maxMessageSize),
+      maxWriteLength: min(hello.maxWriteLength, BluetoothProtocolConstants.maxWriteLength),
+      capacities: hello.capacities,
+      encodings: hello.encodings,
+      supportsFraming: true,
+      maxDeltaItems: max(hello.maxDeltaItems ?? 0, 0)
+    )
+  }
+
+  /// Bytes of list items per response page.
+  /// Bounded by what the device can parse and by how many ATT packets the link
+  /// should spend on one page, so small-MTU links still get a first page quickly.
+  var pageBudget: Int {
+    let attPayload = max(mtu - BluetoothProtocolConstants.attHeaderSize, 20)
+    let linkBudget = supportsFraming ? attPayload * BluetoothProtocolConstants.packetsPerPage : maxMessageSize
+    let budget = min(maxMessageSize, linkBudget) - BluetoothProtocolConstants.pageEnvelopeReserve
+    return max(budget, BluetoothProtocolConstants.minPageBudget)
+  }
+
+  /// Splits items into pages whose encoded JSON fits the page budget.
+  /// Items beyond what the device can hold are not sent; `truncated` counts them.
+  func paginate<T: Encodable>(_ items: [T], capacity: Int) -> (pages: [[T]], truncated: Int) {
+    let budget = pageBudget
+    let encoder = JSONEncoder()
+    var pages: [[T]] = []
+    var current: [T] = []
+    var currentSize = 0
+
+    for item in items.prefix(max(capacity, 0)) {
+      let size = ((try? encoder.encode(item))?.count ?? 0) + 1  // +1 for the separating comma
+      if !current.isEmpty, currentSize + size > budget {
+        pages.append(current)
+        current = []
+        currentSize = 0
+      }
+      current.append(item)
+      currentSize += size
+    }
+    if !current.isEmpty || pages.isEmpty {
+      pages.append(current)
+    }
+    return (pages, max(items.count - max(capacity, 0), 0))
+  }
+}
+
+// MARK: - List Revisions
+
+/// A library list record as revisions and deltas see it (v1.4)
+protocol BluetoothListItem: Codable, Equatable {
+  var id: String { get }
+  /// The delta entry for a record no longer in the list
+  static func removal(id: String) -> Self
+}
+
+extension PlaylistInfo: BluetoothListItem {
+  static func removal(id: String) -> PlaylistInfo {
+    PlaylistInfo(id: id, name: "", songCount: 0, removed: true)
+  }
+}
+
+extension ArtistInfo: BluetoothListItem {
+  static func removal(id: String) -> ArtistInfo {
+    ArtistInfo(id: id, name: "", albumCount: 0, songCount: 0, removed: true)
+  }
+}
+
+extension AlbumInfo: BluetoothListItem {
+  static func removal(id: String) -> AlbumInfo {
+    AlbumInfo(id: id, name: "", artist: nil, songCount: 0, year: nil, removed: true)
+  }
+}
+
+/// The last few versions of one library list sent to devices, so a device that names
+/// one of them in its query gets only what changed since (v1.4).
+/// Revisions are a hash of the list, so an unchanged library keeps its revision even
+/// across app restarts; the versions themselves are kept in memory only.
+struct BluetoothListHistory<Item: BluetoothListItem> {
+  static var depth: Int { 4 }
+
+  private var versions: [(revision: UInt32, items: [Item])] = []
+
+  /// FNV-1a over the list's JSON - equal lists, equal revisions. Never 0, which means none.
+  static func revision(of items: [Item]) -> UInt32 {
+    let encoder = JSONEncoder()
+    encoder.outputFormatting = .sortedKeys
+    var hash: UInt32 = 2_166_136_261
+    for byte in (try? encoder.encode(items)) ?? Data() {
+      hash = (hash ^ UInt32(byte)) &* 16_777_619
+    }
+    return hash == 0 ? 1 : hash
+  }
+
+  /// What to send a device holding `base` of a list that is now `items`: the list
+  /// itself, or - when base is a version still kept and the changes fit maxDelta and
+  /// are well short of the list - the removed IDs followed by the added and changed records
+  mutating func answer(_ items: [Item], base: UInt32?, maxDelta: Int) -> (items: [Item], revision: UInt32, delta: Bool) {
+    let revision = Self.revision(of: items)
+    if versions.last?.revision != revision {
+      versions.append((revision, items))
+      versions.removeFirst(max(versions.count - Self.depth, 0))
+    }
+
+    guard let base = base, base != 0, let previous = versions.first(where: { $0.revision == base })?.items else {
+      return (items, revision, false)
+    }
+    let current = Set(items.map(\.id))
+    let before = Dictionary(previous.map { ($0.id, $0) }, uniquingKeysWith: { first, _ in first })
+    let changes = previous.filter { !current.contains($0.id) }.map { Item.removal(id: $0.id) }
+      + items.filter { before[$0.id] != $0 }
+    guard changes.count <= maxDelta, changes.count * 2 <= items.count else {
+      return (items, revision, false)
+    }
+    return (changes, revision, true)
+  }
+}
+
 // MARK: - Protocol Constants
 
 enum BluetoothProtocolConstants {
-  static let protocolVersion = "1.0"
-  static let maxMessageSize = 512  // 512 bytes max per message
+  static let protocolVersion = "1.6"
+  static let maxMessageSize = 16 * 1024  // Upper bound for any message, the device may report less in HELLO
+  static let maxWriteLength = 512  // Largest single BLE write (one fragment) the device accepts
   static let progressUpdateInterval: TimeInterval = 0.25  // 250ms
+
+  // Page sizing
+  static let attHeaderSize = 3  // ATT opcode + handle
+  static let packetsPerPage = 24  // ATT packets one response page may occupy
+  static let pageEnvelopeReserve = 256  // type, timestamp, page counters, revision, request id and context around the items
+  static let minPageBudget = 256
 }
@@ -0,0 +1,161 @@
+//
+//  BluetoothPaginationTest.swift
+//  AmperfyKitTests
+//
+//  Created by Maximilian Bauer on 16.10.26.
+//  Copyright (c) 2026 Maximilian Bauer. All rights reserved.
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+import XCTest
+
+// BluetoothProtocol.swift belongs to the app target and is compiled into this bundle as well
+
+class BluetoothPaginationTest: XCTestCase {
+  let mtus = [23, 27, 185, 247, 512, 517]
+  let messageSizes = [512, 4 * 1024, BluetoothProtocolConstants.maxMessageSize]
+  let capacities = CollectionCapacities(playlists: 500, artists: 1000, albums: 1000, songs: 2000)
+  let contextId = "4f1c2a9e-7b3d-4e8a-9c51-0d2e6f7a8b90"
+
+  private func makeLink(mtu: Int, maxMessageSize: Int) -> BluetoothLinkCapabilities {
+    BluetoothLinkCapabilities(
+      mtu: mtu,
+      maxMessageSize: maxMessageSize,
+      maxWriteLength: BluetoothProtocolConstants.maxWriteLength,
+      capacities: capacities,
+      encodings: ["json", "tlv"],
+      supportsFraming: true,
+      maxDeltaItems: 256
+    )
+  }
+
+  // Names as the app cuts them, escapes and multi-byte characters included
+  private func songs(_ count: Int) -> [SongInfo] {
+    (0 ..< count).map { index in
+      SongInfo(
+        id: "song-\(index)-\(contextId)",
+        title: String("Title \"\(index)\" / Ünïcødé 🎵 \(String(repeating: "x", count: index % 40))".prefix(30)),
+        artist: String("Artist \(index % 97) \(String(repeating: "y", count: index % 30))".prefix(30)),
+        album: String("Album \(index % 211) \(String(repeating: "z", count: index % 50))".prefix(30)),
+        duration: Double(index % 600) + 0.5,
+        trackNumber: index % 30
+      )
+    }
+  }
+
+  private func playlists(_ count: Int) -> [PlaylistInfo] {
+    (0 ..< count).map { index in
+      PlaylistInfo(
+        id: "\(index)-\(contextId)",
+        name: String("Playlist \(index) \(String(repeating: "é", count: index % 40))".prefix(30)),
+        songCount: index * 7
+      )
+    }
+  }
+
+  private func itemBytes<T: Encodable>(_ items: [T]) -> Int {
+    let encoder = JSONEncoder()
+    return items.reduce(0) { $0 + ((try? encoder.encode($1))?.count ?? 0) + 1 }
+  }
+
+  /// Pages as the app sends them, with every optional envelope field at its longest
+  private func songMessages(_ pages: [[SongInfo]], totalItems: Int) -> [BluetoothMessage] {
+    pages.enumerated().map { page, items in
+      BluetoothMessage(type: .songsResponse, payload: SongsResponsePayload(
+        songs: items, context: "playlist", contextId: contextId, page: page + 1, totalPages: pages.count,
+        offset: 65535, totalItems: totalItems, requestId: UInt32.max
+      ))
+    }
+  }
+
+  private func playlistMessages(_ pages: [[PlaylistInfo]]) -> [BluetoothMessage] {
+    pages.enumerated().map { page, items in
+      BluetoothMessage(type: .playlistsResponse, payload: PlaylistsResponsePayload(
+        playlists: items, page: page + 1, totalPages: pages.count, offset: 65535, totalItems: 65535,
+        revision: UInt32.max, delta: false, requestId: UInt32.max
+      ))
+    }
+  }
+
+  private func checkMessagesFit(_ messages: [BluetoothMessage], link: BluetoothLinkCapabilities) {
+    for message in messages {
+      guard let json = message.toData() else { XCTFail("\(message.type) did not encode"); continue }
+      XCTAssertLessThanOrEqual(json.count, link.maxMessageSize, "JSON page, MTU \(link.mtu)")
+      if let binary = BluetoothBinaryCodec.encode(message) {
+        XCTAssertLessThanOrEqual(binary.count, link.maxMessageSize, "TLV page, MTU \(link.mtu)")
+      }
+    }
+  }
+
+  func testPagesFitBudgetAcrossMtus() {
+    let items = songs(1500)
+    for maxMessageSize in messageSizes {
+      var previousPageCount = Int.max
+      for mtu in mtus {
+        let link = makeLink(mtu: mtu, maxMessageSize: maxMessageSize)
+        let budget = link.pageBudget
+        XCTAssertGreaterThanOrEqual(budget, BluetoothProtocolConstants.minPageBudget)
+        XCTAssertLessThanOrEqual(budget + BluetoothProtocolConstants.pageEnvelopeReserve, max(
+          maxMessageSize,
+          BluetoothProtocolConstants.minPageBudget + BluetoothProtocolConstants.pageEnvelopeReserve
+        ))
+
+        let paginated = link.paginate(items, capacity: capacities.songs)
+        XCTAssertEqual(paginated.truncated, 0)
+        XCTAssertEqual(paginated.pages.flatMap { $0 }.map(\.id), items.map(\.id), "MTU \(mtu)")
+        for page in paginated.pages {
+          XCTAssertFalse(page.isEmpty)
+          // Only an item too big on its own may go past the budget
+          if page.count > 1 {
+            XCTAssertLessThanOrEqual(itemBytes(page), budget, "MTU \(mtu), max \(maxMessageSize)")
+          }
+        }
+        checkMessagesFit(songMessages(paginated.pages, totalItems: items.count), link: link)
+
+        // A bigger MTU never needs more pages
+        XCTAssertLessThanOrEqual(paginated.pages.count, previousPageCount, "MTU \(mtu)")
+        previousPageCount = paginated.pages.count
+      }
+    }
+  }
+
+  func testLegacyLinkPagesFitOneWrite() {
+    let legacy = BluetoothLinkCapabilities.legacy
+    let paginated = legacy.paginate(playlists(120), capacity: legacy.capacities.playlists)
+    XCTAssertEqual(paginated.pages.flatMap { $0 }.count, legacy.capacities.playlists)
+    checkMessagesFit(playlistMessages(paginated.pages), link: legacy)
+  }
+
+  func testTruncationIsReported() {
+    let link = makeLink(mtu: 247, maxMessageSize: BluetoothProtocolConstants.maxMessageSize)
+    let items = playlists(capacities.playlists + 37)
+    let paginated = link.paginate(items, capacity: capacities.playlists)
+    XCTAssertEqual(paginated.truncated, 37)
+    XCTAssertEqual(paginated.pages.flatMap { $0 }, Array(items.prefix(capacities.playlists)))
+    checkMessagesFit(playlistMessages(paginated.pages), link: link)
+
+    let none = link.paginate(items, capacity: 0)
+    XCTAssertEqual(none.truncated, items.count)
+    XCTAssertEqual(none.pages.count, 1)
+    XCTAssertTrue(none.pages[0].isEmpty)
+  }
+
+  func testEmptyListIsOneEmptyPage() {
+    let paginated = makeLink(mtu: 185, maxMessageSize: 4 * 1024).paginate([SongInfo](), capacity: capacities.songs)
+    XCTAssertEqual(paginated.truncated, 0)
+    XCTAssertEqual(paginated.pages.count, 1)
+    XCTAssertTrue(paginated.pages[0].isEmpty)
+  }
+}